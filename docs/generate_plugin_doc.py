@@ -44,6 +44,7 @@ SENSOR_ORDERING = ['perspective',
                    'thinlens']
 
 TEXTURE_ORDERING = ['bitmap',
+                    'tiledbitmap',
                     'checkerboard']
 
 SPECTRUM_ORDERING = ['uniform',
@@ -58,7 +59,9 @@ SAMPLER_ORDERING = ['independent',
                     'stratified',
                     'multijitter',
                     'orthogonal',
-                    'ldsampler']
+                    'ldsampler',
+                    'sobol',
+                    'bluenoise']
 
 INTEGRATOR_ORDERING = ['direct',
                        'path',
@@ -74,7 +77,9 @@ RFILTER_ORDERING = ['box',
                     'lanczos']
 
 PHASE_ORDERING = ['isotropic',
-                  'hg']
+                  'hg',
+                  'hgmix',
+                  'tabphase']
 
 def find_order_id(filename, ordering):
     f = os.path.split(filename)[-1].split('.')[0]
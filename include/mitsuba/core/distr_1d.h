@@ -45,6 +45,29 @@ public:
         : DiscreteDistribution(FloatStorage::copy(values, size)) {
     }
 
+    /**
+     * \brief Initialize from a probability mass function and a matching
+     * unnormalized cumulative distribution function
+     *
+     * This skips the (serial) computation of the CDF in \ref update() for
+     * callers that already computed it, e.g. using a parallel prefix sum.
+     *
+     * \param valid
+     *     Index of the first and last entry with nonzero probability mass
+     *
+     * \param sum
+     *     Sum of all PMF entries (i.e. the last CDF entry)
+     */
+    DiscreteDistribution(FloatStorage &&pmf, FloatStorage &&cdf,
+                         const ScalarVector2u &valid, ScalarFloat sum)
+        : m_pmf(std::move(pmf)), m_cdf(std::move(cdf)), m_sum(sum),
+          m_normalization(ScalarFloat(1.0 / (double) sum)), m_valid(valid) {
+        if (m_pmf.size() == 0 || m_pmf.size() != m_cdf.size())
+            Throw("DiscreteDistribution: invalid PMF/CDF sizes!");
+        if (any(eq(m_valid, (uint32_t) -1)) || !(sum > 0))
+            Throw("DiscreteDistribution: no probability mass found!");
+    }
+
     /// Update the internal state. Must be invoked when changing the pmf.
     void update() {
         size_t size = m_pmf.size();
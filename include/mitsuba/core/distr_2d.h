@@ -2,6 +2,8 @@
 
 #include <mitsuba/core/warp.h>
 #include <mitsuba/core/util.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -195,6 +197,30 @@ protected:
     ScalarFloat m_normalization;
 };
 
+NAMESPACE_BEGIN(detail)
+/**
+ * \brief Invoke <tt>func(begin, end)</tt> on subranges of <tt>[0, size)</tt>
+ * in parallel, used to construct the 2D distributions
+ *
+ * \c cost denotes the work per element. Subranges span about 16K units of
+ * work, hence small distributions are built on the calling thread.
+ */
+template <typename Func>
+void distr_2d_parallel_for(uint32_t size, uint32_t cost, Func func) {
+    uint32_t grain = std::max((1u << 14) / std::max(cost, 1u), 1u);
+    if (size <= grain) {
+        func(0u, size);
+        return;
+    }
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(0u, size, grain),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            func(range.begin(), range.end());
+        }
+    );
+}
+NAMESPACE_END(detail)
+
 /// Base class of Hierarchical2D and Marginal2D with common functionality
 template <typename Float_, size_t Dimension_ = 0> class Distribution2D {
 public:
@@ -421,27 +447,45 @@ public:
             uint32_t offset0 = m_levels[0].size * slice,
                      offset1 = m_levels[1].size * slice;
 
-            // Integrate linear interpolant
+            // Integrate linear interpolant (rows are processed in parallel)
             const ScalarFloat *in = data + offset0;
+            std::unique_ptr<double[]> row_sum(new double[n_patches.y()]);
+            Level &level1 = m_levels[1];
+
+            detail::distr_2d_parallel_for(n_patches.y(), n_patches.x(),
+                [&](uint32_t y_begin, uint32_t y_end) {
+                    for (uint32_t y = y_begin; y < y_end; ++y) {
+                        const ScalarFloat *row = in + y * size.x();
+                        double row_accum = 0.0;
+                        for (uint32_t x = 0; x < n_patches.x(); ++x) {
+                            ScalarFloat avg = (row[x] + row[x + 1] + row[x + size.x()] +
+                                               row[x + size.x() + 1]) * .25f;
+                            row_accum += (double) avg;
+                            *(level1.ptr(ScalarVector2u(x, y)) + offset1) = avg;
+                        }
+                        row_sum[y] = row_accum;
+                    }
+                }
+            );
 
             double sum = 0.0;
-            for (uint32_t y = 0; y < n_patches.y(); ++y) {
-                for (uint32_t x = 0; x < n_patches.x(); ++x) {
-                    ScalarFloat avg = (in[0] + in[1] + in[size.x()] +
-                                 in[size.x() + 1]) * .25f;
-                    sum += (double) avg;
-                    *(m_levels[1].ptr(ScalarVector2u(x, y)) + offset1) = avg;
-                    ++in;
-                }
-                ++in;
-            }
+            for (uint32_t y = 0; y < n_patches.y(); ++y)
+                sum += row_sum[y];
 
             // Copy and normalize fine resolution interpolant
             ScalarFloat scale = normalize ? (ScalarFloat) (hprod(n_patches) / sum) : 1.f;
-            for (uint32_t i = 0; i < m_levels[0].size; ++i)
-                m_levels[0].data_ptr[offset0 + i] = data[offset0 + i] * scale;
-            for (uint32_t i = 0; i < m_levels[1].size; ++i)
-                m_levels[1].data_ptr[offset1 + i] *= scale;
+            detail::distr_2d_parallel_for(m_levels[0].size, 1,
+                [&](uint32_t begin, uint32_t end) {
+                    for (uint32_t i = begin; i < end; ++i)
+                        m_levels[0].data_ptr[offset0 + i] = data[offset0 + i] * scale;
+                }
+            );
+            detail::distr_2d_parallel_for(level1.size, 1,
+                [&](uint32_t begin, uint32_t end) {
+                    for (uint32_t i = begin; i < end; ++i)
+                        level1.data_ptr[offset1 + i] *= scale;
+                }
+            );
 
             // Build a MIP hierarchy
             level_size = n_patches;
@@ -453,13 +497,17 @@ public:
                 level_size = sr<1>(level_size + 1u);
 
                 // Downsample
-                for (uint32_t y = 0; y < level_size.y(); ++y) {
-                    for (uint32_t x = 0; x < level_size.x(); ++x) {
-                        ScalarFloat *d1 = l1.ptr(ScalarVector2u(x, y)) + offset1;
-                        const ScalarFloat *d0 = l0.ptr(ScalarVector2u(x*2, y*2)) + offset0;
-                        *d1 = d0[0] + d0[1] + d0[2] + d0[3];
+                detail::distr_2d_parallel_for(level_size.y(), level_size.x(),
+                    [&](uint32_t y_begin, uint32_t y_end) {
+                        for (uint32_t y = y_begin; y < y_end; ++y) {
+                            for (uint32_t x = 0; x < level_size.x(); ++x) {
+                                ScalarFloat *d1 = l1.ptr(ScalarVector2u(x, y)) + offset1;
+                                const ScalarFloat *d0 = l0.ptr(ScalarVector2u(x*2, y*2)) + offset0;
+                                *d1 = d0[0] + d0[1] + d0[2] + d0[3];
+                            }
+                        }
                     }
-                }
+                );
             }
         }
     }
@@ -875,29 +923,33 @@ public:
             m_cond_cdf = empty<FloatStorage>(m_slices * n_cond);
             m_cond_cdf.managed();
 
-            ScalarFloat *marg_cdf = m_marg_cdf.data(),
-                        *cond_cdf = m_cond_cdf.data(),
-                        *data_out = m_data.data();
-
             std::unique_ptr<double[]> cond_cdf_sum(new double[h]);
 
             for (uint32_t slice = 0; slice < m_slices; ++slice) {
+                ScalarFloat *marg_cdf = m_marg_cdf.data() + slice * n_marg,
+                            *cond_cdf = m_cond_cdf.data() + slice * n_cond,
+                            *data_out = m_data.data() + slice * n_data;
+                const ScalarFloat *data_in = data + slice * n_data;
                 ScalarFloat norm = 1.f;
 
                 /* The marginal/probability distribution computation
-                   differs for the Continuous=false/true cases */
+                   differs for the Continuous=false/true cases. The
+                   conditional CDFs of different rows are independent
+                   and constructed in parallel. */
                 if constexpr (Continuous) {
                     // Construct conditional CDF
-                    for (uint32_t y = 0; y < h; ++y) {
-                        double accum = 0.0;
-                        uint32_t i = y * w, j = y * (w - 1);
-                        for (uint32_t x = 0; x < w - 1; ++x, ++i, ++j) {
-                            accum += scale_x * ((double) data[i] +
-                                                (double) data[i + 1]);
-                            cond_cdf[j] = (ScalarFloat) accum;
+                    detail::distr_2d_parallel_for(h, w, [&](uint32_t y_begin, uint32_t y_end) {
+                        for (uint32_t y = y_begin; y < y_end; ++y) {
+                            double accum = 0.0;
+                            uint32_t i = y * w, j = y * (w - 1);
+                            for (uint32_t x = 0; x < w - 1; ++x, ++i, ++j) {
+                                accum += scale_x * ((double) data_in[i] +
+                                                    (double) data_in[i + 1]);
+                                cond_cdf[j] = (ScalarFloat) accum;
+                            }
+                            cond_cdf_sum[y] = accum;
                         }
-                        cond_cdf_sum[y] = accum;
-                    }
+                    });
 
                     // Construct marginal CDF
                     double accum = 0.0;
@@ -912,18 +964,20 @@ public:
                     double scale = scale_x * scale_y;
 
                     // Construct conditional CDF
-                    for (uint32_t y = 0; y < h - 1; ++y) {
-                        double accum = 0.0;
-                        uint32_t i = y * w, j = y * (w - 1);
-                        for (uint32_t x = 0; x < w - 1; ++x, ++i, ++j) {
-                            accum += scale * ((double) data[i] +
-                                              (double) data[i + 1] +
-                                              (double) data[i + w] +
-                                              (double) data[i + w + 1]);
-                            cond_cdf[j] = (ScalarFloat) accum;
+                    detail::distr_2d_parallel_for(h - 1, w, [&](uint32_t y_begin, uint32_t y_end) {
+                        for (uint32_t y = y_begin; y < y_end; ++y) {
+                            double accum = 0.0;
+                            uint32_t i = y * w, j = y * (w - 1);
+                            for (uint32_t x = 0; x < w - 1; ++x, ++i, ++j) {
+                                accum += scale * ((double) data_in[i] +
+                                                  (double) data_in[i + 1] +
+                                                  (double) data_in[i + w] +
+                                                  (double) data_in[i + w + 1]);
+                                cond_cdf[j] = (ScalarFloat) accum;
+                            }
+                            cond_cdf_sum[y] = accum;
                         }
-                        cond_cdf_sum[y] = accum;
-                    }
+                    });
 
                     // Construct marginal CDF
                     double accum = 0.0;
@@ -936,12 +990,16 @@ public:
                         norm = ScalarFloat(1.0 / accum);
                 }
 
-                for (size_t i = 0; i < n_cond; ++i)
-                    *cond_cdf++ *= norm;
                 for (size_t i = 0; i < n_marg; ++i)
-                    *marg_cdf++ *= norm;
-                for (size_t i = 0; i < n_data; ++i)
-                    *data_out++ = *data++ * norm;
+                    marg_cdf[i] *= norm;
+                detail::distr_2d_parallel_for(n_cond, 1, [&](uint32_t begin, uint32_t end) {
+                    for (uint32_t i = begin; i < end; ++i)
+                        cond_cdf[i] *= norm;
+                });
+                detail::distr_2d_parallel_for(n_data, 1, [&](uint32_t begin, uint32_t end) {
+                    for (uint32_t i = begin; i < end; ++i)
+                        data_out[i] = data_in[i] * norm;
+                });
             }
         } else {
             ScalarFloat *data_out = m_data.data();
@@ -30,7 +30,7 @@ enum class ProfilerPhase : int {
     ImageBlockPut,              /* ImageBlock::put() */
     BSDFEvaluate,               /* BSDF::eval() and BSDF::pdf() */
     BSDFSample,                 /* BSDF::sample() */
-    BSDFID,                     /* BSDF::medh_id() */
+    BSDFID,                     /* BSDF::mesh_id() */
     SurfaceProjection,          /* SurfaceInteraction::project_...() */
     PhaseFunctionEvaluate,      /* PhaseFunction::eval() and PhaseFunction::pdf() */
     PhaseFunctionSample,        /* PhaseFunction::sample() */
@@ -41,12 +41,13 @@ enum class ProfilerPhase : int {
     EndpointSampleDirection,    /* Endpoint::sample_direction() */
     TextureSample,              /* Texture::sample() */
     TextureEvaluate,            /* Texture::eval() and Texture::pdf() */
+    TextureCacheLoad,           /* TextureCache::tile() upon a cache miss */
 
     ProfilerPhaseCount
 };
 
 constexpr const char
-    *profiler_phase_id[int(ProfilerPhase::ProfilerPhaseCount)] = {
+    *profiler_phase_id[] = {
         "Scene initialization",
         "Geometry loading",
         "Texture loading",
@@ -61,6 +62,8 @@ constexpr const char
         "ImageBlock::put()",
         "BSDF::eval(), pdf()",
         "BSDF::sample()",
+        "BSDF::mesh_id()",
+        "SurfaceInteraction::project()",
         "PhaseFunction::eval(), pdf()",
         "PhaseFunction::sample()",
         "Medium::eval(), pdf()",
@@ -69,7 +72,8 @@ constexpr const char
         "Endpoint::sample_ray()",
         "Endpoint::sample_direction()",
         "Texture::sample()",
-        "Texture::eval()"
+        "Texture::eval()",
+        "TextureCache::tile() miss"
     };
 
 
@@ -151,6 +151,14 @@ public:
         return !operator==(props);
     }
 
+    /**
+     * \brief Compute a hash value of the plugin name and of all stored
+     * properties (the identifier is not included)
+     *
+     * Objects and pointers are hashed by their address.
+     */
+    size_t hash() const;
+
     MTS_EXPORT_CORE friend
     std::ostream &operator<<(std::ostream &os, const Properties &p);
 
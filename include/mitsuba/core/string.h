@@ -98,5 +98,20 @@ extern MTS_EXPORT_CORE std::string trim(const std::string &s,
 /// Check if a list of keys contains a specific key
 extern MTS_EXPORT_CORE bool contains(const std::vector<std::string> &keys, const std::string &key);
 
+/**
+ * \brief Locale-independent fast conversion of a string to a floating point value
+ *
+ * Drop-in replacement for \c std::strtof() / \c std::strtod() that is
+ * considerably faster for the plain decimal and scientific notation found in
+ * mesh files. The fast path only handles inputs that it can convert with a
+ * single correctly rounded operation (for \c float: significands below 2^24
+ * and decimal exponents up to 10 in magnitude; for \c double: at most 15
+ * significant digits and exponents up to 22). Everything else (longer
+ * significands, large exponents, "inf", "nan", hexadecimal notation, ...) is
+ * forwarded to the standard library implementation.
+ */
+template <typename T>
+extern MTS_EXPORT_CORE T strtof(const char *nptr, char **endptr);
+
 NAMESPACE_END(string)
 NAMESPACE_END(mitsuba)
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <mitsuba/core/object.h>
+#include <mitsuba/core/filesystem.h>
+#include <mitsuba/core/rfilter.h>
+#include <mitsuba/core/vector.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Image stored in Mitsuba's native tiled and MIP-mapped format
+ *
+ * The file starts with a header consisting of the ASCII bytes 'M', 'T', 'X'
+ * and a version byte, followed by the width, height, channel count, tile size
+ * and level count of the image as 32-bit integers. The tiles of all MIP levels
+ * follow in order of increasing level, and in row-major order within each
+ * level. Every tile stores <tt>tile_size * tile_size * channel_count</tt>
+ * single precision values, i.e. tiles along the right and bottom border are
+ * padded by replicating the last row and column.
+ *
+ * This class does not keep the image in memory. Instead, tiles are loaded on
+ * demand through the \ref TextureCache, which bounds the total memory usage of
+ * all tiled images.
+ */
+class MTS_EXPORT_CORE TiledImage : public Object {
+public:
+    using Vector2u = Vector<uint32_t, 2>;
+
+    /// Function that is applied to the texels of every tile after loading it
+    using TileTransform = std::function<void(float *data, size_t texel_count)>;
+
+    /**
+     * \brief Open a tiled image
+     *
+     * \param filename
+     *    Path to a file in the native tiled format (see \ref write())
+     *
+     * \param transform
+     *    Optional transformation that is applied to every tile after it has
+     *    been loaded (e.g. to convert texels into another representation).
+     *    Tiles of different \c TiledImage instances are never shared, even
+     *    when they refer to the same file.
+     */
+    TiledImage(const fs::path &filename, const TileTransform &transform = {});
+
+    /**
+     * \brief Convert a bitmap into the native tiled format
+     *
+     * The bitmap is converted into a linear single precision luminance or RGB
+     * image (alpha channels are discarded), and its MIP map is computed using
+     * a box filter.
+     *
+     * \param bitmap
+     *    Bitmap to be converted
+     *
+     * \param filename
+     *    Destination path
+     *
+     * \param tile_size
+     *    Width and height of a tile in texels
+     *
+     * \param bc
+     *    Boundary condition used while downsampling the MIP levels
+     */
+    static void write(const Bitmap *bitmap, const fs::path &filename,
+                      uint32_t tile_size = 64,
+                      FilterBoundaryCondition bc = FilterBoundaryCondition::Repeat);
+
+    /// Return the resolution of the finest level
+    const Vector2u &size() const { return m_size; }
+
+    /// Return the resolution of the given MIP level
+    Vector2u level_size(uint32_t level) const {
+        return max(Vector2u(m_size.x() >> level, m_size.y() >> level), 1u);
+    }
+
+    /// Return the number of MIP levels
+    uint32_t level_count() const { return m_level_count; }
+
+    /// Return the number of channels (1 or 3)
+    uint32_t channel_count() const { return m_channel_count; }
+
+    /// Return the width and height of a tile in texels
+    uint32_t tile_size() const { return m_tile_size; }
+
+    /// Return the number of bytes occupied by a tile in memory
+    size_t tile_bytes() const {
+        return sizeof(float) * m_tile_size * m_tile_size * m_channel_count;
+    }
+
+    /// Return a unique identifier of this image within the texture cache
+    uint32_t id() const { return m_id; }
+
+    /// Return the path of the underlying file
+    const fs::path &filename() const { return m_filename; }
+
+    /**
+     * \brief Look up a texel through the texture cache
+     *
+     * The coordinates must lie within the resolution of the given level.
+     * Returns a pointer to \ref channel_count() values, which remains valid
+     * until the calling thread performs its next lookup.
+     */
+    const float *texel(uint32_t level, uint32_t x, uint32_t y) const;
+
+    /// Read the specified tile from disk (used by the texture cache upon a miss)
+    void read_tile(uint32_t level, uint32_t tile_x, uint32_t tile_y, float *dest) const;
+
+    /// Return a human-readable representation
+    std::string to_string() const override;
+
+    MTS_DECLARE_CLASS()
+protected:
+    virtual ~TiledImage();
+
+private:
+    fs::path m_filename;
+    ref<FileStream> m_stream;
+    mutable std::mutex m_mutex;
+    TileTransform m_transform;
+    Vector2u m_size;
+    uint32_t m_channel_count;
+    uint32_t m_tile_size;
+    uint32_t m_level_count;
+    uint32_t m_id;
+    /// Index of the first tile of each level, and number of tiles per row
+    std::vector<uint64_t> m_level_tile;
+    std::vector<uint32_t> m_level_tiles_x;
+};
+
+/**
+ * \brief Shared and thread-safe cache of image tiles with a memory budget
+ *
+ * Tiles of \ref TiledImage instances are loaded on demand and evicted in
+ * least-recently-used order once the memory budget is exceeded.
+ *
+ * Lookups first consult a small direct-mapped cache that is local to the
+ * calling thread and requires neither locks nor atomic read-modify-write
+ * operations. Misses fall back to the shared cache, which is split into
+ * independently locked shards. Tiles are reference counted, hence evicting a
+ * tile never invalidates data that is still referenced by a thread-local
+ * cache. This means that the actual memory usage may exceed the budget by a
+ * few tiles per thread.
+ *
+ * The hit rates are reported along with the profiler output.
+ */
+class MTS_EXPORT_CORE TextureCache : public Object {
+public:
+    /// Cache statistics
+    struct Statistics {
+        /// Lookups served by the thread-local caches
+        uint64_t local_hits = 0;
+        /// Lookups served by the shared cache
+        uint64_t shared_hits = 0;
+        /// Lookups that required loading a tile from disk
+        uint64_t misses = 0;
+        /// Number of tiles evicted from the shared cache
+        uint64_t evictions = 0;
+    };
+
+    /// Return the global texture cache
+    static TextureCache *instance();
+
+    /// Set the memory budget of the cache in bytes (default: 1 GiB)
+    void set_budget(size_t budget);
+
+    /// Return the memory budget of the cache in bytes
+    size_t budget() const { return m_budget; }
+
+    /// Return the number of bytes occupied by tiles in the shared cache
+    size_t memory_usage() const { return m_memory_usage; }
+
+    /**
+     * \brief Return a pointer to the texels of a tile
+     *
+     * The pointer remains valid until the calling thread performs its next
+     * lookup.
+     */
+    const float *tile(const TiledImage *image, uint32_t level,
+                      uint32_t tile_x, uint32_t tile_y);
+
+    /// Release all tiles (e.g. after an image was modified on disk)
+    void clear();
+
+    /// Return the statistics accumulated since the last call to \ref reset_statistics()
+    Statistics statistics() const;
+
+    /// Reset the cache statistics
+    void reset_statistics();
+
+    /// Log the cache statistics (invoked by the profiler, if the cache was used)
+    static void print_statistics();
+
+    /// Return a human-readable representation
+    std::string to_string() const override;
+
+    MTS_DECLARE_CLASS()
+protected:
+    TextureCache();
+    virtual ~TextureCache();
+
+private:
+    struct TextureCachePrivate;
+    std::unique_ptr<TextureCachePrivate> d;
+    size_t m_budget;
+    std::atomic<size_t> m_memory_usage;
+};
+
+NAMESPACE_END(mitsuba)
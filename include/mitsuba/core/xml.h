@@ -29,16 +29,25 @@ using ParameterList = std::vector<std::pair<std::string, std::string>>;
  * \param update_scene
  *     When Mitsuba updates scene to a newer version, should the
  *     updated XML file be written back to disk?
+ *
+ * \param deduplicate
+ *     Share a single instance between textures and BSDFs that are declared
+ *     multiple times with identical plugin types and properties (including
+ *     identical nested objects). This reduces the loading time and memory
+ *     usage of scenes with many repeated materials. Note that shared objects
+ *     are also shared when modifying the scene parameters.
  */
 extern MTS_EXPORT_CORE ref<Object> load_file(const fs::path &path,
                                              const std::string &variant,
                                              ParameterList parameters = ParameterList(),
-                                             bool update_scene = false);
+                                             bool update_scene = false,
+                                             bool deduplicate = false);
 
 /// Load a Mitsuba scene from an XML string
 extern MTS_EXPORT_CORE ref<Object> load_string(const std::string &string,
                                                const std::string &variant,
-                                               ParameterList parameters = ParameterList());
+                                               ParameterList parameters = ParameterList(),
+                                               bool deduplicate = false);
 
 
 
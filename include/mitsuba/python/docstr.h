@@ -623,6 +623,14 @@ sampling failed.)doc";
 
 static const char *__doc_mitsuba_BSDF_to_string = R"doc(Return a human-readable representation of the BSDF)doc";
 
+static const char *__doc_mitsuba_BSDF_update_differentials_flag =
+R"doc(Set BSDFFlags::NeedsDifferentials if a texture referenced by this BSDF
+(or by one of its nested BSDFs) filters its lookups using texture-
+space differentials.
+
+This is invoked by the shape that the BSDF is attached to, once the
+BSDF and all of its children have been fully constructed.)doc";
+
 static const char *__doc_mitsuba_Bitmap =
 R"doc(General-purpose bitmap class with read and write support for several
 common file formats.
@@ -1964,6 +1972,12 @@ static const char *__doc_mitsuba_Emitter_is_environment = R"doc(Is this an envir
 
 static const char *__doc_mitsuba_Emitter_m_flags = R"doc(Combined flags for all properties of this emitter.)doc";
 
+static const char *__doc_mitsuba_Emitter_m_scene_index = R"doc(Index within the list of emitters of the scene (used for emitter selection))doc";
+
+static const char *__doc_mitsuba_Emitter_scene_index = R"doc(Return the index of this emitter within the list of emitters of the scene)doc";
+
+static const char *__doc_mitsuba_Emitter_set_scene_index = R"doc(Set the index of this emitter within the list of emitters of the scene)doc";
+
 static const char *__doc_mitsuba_Endpoint =
 R"doc(Endpoint: an abstract interface to light sources and sensors
 
@@ -3251,6 +3265,20 @@ static const char *__doc_mitsuba_Medium_Medium_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_Medium_class = R"doc()doc";
 
+static const char *__doc_mitsuba_Medium_eval_majorant_grid = R"doc(Look up the majorant grid cell containing the point ``p``)doc";
+
+static const char *__doc_mitsuba_Medium_eval_ratio_tracking_weight =
+R"doc(Compute the ratio tracking weight of an interaction returned by
+sample_ratio_tracking()
+
+Parameter ``maxt``:
+    Distance at which the estimate ends (e.g. a surface)
+
+Returns:
+    The transmittance divided by the PDF of the sampled distance (see
+    eval_tr_weight()), multiplied by ``sigma_n`` if a collision
+    occurred before ``maxt``.)doc";
+
 static const char *__doc_mitsuba_Medium_eval_tr_and_pdf =
 R"doc(Compute the transmittance and PDF
 
@@ -3266,12 +3294,28 @@ depend on the wavelength.
 Returns:
     This method returns a pair of (Transmittance, PDF).)doc";
 
+static const char *__doc_mitsuba_Medium_eval_tr_weight =
+R"doc(Compute the throughput weight of a free-flight distance sampled by
+sample_interaction()
+
+This is the transmittance divided by the PDF returned by
+eval_tr_and_pdf(). When ``spectral_mis`` is ``False``, the PDF is the
+one of channel ``channel``. Otherwise, the caller is expected to draw
+``channel`` uniformly at random for every sampled distance, and the
+PDF is the average over all channels (i.e. the one-sample balance
+heuristic over channels or wavelengths). This bounds the weights of
+strongly chromatic media.)doc";
+
 static const char *__doc_mitsuba_Medium_get_combined_extinction = R"doc(Returns the medium's majorant used for delta tracking)doc";
 
 static const char *__doc_mitsuba_Medium_get_scattering_coefficients =
 R"doc(Returns the medium coefficients Sigma_s, Sigma_n and Sigma_t evaluated
 at a given MediumInteraction mi)doc";
 
+static const char *__doc_mitsuba_Medium_has_control_extinction = R"doc(Returns whether the extinction has a known homogeneous control component)doc";
+
+static const char *__doc_mitsuba_Medium_has_majorant_grid = R"doc(Returns whether free-flight sampling uses a spatially varying majorant grid)doc";
+
 static const char *__doc_mitsuba_Medium_has_spectral_extinction = R"doc(Returns whether this medium has a spectrally varying extinction)doc";
 
 static const char *__doc_mitsuba_Medium_id = R"doc(Return a string identifier)doc";
@@ -3308,6 +3352,28 @@ static const char *__doc_mitsuba_Medium_operator_new_4 = R"doc()doc";
 
 static const char *__doc_mitsuba_Medium_phase_function = R"doc(Return the phase function of this medium)doc";
 
+static const char *__doc_mitsuba_Medium_sample_collision =
+R"doc(Decide whether a valid interaction returned by sample_interaction()
+is a real or a null collision
+
+Parameter ``mi``:
+    Sampled medium interaction
+
+Parameter ``sample``:
+    A uniformly distributed random sample
+
+Parameter ``channel``:
+    Channel used to decide (ignored with spectral MIS)
+
+Parameter ``spectral_mis``:
+    Draw the channel from ``sample`` and weight the decision using the
+    average over all channels
+
+Returns:
+    A pair containing a mask of real collisions and the throughput
+    weight of the decision: ``sigma_s`` or ``sigma_n`` divided by the
+    probability of the chosen type of collision.)doc";
+
 static const char *__doc_mitsuba_Medium_sample_interaction =
 R"doc(Sample a free-flight distance in the medium.
 
@@ -3324,13 +3390,26 @@ Parameter ``sample``:
 
 Parameter ``channel``:
     The channel according to which we will sample the free-flight
-    distance. This argument is only used when rendering in RGB modes.
+    distance. In spectral modes, this is the index of the wavelength
+    (0 corresponds to the hero wavelength).
 
 Returns:
     This method returns a MediumInteraction. The MediumInteraction
     will always be valid, except if the ray missed the Medium's
     bounding box.)doc";
 
+static const char *__doc_mitsuba_Medium_sample_ratio_tracking =
+R"doc(Sample a tentative collision for estimating the transmittance along a
+ray using ratio tracking
+
+Without a control component, this is equivalent to
+sample_interaction(). Otherwise, decomposition tracking is used: only
+collisions with the residual component are sampled, and
+``combined_extinction`` stores the residual majorant. The
+transmittance of the homogeneous control component is accounted for
+analytically by eval_ratio_tracking_weight(), which reduces both the
+number of density lookups and the variance of the estimate.)doc";
+
 static const char *__doc_mitsuba_Medium_to_string = R"doc(Return a human-readable representation of the Medium)doc";
 
 static const char *__doc_mitsuba_Medium_use_emitter_sampling = R"doc(Returns whether this specific medium instance uses emitter sampling)doc";
@@ -3527,6 +3606,17 @@ since it uses a mutex.)doc";
 
 static const char *__doc_mitsuba_Mesh_class = R"doc()doc";
 
+static const char *__doc_mitsuba_Mesh_compact_vertex_data =
+R"doc(Convert the vertex data into the compact storage format
+
+Vertex normals are octahedral-encoded into a single 32-bit word,
+texture coordinates are quantized to 16 bit per component relative to
+their bounding box, and positions are quantized to 21/21/22 bit
+relative to the bounds of clusters of 256 consecutive vertices. The
+full-precision buffers are released afterwards, and the mesh can no
+longer be modified. Should be called by mesh loaders once all vertex
+data (including computed normals) is available.)doc";
+
 static const char *__doc_mitsuba_Mesh_compute_surface_interaction = R"doc()doc";
 
 static const char *__doc_mitsuba_Mesh_ensure_pmf_built = R"doc()doc";
@@ -3551,6 +3641,8 @@ static const char *__doc_mitsuba_Mesh_faces_buffer = R"doc(Return face indices b
 
 static const char *__doc_mitsuba_Mesh_faces_buffer_2 = R"doc(Const variant of faces_buffer.)doc";
 
+static const char *__doc_mitsuba_Mesh_has_compact_storage = R"doc(Does this mesh store its vertex data in the quantized compact format?)doc";
+
 static const char *__doc_mitsuba_Mesh_has_vertex_normals = R"doc(Does this mesh have per-vertex normals?)doc";
 
 static const char *__doc_mitsuba_Mesh_has_vertex_texcoords = R"doc(Does this mesh have per-vertex texture coordinates?)doc";
@@ -5051,6 +5143,26 @@ the wavefront.)doc";
 
 static const char *__doc_mitsuba_Sampler_seeded = R"doc(Return whether the sampler was seeded)doc";
 
+static const char *__doc_mitsuba_Sampler_set_pixel =
+R"doc(Set the pixel that subsequently generated samples belong to
+
+Rendering algorithms call this function before generating the
+components of a sample. Samplers that correlate the samples of
+neighboring pixels (e.g. to distribute the error as blue noise in
+screen space) rely on it, while other samplers simply ignore it.
+
+In packet variants, ``pixel`` holds the pixel of every lane.)doc";
+
+static const char *__doc_mitsuba_Sampler_set_sample_index =
+R"doc(Set the index of the sample within its pixel for every lane
+
+Packet rendering algorithms process several samples of the same pixel
+in one packet without calling ``advance`` in between. They call this
+function before generating the components of a sample, so that
+samplers that rely on set_pixel() can assign a different sample of
+the pixel to every lane. The index is taken modulo the sample count.
+Other samplers simply ignore it.)doc";
+
 static const char *__doc_mitsuba_Sampler_set_samples_per_wavefront = R"doc(Set the number of samples per pass in wavefront modes (default is 1))doc";
 
 static const char *__doc_mitsuba_Sampler_wavefront_size = R"doc(Return the size of the wavefront (or 0, if not seeded))doc";
@@ -5178,6 +5290,8 @@ static const char *__doc_mitsuba_Scene_bbox = R"doc(Return a bounding box surrou
 
 static const char *__doc_mitsuba_Scene_class = R"doc()doc";
 
+static const char *__doc_mitsuba_Scene_emitter_selection = R"doc(Return the strategy used to select emitters)doc";
+
 static const char *__doc_mitsuba_Scene_emitters = R"doc(Return the list of emitters)doc";
 
 static const char *__doc_mitsuba_Scene_emitters_2 = R"doc(Return the list of emitters (const version))doc";
@@ -5206,8 +5320,18 @@ static const char *__doc_mitsuba_Scene_m_shapes = R"doc()doc";
 
 static const char *__doc_mitsuba_Scene_m_shapes_grad_enabled = R"doc()doc";
 
+static const char *__doc_mitsuba_Scene_occlusion_cache_statistics =
+R"doc(Return the statistics of the occlusion cache
+
+Every thread reports its counts in batches, hence the statistics may
+lag behind by a few hundred shadow rays per thread.)doc";
+
 static const char *__doc_mitsuba_Scene_parameters_changed = R"doc(Update internal state following a parameter update)doc";
 
+static const char *__doc_mitsuba_Scene_pdf_emitter =
+R"doc(Evaluate the probability of selecting the emitter with the given index
+in sample_emitter())doc";
+
 static const char *__doc_mitsuba_Scene_pdf_emitter_direction =
 R"doc(Evaluate the probability density of the sample_emitter_direct()
 technique given an filled-in DirectionSample record.
@@ -5275,6 +5399,22 @@ static const char *__doc_mitsuba_Scene_ray_test_cpu = R"doc(Trace a shadow ray)d
 
 static const char *__doc_mitsuba_Scene_ray_test_gpu = R"doc()doc";
 
+static const char *__doc_mitsuba_Scene_reset_occlusion_cache_statistics = R"doc(Reset the statistics of the occlusion cache)doc";
+
+static const char *__doc_mitsuba_Scene_sample_emitter =
+R"doc(Select an emitter for the given reference point
+
+Parameter ``ref``:
+    A reference point somewhere within the scene
+
+Parameter ``sample``:
+    A uniformly distributed sample on the interval [0, 1], which is re-
+    scaled so that it can be reused as a uniform variate
+
+Returns:
+    The index of the emitter within emitters(), and the probability of
+    having selected it)doc";
+
 static const char *__doc_mitsuba_Scene_sample_emitter_direction =
 R"doc(Direct illumination sampling routine
 
@@ -7046,6 +7186,52 @@ The spectrum can be evaluated at arbitrary (continuous) wavelengths,
 though the underlying function it is not required to be smooth or even
 continuous.)doc";
 
+static const char *__doc_mitsuba_TextureCache =
+R"doc(Shared and thread-safe cache of image tiles with a memory budget
+
+Tiles of TiledImage instances are loaded on demand and evicted in
+least-recently-used order once the memory budget is exceeded.
+
+Lookups first consult a small direct-mapped cache that is local to the
+calling thread and requires neither locks nor atomic read-modify-write
+operations. Misses fall back to the shared cache, which is split into
+independently locked shards. Tiles are reference counted, hence
+evicting a tile never invalidates data that is still referenced by a
+thread-local cache. This means that the actual memory usage may exceed
+the budget by a few tiles per thread.
+
+The hit rates are reported along with the profiler output.)doc";
+
+static const char *__doc_mitsuba_TextureCache_Statistics = R"doc(Cache statistics)doc";
+
+static const char *__doc_mitsuba_TextureCache_TextureCache = R"doc()doc";
+
+static const char *__doc_mitsuba_TextureCache_budget = R"doc(Return the memory budget of the cache in bytes)doc";
+
+static const char *__doc_mitsuba_TextureCache_class = R"doc()doc";
+
+static const char *__doc_mitsuba_TextureCache_clear = R"doc(Release all tiles (e.g. after an image was modified on disk))doc";
+
+static const char *__doc_mitsuba_TextureCache_instance = R"doc(Return the global texture cache)doc";
+
+static const char *__doc_mitsuba_TextureCache_memory_usage = R"doc(Return the number of bytes occupied by tiles in the shared cache)doc";
+
+static const char *__doc_mitsuba_TextureCache_print_statistics = R"doc(Log the cache statistics (invoked by the profiler, if the cache was used))doc";
+
+static const char *__doc_mitsuba_TextureCache_reset_statistics = R"doc(Reset the cache statistics)doc";
+
+static const char *__doc_mitsuba_TextureCache_set_budget = R"doc(Set the memory budget of the cache in bytes (default: 1 GiB))doc";
+
+static const char *__doc_mitsuba_TextureCache_statistics = R"doc(Return the statistics accumulated since the last call to reset_statistics())doc";
+
+static const char *__doc_mitsuba_TextureCache_tile =
+R"doc(Return a pointer to the texels of a tile
+
+The pointer remains valid until the calling thread performs its next
+lookup.)doc";
+
+static const char *__doc_mitsuba_TextureCache_to_string = R"doc(Return a human-readable representation)doc";
+
 static const char *__doc_mitsuba_Texture_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_Texture_3 = R"doc()doc";
@@ -7122,6 +7308,13 @@ default implementation throws an exception.
 Even if the operation is provided, it may only return an
 approximation.)doc";
 
+static const char *__doc_mitsuba_Texture_needs_differentials =
+R"doc(Does this texture filter its lookups using the texture-space
+differentials ``si.duv_dx`` and ``si.duv_dy``?
+
+BSDFs referencing such a texture request these differentials from the
+surface interaction (see BSDF::update_differentials_flag()).)doc";
+
 static const char *__doc_mitsuba_Texture_pdf_position = R"doc(Returns the probability per unit area of sample_position())doc";
 
 static const char *__doc_mitsuba_Texture_pdf_spectrum =
@@ -7396,6 +7589,82 @@ static const char *__doc_mitsuba_Thread_unregister_external_thread = R"doc(Unreg
 
 static const char *__doc_mitsuba_Thread_yield = R"doc(Yield to another processor)doc";
 
+static const char *__doc_mitsuba_TiledImage =
+R"doc(Image stored in Mitsuba's native tiled and MIP-mapped format
+
+The file starts with a header consisting of the ASCII bytes 'M', 'T',
+'X' and a version byte, followed by the width, height, channel count,
+tile size and level count of the image as 32-bit integers. The tiles
+of all MIP levels follow in order of increasing level, and in row-
+major order within each level. Every tile stores ``tile_size *
+tile_size * channel_count`` single precision values, i.e. tiles along
+the right and bottom border are padded by replicating the last row and
+column.
+
+This class does not keep the image in memory. Instead, tiles are
+loaded on demand through the TextureCache, which bounds the total
+memory usage of all tiled images.)doc";
+
+static const char *__doc_mitsuba_TiledImage_TiledImage =
+R"doc(Open a tiled image
+
+Parameter ``filename``:
+    Path to a file in the native tiled format (see write())
+
+Parameter ``transform``:
+    Optional transformation that is applied to every tile after it
+    has been loaded (e.g. to convert texels into another
+    representation). Tiles of different TiledImage instances are
+    never shared, even when they refer to the same file.)doc";
+
+static const char *__doc_mitsuba_TiledImage_channel_count = R"doc(Return the number of channels (1 or 3))doc";
+
+static const char *__doc_mitsuba_TiledImage_class = R"doc()doc";
+
+static const char *__doc_mitsuba_TiledImage_filename = R"doc(Return the path of the underlying file)doc";
+
+static const char *__doc_mitsuba_TiledImage_id = R"doc(Return a unique identifier of this image within the texture cache)doc";
+
+static const char *__doc_mitsuba_TiledImage_level_count = R"doc(Return the number of MIP levels)doc";
+
+static const char *__doc_mitsuba_TiledImage_level_size = R"doc(Return the resolution of the given MIP level)doc";
+
+static const char *__doc_mitsuba_TiledImage_read_tile = R"doc(Read the specified tile from disk (used by the texture cache upon a miss))doc";
+
+static const char *__doc_mitsuba_TiledImage_size = R"doc(Return the resolution of the finest level)doc";
+
+static const char *__doc_mitsuba_TiledImage_texel =
+R"doc(Look up a texel through the texture cache
+
+The coordinates must lie within the resolution of the given level.
+Returns a pointer to channel_count() values, which remains valid until
+the calling thread performs its next lookup.)doc";
+
+static const char *__doc_mitsuba_TiledImage_tile_bytes = R"doc(Return the number of bytes occupied by a tile in memory)doc";
+
+static const char *__doc_mitsuba_TiledImage_tile_size = R"doc(Return the width and height of a tile in texels)doc";
+
+static const char *__doc_mitsuba_TiledImage_to_string = R"doc(Return a human-readable representation)doc";
+
+static const char *__doc_mitsuba_TiledImage_write =
+R"doc(Convert a bitmap into the native tiled format
+
+The bitmap is converted into a linear single precision luminance or
+RGB image (alpha channels are discarded), and its MIP map is computed
+using a box filter.
+
+Parameter ``bitmap``:
+    Bitmap to be converted
+
+Parameter ``filename``:
+    Destination path
+
+Parameter ``tile_size``:
+    Width and height of a tile in texels
+
+Parameter ``bc``:
+    Boundary condition used while downsampling the MIP levels)doc";
+
 static const char *__doc_mitsuba_Timer = R"doc()doc";
 
 static const char *__doc_mitsuba_Timer_Timer = R"doc()doc";
@@ -7643,6 +7912,17 @@ static const char *__doc_mitsuba_Volume_m_world_to_local = R"doc(Used to bring p
 
 static const char *__doc_mitsuba_Volume_max = R"doc(Returns the maximum value of the texture over all dimensions.)doc";
 
+static const char *__doc_mitsuba_Volume_max_per_cell =
+R"doc(Conservatively bound the texture's values over the cells of a regular
+grid that subdivides the given world-space bounding box.
+
+The returned array has <tt>hprod(resolution)</tt> entries in x-major
+order. Each entry bounds the values that eval() can take anywhere
+inside the corresponding cell, which makes the result suitable as a
+spatially varying majorant for delta tracking.
+
+The default implementation fills the entire grid with max().)doc";
+
 static const char *__doc_mitsuba_Volume_resolution =
 R"doc(Returns the resolution of the volume, assuming that it is based on a
 discrete representation.
@@ -9964,7 +10244,14 @@ Parameter ``variant``:
 
 Parameter ``update_scene``:
     When Mitsuba updates scene to a newer version, should the updated
-    XML file be written back to disk?)doc";
+    XML file be written back to disk?
+
+Parameter ``deduplicate``:
+    Share a single instance between textures and BSDFs that are
+    declared multiple times with identical plugin types and properties
+    (including identical nested objects). This reduces the loading time
+    and memory usage of scenes with many repeated materials. Note that
+    shared objects are also shared when modifying the scene parameters.)doc";
 
 static const char *__doc_mitsuba_xml_load_string = R"doc(Load a Mitsuba scene from an XML string)doc";
 
@@ -452,6 +452,16 @@ public:
         return m_components.size();
     }
 
+    /**
+     * \brief Set \ref BSDFFlags::NeedsDifferentials if a texture referenced
+     * by this BSDF (or by one of its nested BSDFs) filters its lookups using
+     * texture-space differentials.
+     *
+     * This is invoked by the shape that the BSDF is attached to, once the BSDF
+     * and all of its children have been fully constructed.
+     */
+    void update_differentials_flag();
+
     /// Return a string identifier
     std::string id() const override;
 
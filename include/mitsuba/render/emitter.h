@@ -70,6 +70,12 @@ public:
     /// Flags for all components combined.
     uint32_t flags(mask_t<Float> /*active*/ = true) const { return m_flags; }
 
+    /// Return the index of this emitter within the list of emitters of the scene
+    uint32_t scene_index() const { return m_scene_index; }
+
+    /// Set the index of this emitter within the list of emitters of the scene
+    void set_scene_index(uint32_t index) { m_scene_index = index; }
+
 
     ENOKI_CALL_SUPPORT_FRIEND()
     MTS_DECLARE_CLASS()
@@ -81,6 +87,9 @@ protected:
 protected:
     /// Combined flags for all properties of this emitter.
     uint32_t m_flags;
+
+    /// Index within the list of emitters of the scene (used for emitter selection)
+    uint32_t m_scene_index = 0;
 };
 
 MTS_EXTERN_CLASS_RENDER(Emitter)
@@ -98,6 +107,7 @@ ENOKI_CALL_SUPPORT_TEMPLATE_BEGIN(mitsuba::Emitter)
     ENOKI_CALL_SUPPORT_METHOD(pdf_direction)
     ENOKI_CALL_SUPPORT_METHOD(is_environment)
     ENOKI_CALL_SUPPORT_GETTER(flags, m_flags)
+    ENOKI_CALL_SUPPORT_GETTER(scene_index, m_scene_index)
 ENOKI_CALL_SUPPORT_TEMPLATE_END(mitsuba::Emitter)
 
 //! @}
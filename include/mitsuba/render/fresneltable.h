@@ -0,0 +1,231 @@
+#pragma once
+
+#include <mitsuba/render/fresnel.h>
+#include <mitsuba/render/interaction.h>
+#include <vector>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Precomputed tables of the unpolarized Fresnel reflectance
+ *
+ * The Fresnel equations require a number of divisions and square roots
+ * that are evaluated in every sampling and evaluation routine of the
+ * dielectric and conductor BSDFs (in spectral variants, once per
+ * wavelength in the case of conductors). When the relative index of
+ * refraction of a material is constant, the reflectance only depends on the
+ * cosine of the incident angle, and it can be replaced with a linearly
+ * interpolated lookup into a 1D table.
+ *
+ * A table consists of one or more rows that are tabulated at regularly spaced
+ * cosines in <tt>[0, 1]</tt>. Dielectrics use a single row. Conductors use
+ * one row per color channel, or one row per wavelength on a regular grid
+ * in spectral variants, which is linearly interpolated as well.
+ */
+template <typename Float> class FresnelTable {
+public:
+    using ScalarFloat   = scalar_t<Float>;
+    using ScalarComplex = Complex<ScalarFloat>;
+    using UInt32        = uint32_array_t<Float>;
+    using Mask          = mask_t<Float>;
+
+    /// Spacing of the tabulated wavelengths in spectral variants (in nanometers)
+    static constexpr ScalarFloat WavelengthSpacing = 5.f;
+
+    /// Create an empty table
+    FresnelTable() = default;
+
+    /**
+     * \brief Tabulate the reflectance of a dielectric interface
+     *
+     * The reflectance of an interface is reciprocal, i.e. it does not change
+     * when the incident and transmitted direction are exchanged. The table
+     * thus only stores the reflectance for light arriving from the side of
+     * lower density, and the reflectance for light arriving from the other
+     * side is looked up using the cosine of the transmitted direction. This
+     * avoids having to interpolate the reflectance across the critical
+     * angle, where it is not differentiable.
+     *
+     * \param eta
+     *      Relative index of refraction of the interface
+     */
+    static FresnelTable dielectric(ScalarFloat eta, size_t resolution = 512) {
+        ScalarFloat eta_rare = eta > 1.f ? eta : 1.f / eta;
+
+        FresnelTable table(1, resolution);
+        table.m_eta = eta;
+        table.tabulate([&](size_t, ScalarFloat cos_theta) {
+            return std::get<0>(fresnel(cos_theta, eta_rare));
+        });
+        return table;
+    }
+
+    /**
+     * \brief Tabulate the reflectance of a conductor for a list of complex
+     * relative indices of refraction (one per row)
+     */
+    static FresnelTable conductor(const std::vector<ScalarComplex> &eta,
+                                  size_t resolution = 128) {
+        FresnelTable table(eta.size(), resolution);
+        table.tabulate([&](size_t row, ScalarFloat cos_theta) {
+            return fresnel_conductor(cos_theta, eta[row]);
+        });
+        return table;
+    }
+
+    /**
+     * \brief Tabulate the reflectance of a conductor whose index of
+     * refraction is given by a pair of spatially constant textures
+     *
+     * In spectral variants, the textures are evaluated on a regular grid of
+     * wavelengths spanning the visible range. Otherwise, the table contains
+     * one row per color channel.
+     */
+    template <typename Spectrum, typename Texture>
+    static FresnelTable conductor(const Texture *eta, const Texture *k,
+                                  size_t resolution = 128) {
+        using UnpolarizedSpectrum  = depolarize_t<Spectrum>;
+        using SurfaceInteraction3f = SurfaceInteraction<Float, Spectrum>;
+        constexpr size_t Channels  = array_size_v<UnpolarizedSpectrum>;
+
+        SurfaceInteraction3f si = zero<SurfaceInteraction3f>();
+        std::vector<ScalarComplex> values;
+
+        if constexpr (is_spectral_v<UnpolarizedSpectrum>) {
+            size_t rows = size_t((MTS_WAVELENGTH_MAX - MTS_WAVELENGTH_MIN) /
+                                 WavelengthSpacing) + 1;
+            for (size_t i = 0; i < rows; i += Channels) {
+                for (size_t j = 0; j < Channels; ++j)
+                    si.wavelengths[j] = MTS_WAVELENGTH_MIN +
+                        std::min(i + j, rows - 1) * WavelengthSpacing;
+
+                UnpolarizedSpectrum eta_v = eta->eval(si),
+                                    k_v   = k->eval(si);
+                for (size_t j = 0; j < Channels && i + j < rows; ++j)
+                    values.emplace_back(hmax(eta_v[j]), hmax(k_v[j]));
+            }
+        } else {
+            UnpolarizedSpectrum eta_v = eta->eval(si),
+                                k_v   = k->eval(si);
+            for (size_t j = 0; j < Channels; ++j)
+                values.emplace_back(hmax(eta_v[j]), hmax(k_v[j]));
+        }
+
+        return conductor(values, resolution);
+    }
+
+    /// Was the table initialized?
+    bool empty() const { return m_rows == 0; }
+
+    /**
+     * \brief Tabulated counterpart of \ref fresnel()
+     *
+     * Only the reflection coefficient is looked up, the remaining entries of
+     * the returned tuple are computed exactly.
+     */
+    std::tuple<Float, Float, Float, Float> eval_dielectric(const Float &cos_theta_i,
+                                                           Mask active = true) const {
+        auto outside_mask = cos_theta_i >= 0.f;
+
+        ScalarFloat rcp_eta = 1.f / m_eta;
+        Float eta_it = select(outside_mask, Float(m_eta), Float(rcp_eta)),
+              eta_ti = select(outside_mask, Float(rcp_eta), Float(m_eta));
+
+        Float cos_theta_t_sqr =
+            fnmadd(fnmadd(cos_theta_i, cos_theta_i, 1.f), eta_ti * eta_ti, 1.f);
+
+        Float cos_theta_i_abs = abs(cos_theta_i);
+        Float cos_theta_t_abs = safe_sqrt(cos_theta_t_sqr);
+
+        // Look up the table using the cosine on the side of lower density
+        Mask from_rare = m_eta > 1.f ? outside_mask : !outside_mask;
+        Float r = lookup(UInt32(0), select(from_rare, cos_theta_i_abs, cos_theta_t_abs), active);
+
+        // Total internal reflection
+        masked(r, cos_theta_t_sqr < 0.f) = 1.f;
+
+        Float cos_theta_t = mulsign_neg(cos_theta_t_abs, cos_theta_i);
+
+        return { r, cos_theta_t, eta_it, eta_ti };
+    }
+
+    /**
+     * \brief Tabulated counterpart of \ref fresnel_conductor()
+     *
+     * \param wavelengths
+     *      Wavelengths of the spectrum, only used in spectral variants.
+     */
+    template <typename UnpolarizedSpectrum>
+    UnpolarizedSpectrum eval_conductor(const Float &cos_theta_i,
+                                       const wavelength_t<UnpolarizedSpectrum> &wavelengths,
+                                       Mask active = true) const {
+        UnpolarizedSpectrum result;
+
+        if constexpr (is_spectral_v<UnpolarizedSpectrum>) {
+            ScalarFloat scale = 1.f / WavelengthSpacing;
+            for (size_t i = 0; i < array_size_v<UnpolarizedSpectrum>; ++i) {
+                Float x = clamp((wavelengths[i] - MTS_WAVELENGTH_MIN) * scale,
+                                0.f, ScalarFloat(m_rows - 1));
+                UInt32 row = min(UInt32(x), uint32_t(m_rows - 2));
+                Float w = x - Float(row);
+
+                Float r0 = lookup(row, cos_theta_i, active),
+                      r1 = lookup(row + 1u, cos_theta_i, active);
+                result[i] = fmadd(w, r1 - r0, r0);
+            }
+        } else {
+            ENOKI_MARK_USED(wavelengths);
+            for (size_t i = 0; i < array_size_v<UnpolarizedSpectrum>; ++i)
+                result[i] = lookup(UInt32(uint32_t(i)), cos_theta_i, active);
+        }
+
+        return result;
+    }
+
+    std::string to_string() const {
+        std::ostringstream oss;
+        oss << "FresnelTable[rows = " << m_rows << ", resolution = " << m_resolution << "]";
+        return oss.str();
+    }
+
+private:
+    FresnelTable(size_t rows, size_t resolution) : m_rows(rows), m_resolution(resolution) {
+        if (resolution < 2)
+            Throw("Fresnel tables require a resolution of at least 2!");
+        if (rows == 0)
+            Throw("Fresnel tables require at least one row!");
+    }
+
+    /// Fill the table by evaluating <tt>func(row, cos_theta)</tt>
+    template <typename Func> void tabulate(Func func) {
+        std::unique_ptr<ScalarFloat[]> data(new ScalarFloat[m_rows * m_resolution]);
+        for (size_t i = 0; i < m_rows; ++i) {
+            for (size_t j = 0; j < m_resolution; ++j) {
+                ScalarFloat cos_theta = ScalarFloat(j) / ScalarFloat(m_resolution - 1);
+                data[i * m_resolution + j] = func(i, cos_theta);
+            }
+        }
+        m_data = DynamicBuffer<Float>::copy(data.get(), m_rows * m_resolution);
+    }
+
+    /// Linearly interpolate a row of the table
+    Float lookup(const UInt32 &row, const Float &cos_theta, Mask active) const {
+        Float x = clamp(cos_theta, 0.f, 1.f) * ScalarFloat(m_resolution - 1);
+        UInt32 i = min(UInt32(x), uint32_t(m_resolution - 2));
+        Float w = x - Float(i);
+
+        UInt32 index = row * uint32_t(m_resolution) + i;
+        Float v0 = gather<Float>(m_data, index, active),
+              v1 = gather<Float>(m_data, index + 1u, active);
+
+        return fmadd(w, v1 - v0, v0);
+    }
+
+private:
+    DynamicBuffer<Float> m_data;
+    size_t m_rows = 0;
+    size_t m_resolution = 0;
+    ScalarFloat m_eta = 1.f;
+};
+
+NAMESPACE_END(mitsuba)
@@ -2146,8 +2146,11 @@ public:
                         intersect_prim<ShadowRay>(prim_index, ray, true);
 
                     if (unlikely(prim_pi.is_valid())) {
-                        if constexpr (ShadowRay)
+                        if constexpr (ShadowRay) {
+                            // Report the blocking primitive (used by the occlusion cache)
+                            prim_pi.prim_index = prim_index;
                             return prim_pi;
+                        }
 
                         Assert(prim_pi.t >= ray.mint && prim_pi.t <= ray.maxt);
                         pi = prim_pi;
@@ -2296,6 +2299,20 @@ public:
         return pi;
     }
 
+    /**
+     * \brief Test whether the primitive with the given (global) index blocks
+     * a shadow ray
+     *
+     * The index matches the \c prim_index field returned by a scalar shadow
+     * ray query via \ref ray_intersect_preliminary().
+     */
+    MTS_INLINE Mask ray_test_primitive(Index prim_index, const Ray3f &ray,
+                                       Mask active) const {
+        if (unlikely(prim_index >= primitive_count()))
+            return false;
+        return intersect_prim<true>(prim_index, ray, active).is_valid();
+    }
+
     /// Brute force intersection routine for debugging purposes
     template <bool ShadowRay>
     MTS_INLINE PreliminaryIntersection3f ray_intersect_naive(Ray3f ray,
@@ -0,0 +1,321 @@
+#pragma once
+
+#include <mitsuba/core/bbox.h>
+#include <mitsuba/core/vector.h>
+#include <enoki/dynamic.h>
+#include <algorithm>
+#include <numeric>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Bounding volume hierarchy over emitters that selects emitters
+ * proportional to a conservative estimate of their contribution to a point
+ *
+ * Every node stores the bounding box, the total power, and the bounds of the
+ * emission directions of the emitters below it. The latter are represented
+ * by a cone of surface normals (axis and half-angle \f$\theta_o\f$) and the
+ * maximum angle between the normal and an emitted direction
+ * (\f$\theta_e\f$), following "Importance Sampling of Many Lights with
+ * Adaptive Tree Splitting" by Conty Estevez and Kulla.
+ *
+ * Emitters are selected by traversing the tree from the root, picking one of
+ * the two children of every node with a probability proportional to its
+ * importance. The importance is zero only if no emitter below a node can
+ * illuminate the point, hence selection is unbiased as long as the bounds
+ * are conservative.
+ *
+ * The nodes are stored in flat arrays, so that selection works with scalar
+ * as well as packet types.
+ */
+template <typename Float> struct LightTree {
+    using FloatStorage  = DynamicBuffer<Float>;
+    using UInt32        = uint32_array_t<Float>;
+    using UInt32Storage = DynamicBuffer<UInt32>;
+    using Mask          = mask_t<Float>;
+    using Point3f       = Point<Float, 3>;
+    using Vector3f      = Vector<Float, 3>;
+
+    using ScalarFloat         = scalar_t<Float>;
+    using ScalarPoint3f       = Point<ScalarFloat, 3>;
+    using ScalarVector3f      = Vector<ScalarFloat, 3>;
+    using ScalarBoundingBox3f = BoundingBox<ScalarPoint3f>;
+
+    /// Spatial and directional bounds of an emitter (or of a set of emitters)
+    struct Bounds {
+        ScalarBoundingBox3f bbox;
+        /// Axis of the cone bounding the surface normals
+        ScalarVector3f axis = ScalarVector3f(0.f, 0.f, 1.f);
+        /// Cosine of the half-angle of the normal cone (-1: all directions)
+        ScalarFloat cos_theta_o = -1.f;
+        /// Cosine of the maximum angle between normal and emitted direction
+        ScalarFloat cos_theta_e = 0.f;
+        /// Emitted power
+        ScalarFloat power = 0.f;
+    };
+
+    /// Flag marking leaf nodes in \c m_node_info
+    static constexpr uint32_t LeafFlag = 0x80000000u;
+
+    /// Maximum depth of the tree (bounded by the bits of the per-emitter paths)
+    static constexpr uint32_t MaxDepth = 32;
+
+    /// Create an empty tree
+    LightTree() { }
+
+    /**
+     * \brief Build the tree
+     *
+     * \param bounds
+     *     Bounds of the emitters that are inserted into the tree
+     *
+     * \param indices
+     *     Index of every emitter in the scene's list of emitters
+     *
+     * \param emitter_count
+     *     Total number of emitters in the scene
+     */
+    LightTree(const std::vector<Bounds> &bounds, const std::vector<uint32_t> &indices,
+              size_t emitter_count) {
+        if (bounds.empty())
+            return;
+
+        std::vector<uint32_t> order(bounds.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::vector<uint32_t> trail(emitter_count, 0u);
+
+        std::vector<Bounds> nodes;
+        std::vector<uint32_t> info;
+        build(bounds, indices, order.begin(), order.end(), 0, 0, nodes, info, trail);
+
+        std::vector<ScalarFloat> data(NodeFloats * nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            const Bounds &b = nodes[i];
+            ScalarFloat *ptr = data.data() + NodeFloats * i;
+            for (size_t j = 0; j < 3; ++j) {
+                ptr[j]     = .5f * (b.bbox.min[j] + b.bbox.max[j]);
+                ptr[3 + j] = b.axis[j];
+            }
+            ptr[6] = .5f * norm(b.bbox.max - b.bbox.min);
+            ptr[7] = b.cos_theta_o;
+            ptr[8] = b.cos_theta_e;
+            ptr[9] = b.power;
+        }
+
+        m_node_data  = FloatStorage::copy(data.data(), data.size());
+        m_node_info  = UInt32Storage::copy(info.data(), info.size());
+        m_trail      = UInt32Storage::copy(trail.data(), trail.size());
+        m_node_count = nodes.size();
+    }
+
+    /// Is the tree empty?
+    bool empty() const { return m_node_count == 0; }
+
+    /// Return the number of nodes
+    size_t node_count() const { return m_node_count; }
+
+    /**
+     * \brief Select an emitter for the reference point \c p
+     *
+     * \param sample
+     *     A uniformly distributed sample on the interval [0, 1], which is
+     *     re-scaled so that it can be reused as a uniform variate.
+     *
+     * \return
+     *     The index of the selected emitter in the scene's list of emitters,
+     *     and its selection probability (zero if no emitter contributes).
+     */
+    std::pair<UInt32, Float> sample(const Point3f &p, Float &sample,
+                                    Mask active = true) const {
+        UInt32 node = 0;
+        Float pmf = 1.f;
+
+        Mask active_t = active;
+        for (uint32_t depth = 0; depth < MaxDepth; ++depth) {
+            UInt32 info = gather<UInt32>(m_node_info, node, active_t);
+            active_t &= eq(info & LeafFlag, 0u);
+            if (none_or<false>(active_t))
+                break;
+
+            UInt32 left = node + 1u, right = info;
+            Float importance_l = importance(p, left, active_t),
+                  importance_r = importance(p, right, active_t),
+                  importance_sum = importance_l + importance_r;
+
+            Mask valid = importance_sum > 0.f;
+            masked(pmf, active_t && !valid) = 0.f;
+            active_t &= valid;
+
+            Float prob_l = importance_l / importance_sum;
+            Mask pick_l = sample < prob_l;
+
+            masked(sample, active_t) = select(pick_l, sample / prob_l,
+                                              (sample - prob_l) / (1.f - prob_l));
+            masked(pmf, active_t) *= select(pick_l, prob_l, 1.f - prob_l);
+            masked(node, active_t) = select(pick_l, left, right);
+        }
+
+        sample = min(sample, math::OneMinusEpsilon<Float>);
+        UInt32 info = gather<UInt32>(m_node_info, node, active);
+        return { info & ~LeafFlag, select(active, pmf, 0.f) };
+    }
+
+    /// Evaluate the probability of selecting the emitter \c index for the reference point \c p
+    Float pmf(const Point3f &p, const UInt32 &index, Mask active = true) const {
+        UInt32 trail = gather<UInt32>(m_trail, index, active),
+               node  = 0;
+        Float pmf = 1.f;
+
+        Mask active_t = active;
+        for (uint32_t depth = 0; depth < MaxDepth; ++depth) {
+            UInt32 info = gather<UInt32>(m_node_info, node, active_t);
+            active_t &= eq(info & LeafFlag, 0u);
+            if (none_or<false>(active_t))
+                break;
+
+            UInt32 left = node + 1u, right = info;
+            Float importance_l = importance(p, left, active_t),
+                  importance_r = importance(p, right, active_t),
+                  importance_sum = importance_l + importance_r;
+
+            Mask pick_l = eq((trail >> depth) & 1u, 0u);
+            Float prob = select(pick_l, importance_l, importance_r) / importance_sum;
+
+            masked(pmf, active_t) *= select(importance_sum > 0.f, prob, 0.f);
+            masked(node, active_t) = select(pick_l, left, right);
+        }
+
+        return select(active, pmf, 0.f);
+    }
+
+    /// Merge two sets of bounds
+    static Bounds merge(const Bounds &a, const Bounds &b) {
+        Bounds result;
+        result.bbox = ScalarBoundingBox3f::merge(a.bbox, b.bbox);
+        result.power = a.power + b.power;
+        result.cos_theta_e = std::min(a.cos_theta_e, b.cos_theta_e);
+
+        // Smallest cone containing both normal cones
+        ScalarFloat theta_a = std::acos(clamp(a.cos_theta_o, -1.f, 1.f)),
+                    theta_b = std::acos(clamp(b.cos_theta_o, -1.f, 1.f)),
+                    theta_d = std::acos(clamp(dot(a.axis, b.axis), -1.f, 1.f)),
+                    pi      = math::Pi<ScalarFloat>;
+
+        if (std::min(theta_d + theta_b, pi) <= theta_a) {
+            result.axis = a.axis;
+            result.cos_theta_o = a.cos_theta_o;
+        } else if (std::min(theta_d + theta_a, pi) <= theta_b) {
+            result.axis = b.axis;
+            result.cos_theta_o = b.cos_theta_o;
+        } else {
+            ScalarFloat theta_o = .5f * (theta_a + theta_d + theta_b);
+            ScalarVector3f w = cross(a.axis, b.axis);
+            if (theta_o >= pi || squared_norm(w) == 0.f) {
+                result.cos_theta_o = -1.f;
+            } else {
+                // Rotate the axis of 'a' towards 'b' (Rodrigues' formula)
+                ScalarFloat theta_r = theta_o - theta_a,
+                            cos_r = std::cos(theta_r), sin_r = std::sin(theta_r);
+                w = normalize(w);
+                result.axis = normalize(a.axis * cos_r + cross(w, a.axis) * sin_r +
+                                        w * dot(w, a.axis) * (1.f - cos_r));
+                result.cos_theta_o = std::cos(theta_o);
+            }
+        }
+        return result;
+    }
+
+private:
+    /// Number of floats per node: center, axis, radius, cos_theta_o, cos_theta_e, power
+    static constexpr size_t NodeFloats = 10;
+
+    /// Importance of a node for the reference point \c p (an upper bound of its contribution)
+    Float importance(const Point3f &p, const UInt32 &node, Mask active) const {
+        UInt32 offset = node * (uint32_t) NodeFloats;
+        auto fetch = [&](uint32_t i) { return gather<Float>(m_node_data, offset + i, active); };
+
+        Point3f center(fetch(0), fetch(1), fetch(2));
+        Vector3f axis(fetch(3), fetch(4), fetch(5));
+        Float radius      = fetch(6),
+              cos_theta_o = fetch(7),
+              cos_theta_e = fetch(8),
+              power       = fetch(9);
+
+        Vector3f d = p - center;
+        Float dist2 = squared_norm(d),
+              radius2 = sqr(radius);
+        Mask outside = dist2 > radius2;
+
+        // Angle between the cone axis and the direction towards the point
+        Vector3f wi = select(dist2 > 0.f, d * rsqrt(dist2), axis);
+        Float cos_theta_w = dot(axis, wi),
+              sin_theta_w = safe_sqrt(1.f - sqr(cos_theta_w));
+
+        // Half-angle subtended by the bounding sphere of the node
+        Float cos_theta_b = select(outside, safe_sqrt(1.f - radius2 / dist2), -1.f),
+              sin_theta_b = safe_sqrt(1.f - sqr(cos_theta_b));
+
+        // theta_x = max(0, theta_w - theta_o)
+        Float sin_theta_o = safe_sqrt(1.f - sqr(cos_theta_o));
+        Mask inside_o = cos_theta_w > cos_theta_o;
+        Float cos_theta_x = select(inside_o, 1.f, cos_theta_w * cos_theta_o + sin_theta_w * sin_theta_o),
+              sin_theta_x = select(inside_o, 0.f, sin_theta_w * cos_theta_o - cos_theta_w * sin_theta_o);
+
+        // theta' = max(0, theta_x - theta_b)
+        Float cos_theta_p = select(cos_theta_x > cos_theta_b, 1.f,
+                                   cos_theta_x * cos_theta_b + sin_theta_x * sin_theta_b);
+
+        Float importance = power * cos_theta_p /
+                           max(max(dist2, radius2), math::Epsilon<Float>);
+        return select(active && cos_theta_p > cos_theta_e, importance, 0.f);
+    }
+
+    /// Recursively build the subtree of the given emitters, returns the index of its root
+    static uint32_t build(const std::vector<Bounds> &bounds, const std::vector<uint32_t> &indices,
+                          std::vector<uint32_t>::iterator begin,
+                          std::vector<uint32_t>::iterator end, uint32_t depth,
+                          uint32_t path, std::vector<Bounds> &nodes,
+                          std::vector<uint32_t> &info, std::vector<uint32_t> &trail) {
+        uint32_t node = (uint32_t) nodes.size();
+        size_t count = (size_t) (end - begin);
+
+        if (count == 1) {
+            // Median splits keep the depth below log2(count) + 1 <= MaxDepth
+            nodes.push_back(bounds[*begin]);
+            info.push_back(indices[*begin] | LeafFlag);
+            trail[indices[*begin]] = path;
+            return node;
+        }
+
+        // Split at the median of the centroids along the largest axis
+        ScalarBoundingBox3f centroids;
+        for (auto it = begin; it != end; ++it)
+            centroids.expand(bounds[*it].bbox.center());
+        int axis = centroids.major_axis();
+
+        auto mid = begin + count / 2;
+        std::nth_element(begin, mid, end, [&](uint32_t a, uint32_t b) {
+            return bounds[a].bbox.center()[axis] < bounds[b].bbox.center()[axis];
+        });
+
+        nodes.emplace_back();
+        info.push_back(0u);
+
+        build(bounds, indices, begin, mid, depth + 1, path, nodes, info, trail);
+        uint32_t right = build(bounds, indices, mid, end, depth + 1,
+                               path | (1u << depth), nodes, info, trail);
+
+        info[node] = right;
+        nodes[node] = merge(nodes[node + 1], nodes[right]);
+        return node;
+    }
+
+private:
+    FloatStorage m_node_data;
+    UInt32Storage m_node_info;
+    /// Path from the root to the leaf of every emitter (bit \c i: child at depth \c i)
+    UInt32Storage m_trail;
+    size_t m_node_count = 0;
+};
+
+NAMESPACE_END(mitsuba)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mitsuba/core/bbox.h>
 #include <mitsuba/core/object.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/traits.h>
@@ -10,7 +11,7 @@ NAMESPACE_BEGIN(mitsuba)
 template <typename Float, typename Spectrum>
 class MTS_EXPORT_RENDER Medium : public Object {
 public:
-    MTS_IMPORT_TYPES(PhaseFunction, Sampler, Scene, Texture);
+    MTS_IMPORT_TYPES(PhaseFunction, Sampler, Scene, Texture, Volume);
 
     /// Intersets a ray with the medium's bounding box
     virtual std::tuple<Mask, Float, Float>
@@ -39,8 +40,8 @@ public:
      * \param ray      Ray, along which a distance should be sampled
      * \param sample   A uniformly distributed random sample
      * \param channel  The channel according to which we will sample the
-     * free-flight distance. This argument is only used when rendering in RGB
-     * modes.
+     * free-flight distance. In spectral modes, this is the index of the
+     * wavelength (0 corresponds to the hero wavelength).
      *
      * \return         This method returns a MediumInteraction.
      *                 The MediumInteraction will always be valid,
@@ -68,6 +69,71 @@ public:
     eval_tr_and_pdf(const MediumInteraction3f &mi,
                     const SurfaceInteraction3f &si, Mask active) const;
 
+    /**
+     * \brief Compute the throughput weight of a free-flight distance sampled
+     * by \ref sample_interaction()
+     *
+     * This is the transmittance divided by the PDF returned by
+     * \ref eval_tr_and_pdf(). When \c spectral_mis is \c false, the PDF is
+     * the one of channel \c channel. Otherwise, the caller is expected to
+     * draw \c channel uniformly at random for every sampled distance, and the
+     * PDF is the average over all channels (i.e. the one-sample balance
+     * heuristic over channels or wavelengths). This bounds the weights of
+     * strongly chromatic media.
+     */
+    UnpolarizedSpectrum eval_tr_weight(const MediumInteraction3f &mi,
+                                       const SurfaceInteraction3f &si,
+                                       UInt32 channel, bool spectral_mis,
+                                       Mask active) const;
+
+    /**
+     * \brief Decide whether a valid interaction returned by
+     * \ref sample_interaction() is a real or a null collision
+     *
+     * \param mi            Sampled medium interaction
+     * \param sample        A uniformly distributed random sample
+     * \param channel       Channel used to decide (ignored with spectral MIS)
+     * \param spectral_mis  Draw the channel from \c sample and weight the
+     *                      decision using the average over all channels
+     *
+     * \return A pair containing a mask of real collisions and the throughput
+     * weight of the decision: \c sigma_s or \c sigma_n divided by the
+     * probability of the chosen type of collision.
+     */
+    std::pair<Mask, UnpolarizedSpectrum>
+    sample_collision(const MediumInteraction3f &mi, Float sample,
+                     UInt32 channel, bool spectral_mis, Mask active) const;
+
+    /**
+     * \brief Sample a tentative collision for estimating the transmittance
+     * along a ray using ratio tracking
+     *
+     * Without a control component, this is equivalent to
+     * \ref sample_interaction(). Otherwise, decomposition tracking is used:
+     * only collisions with the residual component are sampled, and
+     * \c combined_extinction stores the residual majorant. The transmittance
+     * of the homogeneous control component is accounted for analytically by
+     * \ref eval_ratio_tracking_weight(), which reduces both the number of
+     * density lookups and the variance of the estimate.
+     */
+    MediumInteraction3f sample_ratio_tracking(const Ray3f &ray, Float sample,
+                                              UInt32 channel, Mask active) const;
+
+    /**
+     * \brief Compute the ratio tracking weight of an interaction returned by
+     * \ref sample_ratio_tracking()
+     *
+     * \param maxt  Distance at which the estimate ends (e.g. a surface)
+     *
+     * \return The transmittance divided by the PDF of the sampled distance
+     * (see \ref eval_tr_weight()), multiplied by \c sigma_n if a collision
+     * occurred before \c maxt.
+     */
+    UnpolarizedSpectrum eval_ratio_tracking_weight(const MediumInteraction3f &mi,
+                                                   Float maxt, UInt32 channel,
+                                                   bool spectral_mis,
+                                                   Mask active) const;
+
     /// Return the phase function of this medium
     MTS_INLINE const PhaseFunction *phase_function() const {
         return m_phase_function.get();
@@ -84,6 +150,12 @@ public:
         return m_has_spectral_extinction;
     }
 
+    /// Returns whether free-flight sampling uses a spatially varying majorant grid
+    MTS_INLINE bool has_majorant_grid() const { return m_majorant_grid.size() > 0; }
+
+    /// Returns whether the extinction has a known homogeneous control component
+    MTS_INLINE bool has_control_extinction() const { return m_control_sigma_t.get() != nullptr; }
+
     /// Return a string identifier
     std::string id() const override { return m_id; }
 
@@ -97,10 +169,77 @@ protected:
     Medium(const Properties &props);
     virtual ~Medium();
 
+    /**
+     * \brief Set a grid of local majorants that subdivides \c bbox into
+     * \c resolution cells. \c values stores one majorant per cell in
+     * x-major order (e.g. computed using \ref Volume::max_per_cell()).
+     *
+     * Once set, \ref sample_interaction() walks the grid using a 3D-DDA and
+     * samples free-flight distances proportionally to the local majorants,
+     * which are also reported in \c MediumInteraction::combined_extinction.
+     */
+    void set_majorant_grid(const ScalarBoundingBox3f &bbox,
+                           const ScalarVector3u &resolution,
+                           const std::vector<ScalarFloat> &values);
+
+    /// Look up the majorant grid cell containing the point \c p
+    Float eval_majorant_grid(const Point3f &p, Mask active = true) const;
+
+    /**
+     * \brief Set the homogeneous control component of the extinction used
+     * for decomposition tracking.
+     *
+     * Throws an exception unless \c volume is spatially constant (i.e. a
+     * \c constvolume or a volume with a resolution of one voxel). Its value
+     * is read once here, hence this function must be called again when the
+     * volume's parameters change.
+     */
+    void set_control_extinction(Volume *volume);
+
+    /**
+     * \brief Return the extinction of the homogeneous control component
+     *
+     * Only spectral variants evaluate the control volume (at the wavelengths
+     * of \c mi, its position is irrelevant); the others return the value
+     * read by \ref set_control_extinction().
+     */
+    UnpolarizedSpectrum eval_control_extinction(const MediumInteraction3f &mi,
+                                                Mask active = true) const;
+
+    /**
+     * \brief Walk the majorant grid between \c mint and \c maxt and find
+     * the distance at which the accumulated optical depth reaches \c tau.
+     *
+     * \c offset is added to the majorant of every cell (e.g. the extinction
+     * of a homogeneous control component that is not part of the grid).
+     *
+     * \return A pair containing the sampled distance (infinite if the
+     * segment was exhausted) and the majorant of the last visited cell.
+     */
+    std::pair<Float, Float> sample_majorant_grid(const Ray3f &ray, Float mint,
+                                                 Float maxt, Float tau,
+                                                 Mask active,
+                                                 Float offset = 0.f) const;
+
 protected:
     ref<PhaseFunction> m_phase_function;
     bool m_sample_emitters, m_is_homogeneous, m_has_spectral_extinction;
 
+    /// Optional grid of local majorants (empty if not used)
+    DynamicBuffer<Float> m_majorant_grid;
+    ScalarBoundingBox3f m_majorant_bbox;
+    ScalarVector3u m_majorant_resolution;
+
+    /**
+     * Optional homogeneous control component of the extinction used for
+     * decomposition tracking. Media that set it must include it in the
+     * extinction and majorant reported by the virtual methods, but not in the
+     * majorant grid. Set using \ref set_control_extinction().
+     */
+    ref<Volume> m_control_sigma_t;
+    /// Value of \c m_control_sigma_t (unused in spectral variants)
+    UnpolarizedSpectrum m_control_extinction;
+
     /// Identifier (if available)
     std::string m_id;
 };
@@ -118,10 +257,16 @@ ENOKI_CALL_SUPPORT_TEMPLATE_BEGIN(mitsuba::Medium)
     ENOKI_CALL_SUPPORT_METHOD(use_emitter_sampling)
     ENOKI_CALL_SUPPORT_METHOD(is_homogeneous)
     ENOKI_CALL_SUPPORT_METHOD(has_spectral_extinction)
+    ENOKI_CALL_SUPPORT_METHOD(has_majorant_grid)
+    ENOKI_CALL_SUPPORT_METHOD(has_control_extinction)
     ENOKI_CALL_SUPPORT_METHOD(get_combined_extinction)
     ENOKI_CALL_SUPPORT_METHOD(intersect_aabb)
     ENOKI_CALL_SUPPORT_METHOD(sample_interaction)
     ENOKI_CALL_SUPPORT_METHOD(eval_tr_and_pdf)
+    ENOKI_CALL_SUPPORT_METHOD(eval_tr_weight)
+    ENOKI_CALL_SUPPORT_METHOD(sample_collision)
+    ENOKI_CALL_SUPPORT_METHOD(sample_ratio_tracking)
+    ENOKI_CALL_SUPPORT_METHOD(eval_ratio_tracking_weight)
     ENOKI_CALL_SUPPORT_METHOD(get_scattering_coefficients)
 ENOKI_CALL_SUPPORT_TEMPLATE_END(mitsuba::Medium)
 
@@ -86,6 +86,8 @@ public:
     template <typename Index>
     MTS_INLINE auto vertex_position(Index index, mask_t<Index> active = true) const {
         using Result = Point<replace_scalar_t<Index, InputFloat>, 3>;
+        if (unlikely(slices(m_vertex_positions_packed_buf) != 0))
+            return decode_position<Result>(index, active);
         return gather<Result>(m_vertex_positions_buf, index, active);
     }
 
@@ -93,6 +95,8 @@ public:
     template <typename Index>
     MTS_INLINE auto vertex_normal(Index index, mask_t<Index> active = true) const {
         using Result = Normal<replace_scalar_t<Index, InputFloat>, 3>;
+        if (unlikely(slices(m_vertex_normals_packed_buf) != 0))
+            return decode_normal<Result>(index, active);
         return gather<Result>(m_vertex_normals_buf, index, active);
     }
 
@@ -100,6 +104,8 @@ public:
     template <typename Index>
     MTS_INLINE auto vertex_texcoord(Index index, mask_t<Index> active = true) const {
         using Result = Point<replace_scalar_t<Index, InputFloat>, 2>;
+        if (unlikely(slices(m_vertex_texcoords_packed_buf) != 0))
+            return decode_texcoord<Result>(index, active);
         return gather<Result>(m_vertex_texcoords_buf, index, active);
     }
 
@@ -116,10 +122,19 @@ public:
     }
 
     /// Does this mesh have per-vertex normals?
-    bool has_vertex_normals() const { return slices(m_vertex_normals_buf) != 0; }
+    bool has_vertex_normals() const {
+        return slices(m_vertex_normals_buf) != 0 ||
+               slices(m_vertex_normals_packed_buf) != 0;
+    }
 
     /// Does this mesh have per-vertex texture coordinates?
-    bool has_vertex_texcoords() const { return slices(m_vertex_texcoords_buf) != 0; }
+    bool has_vertex_texcoords() const {
+        return slices(m_vertex_texcoords_buf) != 0 ||
+               slices(m_vertex_texcoords_packed_buf) != 0;
+    }
+
+    /// Does this mesh store its vertex data in the quantized compact format?
+    bool has_compact_storage() const { return m_compact_storage; }
 
     /// @}
     // =========================================================================
@@ -271,6 +286,19 @@ protected:
      */
     void build_parameterization();
 
+    /**
+     * \brief Convert the vertex data into the compact storage format
+     *
+     * Vertex normals are octahedral-encoded into a single 32-bit word,
+     * texture coordinates are quantized to 16 bit per component relative to
+     * their bounding box, and positions are quantized to 21/21/22 bit relative
+     * to the bounds of clusters of 256 consecutive vertices. The
+     * full-precision buffers are released afterwards, and the mesh can no
+     * longer be modified. Should be called by mesh loaders once all vertex
+     * data (including computed normals) is available.
+     */
+    void compact_vertex_data();
+
     // Ensures that the sampling table are ready.
     ENOKI_INLINE void ensure_pmf_built() const {
         if (unlikely(m_area_pmf.empty()))
@@ -290,6 +318,57 @@ protected:
         FloatStorage buf;
     };
 
+    /// Vertices are grouped into clusters of 2^CompactClusterShift for position quantization
+    static constexpr uint32_t CompactClusterShift = 8;
+
+    template <typename Result, typename Index>
+    MTS_INLINE Result decode_position(const Index &index, mask_t<Index> active) const {
+        using UInt32X = replace_scalar_t<Index, uint32_t>;
+        using FloatX  = value_t<Result>;
+        using Point3X = Point<FloatX, 3>;
+
+        auto w = gather<Array<UInt32X, 2>>(m_vertex_positions_packed_buf, index, active);
+        UInt32X cluster = index >> CompactClusterShift;
+        Point3X offset = gather<Point3X>(m_vertex_position_clusters_buf, cluster * 2, active),
+                scale  = gather<Point3X>(m_vertex_position_clusters_buf, cluster * 2 + 1, active);
+
+        Point3X q(FloatX(w.x() & 0x1FFFFFu),
+                  FloatX((w.x() >> 21) | ((w.y() & 0x3FFu) << 11)),
+                  FloatX(w.y() >> 10));
+
+        return Result(fmadd(q, scale, offset));
+    }
+
+    template <typename Result, typename Index>
+    MTS_INLINE Result decode_normal(const Index &index, mask_t<Index> active) const {
+        using UInt32X = replace_scalar_t<Index, uint32_t>;
+        using FloatX  = value_t<Result>;
+
+        UInt32X w = gather<UInt32X>(m_vertex_normals_packed_buf, index, active);
+
+        // Undo the octahedral mapping (branch-free fold of the lower hemisphere)
+        FloatX x = fmadd(FloatX(w & 0xFFFFu), 2.f / 65535.f, -1.f),
+               y = fmadd(FloatX(w >> 16),     2.f / 65535.f, -1.f),
+               z = 1.f - abs(x) - abs(y),
+               t = max(-z, 0.f);
+
+        x += select(x >= 0.f, -t, t);
+        y += select(y >= 0.f, -t, t);
+
+        return normalize(Result(x, y, z));
+    }
+
+    template <typename Result, typename Index>
+    MTS_INLINE Result decode_texcoord(const Index &index, mask_t<Index> active) const {
+        using UInt32X = replace_scalar_t<Index, uint32_t>;
+        using FloatX  = value_t<Result>;
+
+        UInt32X w = gather<UInt32X>(m_vertex_texcoords_packed_buf, index, active);
+
+        return Result(fmadd(FloatX(w & 0xFFFFu), m_texcoord_scale.x(), m_texcoord_offset.x()),
+                      fmadd(FloatX(w >> 16),     m_texcoord_scale.y(), m_texcoord_offset.y()));
+    }
+
     template <uint32_t Size, bool Raw>
     auto interpolate_attribute(MeshAttributeType type,
                                const FloatStorage &buf,
@@ -347,6 +426,14 @@ protected:
 
     DynamicBuffer<UInt32> m_faces_buf;
 
+    /// Quantized vertex data, only populated when compact storage is enabled
+    DynamicBuffer<UInt32> m_vertex_positions_packed_buf;
+    DynamicBuffer<UInt32> m_vertex_normals_packed_buf;
+    DynamicBuffer<UInt32> m_vertex_texcoords_packed_buf;
+    /// Per-cluster (offset, scale) pairs used to dequantize positions
+    FloatStorage m_vertex_position_clusters_buf;
+    InputVector2f m_texcoord_offset = 0.f, m_texcoord_scale = 0.f;
+
     std::unordered_map<std::string, MeshAttribute> m_mesh_attributes;
 
 #if defined(MTS_ENABLE_OPTIX)
@@ -356,6 +443,9 @@ protected:
     /// Flag that can be set by the user to disable loading/computation of vertex normals
     bool m_disable_vertex_normals = false;
 
+    /// Flag that can be set by the user to request quantized vertex storage
+    bool m_compact_storage = false;
+
     /* Surface area distribution -- generated on demand when \ref
        prepare_area_pmf() is first called. */
     DiscreteDistribution<Float> m_area_pmf;
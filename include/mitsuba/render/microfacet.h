@@ -11,6 +11,10 @@
 #include <mitsuba/core/warp.h>
 #include <mitsuba/render/fresnel.h>
 #include <mitsuba/render/fwd.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <memory>
+#include <vector>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -450,24 +454,25 @@ std::ostream &operator<<(std::ostream &os, const MicrofacetDistribution<Float, S
     return os;
 }
 
-template <typename FloatP, typename Spectrum>
-DynamicArray<FloatP> eval_reflectance(const MicrofacetDistribution<FloatP, Spectrum> &distr,
-                                      const Vector<DynamicArray<FloatP>, 3> &wi_,
-                                      scalar_t<FloatP> eta) {
-    using Float     = scalar_t<FloatP>;
+NAMESPACE_BEGIN(detail)
+
+/**
+ * \brief Integrate a function over the distribution of visible normals for
+ * each of the specified incident directions
+ *
+ * Uses a tensor product Gauss-Legendre quadrature rule with (at least) \c res
+ * nodes per dimension. The incident directions are processed in parallel.
+ * The function receives the incident direction and the microfacet normal.
+ */
+template <typename FloatP, typename Spectrum, typename Func>
+DynamicArray<FloatP> integrate_visible_normals(const MicrofacetDistribution<FloatP, Spectrum> &distr,
+                                               const Vector<DynamicArray<FloatP>, 3> &wi_,
+                                               int res, const Func &func) {
     using FloatX    = DynamicArray<FloatP>;
     using Vector2fP = Vector<FloatP, 2>;
-    using Vector3fP = Vector<FloatP, 3>;
     using Normal3fP = Normal<FloatP, 3>;
     using Vector2fX = Vector<FloatX, 2>;
-    using Vector3fX = Vector<FloatX, 3>;
-
-    if (!distr.sample_visible())
-        Throw("eval_reflectance(): requires visible normal sampling!");
 
-    int res = 128;
-    if (eta > 1)
-        res = 32;
     while (res % FloatP::Size != 0)
         ++res;
 
@@ -478,76 +483,147 @@ DynamicArray<FloatP> eval_reflectance(const MicrofacetDistribution<FloatP, Spect
     Vector2fX nodes_2    = meshgrid(nodes, nodes),
               weights_2  = meshgrid(weights, weights);
 
-    for (size_t i = 0; i < slices(wi_); ++i) {
-        auto wi      = slice(wi_, i);
-        FloatP accum = zero<FloatP>();
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, slices(wi_), 1),
+        [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i != range.end(); ++i) {
+                auto wi      = slice(wi_, i);
+                FloatP accum = zero<FloatP>();
+
+                for (size_t j = 0; j < packets(nodes_2); ++j) {
+                    Vector2fP node(packet(nodes_2, j)),
+                              weight(packet(weights_2, j));
+                    node = fmadd(node, .5f, .5f);
+
+                    Normal3fP m = std::get<0>(distr.sample(wi, node));
+                    accum += func(wi, m) * hprod(weight);
+                }
+                slice(result, i) = hsum(accum) * .25f;
+            }
+        }
+    );
+
+    return result;
+}
+
+NAMESPACE_END(detail)
+
+template <typename FloatP, typename Spectrum>
+DynamicArray<FloatP> eval_reflectance(const MicrofacetDistribution<FloatP, Spectrum> &distr,
+                                      const Vector<DynamicArray<FloatP>, 3> &wi_,
+                                      scalar_t<FloatP> eta) {
+    using Vector3fP = Vector<FloatP, 3>;
+    using Normal3fP = Normal<FloatP, 3>;
 
-        for (size_t j = 0; j < packets(nodes_2); ++j) {
-            Vector2fP node(packet(nodes_2, j)),
-                      weight(packet(weights_2, j));
-            node = fmadd(node, .5f, .5f);
+    if (!distr.sample_visible())
+        Throw("eval_reflectance(): requires visible normal sampling!");
 
-            Normal3fP m = std::get<0>(distr.sample(wi, node));
+    return detail::integrate_visible_normals(
+        distr, wi_, eta > 1 ? 32 : 128,
+        [&](const auto &wi, const Normal3fP &m) {
             Vector3fP wo = reflect(Vector3fP(wi), m);
             FloatP f = std::get<0>(fresnel(dot(wi, m), FloatP(eta)));
             FloatP smith = distr.smith_g1(wo, m) * f;
             smith[wo.z() <= 0.f || wi.z() <= 0.f] = 0.f;
-
-            accum += smith * hprod(weight);
-        }
-        slice(result, i) = hsum(accum) * .25f;
-    }
-    return result;
+            return smith;
+        });
 }
 
 template <typename FloatP, typename Spectrum>
 DynamicArray<FloatP> eval_transmittance(const MicrofacetDistribution<FloatP, Spectrum> &distr,
                                         const Vector<DynamicArray<FloatP>, 3> &wi_,
                                         scalar_t<FloatP> eta) {
-    using Float     = scalar_t<FloatP>;
-    using FloatX    = DynamicArray<FloatP>;
-    using Vector2fP = Vector<FloatP, 2>;
     using Vector3fP = Vector<FloatP, 3>;
     using Normal3fP = Normal<FloatP, 3>;
-    using Vector2fX = Vector<FloatX, 2>;
-    using Vector3fX = Vector<FloatX, 3>;
 
     if (!distr.sample_visible())
         Throw("eval_transmittance(): requires visible normal sampling!");
 
-    int res = 128;
-    if (eta > 1)
-        res = 32;
-    while (res % FloatP::Size != 0)
-        ++res;
-
-    FloatX nodes, weights, result;
-    std::tie(nodes, weights) = quad::gauss_legendre<FloatX>(res);
-    set_slices(result, slices(wi_));
-
-    Vector2fX nodes_2    = meshgrid(nodes, nodes),
-              weights_2  = meshgrid(weights, weights);
-
-    for (size_t i = 0; i < slices(wi_); ++i) {
-        auto wi      = slice(wi_, i);
-        FloatP accum = zero<FloatP>();
-
-        for (size_t j = 0; j < packets(nodes_2); ++j) {
-            Vector2fP node(packet(nodes_2, j)),
-                      weight(packet(weights_2, j));
-            node = fmadd(node, .5f, .5f);
-
-            Normal3fP m = std::get<0>(distr.sample(wi, node));
+    return detail::integrate_visible_normals(
+        distr, wi_, eta > 1 ? 32 : 128,
+        [&](const auto &wi, const Normal3fP &m) {
             auto [f, cos_theta_t, eta_it, eta_ti] = fresnel(dot(wi, m), FloatP(eta));
             Vector3fP wo = refract(Vector3fP(wi), m, cos_theta_t, eta_ti);
             FloatP smith = distr.smith_g1(wo, m) * (1.f - f);
             smith[wo.z() * wi.z() >= 0.f] = 0.f;
+            return smith;
+        });
+}
 
-            accum += smith * hprod(weight);
-        }
-        slice(result, i) = hsum(accum) * .25f;
-    }
-    return result;
+/**
+ * \brief Evaluate the directional albedo of a microfacet BRDF whose Fresnel
+ * factor is equal to one (i.e. a rough perfect mirror)
+ *
+ * The missing energy (one minus the albedo) is due to light that is scattered
+ * more than once between the microfacets, which is neglected by the
+ * microfacet model.
+ */
+template <typename FloatP, typename Spectrum>
+DynamicArray<FloatP> eval_albedo(const MicrofacetDistribution<FloatP, Spectrum> &distr,
+                                 const Vector<DynamicArray<FloatP>, 3> &wi_) {
+    using Vector3fP = Vector<FloatP, 3>;
+    using Normal3fP = Normal<FloatP, 3>;
+
+    if (!distr.sample_visible())
+        Throw("eval_albedo(): requires visible normal sampling!");
+
+    return detail::integrate_visible_normals(
+        distr, wi_, 64,
+        [&](const auto &wi, const Normal3fP &m) {
+            Vector3fP wo = reflect(Vector3fP(wi), m);
+            FloatP smith = distr.smith_g1(wo, m);
+            smith[wo.z() <= 0.f || wi.z() <= 0.f] = 0.f;
+            return smith;
+        });
 }
 
+/**
+ * \brief Process-wide cache of tables that are precomputed from microfacet
+ * distributions
+ *
+ * Rough BSDFs tabulate integrals over the distribution of visible normals,
+ * such as the transmittance through a rough dielectric interface or the
+ * directional albedo that is needed for multiple scattering energy
+ * compensation. These tables only depend on a few scalar parameters, hence
+ * each of them is computed once (in parallel) and subsequently shared by all
+ * BSDFs that request the same parameters. Other threads that request a table
+ * while it is being computed wait for the result.
+ *
+ * Unless noted otherwise, tables are regularly spaced over the cosine of the
+ * incident angle on the interval [0, 1].
+ */
+template <typename Float>
+class MTS_EXPORT_RENDER MicrofacetTables {
+public:
+    using Table = std::vector<Float>;
+
+    /// Reflectance of a rough dielectric interface (see \ref eval_reflectance())
+    static std::shared_ptr<const Table> reflectance(MicrofacetType type, Float alpha,
+                                                    Float eta, size_t resolution);
+
+    /// Transmittance through a rough dielectric interface (see \ref eval_transmittance())
+    static std::shared_ptr<const Table> transmittance(MicrofacetType type, Float alpha,
+                                                      Float eta, size_t resolution);
+
+    /**
+     * \brief Directional albedo of a rough perfect mirror (see \ref eval_albedo())
+     *
+     * The table consists of \c resolution rows, which correspond to values of
+     * the roughness that are regularly spaced on the interval [0, 1].
+     */
+    static std::shared_ptr<const Table> albedo(MicrofacetType type, size_t resolution);
+
+    /**
+     * \brief Cosine-weighted average of the directional albedo over the
+     * hemisphere, for each row of \ref albedo()
+     */
+    static std::shared_ptr<const Table> average_albedo(MicrofacetType type, size_t resolution);
+
+    /// Return the number of cached tables
+    static size_t size();
+
+    /// Release all cached tables (tables that are still in use remain valid)
+    static void clear();
+};
+
 NAMESPACE_END(mitsuba)
@@ -85,6 +85,30 @@ public:
     /// Retrieve the next two component values from the current sample
     virtual Point2f next_2d(Mask active = true);
 
+    /**
+     * \brief Set the pixel that subsequently generated samples belong to
+     *
+     * Rendering algorithms call this function before generating the
+     * components of a sample. Samplers that correlate the samples of
+     * neighboring pixels (e.g. to distribute the error as blue noise in
+     * screen space) rely on it, while other samplers simply ignore it.
+     *
+     * In packet variants, \c pixel holds the pixel of every lane.
+     */
+    virtual void set_pixel(const Point2u &pixel);
+
+    /**
+     * \brief Set the index of the sample within its pixel for every lane
+     *
+     * Packet rendering algorithms process several samples of the same pixel
+     * in one packet without calling \c advance in between. They call this
+     * function before generating the components of a sample, so that
+     * samplers that rely on \ref set_pixel() can assign a different sample
+     * of the pixel to every lane. The index is taken modulo the sample count.
+     * Other samplers simply ignore it.
+     */
+    virtual void set_sample_index(const UInt32 &index);
+
     /// Return the number of samples per pixel
     uint32_t sample_count() const { return m_sample_count; }
 
@@ -1,13 +1,40 @@
 #pragma once
 
+#include <mitsuba/core/distr_1d.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/render/emitter.h>
+#include <mitsuba/render/lighttree.h>
 #include <mitsuba/render/shapegroup.h>
 #include <mitsuba/render/fwd.h>
 #include <mitsuba/render/sensor.h>
+#include <atomic>
 
 NAMESPACE_BEGIN(mitsuba)
 
+/// Strategies for selecting the emitter that is sampled by \ref Scene::sample_emitter_direction()
+enum class EmitterSelection : uint32_t {
+    /// Select all emitters with the same probability
+    Uniform,
+
+    /// Select emitters proportional to their estimated power
+    Power,
+
+    /**
+     * Select emitters using a light tree, i.e. proportional to a bound of their
+     * contribution to the reference point, which accounts for power, distance
+     * and orientation
+     */
+    LightTree
+};
+
+/// Statistics of the cache that accelerates shadow rays towards emitters
+struct OcclusionCacheStatistics {
+    /// Shadow rays that were found to be blocked by the cached primitive
+    uint64_t hits = 0;
+    /// Shadow rays that required a full traversal of the acceleration data structure
+    uint64_t misses = 0;
+};
+
 template <typename Float, typename Spectrum>
 class MTS_EXPORT_RENDER Scene : public Object {
 public:
@@ -127,6 +154,29 @@ public:
                                 const DirectionSample3f &ds,
                                 Mask active = true) const;
 
+    /**
+     * \brief Select an emitter for the given reference point
+     *
+     * \param ref
+     *    A reference point somewhere within the scene
+     *
+     * \param sample
+     *    A uniformly distributed sample on the interval [0, 1], which is
+     *    re-scaled so that it can be reused as a uniform variate
+     *
+     * \return
+     *    The index of the emitter within \ref emitters(), and the probability
+     *    of having selected it
+     */
+    std::pair<UInt32, Float> sample_emitter(const Interaction3f &ref, Float &sample,
+                                            Mask active = true) const;
+
+    /**
+     * \brief Evaluate the probability of selecting the emitter with the
+     * given index in \ref sample_emitter()
+     */
+    Float pdf_emitter(const Interaction3f &ref, UInt32 index, Mask active = true) const;
+
     //! @}
     // =============================================================
 
@@ -150,6 +200,20 @@ public:
     /// Return the environment emitter (if any)
     const Emitter *environment() const { return m_environment.get(); }
 
+    /// Return the strategy used to select emitters
+    EmitterSelection emitter_selection() const { return m_emitter_selection; }
+
+    /**
+     * \brief Return the statistics of the occlusion cache
+     *
+     * Every thread reports its counts in batches, hence the statistics may
+     * lag behind by a few hundred shadow rays per thread.
+     */
+    OcclusionCacheStatistics occlusion_cache_statistics() const;
+
+    /// Reset the statistics of the occlusion cache
+    void reset_occlusion_cache_statistics();
+
     /// Return the list of shapes
     std::vector<ref<Shape>> &shapes() { return m_shapes; }
     /// Return the list of shapes
@@ -191,6 +255,16 @@ protected:
     void accel_release_cpu();
     void accel_release_gpu();
 
+    /// Create the data structures used to select emitters
+    void emitter_selection_init(const Properties &props);
+
+    /// Estimate the power of an emitter by averaging the weights of sampled rays
+    ScalarFloat emitter_power(const Emitter *emitter) const;
+
+    /// Compute the bounds of an emitter that are stored in the light tree
+    typename LightTree<Float>::Bounds emitter_bounds(const Emitter *emitter,
+                                                    ScalarFloat power) const;
+
     /// Trace a ray and only return a preliminary intersection data structure
     MTS_INLINE PreliminaryIntersection3f ray_intersect_preliminary_cpu(const Ray3f &ray, Mask active) const;
     MTS_INLINE PreliminaryIntersection3f ray_intersect_preliminary_gpu(const Ray3f &ray, Mask active) const;
@@ -204,6 +278,18 @@ protected:
     MTS_INLINE Mask ray_test_cpu(const Ray3f &ray, Mask active) const;
     MTS_INLINE Mask ray_test_gpu(const Ray3f &ray, Mask active) const;
 
+    /**
+     * \brief Trace a shadow ray towards the emitter with index \c index,
+     * first testing the primitive that last blocked a shadow ray from the
+     * vicinity of \c p towards the same emitter
+     */
+    MTS_INLINE Mask ray_test_cached_cpu(const Ray3f &ray, const Point3f &p,
+                                        UInt32 index, Mask active) const;
+
+    /// Trace a shadow ray towards the emitter with index \c index
+    Mask ray_test_emitter(const Ray3f &ray, const Interaction3f &ref, UInt32 index,
+                          Mask active) const;
+
     using ShapeKDTree = mitsuba::ShapeKDTree<Float, Spectrum>;
 
 protected:
@@ -220,6 +306,24 @@ protected:
     ref<Integrator> m_integrator;
     ref<Emitter> m_environment;
 
+    EmitterSelection m_emitter_selection;
+    /// Selection probabilities proportional to the power of the emitters
+    DiscreteDistribution<Float> m_emitter_distr;
+    /// Light tree over all emitters at a finite distance
+    LightTree<Float> m_light_tree;
+    /// Emitters at infinity (selected uniformly when using the light tree)
+    DynamicBuffer<UInt32> m_infinite_emitters;
+    /// Probability of selecting an emitter at infinity when using the light tree
+    ScalarFloat m_infinite_prob = 0.f;
+
+    /// Cache the primitives that block shadow rays towards emitters?
+    bool m_occlusion_cache;
+    /// Identifies the scene in the thread-local occlusion caches
+    uint64_t m_occlusion_cache_id;
+    /// Size of the cells that group shading points sharing a cache entry
+    ScalarFloat m_occlusion_cell_size;
+    mutable std::atomic<uint64_t> m_occlusion_hits { 0 }, m_occlusion_misses { 0 };
+
     bool m_shapes_grad_enabled;
 };
 
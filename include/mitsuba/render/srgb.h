@@ -41,6 +41,20 @@ MTS_INLINE value_t<Array3f> srgb_model_mean(const Array3f &coeff) {
  */
 MTS_EXPORT_RENDER Array<float, 3> srgb_model_fetch(const Color<float, 3> &);
 
+/**
+ * \brief Look up model coefficients that can be linearly interpolated
+ *
+ * Black and white are represented by infinite coefficients, which turn into
+ * NaNs when they are interpolated. This function returns finite values
+ * instead, whose spectra deviate from zero or one by less than 1e-4.
+ */
+inline Array<float, 3> srgb_model_fetch_finite(const Color<float, 3> &c) {
+    Array<float, 3> coeff = srgb_model_fetch(c);
+    if (std::isinf(coeff.z()))
+        coeff.z() = coeff.z() > 0.f ? 100.f : -100.f;
+    return coeff;
+}
+
 /// Sanity check: convert the coefficients back to sRGB
 // MTS_EXPORT_RENDER Color<float, 3> srgb_model_eval_rgb(const Array<float, 3> &);
 
@@ -188,6 +188,15 @@ public:
     /// Does this texture evaluation depend on the UV coordinates
     virtual bool is_spatially_varying() const { return false; }
 
+    /**
+     * \brief Does this texture filter its lookups using the texture-space
+     * differentials <tt>si.duv_dx</tt> and <tt>si.duv_dy</tt>?
+     *
+     * BSDFs referencing such a texture request these differentials from the
+     * surface interaction (see \ref BSDF::update_differentials_flag()).
+     */
+    virtual bool needs_differentials() const { return false; }
+
     /// Convenience method returning the standard D65 illuminant.
     static ref<Texture> D65(ScalarFloat scale = 1.f);
 
@@ -245,6 +254,21 @@ public:
      */
     virtual ScalarVector3i resolution() const;
 
+    /**
+     * \brief Conservatively bound the texture's values over the cells of a
+     * regular grid that subdivides the given world-space bounding box.
+     *
+     * The returned array has <tt>hprod(resolution)</tt> entries in x-major
+     * order. Each entry bounds the values that \ref eval() can take anywhere
+     * inside the corresponding cell, which makes the result suitable as a
+     * spatially varying majorant for delta tracking.
+     *
+     * The default implementation fills the entire grid with \ref max().
+     */
+    virtual std::vector<ScalarFloat>
+    max_per_cell(const ScalarBoundingBox3f &bbox,
+                 const ScalarVector3u &resolution) const;
+
     //! @}
     // ======================================================================
 
@@ -1,5 +1,6 @@
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/fresnel.h>
+#include <mitsuba/render/fresneltable.h>
 #include <mitsuba/render/texture.h>
 #include <mitsuba/render/ior.h>
 
@@ -20,6 +21,10 @@ BSSRDF with python
  * - ext_ior
    - |float| or |string|
    - Exterior index of refraction specified numerically or using a known material name.  (Default: air / 1.000277)
+ * - fresnel_table
+   - |bool|
+   - Look up the Fresnel reflectance from a precomputed table instead of evaluating the Fresnel
+     equations exactly (see :ref:`dielectric <bsdf-dielectric>`). (Default: |false|)
 
 
 
@@ -81,6 +86,14 @@ public:
         m_components.push_back((uint32_t)BSDFFlags::BSSRDF);
 
         m_flags = m_components[0] | m_components[1] | m_components[2];
+
+        m_use_fresnel_table = props.bool_("fresnel_table", false);
+        parameters_changed();
+    }
+
+    void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override {
+        if (m_use_fresnel_table)
+            m_fresnel_table = FresnelTable<Float>::dielectric(m_eta);
     }
 
     std::pair<BSDFSample3f, Spectrum> sample(const BSDFContext &ctx,
@@ -96,7 +109,9 @@ public:
         // Evaluate the Fresnel equations for unpolarized illumination
         Float cos_theta_i = Frame3f::cos_theta(si.wi);
 
-        auto [r_i, cos_theta_t, eta_it, eta_ti] = fresnel(cos_theta_i, Float(m_eta));
+        auto [r_i, cos_theta_t, eta_it, eta_ti] =
+            m_use_fresnel_table ? m_fresnel_table.eval_dielectric(cos_theta_i, active)
+                                : fresnel(cos_theta_i, Float(m_eta));
         Float t_i = 1.f - r_i;
 
         // Lobe selection
@@ -255,7 +270,8 @@ public:
         oss << "  trans = " << m_trans << "," << std::endl;
         oss << "  rotate_x = " << m_rotate_x << "," << std::endl;
         oss << "  rotate_y = " << m_rotate_y << "," << std::endl;
-        oss << "  rotate_z = " << m_rotate_z << "," << std::endl
+        oss << "  rotate_z = " << m_rotate_z << "," << std::endl;
+        oss << "  fresnel_table = " << m_use_fresnel_table << std::endl
             << "]";
         return oss.str();
     }
@@ -271,6 +287,8 @@ private:
     ScalarInt32 m_mesh_id;
     Vector3f m_trans;
     ScalarFloat m_rotate_x, m_rotate_y, m_rotate_z;
+    bool m_use_fresnel_table;
+    FresnelTable<Float> m_fresnel_table;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(BSSRDF, BSDF)
@@ -2,6 +2,7 @@
 #include <mitsuba/core/warp.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/fresnel.h>
+#include <mitsuba/render/fresneltable.h>
 #include <mitsuba/render/ior.h>
 #include <mitsuba/render/texture.h>
 
@@ -26,6 +27,12 @@ Smooth conductor (:monosp:`conductor`)
    - |spectrum| or |texture|
    - Optional factor that can be used to modulate the specular reflection component.
      Note that for physical realism, this parameter should never be touched. (Default: 1.0)
+ * - fresnel_table
+   - |bool|
+   - Look up the unpolarized Fresnel reflectance from a precomputed table instead of evaluating
+     the Fresnel equations exactly. In spectral variants, the table is tabulated on a regular
+     grid of wavelengths. This requires :paramtype:`eta` and :paramtype:`k` to be spatially
+     constant, and is not supported in GPU variants. (Default: |false|)
 
 .. subfigstart::
 .. subfigure:: ../../resources/data/docs/images/render/bsdf_conductor_gold.jpg
@@ -212,6 +219,29 @@ public:
         } else {
             std::tie(m_eta, m_k) = complex_ior_from_file<Spectrum, Texture>(props.string("material", "Cu"));
         }
+
+        m_use_fresnel_table = props.bool_("fresnel_table", false);
+        if (m_use_fresnel_table) {
+            if constexpr (is_cuda_array_v<Float>) {
+                Log(Warn, "Fresnel tables are not supported in GPU variants, "
+                          "evaluating the Fresnel equations instead.");
+                m_use_fresnel_table = false;
+            } else if (m_eta->is_spatially_varying() || m_k->is_spatially_varying()) {
+                Log(Warn, "Fresnel tables require a spatially constant index of refraction, "
+                          "evaluating the Fresnel equations instead.");
+                m_use_fresnel_table = false;
+            }
+        }
+
+        parameters_changed();
+    }
+
+    void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override {
+        if constexpr (!is_cuda_array_v<Float>) {
+            if (m_use_fresnel_table)
+                m_fresnel_table =
+                    FresnelTable<Float>::template conductor<Spectrum>(m_eta.get(), m_k.get());
+        }
     }
 
     std::pair<BSDFSample3f, Spectrum> sample(const BSDFContext &ctx,
@@ -235,11 +265,12 @@ public:
         bs.eta = 1.f;
         bs.pdf = 1.f;
 
-        Complex<UnpolarizedSpectrum> eta(m_eta->eval(si, active),
-                                         m_k->eval(si, active));
         UnpolarizedSpectrum reflectance = m_specular_reflectance->eval(si, active);
 
         if constexpr (is_polarized_v<Spectrum>) {
+            Complex<UnpolarizedSpectrum> eta(m_eta->eval(si, active),
+                                             m_k->eval(si, active));
+
             /* Due to lack of reciprocity in polarization-aware pBRDFs, they are
                always evaluated w.r.t. the actual light propagation direction, no
                matter the transport mode. In the following, 'wi_hat' is toward the
@@ -269,7 +300,16 @@ public:
                                                    wo_hat, p_axis_out, mueller::stokes_basis(wo_hat));
             value *= mueller::absorber(reflectance);
         } else {
-            value = reflectance * fresnel_conductor(UnpolarizedSpectrum(cos_theta_i), eta);
+            UnpolarizedSpectrum F;
+            if (m_use_fresnel_table) {
+                F = m_fresnel_table.template eval_conductor<UnpolarizedSpectrum>(
+                    cos_theta_i, si.wavelengths, active);
+            } else {
+                Complex<UnpolarizedSpectrum> eta(m_eta->eval(si, active),
+                                                 m_k->eval(si, active));
+                F = fresnel_conductor(UnpolarizedSpectrum(cos_theta_i), eta);
+            }
+            value = reflectance * F;
         }
 
         return { bs, value & active };
@@ -300,7 +340,8 @@ public:
         oss << "SmoothConductor[" << std::endl
             << "  eta = " << string::indent(m_eta) << "," << std::endl
             << "  k = "   << string::indent(m_k)   << "," << std::endl
-            << "  specular_reflectance = " << string::indent(m_specular_reflectance) << std::endl
+            << "  specular_reflectance = " << string::indent(m_specular_reflectance) << "," << std::endl
+            << "  fresnel_table = " << m_use_fresnel_table << std::endl
             << "]";
         return oss.str();
     }
@@ -309,6 +350,8 @@ public:
 private:
     ref<Texture> m_specular_reflectance;
     ref<Texture> m_eta, m_k;
+    bool m_use_fresnel_table;
+    FresnelTable<Float> m_fresnel_table;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(SmoothConductor, BSDF)
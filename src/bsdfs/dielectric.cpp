@@ -1,5 +1,6 @@
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/fresnel.h>
+#include <mitsuba/render/fresneltable.h>
 #include <mitsuba/render/texture.h>
 #include <mitsuba/render/ior.h>
 
@@ -26,6 +27,11 @@ Smooth dielectric material (:monosp:`dielectric`)
  * - specular_transmittance
    - |spectrum| or |texture|
    - Optional factor that can be used to modulate the specular transmission component. Note that for physical realism, this parameter should never be touched. (Default: 1.0)
+ * - fresnel_table
+   - |bool|
+   - Look up the unpolarized Fresnel reflectance from a precomputed table instead of evaluating
+     the Fresnel equations exactly. This is faster, and the interpolation error of the reflectance
+     is below :math:`10^{-4}`. (Default: |false|, i.e. use the exact equations)
 
 .. subfigstart::
 .. subfigure:: ../../resources/data/docs/images/render/bsdf_dielectric_glass.jpg
@@ -196,6 +202,14 @@ public:
                                BSDFFlags::BackSide | BSDFFlags::NonSymmetric);
 
         m_flags = m_components[0] | m_components[1];
+
+        m_use_fresnel_table = props.bool_("fresnel_table", false);
+        parameters_changed();
+    }
+
+    void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override {
+        if (m_use_fresnel_table)
+            m_fresnel_table = FresnelTable<Float>::dielectric(m_eta);
     }
 
     std::pair<BSDFSample3f, Spectrum> sample(const BSDFContext &ctx,
@@ -211,7 +225,9 @@ public:
         // Evaluate the Fresnel equations for unpolarized illumination
         Float cos_theta_i = Frame3f::cos_theta(si.wi);
 
-        auto [r_i, cos_theta_t, eta_it, eta_ti] = fresnel(cos_theta_i, Float(m_eta));
+        auto [r_i, cos_theta_t, eta_it, eta_ti] =
+            m_use_fresnel_table ? m_fresnel_table.eval_dielectric(cos_theta_i, active)
+                                : fresnel(cos_theta_i, Float(m_eta));
         Float t_i = 1.f - r_i;
 
         // Lobe selection
@@ -345,6 +361,7 @@ public:
         if (m_specular_transmittance)
             oss << "  specular_transmittance = " << string::indent(m_specular_transmittance) << ", " << std::endl;
         oss << "  eta = " << m_eta << "," << std::endl
+            << "  fresnel_table = " << m_use_fresnel_table << std::endl
             << "]";
         return oss.str();
     }
@@ -354,6 +371,8 @@ private:
     ScalarFloat m_eta;
     ref<Texture> m_specular_reflectance;
     ref<Texture> m_specular_transmittance;
+    bool m_use_fresnel_table;
+    FresnelTable<Float> m_fresnel_table;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(SmoothDielectric, BSDF)
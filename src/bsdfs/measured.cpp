@@ -4,6 +4,10 @@
 #include <mitsuba/core/distr_2d.h>
 #include <mitsuba/core/warp.h>
 #include <mitsuba/render/bsdf.h>
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
 
 /// Set to 1 to fall back to cosine-weighted sampling (for debugging)
 #define MTS_SAMPLE_DIFFUSE     0
@@ -13,38 +17,45 @@
 
 NAMESPACE_BEGIN(mitsuba)
 
-template <typename Float, typename Spectrum>
-class Measured final : public BSDF<Float, Spectrum> {
-public:
-    MTS_IMPORT_BASE(BSDF, m_flags, m_components)
-    MTS_IMPORT_TYPES()
-
-    using Warp2D0 = Marginal2D<Float, 0, true>;
-    using Warp2D2 = Marginal2D<Float, 2, true>;
-    using Warp2D3 = Marginal2D<Float, 3, true>;
-
-    Measured(const Properties &props) : Base(props) {
-        if constexpr (is_polarized_v<Spectrum>)
-            Throw("The measured BSDF model requires that rendering takes place in spectral mode!");
-
-        m_components.push_back(BSDFFlags::GlossyReflection | BSDFFlags::FrontSide);
-        m_flags = m_components[0];
-
-        auto fs            = Thread::thread()->file_resolver();
-        fs::path file_path = fs->resolve(props.string("filename"));
-        m_name             = file_path.filename().string();
-
+NAMESPACE_BEGIN(detail)
+
+/**
+ * \brief Tabulated representation of a measured material
+ *
+ * The data structures only depend on the file and on the floating point
+ * type, and they are never modified after construction. They are thus shared
+ * between all plugin instances (and Spectrum variants) that reference the
+ * same file, see \ref MeasuredDataCache.
+ */
+template <typename Float> struct MeasuredData {
+    using ScalarFloat    = scalar_t<Float>;
+    using ScalarVector2u = Vector<uint32_t, 2>;
+    using Warp2D0        = Marginal2D<Float, 0, true>;
+    using Warp2D2        = Marginal2D<Float, 2, true>;
+    using Warp2D3        = Marginal2D<Float, 3, true>;
+
+    Warp2D0 ndf;
+    Warp2D0 sigma;
+    Warp2D2 vndf;
+    Warp2D2 luminance;
+    Warp2D3 spectra;
+    bool isotropic;
+    bool jacobian;
+    int reduction = 0;
+
+    MeasuredData(const fs::path &file_path) {
+        // The tensor file is memory-mapped, its fields are read in place
         ref<TensorFile> tf = new TensorFile(file_path);
         auto theta_i       = tf->field("theta_i");
         auto phi_i         = tf->field("phi_i");
-        auto ndf           = tf->field("ndf");
-        auto sigma         = tf->field("sigma");
-        auto vndf          = tf->field("vndf");
-        auto spectra       = tf->field("spectra");
-        auto luminance     = tf->field("luminance");
+        auto ndf_          = tf->field("ndf");
+        auto sigma_        = tf->field("sigma");
+        auto vndf_         = tf->field("vndf");
+        auto spectra_      = tf->field("spectra");
+        auto luminance_    = tf->field("luminance");
         auto wavelengths   = tf->field("wavelengths");
         auto description   = tf->field("description");
-        auto jacobian      = tf->field("jacobian");
+        auto jacobian_     = tf->field("jacobian");
 
         if (!(description.shape.size() == 1 &&
               description.dtype == Struct::Type::UInt8 &&
@@ -58,91 +69,92 @@ public:
               wavelengths.shape.size() == 1 &&
               wavelengths.dtype == Struct::Type::Float32 &&
 
-              ndf.shape.size() == 2 &&
-              ndf.dtype == Struct::Type::Float32 &&
+              ndf_.shape.size() == 2 &&
+              ndf_.dtype == Struct::Type::Float32 &&
 
-              sigma.shape.size() == 2 &&
-              sigma.dtype == Struct::Type::Float32 &&
+              sigma_.shape.size() == 2 &&
+              sigma_.dtype == Struct::Type::Float32 &&
 
-              vndf.shape.size() == 4 &&
-              vndf.dtype == Struct::Type::Float32 &&
-              vndf.shape[0] == phi_i.shape[0] &&
-              vndf.shape[1] == theta_i.shape[0] &&
+              vndf_.shape.size() == 4 &&
+              vndf_.dtype == Struct::Type::Float32 &&
+              vndf_.shape[0] == phi_i.shape[0] &&
+              vndf_.shape[1] == theta_i.shape[0] &&
 
-              luminance.shape.size() == 4 &&
-              luminance.dtype == Struct::Type::Float32 &&
-              luminance.shape[0] == phi_i.shape[0] &&
-              luminance.shape[1] == theta_i.shape[0] &&
-              luminance.shape[2] == luminance.shape[3] &&
+              luminance_.shape.size() == 4 &&
+              luminance_.dtype == Struct::Type::Float32 &&
+              luminance_.shape[0] == phi_i.shape[0] &&
+              luminance_.shape[1] == theta_i.shape[0] &&
+              luminance_.shape[2] == luminance_.shape[3] &&
 
-              spectra.dtype == Struct::Type::Float32 &&
-              spectra.shape.size() == 5 &&
-              spectra.shape[0] == phi_i.shape[0] &&
-              spectra.shape[1] == theta_i.shape[0] &&
-              spectra.shape[2] == wavelengths.shape[0] &&
-              spectra.shape[3] == spectra.shape[4] &&
+              spectra_.dtype == Struct::Type::Float32 &&
+              spectra_.shape.size() == 5 &&
+              spectra_.shape[0] == phi_i.shape[0] &&
+              spectra_.shape[1] == theta_i.shape[0] &&
+              spectra_.shape[2] == wavelengths.shape[0] &&
+              spectra_.shape[3] == spectra_.shape[4] &&
 
-              luminance.shape[2] == spectra.shape[3] &&
-              luminance.shape[3] == spectra.shape[4] &&
+              luminance_.shape[2] == spectra_.shape[3] &&
+              luminance_.shape[3] == spectra_.shape[4] &&
 
-              jacobian.shape.size() == 1 &&
-              jacobian.shape[0] == 1 &&
-              jacobian.dtype == Struct::Type::UInt8))
+              jacobian_.shape.size() == 1 &&
+              jacobian_.shape[0] == 1 &&
+              jacobian_.dtype == Struct::Type::UInt8))
               Throw("Invalid file structure: %s", tf);
 
-        m_isotropic = phi_i.shape[0] <= 2;
-        m_jacobian  = ((uint8_t *) jacobian.data)[0];
+        std::vector<ScalarFloat> theta_i_storage, phi_i_storage, wavelengths_storage;
+        const ScalarFloat *theta_i_data     = field_data(theta_i, theta_i_storage),
+                          *phi_i_data       = field_data(phi_i, phi_i_storage),
+                          *wavelengths_data = field_data(wavelengths, wavelengths_storage);
+
+        isotropic = phi_i.shape[0] <= 2;
+        jacobian  = ((uint8_t *) jacobian_.data)[0];
 
-        if (!m_isotropic) {
-            ScalarFloat *phi_i_data = (ScalarFloat *) phi_i.data;
-            m_reduction = (int) std::rint((2 * math::Pi<ScalarFloat>) /
+        if (!isotropic)
+            reduction = (int) std::rint((2 * math::Pi<ScalarFloat>) /
                 (phi_i_data[phi_i.shape[0] - 1] - phi_i_data[0]));
-        }
+
+        std::vector<ScalarFloat> storage;
 
         // Construct NDF interpolant data structure
-        m_ndf = Warp2D0(
-            (ScalarFloat *) ndf.data,
-            ScalarVector2u(ndf.shape[1], ndf.shape[0]),
+        ndf = Warp2D0(
+            field_data(ndf_, storage),
+            ScalarVector2u(ndf_.shape[1], ndf_.shape[0]),
             { }, { }, false, false
         );
 
         // Construct projected surface area interpolant data structure
-        m_sigma = Warp2D0(
-            (ScalarFloat *) sigma.data,
-            ScalarVector2u(sigma.shape[1], sigma.shape[0]),
+        sigma = Warp2D0(
+            field_data(sigma_, storage),
+            ScalarVector2u(sigma_.shape[1], sigma_.shape[0]),
             { }, { }, false, false
         );
 
         // Construct VNDF warp data structure
-        m_vndf = Warp2D2(
-            (ScalarFloat *) vndf.data,
-            ScalarVector2u(vndf.shape[3], vndf.shape[2]),
+        vndf = Warp2D2(
+            field_data(vndf_, storage),
+            ScalarVector2u(vndf_.shape[3], vndf_.shape[2]),
             {{ (uint32_t) phi_i.shape[0],
                (uint32_t) theta_i.shape[0] }},
-            {{ (const ScalarFloat *) phi_i.data,
-               (const ScalarFloat *) theta_i.data }}
+            {{ phi_i_data, theta_i_data }}
         );
 
         // Construct Luminance warp data structure
-        m_luminance = Warp2D2(
-            (ScalarFloat *) luminance.data,
-            ScalarVector2u(luminance.shape[3], luminance.shape[2]),
+        luminance = Warp2D2(
+            field_data(luminance_, storage),
+            ScalarVector2u(luminance_.shape[3], luminance_.shape[2]),
             {{ (uint32_t) phi_i.shape[0],
                (uint32_t) theta_i.shape[0] }},
-            {{ (const ScalarFloat *) phi_i.data,
-               (const ScalarFloat *) theta_i.data }}
+            {{ phi_i_data, theta_i_data }}
         );
 
         // Construct spectral interpolant
-        m_spectra = Warp2D3(
-            (ScalarFloat *) spectra.data,
-            ScalarVector2u(spectra.shape[4], spectra.shape[3]),
+        spectra = Warp2D3(
+            field_data(spectra_, storage),
+            ScalarVector2u(spectra_.shape[4], spectra_.shape[3]),
             {{ (uint32_t) phi_i.shape[0],
                (uint32_t) theta_i.shape[0],
                (uint32_t) wavelengths.shape[0] }},
-            {{ (const ScalarFloat *) phi_i.data,
-               (const ScalarFloat *) theta_i.data,
-               (const ScalarFloat *) wavelengths.data }},
+            {{ phi_i_data, theta_i_data, wavelengths_data }},
             false, false
         );
 
@@ -152,8 +164,133 @@ public:
         );
 
         Log(Info, "Loaded material \"%s\" (resolution %i x %i x %i x %i x %i)",
-            description_str, spectra.shape[0], spectra.shape[1],
-            spectra.shape[3], spectra.shape[4], spectra.shape[2]);
+            description_str, spectra_.shape[0], spectra_.shape[1],
+            spectra_.shape[3], spectra_.shape[4], spectra_.shape[2]);
+    }
+
+private:
+    /**
+     * \brief Return the contents of a single precision field in the
+     * precision of \c ScalarFloat
+     *
+     * Single precision variants directly use the memory-mapped file contents.
+     * Otherwise, the values are converted into \c storage.
+     */
+    static const ScalarFloat *field_data(const TensorFile::Field &field,
+                                         std::vector<ScalarFloat> &storage) {
+        if constexpr (std::is_same_v<ScalarFloat, float>) {
+            ENOKI_MARK_USED(storage);
+            return (const ScalarFloat *) field.data;
+        } else {
+            size_t size = 1;
+            for (size_t s : field.shape)
+                size *= s;
+            const float *data = (const float *) field.data;
+            storage.assign(data, data + size);
+            return storage.data();
+        }
+    }
+};
+
+/**
+ * \brief Process-wide cache of measured materials, keyed by the resolved
+ * filename
+ *
+ * The cache only holds weak references, i.e. a material is released once the
+ * last plugin instance using it is destroyed.
+ */
+template <typename Float> struct MeasuredDataCache {
+    using Data    = MeasuredData<Float>;
+    using DataPtr = std::shared_ptr<const Data>;
+    using WeakPtr = std::weak_ptr<const Data>;
+
+    std::mutex mutex;
+    std::map<std::string, std::shared_future<WeakPtr>> entries;
+
+    /**
+     * \brief Look up a material, and load it if it is not cached yet
+     *
+     * The material is loaded outside of the lock, so that different files can
+     * be loaded concurrently. Concurrent requests for the same file wait for
+     * the instance that loads it.
+     */
+    static DataPtr get(const fs::path &file_path) {
+        MeasuredDataCache &cache = instance();
+        std::string key = file_path.string();
+
+        while (true) {
+            std::promise<WeakPtr> promise;
+            std::shared_future<WeakPtr> future;
+            bool owner = false;
+
+            /* Critical section */ {
+                std::lock_guard<std::mutex> guard(cache.mutex);
+                auto it = cache.entries.find(key);
+                if (it == cache.entries.end()) {
+                    future = promise.get_future().share();
+                    cache.entries.emplace(key, future);
+                    owner = true;
+                } else {
+                    future = it->second;
+                }
+            }
+
+            if (owner) {
+                DataPtr data;
+                try {
+                    data = std::make_shared<const Data>(file_path);
+                } catch (...) {
+                    /* Critical section */ {
+                        std::lock_guard<std::mutex> guard(cache.mutex);
+                        cache.entries.erase(key);
+                    }
+                    promise.set_exception(std::current_exception());
+                    throw;
+                }
+                promise.set_value(data);
+                return data;
+            }
+
+            if (DataPtr data = future.get().lock())
+                return data;
+
+            /* The material was already released, remove the stale entry (unless
+               another thread has replaced it in the meantime) and retry */
+            std::lock_guard<std::mutex> guard(cache.mutex);
+            auto it = cache.entries.find(key);
+            if (it != cache.entries.end() &&
+                it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready &&
+                it->second.get().expired())
+                cache.entries.erase(it);
+        }
+    }
+
+    static MeasuredDataCache &instance() {
+        static MeasuredDataCache cache;
+        return cache;
+    }
+};
+
+NAMESPACE_END(detail)
+
+template <typename Float, typename Spectrum>
+class Measured final : public BSDF<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(BSDF, m_flags, m_components)
+    MTS_IMPORT_TYPES()
+
+    Measured(const Properties &props) : Base(props) {
+        if constexpr (is_polarized_v<Spectrum>)
+            Throw("The measured BSDF model requires that rendering takes place in spectral mode!");
+
+        m_components.push_back(BSDFFlags::GlossyReflection | BSDFFlags::FrontSide);
+        m_flags = m_components[0];
+
+        auto fs            = Thread::thread()->file_resolver();
+        fs::path file_path = fs->resolve(props.string("filename"));
+        m_name             = file_path.filename().string();
+
+        m_data = detail::MeasuredDataCache<Float>::get(file_path);
     }
 
     /**
@@ -183,9 +320,9 @@ public:
 
         Float sx = -1.f, sy = -1.f;
 
-        if (m_reduction >= 2) {
+        if (m_data->reduction >= 2) {
             sy = wi.y();
-            sx = (m_reduction == 4) ? wi.x() : sy;
+            sx = (m_data->reduction == 4) ? wi.x() : sy;
             wi.x() = mulsign_neg(wi.x(), sx);
             wi.y() = mulsign_neg(wi.y(), sy);
         }
@@ -203,15 +340,15 @@ public:
         Float pdf = 1.f;
 
         #if MTS_SAMPLE_LUMINANCE == 1
-        std::tie(sample, pdf) = m_luminance.sample(sample, params, active);
+        std::tie(sample, pdf) = m_data->luminance.sample(sample, params, active);
         #endif
 
-        auto [u_m, ndf_pdf] = m_vndf.sample(sample, params, active);
+        auto [u_m, ndf_pdf] = m_data->vndf.sample(sample, params, active);
 
         Float phi_m   = u2phi(u_m.y()),
             theta_m = u2theta(u_m.x());
 
-        if (m_isotropic)
+        if (m_data->isotropic)
             phi_m += phi_i;
 
         // Spherical -> Cartesian coordinates
@@ -240,11 +377,11 @@ public:
             phi_m   = atan2(m.y(), m.x());
 
         Vector2f u_m(theta2u(theta_m),
-                    phi2u(m_isotropic ? (phi_m - phi_i) : phi_m));
+                    phi2u(m_data->isotropic ? (phi_m - phi_i) : phi_m));
 
         u_m[1] = u_m[1] - floor(u_m[1]);
 
-    std::tie(sample, std::ignore) = m_vndf.invert(u_m, params, active);
+    std::tie(sample, std::ignore) = m_data->vndf.invert(u_m, params, active);
 #endif // MTS_SAMPLE_DIFFUSE
 
         bs.eta               = 1.f;
@@ -254,12 +391,12 @@ public:
         UnpolarizedSpectrum spec;
         for (size_t i = 0; i < array_size_v<UnpolarizedSpectrum>; ++i) {
             Float params_spec[3] = { phi_i, theta_i, si.wavelengths[i] };
-            spec[i] = m_spectra.eval(sample, params_spec, active);
+            spec[i] = m_data->spectra.eval(sample, params_spec, active);
         }
 
-        if (m_jacobian)
-            spec *= m_ndf.eval(u_m, params, active) /
-                    (4 * m_sigma.eval(u_wi, params, active));
+        if (m_data->jacobian)
+            spec *= m_data->ndf.eval(u_m, params, active) /
+                    (4 * m_data->sigma.eval(u_wi, params, active));
 
         bs.wo.x() = mulsign_neg(bs.wo.x(), sx);
         bs.wo.y() = mulsign_neg(bs.wo.y(), sy);
@@ -281,9 +418,9 @@ public:
         if (!ctx.is_enabled(BSDFFlags::GlossyReflection) || none_or<false>(active))
             return Spectrum(0.f);
 
-        if (m_reduction >= 2) {
+        if (m_data->reduction >= 2) {
             Float sy = wi.y(),
-                sx = (m_reduction == 4) ? wi.x() : sy;
+                sx = (m_data->reduction == 4) ? wi.x() : sy;
 
             wi.x() = mulsign_neg(wi.x(), sx);
             wi.y() = mulsign_neg(wi.y(), sy);
@@ -302,22 +439,22 @@ public:
         // Spherical coordinates -> unit coordinate system
         Vector2f u_wi(theta2u(theta_i), phi2u(phi_i)),
                 u_m (theta2u(theta_m), phi2u(
-                    m_isotropic ? (phi_m - phi_i) : phi_m));
+                    m_data->isotropic ? (phi_m - phi_i) : phi_m));
 
         u_m[1] = u_m[1] - floor(u_m[1]);
 
         Float params[2] = { phi_i, theta_i };
-        auto [sample, unused] = m_vndf.invert(u_m, params, active);
+        auto [sample, unused] = m_data->vndf.invert(u_m, params, active);
 
         UnpolarizedSpectrum spec;
         for (size_t i = 0; i < array_size_v<UnpolarizedSpectrum>; ++i) {
             Float params_spec[3] = { phi_i, theta_i, si.wavelengths[i] };
-            spec[i] = m_spectra.eval(sample, params_spec, active);
+            spec[i] = m_data->spectra.eval(sample, params_spec, active);
         }
 
-        if (m_jacobian)
-            spec *= m_ndf.eval(u_m, params, active) /
-                    (4 * m_sigma.eval(u_wi, params, active));
+        if (m_data->jacobian)
+            spec *= m_data->ndf.eval(u_m, params, active) /
+                    (4 * m_data->sigma.eval(u_wi, params, active));
 
         return unpolarized<Spectrum>(spec) & active;
     }
@@ -334,9 +471,9 @@ public:
         if (!ctx.is_enabled(BSDFFlags::GlossyReflection) || none_or<false>(active))
             return 0.f;
 
-        if (m_reduction >= 2) {
+        if (m_data->reduction >= 2) {
             Float sy = wi.y(),
-                sx = (m_reduction == 4) ? wi.x() : sy;
+                sx = (m_data->reduction == 4) ? wi.x() : sy;
 
             wi.x() = mulsign_neg(wi.x(), sx);
             wi.y() = mulsign_neg(wi.y(), sy);
@@ -358,16 +495,16 @@ public:
         // Spherical coordinates -> unit coordinate system
         Vector2f u_wi(theta2u(theta_i), phi2u(phi_i));
         Vector2f u_m (theta2u(theta_m),
-                    phi2u(m_isotropic ? (phi_m - phi_i) : phi_m));
+                    phi2u(m_data->isotropic ? (phi_m - phi_i) : phi_m));
 
         u_m[1] = u_m[1] - floor(u_m[1]);
 
         Float params[2] = { phi_i, theta_i };
-        auto [sample, vndf_pdf] = m_vndf.invert(u_m, params, active);
+        auto [sample, vndf_pdf] = m_data->vndf.invert(u_m, params, active);
 
         Float pdf = 1.f;
         #if MTS_SAMPLE_LUMINANCE == 1
-        pdf = m_luminance.eval(sample, params, active);
+        pdf = m_data->luminance.eval(sample, params, active);
         #endif
 
         Float jacobian =
@@ -388,11 +525,11 @@ public:
         std::ostringstream oss;
         oss << "Measured[" << std::endl
             << "  filename = \"" << m_name << "\"," << std::endl
-            << "  ndf = " << string::indent(m_ndf.to_string()) << "," << std::endl
-            << "  sigma = " << string::indent(m_sigma.to_string()) << "," << std::endl
-            << "  vndf = " << string::indent(m_vndf.to_string()) << "," << std::endl
-            << "  luminance = " << string::indent(m_luminance.to_string()) << "," << std::endl
-            << "  spectra = " << string::indent(m_spectra.to_string()) << std::endl
+            << "  ndf = " << string::indent(m_data->ndf.to_string()) << "," << std::endl
+            << "  sigma = " << string::indent(m_data->sigma.to_string()) << "," << std::endl
+            << "  vndf = " << string::indent(m_data->vndf.to_string()) << "," << std::endl
+            << "  luminance = " << string::indent(m_data->luminance.to_string()) << "," << std::endl
+            << "  spectra = " << string::indent(m_data->spectra.to_string()) << std::endl
             << "]";
         return oss.str();
     }
@@ -417,14 +554,7 @@ private:
 
 private:
     std::string m_name;
-    Warp2D0 m_ndf;
-    Warp2D0 m_sigma;
-    Warp2D2 m_vndf;
-    Warp2D2 m_luminance;
-    Warp2D3 m_spectra;
-    bool m_isotropic;
-    bool m_jacobian;
-    int m_reduction;
+    std::shared_ptr<const detail::MeasuredData<Float>> m_data;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(Measured, BSDF)
@@ -2,10 +2,13 @@
 #include <mitsuba/core/fwd.h>
 #include <mitsuba/core/plugin.h>
 #include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/fresneltable.h>
 #include <mitsuba/render/ior.h>
 #include <mitsuba/render/microfacet.h>
 #include <mitsuba/render/texture.h>
 
+#define MTS_MICROFACET_ALBEDO_RES 32
+
 NAMESPACE_BEGIN(mitsuba)
 
 /**!
@@ -48,6 +51,14 @@ Rough conductor material (:monosp:`roughconductor`)
    - Enables a sampling technique proposed by Heitz and D'Eon :cite:`Heitz1014Importance`, which
      focuses computation on the visible parts of the microfacet normal distribution, considerably
      reducing variance in some cases. (Default: |true|, i.e. use visible normal sampling)
+ * - energy_compensation
+   - |bool|
+   - Adds a lobe that accounts for the energy lost by the microfacet model due to multiple
+     scattering between the microfacets :cite:`Kulla2017Revisiting`. (Default: |false|)
+ * - fresnel_table
+   - |bool|
+   - Look up the unpolarized Fresnel reflectance from a precomputed table instead of evaluating
+     the Fresnel equations exactly (see :ref:`conductor <bsdf-conductor>`). (Default: |false|)
 
 This plugin implements a realistic microfacet scattering model for rendering
 rough conducting materials, such as metals.
@@ -136,6 +147,17 @@ consider using the :ref:`twosided <bsdf-twosided>` BRDF adapter.
 In *polarized* rendering modes, the material automatically switches to a polarized
 implementation of the underlying Fresnel equations.
 
+The microfacet model only accounts for light that is reflected once by the
+microfacets. Light that is reflected several times is lost, which darkens very
+rough materials noticeably. When :monosp:`energy_compensation` is enabled, the
+plugin adds the multiple scattering lobe proposed by Kulla and Conty
+:cite:`Kulla2017Revisiting`, which restores the missing energy based on the
+precomputed albedo of the microfacet model. Its Fresnel factor is approximated
+using the reflectance at normal incidence, and anisotropic roughness is
+approximated by the geometric mean of :math:`\alpha_u` and :math:`\alpha_v`.
+The albedo tables are computed once per process and shared by all instances.
+In *polarized* rendering modes, this additional lobe is depolarizing.
+
  */
 
 template <typename Float, typename Spectrum>
@@ -185,17 +207,50 @@ public:
         if (props.has_property("specular_reflectance"))
             m_specular_reflectance = props.texture<Texture>("specular_reflectance", 1.f);
 
+        m_energy_compensation = props.bool_("energy_compensation", false);
+        if (m_energy_compensation) {
+            using Tables = MicrofacetTables<ScalarFloat>;
+            auto albedo = Tables::albedo(m_type, MTS_MICROFACET_ALBEDO_RES),
+                 average_albedo = Tables::average_albedo(m_type, MTS_MICROFACET_ALBEDO_RES);
+            m_albedo = DynamicBuffer<Float>::copy(albedo->data(), albedo->size());
+            m_average_albedo = DynamicBuffer<Float>::copy(average_albedo->data(),
+                                                          average_albedo->size());
+        }
+
+        m_use_fresnel_table = props.bool_("fresnel_table", false);
+        if (m_use_fresnel_table) {
+            if constexpr (is_cuda_array_v<Float>) {
+                Log(Warn, "Fresnel tables are not supported in GPU variants, "
+                          "evaluating the Fresnel equations instead.");
+                m_use_fresnel_table = false;
+            } else if (m_eta->is_spatially_varying() || m_k->is_spatially_varying()) {
+                Log(Warn, "Fresnel tables require a spatially constant index of refraction, "
+                          "evaluating the Fresnel equations instead.");
+                m_use_fresnel_table = false;
+            }
+        }
+
         m_flags = BSDFFlags::GlossyReflection | BSDFFlags::FrontSide;
         if (m_alpha_u != m_alpha_v)
             m_flags = m_flags | BSDFFlags::Anisotropic;
 
         m_components.clear();
         m_components.push_back(m_flags);
+
+        parameters_changed();
+    }
+
+    void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override {
+        if constexpr (!is_cuda_array_v<Float>) {
+            if (m_use_fresnel_table)
+                m_fresnel_table =
+                    FresnelTable<Float>::template conductor<Spectrum>(m_eta.get(), m_k.get());
+        }
     }
 
     std::pair<BSDFSample3f, Spectrum> sample(const BSDFContext &ctx,
                                              const SurfaceInteraction3f &si,
-                                             Float /* sample1 */,
+                                             Float sample1,
                                              const Point2f &sample2,
                                              Mask active) const override {
         MTS_MASKED_FUNCTION(ProfilerPhase::BSDFSample, active);
@@ -224,6 +279,19 @@ public:
         bs.sampled_component = 0;
         bs.sampled_type = +BSDFFlags::GlossyReflection;
 
+        if (unlikely(m_energy_compensation)) {
+            /* Alternatively sample the multiple scattering lobe. The lobes
+               overlap, hence the complete model is evaluated in this case. */
+            Float alpha = sqrt(distr.alpha_u() * distr.alpha_v());
+            Mask sample_ms = active && sample1 < ms_probability(cos_theta_i, alpha, active);
+            masked(bs.wo, sample_ms) = warp::square_to_cosine_hemisphere(sample2);
+
+            bs.pdf = pdf(ctx, si, bs.wo, active);
+            active &= bs.pdf > 0.f;
+            Spectrum value = eval(ctx, si, bs.wo, active);
+            return { bs, select(active, value / bs.pdf, 0.f) };
+        }
+
         // Ensure that this is a valid sample
         active &= neq(bs.pdf, 0.f) && Frame3f::cos_theta(bs.wo) > 0.f;
 
@@ -238,11 +306,11 @@ public:
         bs.pdf /= 4.f * dot(bs.wo, m);
 
         // Evaluate the Fresnel factor
-        Complex<UnpolarizedSpectrum> eta_c(m_eta->eval(si, active),
-                                           m_k->eval(si, active));
-
         Spectrum F;
         if constexpr (is_polarized_v<Spectrum>) {
+            Complex<UnpolarizedSpectrum> eta_c(m_eta->eval(si, active),
+                                               m_k->eval(si, active));
+
             /* Due to lack of reciprocity in polarization-aware pBRDFs, they are
                always evaluated w.r.t. the actual light propagation direction, no
                matter the transport mode. In the following, 'wi_hat' is toward the
@@ -270,7 +338,7 @@ public:
                                               -wi_hat, p_axis_in, mueller::stokes_basis(-wi_hat),
                                                wo_hat, p_axis_out, mueller::stokes_basis(wo_hat));
         } else {
-            F = fresnel_conductor(UnpolarizedSpectrum(dot(si.wi, m)), eta_c);
+            F = eval_fresnel(si, dot(si.wi, m), active);
         }
 
         /* If requested, include the specular reflectance component */
@@ -305,6 +373,8 @@ public:
         // Evaluate the microfacet normal distribution
         Float D = distr.eval(H);
 
+        // The multiple scattering lobe does not depend on the microfacet normal
+        Mask active_ms = active;
         active &= neq(D, 0.f);
 
         // Evaluate Smith's shadow-masking function
@@ -314,11 +384,11 @@ public:
         UnpolarizedSpectrum result = D * G / (4.f * Frame3f::cos_theta(si.wi));
 
         // Evaluate the Fresnel factor
-        Complex<UnpolarizedSpectrum> eta_c(m_eta->eval(si, active),
-                                           m_k->eval(si, active));
-
         Spectrum F;
         if constexpr (is_polarized_v<Spectrum>) {
+            Complex<UnpolarizedSpectrum> eta_c(m_eta->eval(si, active_ms),
+                                               m_k->eval(si, active_ms));
+
             /* Due to lack of reciprocity in polarization-aware pBRDFs, they are
                always evaluated w.r.t. the actual light propagation direction, no
                matter the transport mode. In the following, 'wi_hat' is toward the
@@ -346,14 +416,22 @@ public:
                                               -wi_hat, p_axis_in, mueller::stokes_basis(-wi_hat),
                                                wo_hat, p_axis_out, mueller::stokes_basis(wo_hat));
         } else {
-            F = fresnel_conductor(UnpolarizedSpectrum(dot(si.wi, H)), eta_c);
+            F = eval_fresnel(si, dot(si.wi, H), active_ms);
         }
 
         /* If requested, include the specular reflectance component */
         if (m_specular_reflectance)
             result *= m_specular_reflectance->eval(si, active);
 
-        return (F * result) & active;
+        Spectrum value = (F * result) & active;
+
+        if (unlikely(m_energy_compensation)) {
+            Float alpha = sqrt(distr.alpha_u() * distr.alpha_v());
+            value += unpolarized<Spectrum>(eval_ms(si, cos_theta_i, cos_theta_o,
+                                                   alpha, active_ms)) & active_ms;
+        }
+
+        return value;
     }
 
     Float pdf(const BSDFContext &ctx, const SurfaceInteraction3f &si,
@@ -366,14 +444,18 @@ public:
         // Calculate the half-direction vector
         Vector3f m = normalize(wo + si.wi);
 
+        // The multiple scattering lobe only requires both directions to be in the upper hemisphere
+        active &= cos_theta_i > 0.f && cos_theta_o > 0.f;
+        Mask active_ms = active;
+
         /* Filter cases where the micro/macro-surface don't agree on the side.
            This logic is evaluated in smith_g1() called as part of the eval()
            and sample() methods and needs to be replicated in the probability
            density computation as well. */
-        active &= cos_theta_i   > 0.f && cos_theta_o   > 0.f &&
-                  dot(si.wi, m) > 0.f && dot(wo,    m) > 0.f;
+        active &= dot(si.wi, m) > 0.f && dot(wo, m) > 0.f;
 
-        if (unlikely(!ctx.is_enabled(BSDFFlags::GlossyReflection) || none_or<false>(active)))
+        if (unlikely(!ctx.is_enabled(BSDFFlags::GlossyReflection) ||
+                     none_or<false>(m_energy_compensation ? active_ms : active)))
             return 0.f;
 
         /* Construct a microfacet distribution matching the
@@ -390,7 +472,17 @@ public:
         else
             result = distr.pdf(si.wi, m) / (4.f * dot(wo, m));
 
-        return select(active, result, 0.f);
+        result = select(active, result, 0.f);
+
+        if (unlikely(m_energy_compensation)) {
+            Float alpha = sqrt(distr.alpha_u() * distr.alpha_v()),
+                  prob_ms = ms_probability(cos_theta_i, alpha, active_ms);
+            result = select(active_ms,
+                            lerp(result, warp::square_to_cosine_hemisphere_pdf(wo), prob_ms),
+                            0.f);
+        }
+
+        return result;
     }
 
     Int32 mesh_id(Mask /*active*/) const override {
@@ -420,12 +512,90 @@ public:
         if (m_specular_reflectance)
            oss << "  specular_reflectance = " << string::indent(m_specular_reflectance) << "," << std::endl;
         oss << "  eta = " << string::indent(m_eta) << "," << std::endl
-            << "  k = " << string::indent(m_k) << std::endl
+            << "  k = " << string::indent(m_k) << "," << std::endl
+            << "  energy_compensation = " << m_energy_compensation << "," << std::endl
+            << "  fresnel_table = " << m_use_fresnel_table << std::endl
             << "]";
         return oss.str();
     }
 
     MTS_DECLARE_CLASS()
+private:
+    /// Bilinearly interpolate the albedo table (rows: roughness, columns: cosine)
+    Float albedo(Float cos_theta, Float alpha, Mask active) const {
+        uint32_t res = MTS_MICROFACET_ALBEDO_RES;
+        Float x = clamp(cos_theta, 0.f, 1.f) * ScalarFloat(res - 1),
+              y = clamp(alpha, 0.f, 1.f) * ScalarFloat(res - 1);
+
+        UInt32 xi = min(UInt32(x), res - 2),
+               yi = min(UInt32(y), res - 2),
+               index = yi * res + xi;
+
+        Float v00 = gather<Float>(m_albedo, index, active),
+              v10 = gather<Float>(m_albedo, index + 1, active),
+              v01 = gather<Float>(m_albedo, index + res, active),
+              v11 = gather<Float>(m_albedo, index + res + 1, active);
+
+        Float fx = x - Float(xi);
+        return lerp(lerp(v00, v10, fx), lerp(v01, v11, fx), y - Float(yi));
+    }
+
+    /// Linearly interpolate the table of average albedos
+    Float average_albedo(Float alpha, Mask active) const {
+        uint32_t res = MTS_MICROFACET_ALBEDO_RES;
+        Float y = clamp(alpha, 0.f, 1.f) * ScalarFloat(res - 1);
+        UInt32 yi = min(UInt32(y), res - 2);
+
+        Float v0 = gather<Float>(m_average_albedo, yi, active),
+              v1 = gather<Float>(m_average_albedo, yi + 1, active);
+
+        return lerp(v0, v1, y - Float(yi));
+    }
+
+    /// Probability of sampling the multiple scattering lobe (its share of the energy)
+    Float ms_probability(Float cos_theta_i, Float alpha, Mask active) const {
+        return clamp(1.f - albedo(cos_theta_i, alpha, active), 0.f, 1.f);
+    }
+
+    /// Evaluate the unpolarized Fresnel reflectance, using the precomputed table if enabled
+    UnpolarizedSpectrum eval_fresnel(const SurfaceInteraction3f &si, const Float &cos_theta_i,
+                                     Mask active) const {
+        if (m_use_fresnel_table)
+            return m_fresnel_table.template eval_conductor<UnpolarizedSpectrum>(
+                cos_theta_i, si.wavelengths, active);
+
+        Complex<UnpolarizedSpectrum> eta_c(m_eta->eval(si, active),
+                                           m_k->eval(si, active));
+        return fresnel_conductor(UnpolarizedSpectrum(cos_theta_i), eta_c);
+    }
+
+    /**
+     * \brief Evaluate the multiple scattering lobe by Kulla and Conty
+     * (multiplied by the cosine of the outgoing direction)
+     */
+    UnpolarizedSpectrum eval_ms(const SurfaceInteraction3f &si,
+                                Float cos_theta_i, Float cos_theta_o,
+                                Float alpha, Mask active) const {
+        Float e_i   = albedo(cos_theta_i, alpha, active),
+              e_o   = albedo(cos_theta_o, alpha, active),
+              e_avg = average_albedo(alpha, active);
+
+        /* Average Fresnel reflectance, using Schlick's approximation
+           based on the reflectance at normal incidence */
+        UnpolarizedSpectrum f_0   = eval_fresnel(si, 1.f, active),
+                            f_avg = f_0 + (1.f - f_0) * (1.f / 21.f),
+                            f_ms  = sqr(f_avg) * e_avg / (1.f - f_avg * (1.f - e_avg));
+
+        UnpolarizedSpectrum value =
+            f_ms * ((1.f - e_i) * (1.f - e_o) * cos_theta_o /
+                    (math::Pi<ScalarFloat> * max(1.f - e_avg, 1e-4f)));
+
+        if (m_specular_reflectance)
+            value *= m_specular_reflectance->eval(si, active);
+
+        return value;
+    }
+
 private:
     /// Specifies the type of microfacet distribution
     MicrofacetType m_type;
@@ -439,6 +609,14 @@ private:
     ref<Texture> m_k;
     /// Specular reflectance component
     ref<Texture> m_specular_reflectance;
+    /// Add the multiple scattering lobe?
+    bool m_energy_compensation;
+    /// Albedo tables of the single scattering model
+    DynamicBuffer<Float> m_albedo, m_average_albedo;
+    /// Look up the Fresnel reflectance from a table?
+    bool m_use_fresnel_table;
+    /// Tabulated Fresnel reflectance
+    FresnelTable<Float> m_fresnel_table;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(RoughConductor, BSDF)
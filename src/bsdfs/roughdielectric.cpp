@@ -6,6 +6,7 @@
 #include <mitsuba/render/ior.h>
 #include <mitsuba/render/microfacet.h>
 #include <mitsuba/render/fresnel.h>
+#include <mitsuba/render/fresneltable.h>
 #include <mitsuba/render/texture.h>
 #include <mitsuba/render/sampler.h>
 
@@ -52,6 +53,10 @@ Rough dielectric material (:monosp:`roughdielectric`)
    - Enables a sampling technique proposed by Heitz and D'Eon :cite:`Heitz1014Importance`, which
      focuses computation on the visible parts of the microfacet normal distribution, considerably
      reducing variance in some cases. (Default: |true|, i.e. use visible normal sampling)
+ * - fresnel_table
+   - |bool|
+   - Look up the Fresnel reflectance from a precomputed table instead of evaluating the Fresnel
+     equations exactly (see :ref:`dielectric <bsdf-dielectric>`). (Default: |false|)
 
 
 This plugin implements a realistic microfacet scattering model for rendering
@@ -193,11 +198,14 @@ public:
                                BSDFFlags::BackSide | BSDFFlags::NonSymmetric | extra);
         m_flags = m_components[0] | m_components[1];
 
+        m_use_fresnel_table = props.bool_("fresnel_table", false);
         parameters_changed();
     }
 
     void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override {
         m_inv_eta = 1.f / m_eta;
+        if (m_use_fresnel_table)
+            m_fresnel_table = FresnelTable<Float>::dielectric(m_eta);
     }
 
     std::pair<BSDFSample3f, Spectrum> sample(const BSDFContext &ctx,
@@ -237,8 +245,7 @@ public:
             sample_distr.sample(mulsign(si.wi, cos_theta_i), sample2);
         active &= neq(bs.pdf, 0.f);
 
-        auto [F, cos_theta_t, eta_it, eta_ti] =
-            fresnel(dot(si.wi, m), Float(m_eta));
+        auto [F, cos_theta_t, eta_it, eta_ti] = eval_fresnel(dot(si.wi, m), active);
 
         // Select the lobe to be sampled
         UnpolarizedSpectrum weight;
@@ -346,7 +353,7 @@ public:
         Float D = distr.eval(m);
 
         // Fresnel factor
-        Float F = std::get<0>(fresnel(dot(si.wi, m), Float(m_eta)));
+        Float F = std::get<0>(eval_fresnel(dot(si.wi, m), active));
 
         // Smith's shadow-masking function
         Float G = distr.G(si.wi, wo, m);
@@ -443,7 +450,7 @@ public:
         Float prob = sample_distr.pdf(mulsign(si.wi, Frame3f::cos_theta(si.wi)), m);
 
         if (likely(has_transmission && has_reflection)) {
-            Float F = std::get<0>(fresnel(dot(si.wi, m), Float(m_eta)));
+            Float F = std::get<0>(eval_fresnel(dot(si.wi, m), active));
             prob *= select(reflect, F, 1.f - F);
         }
 
@@ -487,12 +494,22 @@ public:
         if (m_specular_transmittance)
             oss << "  specular_transmittance = " << string::indent(m_specular_transmittance) << ", " << std::endl;
 
-        oss << "  eta = "                    << m_eta << std::endl
+        oss << "  eta = "                    << m_eta << "," << std::endl
+            << "  fresnel_table = "          << m_use_fresnel_table << std::endl
             << "]";
         return oss.str();
     }
 
     MTS_DECLARE_CLASS()
+private:
+    /// Evaluate the Fresnel equations, using the precomputed table if enabled
+    std::tuple<Float, Float, Float, Float> eval_fresnel(const Float &cos_theta_i,
+                                                        Mask active) const {
+        if (m_use_fresnel_table)
+            return m_fresnel_table.eval_dielectric(cos_theta_i, active);
+        return fresnel(cos_theta_i, Float(m_eta));
+    }
+
 private:
     ref<Texture> m_specular_reflectance;
     ref<Texture> m_specular_transmittance;
@@ -500,6 +517,8 @@ private:
     ref<Texture> m_alpha_u, m_alpha_v;
     ScalarFloat m_eta, m_inv_eta;
     bool m_sample_visible;
+    bool m_use_fresnel_table;
+    FresnelTable<Float> m_fresnel_table;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(RoughDielectric, BSDF)
@@ -379,23 +379,22 @@ public:
 
         m_specular_sampling_weight = s_mean / (d_mean + s_mean);
 
-        // Precompute rough reflectance (vectorized)
+        // Look up the rough transmittance and reflectance (shared between instances)
         if (keys.empty() || string::contains(keys, "alpha") || string::contains(keys, "eta")) {
-            using FloatP    = Packet<ScalarFloat>;
-            using Vector3fX = Vector<DynamicArray<FloatP>, 3>;
-
-            mitsuba::MicrofacetDistribution<FloatP, Spectrum> distr_p(m_type, m_alpha);
-            Vector3fX wi = zero<Vector3fX>(MTS_ROUGH_TRANSMITTANCE_RES);
-            for (size_t i = 0; i < slices(wi); ++i) {
-                ScalarFloat mu    = std::max((ScalarFloat) 1e-6f, ScalarFloat(i) / ScalarFloat(slices(wi) - 1));
-                slice(wi, i) = ScalarVector3f(std::sqrt(1 - mu * mu), 0.f, mu);
+            using Tables = MicrofacetTables<ScalarFloat>;
+            size_t res = MTS_ROUGH_TRANSMITTANCE_RES;
+
+            auto external_transmittance = Tables::transmittance(m_type, m_alpha, m_eta, res);
+            m_external_transmittance = DynamicBuffer<Float>::copy(external_transmittance->data(),
+                                                                  external_transmittance->size());
+
+            auto internal_reflectance = Tables::reflectance(m_type, m_alpha, 1.f / m_eta, res);
+            ScalarFloat sum = 0.f;
+            for (size_t i = 0; i < res; ++i) {
+                ScalarFloat mu = std::max((ScalarFloat) 1e-6f, ScalarFloat(i) / ScalarFloat(res - 1));
+                sum += (*internal_reflectance)[i] * mu;
             }
-
-            auto external_transmittance = eval_transmittance(distr_p, wi, m_eta);
-            m_external_transmittance = DynamicBuffer<Float>::copy(external_transmittance.data(),
-                                                                  slices(external_transmittance));
-            m_internal_reflectance =
-                hmean(eval_reflectance(distr_p, wi, 1.f / m_eta) * wi.z()) * 2.f;
+            m_internal_reflectance = sum / res * 2.f;
         }
     }
 
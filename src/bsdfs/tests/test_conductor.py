@@ -215,3 +215,29 @@ def test02_sample_pol_world(variant_scalar_mono_polarized):
     # Test that the polarization is flipped to right circular
     a6 = M_world @ spectrum_from_stokes([1, 0, 0, -1])
     assert ek.all(a6[3, 0] > UnpolarizedSpectrum(0.0))
+
+
+def test03_fresnel_table(variant_packet_spectral):
+    import numpy as np
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import BSDFContext, SurfaceInteraction3f
+
+    n = 10000
+    cos_theta = np.random.uniform(size=n)
+    si = SurfaceInteraction3f.zero(n)
+    si.wi = np.column_stack([np.sqrt(1 - cos_theta**2), np.zeros(n), cos_theta])
+    si.wavelengths = np.random.uniform(360, 830, size=(n, 4))
+    ctx = BSDFContext()
+
+    values = []
+    for fresnel_table in ['false', 'true']:
+        bsdf = load_string("""<bsdf version="2.0.0" type="conductor">
+                <string name="material" value="Au"/>
+                <boolean name="fresnel_table" value="{}"/>
+            </bsdf>""".format(fresnel_table))
+
+        _, value = bsdf.sample(ctx, si, 0, [0, 0])
+        values.append(np.array(value))
+
+    # The table is also interpolated between the tabulated wavelengths
+    assert np.allclose(values[0], values[1], atol=5e-3)
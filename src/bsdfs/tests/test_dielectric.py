@@ -172,3 +172,31 @@ def test05_spot_check(variant_scalar_rgb):
     bs, spec = bsdf.sample(ctx, si, 1, [0, 0])
     assert ek.allclose(bs.pdf, 1 - 0.387704354691473)
     assert ek.allclose(bs.wo, wi)
+
+
+def test06_fresnel_table(variant_packet_rgb):
+    import numpy as np
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import BSDFContext, SurfaceInteraction3f
+
+    n = 10001
+    cos_theta = np.linspace(-1, 1, n)
+    si = SurfaceInteraction3f.zero(n)
+    si.wi = np.column_stack([np.sqrt(1 - cos_theta**2), np.zeros(n), cos_theta])
+    ctx = BSDFContext()
+
+    # Both sides of the interface, including total internal reflection
+    for int_ior, ext_ior in [(1.5, 1.0), (1.0, 1.5), (2.4, 1.33)]:
+        pdfs = []
+        for fresnel_table in ['false', 'true']:
+            bsdf = load_string("""<bsdf version="2.0.0" type="dielectric">
+                    <float name="int_ior" value="{}"/>
+                    <float name="ext_ior" value="{}"/>
+                    <boolean name="fresnel_table" value="{}"/>
+                </bsdf>""".format(int_ior, ext_ior, fresnel_table))
+
+            # Reflection is always chosen, hence the pdf is the Fresnel reflectance
+            bs, _ = bsdf.sample(ctx, si, 0, [0, 0])
+            pdfs.append(np.array(bs.pdf))
+
+        assert np.allclose(pdfs[0], pdfs[1], atol=2e-4)
@@ -0,0 +1,112 @@
+import gc
+import struct
+
+import numpy as np
+import pytest
+
+import enoki as ek
+import mitsuba
+
+
+def write_tensor_file(filename, fields):
+    """Write a dictionary of numpy arrays in the format read by TensorFile"""
+    dtypes = { np.dtype(np.uint8): 1, np.dtype(np.float32): 10 }
+
+    header_size = 12 + 2 + 4
+    for name, value in fields.items():
+        header_size += 2 + len(name) + 2 + 1 + 8 + 8 * value.ndim
+
+    header = b'tensor_file\0' + struct.pack('<BBI', 1, 0, len(fields))
+    data, offset = b'', header_size
+    for name, value in fields.items():
+        offset = (offset + 7) // 8 * 8
+        padding = offset - header_size - len(data)
+        header += struct.pack('<H', len(name)) + name.encode()
+        header += struct.pack('<HBQ', value.ndim, dtypes[value.dtype], offset)
+        header += struct.pack('<%iQ' % value.ndim, *value.shape)
+        data += b'\0' * padding + value.tobytes()
+        offset += value.nbytes
+
+    with open(filename, 'wb') as f:
+        f.write(header + data)
+
+
+@pytest.fixture
+def measured_file(tmpdir):
+    # Isotropic material with uniform sampling densities and a constant albedo
+    shape = (2, 3, 4, 4)
+    filename = str(tmpdir.join('material.bsdf'))
+    write_tensor_file(filename, {
+        'description': np.frombuffer(b'test material', dtype=np.uint8),
+        'jacobian': np.array([1], dtype=np.uint8),
+        'phi_i': np.array([-np.pi, np.pi], dtype=np.float32),
+        'theta_i': np.array([0, np.pi / 4, np.pi / 2], dtype=np.float32),
+        'wavelengths': np.array([360, 500, 650, 830], dtype=np.float32),
+        'ndf': np.ones((4, 4), dtype=np.float32),
+        'sigma': np.ones((4, 4), dtype=np.float32),
+        'vndf': np.ones(shape, dtype=np.float32),
+        'luminance': np.ones(shape, dtype=np.float32),
+        'spectra': np.full((2, 3, 4, 4, 4), 0.5, dtype=np.float32)
+    })
+    return filename
+
+
+def test01_shared_data(variant_scalar_spectral, measured_file):
+    from mitsuba.core import Thread, Appender, LogLevel, Frame3f, Vector3f
+    from mitsuba.core.xml import load_dict
+    from mitsuba.render import BSDFContext, SurfaceInteraction3f
+
+    si = SurfaceInteraction3f()
+    si.n = [0, 0, 1]
+    si.sh_frame = Frame3f(si.n)
+    si.wi = ek.normalize(Vector3f(0.3, 0.2, 1))
+    si.wavelengths = [400, 500, 600, 700]
+    wo = ek.normalize(Vector3f(-0.2, 0.1, 1))
+
+    def eval(bsdf):
+        return bsdf.eval(BSDFContext(), si, wo), bsdf.pdf(BSDFContext(), si, wo)
+
+    # Count how often the material is loaded from disk
+    messages = []
+
+    class MyAppender(Appender):
+        def append(self, level, text):
+            messages.append(text)
+
+    logger = Thread.thread().logger()
+    log_level = logger.log_level()
+    appender = MyAppender()
+    logger.add_appender(appender)
+    logger.set_log_level(LogLevel.Info)
+
+    def load_count():
+        return sum('Loaded material' in m for m in messages)
+
+    try:
+        # Two instances referencing the same file share one data block
+        bsdf_1 = load_dict({ 'type': 'measured', 'filename': measured_file })
+        bsdf_2 = load_dict({ 'type': 'measured', 'filename': measured_file })
+        assert load_count() == 1
+
+        value, pdf = eval(bsdf_1)
+        assert ek.all(value > 0) and pdf > 0
+        value_2, pdf_2 = eval(bsdf_2)
+        assert ek.allclose(value, value_2) and ek.allclose(pdf, pdf_2)
+
+        # Releasing one instance keeps the data alive for the other one
+        del bsdf_1
+        gc.collect()
+        bsdf_3 = load_dict({ 'type': 'measured', 'filename': measured_file })
+        assert load_count() == 1
+
+        # Once all instances are gone, the material is loaded again
+        del bsdf_2, bsdf_3
+        gc.collect()
+        bsdf_4 = load_dict({ 'type': 'measured', 'filename': measured_file })
+        assert load_count() == 2
+
+        value_4, pdf_4 = eval(bsdf_4)
+        assert ek.allclose(value, value_4) and ek.allclose(pdf, pdf_4)
+    finally:
+        logger.remove_appender(appender)
+        logger.set_log_level(log_level)
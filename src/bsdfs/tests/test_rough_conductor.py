@@ -95,3 +95,53 @@ def test05_chi2_aniso_ggx_visible(variant_packet_rgb):
     )
 
     assert chi2.run()
+
+
+def test06_chi2_energy_compensation(variant_packet_rgb):
+    xml = """<float name="alpha" value="0.6"/>
+             <string name="distribution" value="ggx"/>
+             <boolean name="energy_compensation" value="true"/>"""
+    wi = ek.normalize([1.0, 1.0, 1.0])
+    sample_func, pdf_func = BSDFAdapter("roughconductor", xml, wi=wi)
+
+    chi2 = ChiSquareTest(
+        domain=SphericalDomain(),
+        sample_func=sample_func,
+        pdf_func=pdf_func,
+        sample_dim=3,
+        ires=8
+    )
+
+    assert chi2.run()
+
+
+def test07_energy_compensation_furnace(variant_scalar_rgb):
+    """ A rough perfect mirror should reflect all energy with energy compensation """
+    from mitsuba.core import Frame3f, PCG32
+    from mitsuba.render import BSDFContext, SurfaceInteraction3f
+    from mitsuba.core.xml import load_string
+
+    si    = SurfaceInteraction3f()
+    si.p  = [0, 0, 0]
+    si.n  = [0, 0, 1]
+    si.wi = ek.normalize([1.0, 0.0, 1.0])
+    si.sh_frame = Frame3f(si.n)
+    ctx = BSDFContext()
+
+    def albedo(compensation):
+        bsdf = load_string("""<bsdf version='2.0.0' type='roughconductor'>
+                                  <float name="alpha" value="1.0"/>
+                                  <string name="distribution" value="ggx"/>
+                                  <boolean name="energy_compensation" value="%s"/>
+                              </bsdf>""" % compensation)
+        rng = PCG32()
+        count = 20000
+        total = 0.0
+        for i in range(count):
+            _, weight = bsdf.sample(ctx, si, rng.next_float32(),
+                                    [rng.next_float32(), rng.next_float32()])
+            total += weight[0]
+        return total / count
+
+    assert albedo('false') < 0.85
+    assert abs(albedo('true') - 1.0) < 0.03
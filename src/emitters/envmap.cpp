@@ -7,6 +7,7 @@
 #include <mitsuba/render/scene.h>
 #include <mitsuba/render/texture.h>
 #include <mitsuba/render/srgb.h>
+#include <tbb/tbb.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -31,6 +32,13 @@ Environment emitter (:monosp:`envmap`)
    - |transform|
    - Specifies an optional emitter-to-world transformation.  (Default: none, i.e. emitter space = world space)
 
+ * - sampling
+   - |string|
+   - Distribution used to sample directions towards the emitter. :monosp:`sphere` is proportional to
+     the luminance, :monosp:`hemisphere` additionally skips directions below the horizon, and
+     :monosp:`cosine` is proportional to the luminance times the cosine to the up axis.
+     (Default: :monosp:`sphere`)
+
 This plugin provides a HDRI (high dynamic range imaging) environment map,
 which is a type of light source that is well-suited for representing "natural"
 illumination.
@@ -56,6 +64,18 @@ High quality free light probes are available on
 `Paul Debevec's <http://gl.ict.usc.edu/Data/HighResProbes>`_ and
 `Bernhard Vogl's <http://dativ.at/lightprobes/>`_ websites.
 
+The :monosp:`hemisphere` and :monosp:`cosine` sampling modes are meant for scenes
+where a ground plane blocks the lower half of the environment, in which case
+shadow rays towards it are wasted. The up axis is the Y axis of the emitter's
+local frame (see the figure above). Directions that are never sampled are
+still accounted for by BSDF sampling, hence these modes require an
+integrator that combines both strategies using multiple importance
+sampling (e.g. :ref:`path <integrator-path>`).
+
+Changes to the image data through :code:`parameters_changed()` rebuild the
+sampling distribution in parallel. The rebuild is skipped altogether if the
+data was merely rescaled, e.g. when animating the brightness of the emitter.
+
  */
 
 template <typename Float, typename Spectrum>
@@ -81,46 +101,58 @@ public:
         bitmap = bitmap->convert(Bitmap::PixelFormat::RGBA, struct_type_v<ScalarFloat>, false);
         m_filename = file_path.filename().string();
 
-        std::unique_ptr<ScalarFloat[]> luminance(new ScalarFloat[bitmap->pixel_count()]);
-
-        ScalarFloat *ptr     = (ScalarFloat *) bitmap->data(),
-                    *lum_ptr = (ScalarFloat *) luminance.get();
-
-        for (size_t y = 0; y < bitmap->size().y(); ++y) {
-            ScalarFloat sin_theta =
-                std::sin(y / ScalarFloat(bitmap->size().y() - 1) * math::Pi<ScalarFloat>);
-
-            for (size_t x = 0; x < bitmap->size().x(); ++x) {
-                ScalarColor3f rgb = load_unaligned<ScalarVector3f>(ptr);
-                ScalarFloat lum   = mitsuba::luminance(rgb);
-
-                ScalarVector4f coeff;
-                if constexpr (is_monochromatic_v<Spectrum>) {
-                    coeff = ScalarVector4f(lum, lum, lum, 1.f);
-                } else if constexpr (is_rgb_v<Spectrum>) {
-                    coeff = concat(rgb, ScalarFloat(1.f));
-                } else {
-                    static_assert(is_spectral_v<Spectrum>);
-                    /* Evaluate the spectral upsampling model. This requires a
-                       reflectance value (colors in [0, 1]) which is accomplished here by
-                       scaling. We use a color where the highest component is 50%,
-                       which generally yields a fairly smooth spectrum. */
-                    ScalarFloat scale = hmax(rgb) * 2.f;
-                    ScalarColor3f rgb_norm = rgb / std::max((ScalarFloat) 1e-8, scale);
-                    coeff = concat((ScalarColor3f) srgb_model_fetch(rgb_norm), scale);
+        ScalarVector2u size = bitmap->size();
+        ScalarFloat *data = (ScalarFloat *) bitmap->data();
+
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0, size.y(), 16),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t y = range.begin(); y != range.end(); ++y) {
+                    ScalarFloat *ptr = data + 4 * y * size.x();
+
+                    for (uint32_t x = 0; x < size.x(); ++x) {
+                        ScalarColor3f rgb = load_unaligned<ScalarVector3f>(ptr);
+
+                        ScalarVector4f coeff;
+                        if constexpr (is_monochromatic_v<Spectrum>) {
+                            ScalarFloat lum = mitsuba::luminance(rgb);
+                            coeff = ScalarVector4f(lum, lum, lum, 1.f);
+                        } else if constexpr (is_rgb_v<Spectrum>) {
+                            coeff = concat(rgb, ScalarFloat(1.f));
+                        } else {
+                            static_assert(is_spectral_v<Spectrum>);
+                            /* Evaluate the spectral upsampling model. This requires a
+                               reflectance value (colors in [0, 1]) which is accomplished here by
+                               scaling. We use a color where the highest component is 50%,
+                               which generally yields a fairly smooth spectrum. */
+                            ScalarFloat scale = hmax(rgb) * 2.f;
+                            ScalarColor3f rgb_norm = rgb / std::max((ScalarFloat) 1e-8, scale);
+                            coeff = concat((ScalarColor3f) srgb_model_fetch(rgb_norm), scale);
+                        }
+
+                        store_unaligned(ptr, coeff);
+                        ptr += 4;
+                    }
                 }
-
-                *lum_ptr++ = lum * sin_theta;
-                store_unaligned(ptr, coeff);
-                ptr += 4;
             }
-        }
+        );
 
         m_resolution = bitmap->size();
         m_data = DynamicBuffer<Float>::copy(bitmap->data(), hprod(m_resolution) * 4);
 
+        std::string sampling = props.string("sampling", "sphere");
+        if (sampling == "sphere")
+            m_sampling = Sampling::Sphere;
+        else if (sampling == "hemisphere")
+            m_sampling = Sampling::Hemisphere;
+        else if (sampling == "cosine")
+            m_sampling = Sampling::Cosine;
+        else
+            Throw("Invalid sampling mode \"%s\", must be one of: \"sphere\", "
+                  "\"hemisphere\", or \"cosine\"!", sampling);
+
         m_scale = props.float_("scale", 1.f);
-        m_warp = Warp(luminance.get(), m_resolution);
+        update_warp();
         m_d65 = Texture::D65(1.f);
         m_flags = EmitterFlags::Infinite | EmitterFlags::SpatiallyVarying;
     }
@@ -220,39 +252,8 @@ public:
     }
 
     void parameters_changed(const std::vector<std::string> &keys = {}) override {
-        if (keys.empty() || string::contains(keys, "data")) {
-            m_data.managed();
-
-            std::unique_ptr<ScalarFloat[]> luminance(new ScalarFloat[hprod(m_resolution)]);
-
-            ScalarFloat *ptr     = (ScalarFloat *) m_data.data(),
-                        *lum_ptr = (ScalarFloat *) luminance.get();
-
-
-            for (size_t y = 0; y < m_resolution.y(); ++y) {
-                ScalarFloat sin_theta =
-                    std::sin(y / ScalarFloat(m_resolution.y() - 1) * math::Pi<ScalarFloat>);
-
-                for (size_t x = 0; x < m_resolution.x(); ++x) {
-                    ScalarVector4f coeff = load<ScalarVector4f>(ptr);
-                    ScalarFloat lum;
-
-                    if constexpr (is_monochromatic_v<Spectrum>) {
-                        lum = coeff.x();
-                    } else if constexpr (is_rgb_v<Spectrum>) {
-                        lum = mitsuba::luminance(ScalarColor3f(head<3>(coeff)));
-                    } else {
-                        static_assert(is_spectral_v<Spectrum>);
-                        lum = srgb_model_mean(head<3>(coeff)) * coeff.w();
-                    }
-
-                    *lum_ptr++ = lum * sin_theta;
-                    ptr += 4;
-                }
-            }
-
-            m_warp = Warp(luminance.get(), m_resolution);
-        }
+        if (keys.empty() || string::contains(keys, "data"))
+            update_warp();
     }
 
     std::string to_string() const override {
@@ -260,12 +261,98 @@ public:
         oss << "EnvironmentMapEmitter[" << std::endl
             << "  filename = \"" << m_filename << "\"," << std::endl
             << "  resolution = \"" << m_resolution << "\"," << std::endl
+            << "  sampling = " << (m_sampling == Sampling::Sphere ? "sphere" :
+                                   (m_sampling == Sampling::Hemisphere ? "hemisphere"
+                                                                       : "cosine"))
+            << "," << std::endl
             << "  bsphere = " << string::indent(m_bsphere) << std::endl
             << "]";
         return oss.str();
     }
 
 protected:
+    /// Distributions used to sample directions towards the emitter
+    enum class Sampling { Sphere, Hemisphere, Cosine };
+
+    /**
+     * \brief Compute the sampling density of every pixel from the luminance
+     * of the image and (re-)build the warp unless the density only changed
+     * by a constant factor
+     */
+    void update_warp() {
+        m_data.managed();
+
+        size_t pixel_count = hprod(m_resolution);
+        std::unique_ptr<ScalarFloat[]> luminance(new ScalarFloat[pixel_count]);
+        const ScalarFloat *data = (const ScalarFloat *) m_data.data();
+
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0, m_resolution.y(), 16),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t y = range.begin(); y != range.end(); ++y) {
+                    ScalarFloat theta =
+                        y / ScalarFloat(m_resolution.y() - 1) * math::Pi<ScalarFloat>,
+                        weight = std::max(std::sin(theta), (ScalarFloat) 0.f);
+
+                    if (m_sampling == Sampling::Hemisphere)
+                        weight = theta <= .5f * math::Pi<ScalarFloat> ? weight : 0.f;
+                    else if (m_sampling == Sampling::Cosine)
+                        weight *= std::max(std::cos(theta), (ScalarFloat) 0.f);
+
+                    const ScalarFloat *ptr = data + 4 * y * m_resolution.x();
+                    ScalarFloat *lum_ptr = luminance.get() + y * m_resolution.x();
+
+                    for (uint32_t x = 0; x < m_resolution.x(); ++x) {
+                        ScalarVector4f coeff = load_unaligned<ScalarVector4f>(ptr);
+                        ScalarFloat lum;
+
+                        if constexpr (is_monochromatic_v<Spectrum>) {
+                            lum = coeff.x();
+                        } else if constexpr (is_rgb_v<Spectrum>) {
+                            lum = mitsuba::luminance(ScalarColor3f(head<3>(coeff)));
+                        } else {
+                            static_assert(is_spectral_v<Spectrum>);
+                            lum = srgb_model_mean(head<3>(coeff)) * coeff.w();
+                        }
+
+                        *lum_ptr++ = lum * weight;
+                        ptr += 4;
+                    }
+                }
+            }
+        );
+
+        /* The warp is normalized, hence a uniformly rescaled image leaves it
+           unchanged. Compare against the density of the last rebuild so that
+           small changes cannot accumulate over several updates */
+        if (m_luminance && proportional(luminance.get(), m_luminance.get(), pixel_count)) {
+            Log(Debug, "Environment map was rescaled, keeping the sampling distribution.");
+            return;
+        }
+
+        m_warp = Warp(luminance.get(), m_resolution);
+        m_luminance = std::move(luminance);
+    }
+
+    /// Check whether the two arrays only differ by a constant factor
+    static bool proportional(const ScalarFloat *a, const ScalarFloat *b, size_t size) {
+        double sum_a = 0.0, sum_b = 0.0;
+        for (size_t i = 0; i < size; ++i) {
+            sum_a += a[i];
+            sum_b += b[i];
+        }
+        if (!(sum_a > 0.0 && sum_b > 0.0))
+            return false;
+
+        double ratio = sum_a / sum_b;
+        for (size_t i = 0; i < size; ++i) {
+            double expected = b[i] * ratio;
+            if (std::abs(a[i] - expected) > 1e-4 * std::max((double) a[i], expected) + 1e-30)
+                return false;
+        }
+        return true;
+    }
+
     UnpolarizedSpectrum eval_spectrum(Point2f uv, const Wavelength &wavelengths, Mask active) const {
         uv *= Vector2f(m_resolution - 1u);
 
@@ -325,6 +412,9 @@ protected:
     DynamicBuffer<Float> m_data;
     ScalarVector2u m_resolution;
     Warp m_warp;
+    /// Sampling density of every pixel that was used to build \c m_warp
+    std::unique_ptr<ScalarFloat[]> m_luminance;
+    Sampling m_sampling;
     ref<Texture> m_d65;
     ScalarFloat m_scale;
 };
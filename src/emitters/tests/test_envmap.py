@@ -0,0 +1,105 @@
+import os
+
+import numpy as np
+import pytest
+
+import enoki as ek
+import mitsuba
+
+
+def create_emitter(tmpdir, sampling='sphere'):
+    from mitsuba.core import Bitmap
+    from mitsuba.core.xml import load_dict
+
+    # Smoothly varying, strictly positive latitude-longitude image
+    y, x = np.meshgrid(np.linspace(0, 1, 32), np.linspace(0, 1, 64), indexing='ij')
+    data = np.zeros((32, 64, 3), dtype=np.float32)
+    data[:, :, 0] = 1 + np.sin(2 * np.pi * x) ** 2
+    data[:, :, 1] = 1 + y
+    data[:, :, 2] = 0.5
+
+    filename = os.path.join(str(tmpdir), 'envmap.exr')
+    Bitmap(data).write(filename)
+
+    return load_dict({
+        'type': 'envmap',
+        'filename': filename,
+        'sampling': sampling
+    })
+
+
+@pytest.mark.parametrize("sampling", ['sphere', 'hemisphere', 'cosine'])
+def test01_sample_direction(variant_scalar_rgb, tmpdir, sampling):
+    from mitsuba.core import Vector3f
+    from mitsuba.render import SurfaceInteraction3f, DirectionSample3f
+
+    emitter = create_emitter(tmpdir, sampling)
+
+    it = SurfaceInteraction3f()
+    it.p = [0.1, -0.2, 0.3]
+
+    for i in range(256):
+        sample = [(i % 16 + 0.5) / 16, (i // 16 + 0.5) / 16]
+        ds, spec = emitter.sample_direction(it, sample)
+        assert ds.pdf > 0
+        assert ek.allclose(emitter.pdf_direction(it, ds), ds.pdf, rtol=1e-3)
+
+        if sampling != 'sphere':
+            # Only the upper hemisphere (and the adjacent patches) is sampled
+            assert ds.d.y > -0.1
+
+    ds = DirectionSample3f()
+    ds.d = ek.normalize(Vector3f(0.3, -0.9, 0.1))
+    pdf = emitter.pdf_direction(it, ds)
+    assert (pdf > 0) == (sampling == 'sphere')
+
+
+def test02_rescaled_data(variant_scalar_rgb, tmpdir):
+    from mitsuba.core import Thread, Appender, LogLevel
+    from mitsuba.python.util import traverse
+    from mitsuba.render import SurfaceInteraction3f
+
+    emitter = create_emitter(tmpdir)
+
+    it = SurfaceInteraction3f()
+    sample = [0.3, 0.6]
+    ds, spec = emitter.sample_direction(it, sample)
+
+    # Record whether parameter updates skip rebuilding the sampling distribution
+    messages = []
+
+    class MyAppender(Appender):
+        def append(self, level, text):
+            messages.append(text)
+
+    logger = Thread.thread().logger()
+    log_level = logger.log_level()
+    appender = MyAppender()
+    logger.add_appender(appender)
+    logger.set_log_level(LogLevel.Debug)
+
+    def update(data):
+        messages.clear()
+        params['data'] = data
+        params.update()
+        return any('keeping the sampling distribution' in m for m in messages)
+
+    try:
+        # Rescaling the image doesn't affect the (normalized) sampling density
+        params = traverse(emitter)
+        data = params['data'] * 1
+        assert update(data * 2)
+
+        ds_2, spec_2 = emitter.sample_direction(it, sample)
+        assert ek.allclose(ds.d, ds_2.d)
+        assert ek.allclose(ds.pdf, ds_2.pdf)
+        assert ek.allclose(spec * 2, spec_2)
+
+        # Other changes rebuild the sampling distribution
+        data_2 = data * 1
+        data_2[0] = data_2[0] + 10
+        assert not update(data_2)
+        assert update(data_2 * 0.5)
+    finally:
+        logger.remove_appender(appender)
+        logger.set_log_level(log_level)
@@ -0,0 +1,360 @@
+#pragma once
+
+#include <mitsuba/core/bbox.h>
+#include <mitsuba/core/vector.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Spatio-directional distribution of incident radiance that is learned
+ * online to guide scattering in participating media
+ *
+ * A spatial octree partitions the bounding box of the scene. Each of its
+ * leaves stores a quadtree over the sphere of directions, which are mapped to
+ * the unit square using cylindrical coordinates (an area-preserving mapping).
+ * Every leaf holds two quadtrees: one that is sampled, and one that
+ * accumulates training records. Records are splatted using atomic operations,
+ * hence any number of threads can train a field while sampling from it.
+ *
+ * The structure of a field never changes once created. Instead, \ref refine()
+ * builds a new field from the training data of the current one, splitting
+ * spatial leaves that received many records and adapting the resolution of
+ * the directional quadtrees to the learned distribution (following "Practical
+ * Path Guiding for Efficient Light-Transport Simulation" by Müller et al.).
+ *
+ * Only used by the scalar variants, where \c Float is a plain floating point
+ * type.
+ */
+template <typename Float> class GuidingField {
+public:
+    using Point2f    = Point<Float, 2>;
+    using Point3f    = Point<Float, 3>;
+    using Vector3f   = Vector<Float, 3>;
+    using BoundingBox3f = BoundingBox<Point3f>;
+
+    /// Indices of the four children of a quadtree node (0: the quadrant is a leaf)
+    using QuadNode = std::array<uint32_t, 4>;
+
+    /// Maximum depth of the directional quadtrees
+    static constexpr uint32_t MaxQuadDepth = 20;
+
+    /// Maximum depth of the spatial octree
+    static constexpr uint32_t MaxOctreeDepth = 16;
+
+    /// Create an untrained field that covers the given bounding box
+    GuidingField(const BoundingBox3f &bbox) : m_bbox(bbox), m_id(next_id()) {
+        m_octree.push_back({ 0, 0 });
+        m_leaves.emplace_back(new Leaf());
+        m_leaves.back()->training.reset(std::vector<QuadNode>{ QuadNode{} });
+    }
+
+    /// Return a process-wide unique identifier of this field
+    uint64_t id() const { return m_id; }
+
+    /// Return the index of the spatial leaf containing \c p
+    uint32_t lookup(const Point3f &p_) const {
+        Vector3f p = (p_ - m_bbox.min) / m_bbox.extents();
+        uint32_t node = 0;
+        while (m_octree[node].first_child != 0) {
+            uint32_t octant = 0;
+            for (size_t i = 0; i < 3; ++i) {
+                if (p[i] >= .5f) {
+                    octant |= 1u << i;
+                    p[i] -= .5f;
+                }
+                p[i] *= 2.f;
+            }
+            node = m_octree[node].first_child + octant;
+        }
+        return m_octree[node].leaf;
+    }
+
+    /// Can directions be sampled from the given spatial leaf?
+    bool valid(uint32_t leaf) const { return m_leaves[leaf]->sampling.total > 0.f; }
+
+    /// Sample a direction from the given spatial leaf, returns the direction and its density
+    std::pair<Vector3f, Float> sample(uint32_t leaf, Point2f sample) const {
+        auto [p, pdf] = m_leaves[leaf]->sampling.sample(sample);
+        return { square_to_direction(p), pdf * math::InvFourPi<Float> };
+    }
+
+    /// Evaluate the (solid angle) density of sampling \c d from the given spatial leaf
+    Float pdf(uint32_t leaf, const Vector3f &d) const {
+        return m_leaves[leaf]->sampling.pdf(direction_to_square(d)) * math::InvFourPi<Float>;
+    }
+
+    /**
+     * \brief Record an estimate of the radiance arriving at a point from
+     * direction \c d, divided by the density of having sampled \c d
+     */
+    void record(uint32_t leaf, const Vector3f &d, Float value) const {
+        Leaf &l = *m_leaves[leaf];
+        l.training.splat(direction_to_square(d), value);
+        l.records.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Build the next field from the training data of this one
+     *
+     * \param spatial_threshold
+     *     Spatial leaves that received more than this many records are split
+     *
+     * \param energy_threshold
+     *     Quadrants that hold more than this fraction of a quadtree's energy
+     *     are subdivided, others are merged
+     */
+    std::shared_ptr<GuidingField> refine(uint32_t spatial_threshold,
+                                         Float energy_threshold) const {
+        std::shared_ptr<GuidingField> result(new GuidingField(m_bbox, next_id()));
+        result->m_octree.push_back({ 0, 0 });
+        result->refine_node(*this, 0, 0, 0, spatial_threshold, energy_threshold);
+        return result;
+    }
+
+    /// Return the number of spatial leaves
+    size_t leaf_count() const { return m_leaves.size(); }
+
+private:
+    /// Quadtree over the unit square that is sampled proportional to its leaf energies
+    struct SamplingTree {
+        std::vector<QuadNode> nodes;
+        std::vector<std::array<Float, 4>> energy;
+        Float total = 0.f;
+
+        std::pair<Point2f, Float> sample(Point2f sample) const {
+            Point2f origin(0.f);
+            Float size = 1.f, pdf = 1.f;
+            uint32_t node = 0;
+            while (true) {
+                const auto &e = energy[node];
+                Float node_total = e[0] + e[1] + e[2] + e[3],
+                      value      = sample.x() * node_total,
+                      cdf        = 0.f;
+
+                uint32_t quadrant = 0;
+                while (quadrant < 3 && cdf + e[quadrant] <= value)
+                    cdf += e[quadrant++];
+
+                // Guard against selecting an empty quadrant due to rounding
+                while (e[quadrant] == 0.f && quadrant > 0)
+                    cdf -= e[--quadrant];
+
+                sample.x() = std::min((value - cdf) / e[quadrant], math::OneMinusEpsilon<Float>);
+                pdf *= 4.f * e[quadrant] / node_total;
+                size *= .5f;
+                origin += Point2f(Float(quadrant & 1), Float(quadrant >> 1)) * size;
+
+                if (nodes[node][quadrant] == 0)
+                    return { origin + sample * size, pdf };
+                node = nodes[node][quadrant];
+            }
+        }
+
+        Float pdf(Point2f p) const {
+            Float pdf = 1.f;
+            uint32_t node = 0;
+            while (true) {
+                const auto &e = energy[node];
+                Float node_total = e[0] + e[1] + e[2] + e[3];
+                uint32_t quadrant = descend(p);
+                if (!(node_total > 0.f))
+                    return 0.f;
+                pdf *= 4.f * e[quadrant] / node_total;
+                if (nodes[node][quadrant] == 0 || pdf == 0.f)
+                    return pdf;
+                node = nodes[node][quadrant];
+            }
+        }
+
+        /// Compute the energy of interior quadrants from the leaves below them
+        Float accumulate(uint32_t node) {
+            Float sum = 0.f;
+            for (size_t i = 0; i < 4; ++i) {
+                if (nodes[node][i] != 0)
+                    energy[node][i] = accumulate(nodes[node][i]);
+                sum += energy[node][i];
+            }
+            return sum;
+        }
+    };
+
+    /// Quadtree over the unit square that accumulates energy in its leaf quadrants
+    struct TrainingTree {
+        std::vector<QuadNode> nodes;
+        std::unique_ptr<std::atomic<Float>[]> energy;
+
+        void reset(std::vector<QuadNode> &&topology) {
+            nodes = std::move(topology);
+            energy.reset(new std::atomic<Float>[4 * nodes.size()]);
+            for (size_t i = 0; i < 4 * nodes.size(); ++i)
+                energy[i].store(0.f, std::memory_order_relaxed);
+        }
+
+        void splat(Point2f p, Float value) {
+            uint32_t node = 0;
+            while (true) {
+                uint32_t quadrant = descend(p);
+                if (nodes[node][quadrant] == 0) {
+                    std::atomic<Float> &target = energy[4 * node + quadrant];
+                    Float current = target.load(std::memory_order_relaxed);
+                    while (!target.compare_exchange_weak(current, current + value,
+                                                         std::memory_order_relaxed))
+                        ;
+                    return;
+                }
+                node = nodes[node][quadrant];
+            }
+        }
+
+        /// Convert the accumulated energy into a sampling tree with the same topology
+        SamplingTree build() const {
+            SamplingTree tree;
+            tree.nodes = nodes;
+            tree.energy.resize(nodes.size());
+            for (size_t i = 0; i < nodes.size(); ++i)
+                for (size_t j = 0; j < 4; ++j)
+                    tree.energy[i][j] = nodes[i][j] == 0
+                        ? energy[4 * i + j].load(std::memory_order_relaxed) : 0.f;
+            tree.total = tree.accumulate(0);
+            return tree;
+        }
+    };
+
+    struct Leaf {
+        SamplingTree sampling;
+        TrainingTree training;
+        std::atomic<uint32_t> records{ 0 };
+    };
+
+    struct OctreeNode {
+        /// Index of the first of eight consecutive children (0: leaf)
+        uint32_t first_child;
+        /// Index of the associated spatial leaf
+        uint32_t leaf;
+    };
+
+    GuidingField(const BoundingBox3f &bbox, uint64_t id) : m_bbox(bbox), m_id(id) { }
+
+    static uint64_t next_id() {
+        static std::atomic<uint64_t> counter{ 0 };
+        return ++counter;
+    }
+
+    /// Select the quadrant containing \c p, and map \c p into it
+    static uint32_t descend(Point2f &p) {
+        uint32_t quadrant = 0;
+        for (size_t i = 0; i < 2; ++i) {
+            if (p[i] >= .5f) {
+                quadrant |= 1u << i;
+                p[i] -= .5f;
+            }
+            p[i] *= 2.f;
+        }
+        return quadrant;
+    }
+
+    static Point2f direction_to_square(const Vector3f &d) {
+        Float cos_theta = std::min(std::max(d.z(), Float(-1.f)), Float(1.f)),
+              phi       = std::atan2(d.y(), d.x());
+        if (phi < 0.f)
+            phi += 2.f * math::Pi<Float>;
+        return Point2f(std::min((cos_theta + 1.f) * .5f, math::OneMinusEpsilon<Float>),
+                       std::min(phi * math::InvTwoPi<Float>, math::OneMinusEpsilon<Float>));
+    }
+
+    static Vector3f square_to_direction(const Point2f &p) {
+        Float cos_theta = 2.f * p.x() - 1.f,
+              sin_theta = std::sqrt(std::max(1.f - cos_theta * cos_theta, Float(0.f))),
+              phi       = 2.f * math::Pi<Float> * p.y();
+        return Vector3f(sin_theta * std::cos(phi), sin_theta * std::sin(phi), cos_theta);
+    }
+
+    /// Derive the topology of the next training tree from a sampling tree
+    static void refine_topology(const SamplingTree &tree, uint32_t node, Float scale,
+                                uint32_t depth, Float threshold,
+                                std::vector<QuadNode> &result, uint32_t target) {
+        for (uint32_t i = 0; i < 4; ++i) {
+            Float fraction = scale * (node != (uint32_t) -1 ? tree.energy[node][i] : 1.f);
+            if (fraction <= threshold || depth + 1 >= MaxQuadDepth)
+                continue;
+
+            /* Subdivide. Quadrants without a counterpart in the sampling
+               tree distribute their energy uniformly among their children */
+            uint32_t child = (uint32_t) result.size();
+            result[target][i] = child;
+            result.push_back(QuadNode{});
+
+            if (node != (uint32_t) -1 && tree.nodes[node][i] != 0)
+                refine_topology(tree, tree.nodes[node][i], scale, depth + 1,
+                                threshold, result, child);
+            else
+                refine_topology(tree, (uint32_t) -1, fraction * .25f, depth + 1,
+                                threshold, result, child);
+        }
+    }
+
+    /// Build the subtree below \c node of this field from the leaf \c leaf of \c prev
+    void refine_node(const GuidingField &prev, uint32_t prev_node, uint32_t node,
+                     uint32_t depth, uint32_t spatial_threshold, Float energy_threshold) {
+        const OctreeNode &pn = prev.m_octree[prev_node];
+        if (pn.first_child != 0) {
+            uint32_t first_child = (uint32_t) m_octree.size();
+            m_octree[node].first_child = first_child;
+            for (uint32_t i = 0; i < 8; ++i)
+                m_octree.push_back({ 0, 0 });
+            for (uint32_t i = 0; i < 8; ++i)
+                refine_node(prev, pn.first_child + i, first_child + i, depth + 1,
+                            spatial_threshold, energy_threshold);
+            return;
+        }
+
+        const Leaf &pl = *prev.m_leaves[pn.leaf];
+        SamplingTree sampling = pl.training.build();
+        std::vector<QuadNode> topology;
+
+        if (sampling.total > 0.f) {
+            topology.push_back(QuadNode{});
+            refine_topology(sampling, 0, 1.f / sampling.total, 0, energy_threshold,
+                            topology, 0);
+        } else {
+            // No energy was recorded: keep what was learned previously
+            sampling = pl.sampling;
+            topology = pl.training.nodes;
+        }
+
+        uint32_t records = pl.records.load(std::memory_order_relaxed);
+        bool split = records > spatial_threshold && depth + 1 < MaxOctreeDepth;
+
+        auto make_leaf = [&](uint32_t target) {
+            m_octree[target].leaf = (uint32_t) m_leaves.size();
+            Leaf *leaf = new Leaf();
+            leaf->sampling = sampling;
+            leaf->training.reset(std::vector<QuadNode>(topology));
+            m_leaves.emplace_back(leaf);
+        };
+
+        if (split) {
+            // The children inherit the directional distribution of their parent
+            uint32_t first_child = (uint32_t) m_octree.size();
+            m_octree[node].first_child = first_child;
+            for (uint32_t i = 0; i < 8; ++i)
+                m_octree.push_back({ 0, 0 });
+            for (uint32_t i = 0; i < 8; ++i)
+                make_leaf(first_child + i);
+        } else {
+            make_leaf(node);
+        }
+    }
+
+private:
+    BoundingBox3f m_bbox;
+    std::vector<OctreeNode> m_octree;
+    std::vector<std::unique_ptr<Leaf>> m_leaves;
+    uint64_t m_id;
+};
+
+NAMESPACE_END(mitsuba)
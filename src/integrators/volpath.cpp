@@ -1,13 +1,18 @@
 #include <random>
+#include <mutex>
 #include <enoki/stl.h>
 #include <mitsuba/core/ray.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/emitter.h>
+#include <mitsuba/render/film.h>
 #include <mitsuba/render/integrator.h>
 #include <mitsuba/render/records.h>
 #include <mitsuba/render/medium.h>
 #include <mitsuba/render/phase.h>
+#include <mitsuba/render/scene.h>
+#include <mitsuba/render/sensor.h>
+#include "guiding.h"
 
 
 NAMESPACE_BEGIN(mitsuba)
@@ -16,23 +21,148 @@ template <typename Float, typename Spectrum>
 class VolumetricPathIntegrator : public MonteCarloIntegrator<Float, Spectrum> {
 
 public:
-    MTS_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth, m_hide_emitters)
-    MTS_IMPORT_TYPES(Scene, Sampler, Emitter, EmitterPtr, BSDF, BSDFPtr,
-                     Medium, MediumPtr, PhaseFunctionContext)
+    MTS_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth, m_hide_emitters,
+                    m_block_size, m_samples_per_pass)
+    MTS_IMPORT_TYPES(Scene, Sensor, Sampler, ImageBlock, Emitter, EmitterPtr, BSDF,
+                     BSDFPtr, Medium, MediumPtr, PhaseFunction, PhaseFunctionContext)
+
+    using Field = GuidingField<ScalarFloat>;
+
+    /// Maximum number of medium scattering events per path that train the guiding field
+    static constexpr size_t MaxGuidingVertices = 32;
+
+    /// Medium scattering event whose incident radiance is recorded at the end of a path
+    struct GuidingVertex {
+        uint32_t leaf;
+        Vector3f d;
+        Float pdf;
+        UnpolarizedSpectrum throughput, result;
+    };
 
     VolumetricPathIntegrator(const Properties &props) : Base(props) {
+        /* Select the channel (RGB) or wavelength (spectral) that drives
+           free-flight sampling anew for every sampled distance, and weight
+           the events using the average over all channels (spectral MIS) */
+        m_use_spectral_mis = props.bool_("use_spectral_mis", false);
+
+        /* Guide medium scattering using a spatio-directional distribution of
+           indirect radiance that is learned while rendering, and refined at
+           the end of every pass (see "samples_per_pass"). The guiding
+           distribution is combined with phase function sampling using
+           one-sample MIS, where "guiding_fraction" is the probability of
+           sampling the guiding distribution. */
+        m_guiding = props.bool_("guiding", false);
+        m_guiding_fraction = props.float_("guiding_fraction", .5f);
+        m_guiding_spatial_threshold =
+            (uint32_t) props.size_("guiding_spatial_threshold", 4000);
+        m_guiding_energy_threshold = props.float_("guiding_energy_threshold", .01f);
+
+        if (m_guiding_fraction < 0.f || m_guiding_fraction >= 1.f)
+            Throw("\"guiding_fraction\" must lie in the interval [0, 1)!");
+
+        if constexpr (is_array_v<Float>) {
+            if (m_guiding) {
+                Log(Warn, "Path guiding is only supported by the scalar variants, disabling it.");
+                m_guiding = false;
+            }
+        }
     }
 
-    MTS_INLINE
-    Float index_spectrum(const UnpolarizedSpectrum &spec, const UInt32 &idx) const {
-        Float m = spec[0];
-        if constexpr (is_rgb_v<Spectrum>) { // Handle RGB rendering
-            masked(m, eq(idx, 1u)) = spec[1];
-            masked(m, eq(idx, 2u)) = spec[2];
-        } else {
-            ENOKI_MARK_USED(idx);
+    bool render(Scene *scene, Sensor *sensor) override {
+        if (m_guiding) {
+            size_t spp = sensor->sampler()->sample_count();
+            if (m_samples_per_pass == (uint32_t) -1 || m_samples_per_pass >= spp)
+                Log(Warn, "The guiding field is refined at the end of every pass, but the "
+                          "image is rendered in a single pass (see \"samples_per_pass\").");
+
+            m_guiding_blocks = 0;
+            publish_guiding_field(std::make_shared<Field>(scene->bbox()));
         }
-        return m;
+        return Base::render(scene, sensor);
+    }
+
+    /// Uniformly select a channel or wavelength (used with spectral MIS)
+    MTS_INLINE UInt32 sample_channel(Float sample) const {
+        uint32_t n_channels = (uint32_t) array_size_v<UnpolarizedSpectrum>;
+        return (UInt32) min(sample * n_channels, n_channels - 1);
+    }
+
+    /// Render a block, and refine the guiding field once all blocks of a pass are done
+    void render_block(const Scene *scene, const Sensor *sensor, Sampler *sampler,
+                      ImageBlock *block, Float *aovs, size_t sample_count,
+                      size_t block_id) const override {
+        Base::render_block(scene, sensor, sampler, block, aovs, sample_count, block_id);
+        if (!m_guiding)
+            return;
+
+        ScalarVector2i blocks =
+            (sensor->film()->crop_size() + (int) m_block_size - 1) / (int) m_block_size;
+        size_t blocks_per_pass = (size_t) hprod(blocks),
+               total_blocks    = blocks_per_pass * (sampler->sample_count() / sample_count),
+               blocks_done     = ++m_guiding_blocks;
+
+        if (blocks_done % blocks_per_pass != 0 || blocks_done >= total_blocks)
+            return;
+
+        /* Other threads keep rendering the next pass with the current field,
+           and may still splat a few records into it that are lost */
+        std::lock_guard<std::mutex> guard(m_guiding_mutex);
+        std::shared_ptr<Field> field = std::atomic_load(&m_guiding_field);
+        std::shared_ptr<Field> refined =
+            field->refine(m_guiding_spatial_threshold, m_guiding_energy_threshold);
+        Log(Debug, "Refined the guiding field after %i blocks (%i spatial leaves)",
+            blocks_done, refined->leaf_count());
+        publish_guiding_field(refined);
+    }
+
+    /// Make a new guiding field available to all threads
+    void publish_guiding_field(const std::shared_ptr<Field> &field) const {
+        std::atomic_store(&m_guiding_field, field);
+        m_guiding_field_id.store(field->id(), std::memory_order_release);
+    }
+
+    /**
+     * \brief Return the current guiding field
+     *
+     * Every thread holds on to the field it used last, and only reloads the
+     * shared pointer when a new field has been published.
+     */
+    const Field *guiding_field() const {
+        thread_local std::shared_ptr<Field> cache;
+        uint64_t id = m_guiding_field_id.load(std::memory_order_acquire);
+        if (!cache || cache->id() != id)
+            cache = std::atomic_load(&m_guiding_field);
+        return cache.get();
+    }
+
+    /**
+     * \brief Sample a direction from the mixture of the phase function and the
+     * guiding distribution of the given spatial leaf
+     *
+     * Multiplies \c throughput by the ratio of the phase function and the
+     * mixture density, and returns the direction along with that density.
+     */
+    std::pair<Vector3f, Float> sample_guided(const Field *field, uint32_t leaf,
+                                             const PhaseFunction *phase,
+                                             const PhaseFunctionContext &phase_ctx,
+                                             const MediumInteraction3f &mi, Sampler *sampler,
+                                             Spectrum &throughput) const {
+        Point2f sample = sampler->next_2d();
+        if (!field->valid(leaf))
+            return phase->sample(phase_ctx, mi, sample);
+
+        Vector3f wo;
+        if (sampler->next_1d() < m_guiding_fraction)
+            wo = field->sample(leaf, sample).first;
+        else
+            wo = phase->sample(phase_ctx, mi, sample).first;
+
+        Float phase_val = phase->eval(phase_ctx, mi, wo),
+              pdf = m_guiding_fraction * field->pdf(leaf, wo) +
+                    (1.f - m_guiding_fraction) * phase_val;
+
+        throughput *= select(pdf > 0.f, phase_val / pdf, 0.f);
+        return { wo, pdf };
     }
 
     std::pair<Spectrum, Mask> sample(const Scene *scene,
@@ -69,6 +199,16 @@ public:
         SurfaceInteraction3f si = zero<SurfaceInteraction3f>();
         si.t = math::Infinity<Float>;
         Mask needs_intersection = true;
+
+        // Guiding field, and the scattering events that train it (scalar variants only)
+        const Field *field = nullptr;
+        std::array<GuidingVertex, is_array_v<Float> ? 0 : MaxGuidingVertices> guiding_path;
+        size_t guiding_vertices = 0;
+        if constexpr (!is_array_v<Float>) {
+            if (m_guiding)
+                field = guiding_field();
+        }
+
         for (int bounce = 0;; ++bounce) {
             // ----------------- Handle termination of paths ------------------
 
@@ -102,6 +242,8 @@ public:
             }
 
             if (any_or<true>(active_medium)) {
+                if (m_use_spectral_mis)
+                    masked(channel, active_medium) = sample_channel(sampler->next_1d(active_medium));
                 mi = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium);
                 masked(ray.maxt, active_medium && medium->is_homogeneous() && mi.is_valid()) = mi.t;
                 Mask intersect = needs_intersection && active_medium;
@@ -110,25 +252,22 @@ public:
                 needs_intersection &= !active_medium;
 
                 masked(mi.t, active_medium && (si.t < mi.t)) = math::Infinity<Float>;
-                if (any_or<true>(is_spectral)) {
-                    auto [tr, free_flight_pdf] = medium->eval_tr_and_pdf(mi, si, is_spectral);
-                    Float tr_pdf = index_spectrum(free_flight_pdf, channel);
-                    masked(throughput, is_spectral) *= select(tr_pdf > 0.f, tr / tr_pdf, 0.f);
-                }
+                if (any_or<true>(is_spectral))
+                    masked(throughput, is_spectral) *=
+                        medium->eval_tr_weight(mi, si, channel, m_use_spectral_mis, is_spectral);
 
                 escaped_medium = active_medium && !mi.is_valid();
                 active_medium &= mi.is_valid();
 
                 // Handle null and real scatter events
-                Mask null_scatter = sampler->next_1d(active_medium) >= index_spectrum(mi.sigma_t, channel) / index_spectrum(mi.combined_extinction, channel);
+                auto [real_scatter, collision_weight] = medium->sample_collision(
+                    mi, sampler->next_1d(active_medium), channel, m_use_spectral_mis, active_medium);
 
-                act_null_scatter |= null_scatter && active_medium;
+                act_null_scatter |= !real_scatter && active_medium;
                 act_medium_scatter |= !act_null_scatter && active_medium;
 
-                if (any_or<true>(is_spectral && act_null_scatter))
-                    masked(throughput, is_spectral && act_null_scatter) *=
-                        mi.sigma_n * index_spectrum(mi.combined_extinction, channel) /
-                        index_spectrum(mi.sigma_n, channel);
+                if (any_or<true>(is_spectral && active_medium))
+                    masked(throughput, is_spectral && active_medium) *= collision_weight;
 
                 masked(depth, act_medium_scatter) += 1;
             }
@@ -144,9 +283,6 @@ public:
             }
 
             if (any_or<true>(act_medium_scatter)) {
-                if (any_or<true>(is_spectral))
-                    masked(throughput, is_spectral && act_medium_scatter) *=
-                        mi.sigma_s * index_spectrum(mi.combined_extinction, channel) / index_spectrum(mi.sigma_t, channel);
                 if (any_or<true>(not_spectral))
                     masked(throughput, not_spectral && act_medium_scatter) *= mi.sigma_s / mi.sigma_t;
 
@@ -168,7 +304,22 @@ public:
 
                 // ------------------ Phase function sampling -----------------
                 masked(phase, !act_medium_scatter) = nullptr;
-                auto [wo, phase_pdf] = phase->sample(phase_ctx, mi, sampler->next_2d(act_medium_scatter), act_medium_scatter);
+                Vector3f wo;
+                if constexpr (!is_array_v<Float>) {
+                    if (field) {
+                        uint32_t leaf = field->lookup(mi.p);
+                        auto [wo_guided, pdf] = sample_guided(field, leaf, phase, phase_ctx,
+                                                              mi, sampler, throughput);
+                        wo = wo_guided;
+                        if (guiding_vertices < MaxGuidingVertices)
+                            guiding_path[guiding_vertices++] = {
+                                leaf, wo, pdf, depolarize(throughput), depolarize(result)
+                            };
+                    }
+                }
+                if (!field)
+                    wo = phase->sample(phase_ctx, mi, sampler->next_2d(act_medium_scatter),
+                                       act_medium_scatter).first;
                 Ray3f new_ray  = mi.spawn_ray(wo);
                 new_ray.mint = 0.0f;
                 masked(ray, act_medium_scatter) = new_ray;
@@ -253,6 +404,20 @@ public:
             }
             active &= (active_surface | active_medium);
         }
+
+        /* Train the guiding field with the radiance that reached each
+           scattering event along the sampled direction */
+        if constexpr (!is_array_v<Float>) {
+            for (size_t i = 0; i < guiding_vertices; ++i) {
+                const GuidingVertex &v = guiding_path[i];
+                UnpolarizedSpectrum radiance =
+                    select(v.throughput > 0.f, (depolarize(result) - v.result) / v.throughput, 0.f);
+                Float value = hmean(radiance) / v.pdf;
+                if (std::isfinite(value) && value >= 0.f)
+                    field->record(v.leaf, v.d, value);
+            }
+        }
+
         return { result, valid_ray };
     }
 
@@ -291,7 +456,9 @@ public:
             Mask active_surface = active && !active_medium;
 
             if (any_or<true>(active_medium)) {
-                auto mi = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium);
+                if (m_use_spectral_mis)
+                    masked(channel, active_medium) = sample_channel(sampler->next_1d(active_medium));
+                auto mi = medium->sample_ratio_tracking(ray, sampler->next_1d(active_medium), channel, active_medium);
                 masked(ray.maxt, active_medium && medium->is_homogeneous() && mi.is_valid()) = min(mi.t, remaining_dist);
                 Mask intersect = needs_intersection && active_medium;
                 if (any_or<true>(intersect))
@@ -300,15 +467,9 @@ public:
                 masked(mi.t, active_medium && (si.t < mi.t)) = math::Infinity<Float>;
                 needs_intersection &= !active_medium;
 
-                Mask is_spectral = medium->has_spectral_extinction() && active_medium;
-                Mask not_spectral = !is_spectral && active_medium;
-                if (any_or<true>(is_spectral)) {
-                    Float t      = min(remaining_dist, min(mi.t, si.t)) - mi.mint;
-                    UnpolarizedSpectrum tr  = exp(-t * mi.combined_extinction);
-                    UnpolarizedSpectrum free_flight_pdf = select(si.t < mi.t || mi.t > remaining_dist, tr, tr * mi.combined_extinction);
-                    Float tr_pdf = index_spectrum(free_flight_pdf, channel);
-                    masked(transmittance, is_spectral) *= select(tr_pdf > 0.f, tr / tr_pdf, 0.f);
-                }
+                // Ratio tracking: weight null collisions by sigma_n
+                masked(transmittance, active_medium) *= medium->eval_ratio_tracking_weight(
+                    mi, min(remaining_dist, si.t), channel, m_use_spectral_mis, active_medium);
 
                 // Handle exceeding the maximum distance by medium sampling
                 masked(total_dist, active_medium && (mi.t > remaining_dist) && mi.is_valid()) = ds.dist;
@@ -316,8 +477,6 @@ public:
 
                 escaped_medium = active_medium && !mi.is_valid();
                 active_medium &= mi.is_valid();
-                is_spectral &= active_medium;
-                not_spectral &= active_medium;
 
                 masked(total_dist, active_medium) += mi.t;
 
@@ -325,11 +484,6 @@ public:
                     masked(ray.o, active_medium)    = mi.p;
                     masked(ray.mint, active_medium) = 0.f;
                     masked(si.t, active_medium) = si.t - mi.t;
-
-                    if (any_or<true>(is_spectral))
-                        masked(transmittance, is_spectral) *= mi.sigma_n;
-                    if (any_or<true>(not_spectral))
-                        masked(transmittance, not_spectral) *= mi.sigma_n / mi.combined_extinction;
                 }
             }
 
@@ -388,7 +542,9 @@ public:
             Mask active_surface = active && !active_medium;
             SurfaceInteraction3f si_medium;
             if (any_or<true>(active_medium)) {
-                auto mi = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium);
+                if (m_use_spectral_mis)
+                    masked(channel, active_medium) = sample_channel(sampler->next_1d(active_medium));
+                auto mi = medium->sample_ratio_tracking(ray, sampler->next_1d(active_medium), channel, active_medium);
                 masked(ray.maxt, active_medium && medium->is_homogeneous() && mi.is_valid()) = mi.t;
                 Mask intersect = needs_intersection && active_medium;
                 if (any_or<true>(intersect))
@@ -396,13 +552,9 @@ public:
 
                 masked(mi.t, active_medium && (si.t < mi.t)) = math::Infinity<Float>;
 
-                Mask is_spectral = medium->has_spectral_extinction() && active_medium;
-                Mask not_spectral = !is_spectral && active_medium;
-                if (any_or<true>(is_spectral)) {
-                    auto [tr, free_flight_pdf] = medium->eval_tr_and_pdf(mi, si, is_spectral);
-                    Float tr_pdf = index_spectrum(free_flight_pdf, channel);
-                    masked(transmittance, is_spectral) *= select(tr_pdf > 0.f, tr / tr_pdf, 0.f);
-                }
+                // Ratio tracking: weight null collisions by sigma_n
+                masked(transmittance, active_medium) *= medium->eval_ratio_tracking_weight(
+                    mi, si.t, channel, m_use_spectral_mis, active_medium);
 
                 needs_intersection &= !active_medium;
                 escaped_medium = active_medium && !mi.is_valid();
@@ -412,11 +564,6 @@ public:
                     masked(ray.o, active_medium)    = mi.p;
                     masked(ray.mint, active_medium) = 0.f;
                     masked(si.t, active_medium) = si.t - mi.t;
-
-                    if (any_or<true>(is_spectral))
-                        masked(transmittance, is_spectral && active_medium) *= mi.sigma_n;
-                    if (any_or<true>(not_spectral))
-                        masked(transmittance, not_spectral && active_medium) *= mi.sigma_n / mi.combined_extinction;
                 }
             }
 
@@ -471,9 +618,13 @@ public:
     std::string to_string() const override {
         return tfm::format("VolumetricSimplePathIntegrator[\n"
                            "  max_depth = %i,\n"
-                           "  rr_depth = %i\n"
+                           "  rr_depth = %i,\n"
+                           "  use_spectral_mis = %s,\n"
+                           "  guiding = %s,\n"
+                           "  guiding_fraction = %f\n"
                            "]",
-                           m_max_depth, m_rr_depth);
+                           m_max_depth, m_rr_depth, m_use_spectral_mis, m_guiding,
+                           m_guiding_fraction);
     }
 
     Float mis_weight(Float pdf_a, Float pdf_b) const {
@@ -483,6 +634,18 @@ public:
     };
 
     MTS_DECLARE_CLASS()
+
+private:
+    bool m_use_spectral_mis;
+
+    bool m_guiding;
+    ScalarFloat m_guiding_fraction;
+    uint32_t m_guiding_spatial_threshold;
+    ScalarFloat m_guiding_energy_threshold;
+    mutable std::shared_ptr<Field> m_guiding_field;
+    mutable std::atomic<uint64_t> m_guiding_field_id { 0 };
+    mutable std::atomic<size_t> m_guiding_blocks { 0 };
+    mutable std::mutex m_guiding_mutex;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(VolumetricPathIntegrator, MonteCarloIntegrator);
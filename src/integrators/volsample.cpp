@@ -23,19 +23,50 @@ public:
     MTS_IMPORT_TYPES(Scene, Sampler, Emitter, EmitterPtr, BSDF, BSDFPtr,
                      Medium, MediumPtr, PhaseFunctionContext, Shape)
 
+    /// Phase functions that the homogeneous fast path samples without virtual calls
+    enum class DirectPhase { None, Isotropic, HenyeyGreenstein };
+
+    /// Coefficients of a homogeneous medium, hoisted out of the random walk
+    struct HomogeneousWalk {
+        const Medium *medium = nullptr;
+        UnpolarizedSpectrum sigma_s, sigma_t;
+        bool spectral;
+        DirectPhase phase = DirectPhase::None;
+        ScalarFloat g;
+    };
+
+    /// Exponentially distributed samples, drawn in batches to vectorize the logarithm
+    struct ExponentialBatch {
+        static constexpr size_t Size = 8;
+        Array<ScalarFloat, Size> values;
+        size_t index = Size;
+
+        ScalarFloat next(Sampler *sampler) {
+            if (index == Size) {
+                Array<ScalarFloat, Size> u;
+                for (size_t i = 0; i < Size; ++i)
+                    u[i] = sampler->next_1d();
+                values = -enoki::log(1.f - u);
+                index  = 0;
+            }
+            return values[index++];
+        }
+    };
+
     VolumetricPathSampler(const Properties &props) : Base(props){
+        // Per-event channel selection with spectral MIS weights (see volpath)
+        m_use_spectral_mis = props.bool_("use_spectral_mis", false);
+
+        /* Trace random walks inside homogeneous media with isotropic or
+           Henyey-Greenstein phase functions using a specialized kernel
+           (scalar variants only) */
+        m_fast_homogeneous = props.bool_("fast_homogeneous", true);
     }
 
-    MTS_INLINE
-    Float index_spectrum(const UnpolarizedSpectrum &spec, const UInt32 &idx) const {
-        Float m = spec[0];
-        if constexpr (is_rgb_v<Spectrum>) { // Handle RGB rendering
-            masked(m, eq(idx, 1u)) = spec[1];
-            masked(m, eq(idx, 2u)) = spec[2];
-        } else {
-            ENOKI_MARK_USED(idx);
-        }
-        return m;
+    /// Uniformly select a channel or wavelength (used with spectral MIS)
+    MTS_INLINE UInt32 sample_channel(Float sample) const {
+        uint32_t n_channels = (uint32_t) array_size_v<UnpolarizedSpectrum>;
+        return (UInt32) min(sample * n_channels, n_channels - 1);
     }
 
     // Sample position and direction on a object in the input scene
@@ -135,6 +166,101 @@ public:
     }
 
 
+    /// Hoist the coefficients and the phase function of a homogeneous medium
+    HomogeneousWalk prepare_walk(const Medium *medium, const Wavelength &wavelengths) const {
+        HomogeneousWalk walk;
+        walk.medium = medium;
+
+        MediumInteraction3f mi = zero<MediumInteraction3f>();
+        mi.wavelengths = wavelengths;
+        UnpolarizedSpectrum sigma_n;
+        std::tie(walk.sigma_s, sigma_n, walk.sigma_t) =
+            medium->get_scattering_coefficients(mi);
+        walk.spectral = medium->has_spectral_extinction();
+
+        const PhaseFunction *phase = medium->phase_function();
+        if (has_flag(phase->flags(), PhaseFunctionFlags::Isotropic)) {
+            walk.phase = DirectPhase::Isotropic;
+        } else if (phase->class_()->name() == "HGPhaseFunction") {
+            walk.phase = DirectPhase::HenyeyGreenstein;
+            walk.g     = phase->get_param();
+        }
+        return walk;
+    }
+
+    /**
+     * \brief Random walk inside a homogeneous medium without virtual calls
+     *
+     * Samples collisions until the ray reaches a surface (returns \c true,
+     * and \c si holds the intersection) or the path is terminated by
+     * Russian roulette or the maximum depth (returns \c false). The weights
+     * match those of the generic path in \ref sample(), where collisions with
+     * homogeneous media are always real.
+     */
+    template <DirectPhase Phase>
+    bool walk_homogeneous(const HomogeneousWalk &walk, const Scene *scene,
+                          Sampler *sampler, ExponentialBatch &exp_batch,
+                          Ray3f &ray, SurfaceInteraction3f &si,
+                          Spectrum &throughput, UInt32 &depth, Float eta,
+                          UInt32 channel) const {
+        ScalarFloat sigma_t_c = walk.sigma_t[channel];
+        UnpolarizedSpectrum scatter_weight = walk.sigma_s / sigma_t_c;
+
+        while (true) {
+            ScalarFloat dist = exp_batch.next(sampler) / sigma_t_c;
+            ray.maxt = ray.mint + dist;
+            si = scene->ray_intersect(ray);
+
+            if (si.is_valid()) {
+                // Passing through the medium: transmittance over its PDF
+                if (walk.spectral)
+                    throughput *= exp(-(si.t - ray.mint) * (walk.sigma_t - sigma_t_c));
+                return true;
+            }
+
+            if (walk.spectral)
+                throughput *= exp(-dist * (walk.sigma_t - sigma_t_c)) * scatter_weight;
+            else
+                throughput *= walk.sigma_s / walk.sigma_t;
+
+            depth += 1;
+            if (depth >= (uint32_t) m_max_depth)
+                return false;
+
+            // Sample the phase function in the frame of the incident direction
+            Point2f sample = sampler->next_2d();
+            Vector3f wo;
+            if constexpr (Phase == DirectPhase::Isotropic) {
+                wo = warp::square_to_uniform_sphere(sample);
+            } else {
+                ScalarFloat g = walk.g;
+                Float cos_theta;
+                if (std::abs(g) < math::Epsilon<ScalarFloat>) {
+                    cos_theta = 1 - 2 * sample.x();
+                } else {
+                    Float sqr_term = (1 - g * g) / (1 - g + 2 * g * sample.x());
+                    cos_theta = (1 + g * g - sqr_term * sqr_term) / (2 * g);
+                }
+                Float sin_theta = enoki::safe_sqrt(1.f - cos_theta * cos_theta);
+                auto [sin_phi, cos_phi] = enoki::sincos(2 * math::Pi<ScalarFloat> * sample.y());
+                wo = Frame3f(ray.d).to_world(
+                    Vector3f(sin_theta * cos_phi, sin_theta * sin_phi, cos_theta));
+            }
+            ray = Ray3f(ray(ray.maxt), wo, 0.f, math::Infinity<Float>, ray.time,
+                        ray.wavelengths);
+
+            // Russian roulette (see sample())
+            if (none(neq(depolarize(throughput), 0.f)))
+                return false;
+            if (depth > (uint32_t) m_rr_depth) {
+                Float q = min(hmax(depolarize(throughput)) * sqr(eta), .95f);
+                if (sampler->next_1d() >= q)
+                    return false;
+                throughput *= rcp(q);
+            }
+        }
+    }
+
     PathSampleResult sample(const Scene *scene,
                 Sampler *sampler,
                 const RayDifferential3f &ray_,
@@ -166,6 +292,9 @@ public:
         si.t = math::Infinity<Float>;
         Mask needs_intersection = true;
 
+        HomogeneousWalk walk;
+        ExponentialBatch exp_batch;
+
         Mask record = false;
         Vector3f pos_out = zero<Vector3f>();
         Vector3f pos_in = zero<Vector3f>();
@@ -211,7 +340,42 @@ public:
                 not_spectral = !is_spectral && active_medium;
             }
 
-            if (any_or<true>(active_medium)) {
+            // Specialized random walk for homogeneous media
+            bool walked = false;
+            if constexpr (!is_array_v<Float>) {
+                if (active_medium && m_fast_homogeneous && !m_use_spectral_mis &&
+                    medium->is_homogeneous()) {
+                    if (walk.medium != medium)
+                        walk = prepare_walk(medium, ray.wavelengths);
+
+                    walked = true;
+                    switch (walk.phase) {
+                        case DirectPhase::Isotropic:
+                            escaped_medium = walk_homogeneous<DirectPhase::Isotropic>(
+                                walk, scene, sampler, exp_batch, ray, si, throughput, depth, eta, channel);
+                            break;
+                        case DirectPhase::HenyeyGreenstein:
+                            escaped_medium = walk_homogeneous<DirectPhase::HenyeyGreenstein>(
+                                walk, scene, sampler, exp_batch, ray, si, throughput, depth, eta, channel);
+                            break;
+                        default:
+                            walked = false;
+                    }
+                }
+                if (walked) {
+                    if (!escaped_medium) {
+                        if (record)
+                            r.status = PathSampleResult::EStatus::EAbsorbed;
+                        break;
+                    }
+                    needs_intersection = false;
+                    active_medium = false;
+                }
+            }
+
+            if (!walked && any_or<true>(active_medium)) {
+                if (m_use_spectral_mis)
+                    masked(channel, active_medium) = sample_channel(sampler->next_1d(active_medium));
                 mi = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium);
                 masked(ray.maxt, active_medium && medium->is_homogeneous() && mi.is_valid()) = mi.t;
                 Mask intersect = needs_intersection && active_medium;
@@ -220,25 +384,22 @@ public:
                 needs_intersection &= !active_medium;
 
                 masked(mi.t, active_medium && (si.t < mi.t)) = math::Infinity<Float>;
-                if (any_or<true>(is_spectral)) {
-                    auto [tr, free_flight_pdf] = medium->eval_tr_and_pdf(mi, si, is_spectral);
-                    Float tr_pdf = index_spectrum(free_flight_pdf, channel);
-                    masked(throughput, is_spectral) *= select(tr_pdf > 0.f, tr / tr_pdf, 0.f);
-                }
+                if (any_or<true>(is_spectral))
+                    masked(throughput, is_spectral) *=
+                        medium->eval_tr_weight(mi, si, channel, m_use_spectral_mis, is_spectral);
 
                 escaped_medium = active_medium && !mi.is_valid();
                 active_medium &= mi.is_valid();
 
                 // Handle null and real scatter events
-                Mask null_scatter = sampler->next_1d(active_medium) >= index_spectrum(mi.sigma_t, channel) / index_spectrum(mi.combined_extinction, channel);
+                auto [real_scatter, collision_weight] = medium->sample_collision(
+                    mi, sampler->next_1d(active_medium), channel, m_use_spectral_mis, active_medium);
 
-                act_null_scatter |= null_scatter && active_medium;
+                act_null_scatter |= !real_scatter && active_medium;
                 act_medium_scatter |= !act_null_scatter && active_medium;
 
-                if (any_or<true>(is_spectral && act_null_scatter))
-                    masked(throughput, is_spectral && act_null_scatter) *=
-                        mi.sigma_n * index_spectrum(mi.combined_extinction, channel) /
-                        index_spectrum(mi.sigma_n, channel);
+                if (any_or<true>(is_spectral && active_medium))
+                    masked(throughput, is_spectral && active_medium) *= collision_weight;
 
                 masked(depth, act_medium_scatter) += 1;
             }
@@ -254,9 +415,6 @@ public:
             }
 
             if (any_or<true>(act_medium_scatter)) {
-                if (any_or<true>(is_spectral))
-                    masked(throughput, is_spectral && act_medium_scatter) *=
-                        mi.sigma_s * index_spectrum(mi.combined_extinction, channel) / index_spectrum(mi.sigma_t, channel);
                 if (any_or<true>(not_spectral))
                     masked(throughput, not_spectral && act_medium_scatter) *= mi.sigma_s / mi.sigma_t;
 
@@ -364,6 +522,10 @@ public:
 
 
     MTS_DECLARE_CLASS()
+
+private:
+    bool m_use_spectral_mis;
+    bool m_fast_homogeneous;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(VolumetricPathSampler, PathSampler);
@@ -1,4 +1,5 @@
 #include <mitsuba/core/profiler.h>
+#include <mitsuba/core/texcache.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/util.h>
 
@@ -172,6 +173,9 @@ void Profiler::print_report() {
             std::string(prefix_length - kv.first.length() - 4, ' '),
             kv.second / float(event_count_total) * 100.f);
     }
+
+    // Hit rates of the out-of-core texture cache (if it was used)
+    TextureCache::print_statistics();
 }
 
 MTS_IMPLEMENT_CLASS(Profiler, Object)
@@ -8,6 +8,7 @@
 #include <map>
 #include <sstream>
 
+#include <mitsuba/core/hash.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/transform.h>
@@ -143,6 +144,32 @@ namespace {
         Type operator()(const void *&) { return Type::Pointer; }
     };
 
+    struct HashVisitor {
+        size_t operator()(const std::nullptr_t &) { throw std::runtime_error("Internal error"); }
+        size_t operator()(const bool &b) { return mitsuba::hash(b); }
+        size_t operator()(const int64_t &i) { return mitsuba::hash(i); }
+        size_t operator()(const Float &f) { return mitsuba::hash(f); }
+        size_t operator()(const Array3f &t) { return hash_array(t.data(), 3); }
+        size_t operator()(const std::string &s) { return mitsuba::hash(s); }
+        size_t operator()(const Transform4f &t) {
+            size_t value = 0;
+            for (size_t i = 0; i < 4; ++i)
+                value = hash_combine(value, hash_array(t.matrix.coeff(i).data(), 4));
+            return value;
+        }
+        size_t operator()(const Color3f &t) { return hash_array(t.data(), 3); }
+        size_t operator()(const NamedReference &nr) { return mitsuba::hash((const std::string &) nr); }
+        size_t operator()(const ref<Object> &o) { return mitsuba::hash((const void *) o.get()); }
+        size_t operator()(const void *&p) { return mitsuba::hash(p); }
+
+        template <typename T> static size_t hash_array(const T *data, size_t size) {
+            size_t value = 0;
+            for (size_t i = 0; i < size; ++i)
+                value = hash_combine(value, mitsuba::hash(data[i]));
+            return value;
+        }
+    };
+
     struct StreamVisitor {
         std::ostream &os;
         StreamVisitor(std::ostream &os) : os(os) { }
@@ -282,6 +309,15 @@ bool Properties::operator==(const Properties &p) const {
     return true;
 }
 
+size_t Properties::hash() const {
+    size_t value = mitsuba::hash(d->plugin_name);
+    for (auto &e : d->entries) {
+        value = hash_combine(value, mitsuba::hash(e.first));
+        value = hash_combine(value, e.second.data.visit(HashVisitor()));
+    }
+    return value;
+}
+
 std::string Properties::as_string(const std::string &name) const {
     std::ostringstream oss;
     bool found = false;
@@ -26,6 +26,7 @@ MTS_PY_DECLARE(MemoryStream);
 MTS_PY_DECLARE(ZStream);
 MTS_PY_DECLARE(ProgressReporter);
 MTS_PY_DECLARE(rfilter);
+MTS_PY_DECLARE(TextureCache);
 MTS_PY_DECLARE(Thread);
 MTS_PY_DECLARE(util);
 
@@ -118,6 +119,7 @@ PYBIND11_MODULE(core_ext, m) {
     MTS_PY_IMPORT(MemoryStream);
     MTS_PY_IMPORT(ZStream);
     MTS_PY_IMPORT(ProgressReporter);
+    MTS_PY_IMPORT(TextureCache);
     MTS_PY_IMPORT(Thread);
     MTS_PY_IMPORT(util);
 
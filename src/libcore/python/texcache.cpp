@@ -0,0 +1,43 @@
+#include <mitsuba/core/texcache.h>
+#include <mitsuba/core/bitmap.h>
+#include <mitsuba/python/python.h>
+
+MTS_PY_EXPORT(TextureCache) {
+    MTS_PY_CLASS(TiledImage, Object)
+        .def(py::init<const mitsuba::filesystem::path &>(), "filename"_a,
+             D(TiledImage, TiledImage))
+        .def_static("write", &TiledImage::write, "bitmap"_a, "filename"_a,
+                    "tile_size"_a = 64, "bc"_a = FilterBoundaryCondition::Repeat,
+                    D(TiledImage, write))
+        .def_method(TiledImage, size)
+        .def_method(TiledImage, level_size, "level"_a)
+        .def_method(TiledImage, level_count)
+        .def_method(TiledImage, channel_count)
+        .def_method(TiledImage, tile_size)
+        .def_method(TiledImage, tile_bytes)
+        .def_method(TiledImage, filename)
+        .def("texel", [](const TiledImage &image, uint32_t level, uint32_t x, uint32_t y) {
+                if (level >= image.level_count() || x >= image.level_size(level).x() ||
+                    y >= image.level_size(level).y())
+                    throw py::index_error("TiledImage.texel(): out of bounds!");
+                const float *value = image.texel(level, x, y);
+                return std::vector<float>(value, value + image.channel_count());
+            }, "level"_a, "x"_a, "y"_a, D(TiledImage, texel));
+
+    MTS_PY_CLASS(TextureCache, Object)
+        .def_static("instance", &TextureCache::instance, D(TextureCache, instance))
+        .def_method(TextureCache, set_budget, "budget"_a)
+        .def_method(TextureCache, budget)
+        .def_method(TextureCache, memory_usage)
+        .def_method(TextureCache, clear)
+        .def_method(TextureCache, reset_statistics)
+        .def("statistics", [](const TextureCache &cache) {
+                TextureCache::Statistics stats = cache.statistics();
+                py::dict result;
+                result["local_hits"]  = stats.local_hits;
+                result["shared_hits"] = stats.shared_hits;
+                result["misses"]      = stats.misses;
+                result["evictions"]   = stats.evictions;
+                return result;
+            }, D(TextureCache, statistics));
+}
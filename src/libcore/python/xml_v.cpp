@@ -22,7 +22,7 @@ MTS_PY_EXPORT(xml) {
 
     m.def(
         "load_file",
-        [](const std::string &name, bool update_scene, py::kwargs kwargs) {
+        [](const std::string &name, bool update_scene, bool deduplicate, py::kwargs kwargs) {
             xml::ParameterList param;
             if (kwargs) {
                 for (auto [k, v] : kwargs)
@@ -32,13 +32,14 @@ MTS_PY_EXPORT(xml) {
                     );
             }
             py::gil_scoped_release release;
-            return cast_object(xml::load_file(name, GET_VARIANT(), param, update_scene));
+            return cast_object(xml::load_file(name, GET_VARIANT(), param, update_scene,
+                                              deduplicate));
         },
-        "path"_a, "update_scene"_a = false, D(xml, load_file));
+        "path"_a, "update_scene"_a = false, "deduplicate"_a = false, D(xml, load_file));
 
     m.def(
         "load_string",
-        [](const std::string &name, py::kwargs kwargs) {
+        [](const std::string &name, bool deduplicate, py::kwargs kwargs) {
             xml::ParameterList param;
             if (kwargs) {
                 for (auto [k, v] : kwargs)
@@ -48,9 +49,9 @@ MTS_PY_EXPORT(xml) {
                     );
             }
             py::gil_scoped_release release;
-            return cast_object(xml::load_string(name, GET_VARIANT(), param));
+            return cast_object(xml::load_string(name, GET_VARIANT(), param, deduplicate));
         },
-        "string"_a, D(xml, load_string));
+        "string"_a, "deduplicate"_a = false, D(xml, load_string));
 
     m.def(
         "load_dict",
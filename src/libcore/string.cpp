@@ -1,5 +1,6 @@
 #include <mitsuba/core/string.h>
 #include <mitsuba/core/object.h>
+#include <cstdlib>
 
 NAMESPACE_BEGIN(mitsuba)
 NAMESPACE_BEGIN(string)
@@ -59,5 +60,109 @@ bool contains(const std::vector<std::string> &keys, const std::string &key) {
     return false;
 }
 
+template <typename T> T strtof(const char *nptr, char **endptr) {
+    /* Exactly representable powers of ten. Together with a mantissa of at
+       most 15 digits, this permits a correctly rounded conversion using a
+       single multiplication or division in double precision (in single
+       precision: mantissas below 2^24 and powers up to 1e10) */
+    static const double powers_of_ten[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    auto fallback = [&]() -> T {
+        if constexpr (std::is_same_v<T, float>)
+            return std::strtof(nptr, endptr);
+        else
+            return (T) std::strtod(nptr, endptr);
+    };
+
+    const char *cur = nptr;
+    while (*cur == ' ' || *cur == '\t')
+        ++cur;
+
+    bool negative = false;
+    if (*cur == '-' || *cur == '+')
+        negative = *cur++ == '-';
+
+    uint64_t mantissa = 0;
+    int exponent = 0, digits = 0;
+    bool has_digits = false;
+
+    while (*cur >= '0' && *cur <= '9') {
+        mantissa = mantissa * 10 + uint64_t(*cur++ - '0');
+        digits += mantissa != 0;
+        has_digits = true;
+    }
+
+    if (*cur == '.') {
+        ++cur;
+        while (*cur >= '0' && *cur <= '9') {
+            mantissa = mantissa * 10 + uint64_t(*cur++ - '0');
+            digits += mantissa != 0;
+            exponent -= 1;
+            has_digits = true;
+        }
+    }
+
+    if (!has_digits || digits > 15)
+        return fallback();
+
+    if (*cur == 'e' || *cur == 'E') {
+        const char *exp_start = cur++;
+        bool exp_negative = false;
+        if (*cur == '-' || *cur == '+')
+            exp_negative = *cur++ == '-';
+
+        if (*cur >= '0' && *cur <= '9') {
+            int value = 0;
+            while (*cur >= '0' && *cur <= '9') {
+                if (value < 10000)
+                    value = value * 10 + (*cur - '0');
+                ++cur;
+            }
+            exponent += exp_negative ? -value : value;
+        } else {
+            cur = exp_start; // Not an exponent, leave the 'e' unconsumed
+        }
+    }
+
+    if constexpr (std::is_same_v<T, float>) {
+        /* Computing in double precision and then casting would round twice.
+           Instead, require both operands to be exactly representable in
+           single precision so that one float operation rounds correctly */
+        if (mantissa >= (1ull << 24) || exponent < -10 || exponent > 10)
+            return fallback();
+
+        float value = (float) mantissa;
+        if (exponent < 0)
+            value /= (float) powers_of_ten[-exponent];
+        else
+            value *= (float) powers_of_ten[exponent];
+
+        if (endptr)
+            *endptr = (char *) cur;
+
+        return negative ? -value : value;
+    } else {
+        if (exponent < -22 || exponent > 22)
+            return fallback();
+
+        double value = (double) mantissa;
+        if (exponent < 0)
+            value /= powers_of_ten[-exponent];
+        else
+            value *= powers_of_ten[exponent];
+
+        if (endptr)
+            *endptr = (char *) cur;
+
+        return (T) (negative ? -value : value);
+    }
+}
+
+template MTS_EXPORT_CORE float  strtof<float> (const char *, char **);
+template MTS_EXPORT_CORE double strtof<double>(const char *, char **);
+
 NAMESPACE_END(string)
 NAMESPACE_END(mitsuba)
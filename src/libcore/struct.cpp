@@ -19,7 +19,7 @@
 NAMESPACE_BEGIN(mitsuba)
 
 // Defined in dither-matrix256.cpp
-extern const float dither_matrix256[65536];
+extern MTS_EXPORT_CORE const float dither_matrix256[65536];
 
 NAMESPACE_BEGIN(detail)
 
@@ -0,0 +1,93 @@
+import numpy as np
+import pytest
+
+import mitsuba
+
+from mitsuba.python.test.util import tmpfile
+
+
+@pytest.fixture
+def tiled_image(variant_scalar_rgb, tmpfile):
+    from mitsuba.core import Bitmap, TiledImage
+
+    np.random.seed(0)
+    values = np.random.uniform(size=(37, 50, 3)).astype(np.float32)
+    TiledImage.write(Bitmap(values), tmpfile, tile_size=8)
+    return TiledImage(tmpfile), values
+
+
+def test01_write_read(tiled_image):
+    from mitsuba.core import TextureCache
+
+    image, values = tiled_image
+    assert image.size() == [50, 37]
+    assert image.channel_count() == 3
+    assert image.tile_size() == 8
+    assert image.level_count() == 6
+    assert image.level_size(1) == [25, 18]
+    assert image.level_size(5) == [1, 1]
+
+    TextureCache.instance().clear()
+    for y in range(37):
+        for x in range(50):
+            assert np.allclose(image.texel(0, x, y), values[y, x])
+
+    # The coarsest level stores the mean of the image
+    assert np.allclose(image.texel(5, 0, 0), np.mean(values, axis=(0, 1)), atol=2e-2)
+
+    with pytest.raises(IndexError):
+        image.texel(0, 50, 0)
+    with pytest.raises(IndexError):
+        image.texel(6, 0, 0)
+
+
+def test02_statistics(tiled_image):
+    from mitsuba.core import TextureCache
+
+    image, _ = tiled_image
+    cache = TextureCache.instance()
+    cache.clear()
+    cache.reset_statistics()
+
+    # 7x5 tiles in the finest level
+    for y in range(37):
+        for x in range(50):
+            image.texel(0, x, y)
+    for y in range(37):
+        for x in range(50):
+            image.texel(0, x, y)
+
+    stats = cache.statistics()
+    assert stats['misses'] == 35
+    assert stats['shared_hits'] > 0
+    assert stats['evictions'] == 0
+    assert cache.memory_usage() == 35 * image.tile_bytes()
+
+    cache.clear()
+    assert cache.memory_usage() == 0
+    image.texel(0, 0, 0)
+    assert cache.statistics()['misses'] == 36
+
+
+def test03_eviction(tiled_image):
+    from mitsuba.core import TextureCache
+
+    image, values = tiled_image
+    cache = TextureCache.instance()
+    budget = cache.budget()
+    try:
+        cache.clear()
+        cache.reset_statistics()
+        cache.set_budget(0)
+
+        for y in range(37):
+            for x in range(50):
+                assert np.allclose(image.texel(0, x, y), values[y, x])
+
+        # Every shard retains at most the most recently used tile
+        assert cache.statistics()['evictions'] > 0
+        assert cache.memory_usage() <= 35 * image.tile_bytes()
+        assert cache.memory_usage() < cache.statistics()['misses'] * image.tile_bytes()
+    finally:
+        cache.set_budget(budget)
+        cache.clear()
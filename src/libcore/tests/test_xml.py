@@ -359,4 +359,34 @@ def test24_properties_duplicated(variant_scalar_rgb):
                                 <rgb name="reflectance" value="0.44"/>
                             </bsdf>
                         </scene>""")
-    e.match(err_str)
\ No newline at end of file
+    e.match(err_str)
+
+def test25_deduplicate(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    scene_str = """<scene version="2.0.0">
+        <shape type="sphere">
+            <bsdf type="diffuse"><rgb name="reflectance" value="0.5"/></bsdf>
+        </shape>
+        <shape type="sphere">
+            <bsdf type="diffuse"><rgb name="reflectance" value="0.5"/></bsdf>
+        </shape>
+        <shape type="sphere">
+            <bsdf type="diffuse"><rgb name="reflectance" value="0.5"/></bsdf>
+        </shape>
+        <shape type="sphere">
+            <bsdf type="diffuse"><rgb name="reflectance" value="0.7"/></bsdf>
+        </shape>
+    </scene>"""
+
+    def unique_bsdfs(scene):
+        # Keep the Python objects alive so that their identity is stable
+        bsdfs = [shape.bsdf() for shape in scene.shapes()]
+        return len(set(id(bsdf) for bsdf in bsdfs))
+
+    assert unique_bsdfs(xml.load_string(scene_str)) == 4
+    assert unique_bsdfs(xml.load_string(scene_str, deduplicate=True)) == 2
+
+    # Shapes are never shared
+    scene = xml.load_string(scene_str, deduplicate=True)
+    assert len(scene.shapes()) == 4
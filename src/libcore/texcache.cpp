@@ -0,0 +1,440 @@
+#include <mitsuba/core/texcache.h>
+#include <mitsuba/core/bitmap.h>
+#include <mitsuba/core/fstream.h>
+#include <mitsuba/core/logger.h>
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/util.h>
+#include <tbb/parallel_for.h>
+#include <tbb/spin_mutex.h>
+#include <list>
+#include <unordered_map>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/// Size of the header of the native tiled format in bytes
+static constexpr size_t tiled_image_header_size = 4 + 5 * sizeof(uint32_t);
+
+/// Source of unique identifiers of tiled images
+static std::atomic<uint32_t> tiled_image_counter { 0 };
+
+/* Layout of the 64 bit keys identifying tiles: 16 bits for the image,
+   6 bits for the level, and 21 bits for each tile coordinate */
+static constexpr uint32_t tile_key_max_images = 1u << 16,
+                          tile_key_max_tiles  = 1u << 21;
+
+static uint64_t tile_key(uint32_t id, uint32_t level, uint32_t tile_x, uint32_t tile_y) {
+    return ((uint64_t) id << 48) | ((uint64_t) level << 42) |
+           ((uint64_t) tile_x << 21) | (uint64_t) tile_y;
+}
+
+// =======================================================================
+//! @{ \name TiledImage
+// =======================================================================
+
+TiledImage::TiledImage(const fs::path &filename, const TileTransform &transform)
+    : m_filename(filename), m_transform(transform) {
+    m_stream = new FileStream(filename);
+
+    char header[3];
+    m_stream->read(header, 3);
+    if (header[0] != 'M' || header[1] != 'T' || header[2] != 'X')
+        Throw("Invalid tiled image file \"%s\" (expected header string \"MTX\")",
+              filename.string());
+
+    uint8_t version;
+    m_stream->read(version);
+    if (version != 1)
+        Throw("Invalid tiled image file \"%s\": unsupported version %i!",
+              filename.string(), (int) version);
+
+    uint32_t width, height;
+    m_stream->read(width);
+    m_stream->read(height);
+    m_stream->read(m_channel_count);
+    m_stream->read(m_tile_size);
+    m_stream->read(m_level_count);
+    m_size = Vector2u(width, height);
+
+    if (width == 0 || height == 0 || m_tile_size == 0 ||
+        (m_channel_count != 1 && m_channel_count != 3) ||
+        m_level_count != 1 + log2i(hmax(m_size)))
+        Throw("Invalid tiled image file \"%s\": inconsistent header!",
+              filename.string());
+
+    uint64_t tile_count = 0;
+    for (uint32_t level = 0; level < m_level_count; ++level) {
+        Vector2u tiles = (level_size(level) + m_tile_size - 1) / m_tile_size;
+        if (any(tiles >= tile_key_max_tiles))
+            Throw("Tiled image \"%s\" has too many tiles!", filename.string());
+        m_level_tile.push_back(tile_count);
+        m_level_tiles_x.push_back(tiles.x());
+        tile_count += (uint64_t) hprod(tiles);
+    }
+
+    size_t expected_size = tiled_image_header_size + tile_count * tile_bytes();
+    if (m_stream->size() != expected_size)
+        Throw("Invalid tiled image file \"%s\": expected %i bytes, found %i!",
+              filename.string(), expected_size, m_stream->size());
+
+    m_id = tiled_image_counter++;
+    if (m_id >= tile_key_max_images)
+        Throw("TiledImage: exceeded the maximum number of tiled images (%i)!",
+              tile_key_max_images);
+}
+
+TiledImage::~TiledImage() { }
+
+void TiledImage::write(const Bitmap *bitmap_, const fs::path &filename,
+                       uint32_t tile_size, FilterBoundaryCondition bc) {
+    if (tile_size == 0)
+        Throw("TiledImage::write(): the tile size must be positive!");
+
+    Bitmap::PixelFormat pixel_format;
+    switch (bitmap_->pixel_format()) {
+        case Bitmap::PixelFormat::Y:
+        case Bitmap::PixelFormat::YA:
+            pixel_format = Bitmap::PixelFormat::Y;
+            break;
+
+        case Bitmap::PixelFormat::RGB:
+        case Bitmap::PixelFormat::RGBA:
+        case Bitmap::PixelFormat::XYZ:
+        case Bitmap::PixelFormat::XYZA:
+            pixel_format = Bitmap::PixelFormat::RGB;
+            break;
+
+        default:
+            Throw("TiledImage::write(): unsupported pixel format (Y[A], "
+                  "RGB[A], XYZ[A] are supported).");
+    }
+
+    // Convert the image into a linear floating point representation
+    ref<Bitmap> bitmap =
+        bitmap_->convert(pixel_format, Struct::Type::Float32, false);
+
+    Vector2u size = bitmap->size();
+    uint32_t channel_count = (uint32_t) bitmap->channel_count(),
+             level_count   = 1 + log2i(hmax(size));
+
+    // Downsample the coarser levels of the MIP map in parallel
+    using ReconstructionFilter = Bitmap::ReconstructionFilter;
+    ref<ReconstructionFilter> rfilter =
+        PluginManager::instance()->create_object<ReconstructionFilter>(Properties("box"));
+
+    std::vector<ref<Bitmap>> levels(level_count);
+    levels[0] = bitmap;
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(1, level_count),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                Vector2u level_size = max(Vector2u(size.x() >> i, size.y() >> i), 1u);
+                levels[i] = bitmap->resample(level_size, rfilter.get(), { bc, bc });
+            }
+        }
+    );
+
+    ref<FileStream> stream = new FileStream(filename, FileStream::ETruncReadWrite);
+    stream->write("MTX", 3);
+    stream->write((uint8_t) 1);
+    stream->write(size.x());
+    stream->write(size.y());
+    stream->write(channel_count);
+    stream->write(tile_size);
+    stream->write(level_count);
+
+    std::unique_ptr<float[]> tile(new float[tile_size * tile_size * channel_count]);
+    for (const Bitmap *level : levels) {
+        const float *data = (const float *) level->data();
+        Vector2u level_size = level->size(),
+                 tiles = (level_size + tile_size - 1) / tile_size;
+
+        for (uint32_t ty = 0; ty < tiles.y(); ++ty) {
+            for (uint32_t tx = 0; tx < tiles.x(); ++tx) {
+                float *target = tile.get();
+                for (uint32_t y = 0; y < tile_size; ++y) {
+                    uint32_t py = std::min(ty * tile_size + y, level_size.y() - 1);
+                    for (uint32_t x = 0; x < tile_size; ++x) {
+                        uint32_t px = std::min(tx * tile_size + x, level_size.x() - 1);
+                        const float *source =
+                            data + ((size_t) py * level_size.x() + px) * channel_count;
+                        for (uint32_t ch = 0; ch < channel_count; ++ch)
+                            *target++ = source[ch];
+                    }
+                }
+                stream->write_array(tile.get(), tile_size * tile_size * channel_count);
+            }
+        }
+    }
+
+    stream->close();
+}
+
+const float *TiledImage::texel(uint32_t level, uint32_t x, uint32_t y) const {
+    const float *tile = TextureCache::instance()->tile(
+        this, level, x / m_tile_size, y / m_tile_size);
+    return tile + ((y % m_tile_size) * m_tile_size + x % m_tile_size) * m_channel_count;
+}
+
+void TiledImage::read_tile(uint32_t level, uint32_t tile_x, uint32_t tile_y,
+                           float *dest) const {
+    uint64_t index = m_level_tile[level] + (uint64_t) tile_y * m_level_tiles_x[level] + tile_x;
+    size_t texel_count = (size_t) m_tile_size * m_tile_size;
+
+    /* critical section */ {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_stream->seek(tiled_image_header_size + index * tile_bytes());
+        m_stream->read_array(dest, texel_count * m_channel_count);
+    }
+
+    if (m_transform)
+        m_transform(dest, texel_count);
+}
+
+std::string TiledImage::to_string() const {
+    std::ostringstream oss;
+    oss << "TiledImage[" << std::endl
+        << "  filename = \"" << m_filename << "\"," << std::endl
+        << "  size = " << m_size << "," << std::endl
+        << "  channel_count = " << m_channel_count << "," << std::endl
+        << "  tile_size = " << m_tile_size << "," << std::endl
+        << "  level_count = " << m_level_count << std::endl
+        << "]";
+    return oss.str();
+}
+
+//! @}
+// =======================================================================
+
+// =======================================================================
+//! @{ \name TextureCache
+// =======================================================================
+
+/// Number of independently locked shards of the shared cache
+static constexpr size_t texture_cache_shards = 64;
+
+/// Number of entries of the direct-mapped thread-local caches
+static constexpr size_t texture_cache_local_size = 16;
+
+/// Number of thread-local hits that are accumulated before updating the statistics
+static constexpr uint64_t texture_cache_flush_interval = 4096;
+
+struct TextureCacheTile {
+    uint64_t key;
+    size_t bytes;
+    std::unique_ptr<float[]> data;
+};
+
+using TextureCacheTilePtr = std::shared_ptr<TextureCacheTile>;
+
+struct TextureCache::TextureCachePrivate {
+    struct Shard {
+        tbb::spin_mutex mutex;
+        /// Tiles in order of their last use (most recent first)
+        std::list<TextureCacheTilePtr> lru;
+        std::unordered_map<uint64_t, std::list<TextureCacheTilePtr>::iterator> map;
+        size_t memory_usage = 0;
+    };
+
+    Shard shards[texture_cache_shards];
+
+    /// Incremented by clear() to invalidate the thread-local caches
+    std::atomic<uint64_t> generation { 0 };
+
+    std::atomic<uint64_t> local_hits { 0 }, shared_hits { 0 },
+                          misses { 0 }, evictions { 0 };
+};
+
+/// Direct-mapped cache of recently used tiles, one per thread
+struct TextureCacheLocal {
+    struct Entry {
+        uint64_t key = (uint64_t) -1;
+        TextureCacheTilePtr tile;
+    };
+
+    Entry entries[texture_cache_local_size];
+    uint64_t generation = 0;
+    uint64_t pending_hits = 0;
+};
+
+static thread_local TextureCacheLocal texture_cache_local;
+
+/// The global cache, which is created upon first use and never released
+static std::atomic<TextureCache *> texture_cache_instance { nullptr };
+static std::mutex texture_cache_instance_mutex;
+
+TextureCache::TextureCache()
+    : d(new TextureCachePrivate()), m_budget(size_t(1) << 30), m_memory_usage(0) { }
+
+TextureCache::~TextureCache() { }
+
+TextureCache *TextureCache::instance() {
+    TextureCache *cache = texture_cache_instance.load(std::memory_order_acquire);
+    if (likely(cache))
+        return cache;
+
+    std::lock_guard<std::mutex> guard(texture_cache_instance_mutex);
+    cache = texture_cache_instance.load(std::memory_order_relaxed);
+    if (!cache) {
+        cache = new TextureCache();
+        cache->inc_ref();
+        texture_cache_instance.store(cache, std::memory_order_release);
+    }
+    return cache;
+}
+
+void TextureCache::set_budget(size_t budget) {
+    m_budget = budget;
+    Log(Debug, "Texture cache budget set to %s", util::mem_string(budget));
+}
+
+const float *TextureCache::tile(const TiledImage *image, uint32_t level,
+                                uint32_t tile_x, uint32_t tile_y) {
+    uint64_t key = tile_key(image->id(), level, tile_x, tile_y);
+    TextureCacheLocal &local = texture_cache_local;
+
+    // Drop the thread-local entries following a call to clear()
+    uint64_t generation = d->generation.load(std::memory_order_relaxed);
+    if (unlikely(local.generation != generation)) {
+        for (auto &entry : local.entries)
+            entry = TextureCacheLocal::Entry();
+        local.generation = generation;
+    }
+
+    // Fast path: thread-local lookup
+    size_t slot = (size_t) (key * 0x9E3779B97F4A7C15ull >> 60) % texture_cache_local_size;
+    TextureCacheLocal::Entry &entry = local.entries[slot];
+    if (likely(entry.key == key)) {
+        if (unlikely(++local.pending_hits == texture_cache_flush_interval)) {
+            d->local_hits.fetch_add(local.pending_hits, std::memory_order_relaxed);
+            local.pending_hits = 0;
+        }
+        return entry.tile->data.get();
+    }
+
+    d->local_hits.fetch_add(local.pending_hits, std::memory_order_relaxed);
+    local.pending_hits = 0;
+
+    // Slow path: look up the tile in the shared cache
+    TextureCachePrivate::Shard &shard =
+        d->shards[std::hash<uint64_t>{}(key) % texture_cache_shards];
+    TextureCacheTilePtr tile;
+
+    /* critical section */ {
+        tbb::spin_mutex::scoped_lock guard(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it != shard.map.end()) {
+            // Move to the front of the LRU list
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            tile = *it->second;
+        }
+    }
+
+    if (tile) {
+        d->shared_hits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        // Miss: load the tile outside of the critical section
+        ScopedPhase phase(ProfilerPhase::TextureCacheLoad);
+        d->misses.fetch_add(1, std::memory_order_relaxed);
+
+        size_t tile_bytes = image->tile_bytes();
+        tile = std::make_shared<TextureCacheTile>();
+        tile->key = key;
+        tile->bytes = tile_bytes;
+        tile->data = std::unique_ptr<float[]>(new float[tile_bytes / sizeof(float)]);
+        image->read_tile(level, tile_x, tile_y, tile->data.get());
+
+        tbb::spin_mutex::scoped_lock guard(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it != shard.map.end()) {
+            // Another thread loaded the same tile in the meantime
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            tile = *it->second;
+        } else {
+            shard.lru.push_front(tile);
+            shard.map[key] = shard.lru.begin();
+            shard.memory_usage += tile_bytes;
+            m_memory_usage += tile_bytes;
+
+            // Evict the least recently used tiles of this shard
+            size_t shard_budget = m_budget / texture_cache_shards;
+            while (shard.memory_usage > shard_budget && shard.lru.size() > 1) {
+                const TextureCacheTilePtr &victim = shard.lru.back();
+                shard.memory_usage -= victim->bytes;
+                m_memory_usage -= victim->bytes;
+                shard.map.erase(victim->key);
+                shard.lru.pop_back();
+                d->evictions.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    entry.key = key;
+    entry.tile = std::move(tile);
+    return entry.tile->data.get();
+}
+
+void TextureCache::clear() {
+    for (auto &shard : d->shards) {
+        tbb::spin_mutex::scoped_lock guard(shard.mutex);
+        m_memory_usage -= shard.memory_usage;
+        shard.memory_usage = 0;
+        shard.map.clear();
+        shard.lru.clear();
+    }
+    d->generation++;
+}
+
+TextureCache::Statistics TextureCache::statistics() const {
+    Statistics stats;
+    stats.local_hits  = d->local_hits;
+    stats.shared_hits = d->shared_hits;
+    stats.misses      = d->misses;
+    stats.evictions   = d->evictions;
+    return stats;
+}
+
+void TextureCache::reset_statistics() {
+    d->local_hits  = 0;
+    d->shared_hits = 0;
+    d->misses      = 0;
+    d->evictions   = 0;
+}
+
+void TextureCache::print_statistics() {
+    TextureCache *cache = texture_cache_instance.load(std::memory_order_acquire);
+    if (!cache)
+        return;
+
+    Statistics stats = cache->statistics();
+    uint64_t lookups = stats.local_hits + stats.shared_hits + stats.misses;
+    if (lookups == 0)
+        return;
+
+    Log(Info, "\U0001F5BC  Texture cache: %i lookups, %.2f%% thread-local hits, "
+              "%.2f%% shared hits, %.2f%% misses, %i evictions (%s of %s in use).",
+        lookups,
+        stats.local_hits  * 100.0 / lookups,
+        stats.shared_hits * 100.0 / lookups,
+        stats.misses      * 100.0 / lookups,
+        stats.evictions,
+        util::mem_string(cache->memory_usage()),
+        util::mem_string(cache->budget()));
+}
+
+std::string TextureCache::to_string() const {
+    std::ostringstream oss;
+    oss << "TextureCache[" << std::endl
+        << "  budget = " << util::mem_string(m_budget) << "," << std::endl
+        << "  memory_usage = " << util::mem_string(m_memory_usage) << std::endl
+        << "]";
+    return oss.str();
+}
+
+//! @}
+// =======================================================================
+
+MTS_IMPLEMENT_CLASS(TiledImage, Object)
+MTS_IMPLEMENT_CLASS(TextureCache, Object)
+NAMESPACE_END(mitsuba)
@@ -262,14 +262,31 @@ bool check_cuda() {
 }
 
 
+/// Object that can be shared between identical declarations (see \ref create_object())
+struct UniqueObject {
+    const Class *class_;
+    Properties props;
+    ref<Object> object;
+};
+
 struct XMLParseContext {
     std::unordered_map<std::string, XMLObject> instances;
     Transform4f transform;
     size_t id_counter = 0;
     bool parallelize;
+    bool deduplicate;
     ColorMode color_mode;
 
-    XMLParseContext(const std::string &variant) : variant(variant) {
+    /// Shared objects, indexed by the hash of their properties
+    std::unordered_multimap<size_t, UniqueObject> unique_objects;
+
+    /// Memoized results of \ref Object::expand() for shared objects
+    std::unordered_map<const Object *, std::vector<ref<Object>>> unique_expansions;
+
+    tbb::spin_mutex unique_mutex;
+
+    XMLParseContext(const std::string &variant, bool deduplicate = false)
+        : deduplicate(deduplicate), variant(variant) {
         color_mode = MTS_INVOKE_VARIANT(variant, variant_to_color_mode);
 
         /* Don't load the scene in parallel when running in GPU mode
@@ -280,6 +297,127 @@ struct XMLParseContext {
     std::string variant;
 };
 
+/// Can instances of the given class be shared between identical declarations?
+static bool is_shareable(const XMLParseContext &ctx, const Class *class_) {
+    return class_->derives_from(Class::for_name("Texture", ctx.variant)) ||
+           class_->derives_from(Class::for_name("BSDF", ctx.variant));
+}
+
+/**
+ * \brief Instantiate a plugin, or return a previously created instance with
+ * identical properties when deduplication is enabled
+ *
+ * Only textures and BSDFs are shared, since these objects are not modified
+ * when they are referenced by other objects (e.g. shapes). Objects that
+ * receive pointers (e.g. spectra with tabulated values) are never shared, as
+ * their properties cannot be compared by value.
+ *
+ * \param shared
+ *     Optional output argument that is set to \c true when an existing
+ *     instance is returned
+ */
+static ref<Object> create_object(XMLParseContext &ctx, const Properties &props,
+                                 const Class *class_, bool *shared = nullptr) {
+    if (shared)
+        *shared = false;
+
+    bool shareable = ctx.deduplicate && is_shareable(ctx, class_);
+    if (shareable) {
+        for (const std::string &name : props.property_names()) {
+            if (props.type(name) == Properties::Type::Pointer) {
+                shareable = false;
+                break;
+            }
+        }
+    }
+
+    if (!shareable)
+        return PluginManager::instance()->create_object(props, class_);
+
+    // Identical declarations only differ in their (generated) identifier
+    Properties key(props);
+    key.set_id("");
+    size_t hash = key.hash();
+
+    auto find = [&]() -> ref<Object> {
+        auto range = ctx.unique_objects.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second.class_ == class_ && it->second.props == key)
+                return it->second.object;
+        }
+        return nullptr;
+    };
+
+    /* Critical section */ {
+        tbb::spin_mutex::scoped_lock lock(ctx.unique_mutex);
+        if (ref<Object> object = find()) {
+            if (shared)
+                *shared = true;
+            return object;
+        }
+    }
+
+    // Instantiate outside of the lock, and keep the first instance if several threads raced
+    ref<Object> object = PluginManager::instance()->create_object(props, class_);
+
+    tbb::spin_mutex::scoped_lock lock(ctx.unique_mutex);
+    if (ref<Object> existing = find()) {
+        if (shared)
+            *shared = true;
+        return existing;
+    }
+    ctx.unique_objects.emplace(hash, UniqueObject{ class_, key, object });
+    return object;
+}
+
+/**
+ * \brief Give an object a chance to recursively expand into sub-objects
+ *
+ * When deduplication is enabled, shared objects are only expanded once, so
+ * that objects referencing them can be shared as well.
+ */
+static std::vector<ref<Object>> expand_object(XMLParseContext &ctx, Object *obj) {
+    if (!ctx.deduplicate || !is_shareable(ctx, obj->class_()))
+        return obj->expand();
+
+    /* Critical section */ {
+        tbb::spin_mutex::scoped_lock lock(ctx.unique_mutex);
+        auto it = ctx.unique_expansions.find(obj);
+        if (it != ctx.unique_expansions.end())
+            return it->second;
+    }
+
+    std::vector<ref<Object>> children = obj->expand();
+
+    tbb::spin_mutex::scoped_lock lock(ctx.unique_mutex);
+    return ctx.unique_expansions.emplace(obj, std::move(children)).first->second;
+}
+
+/// Properties of the texture that is created for an RGB value
+static Properties rgb_texture_properties(const std::string &name, const Color<float, 3> &color,
+                                         bool within_emitter) {
+    Properties props(within_emitter ? "srgb_d65" : "srgb");
+    props.set_color("color", color);
+
+    if (!within_emitter && is_unbounded_spectrum(name))
+        props.set_bool("unbounded", true);
+
+    return props;
+}
+
+/// Properties of the texture that is created for a constant spectrum
+static Properties uniform_texture_properties(float const_value, bool within_emitter,
+                                             bool is_spectral_mode) {
+    Properties props("uniform");
+    if (within_emitter && is_spectral_mode) {
+        props.set_plugin_name("d65");
+        props.set_float("scale", const_value);
+    } else {
+        props.set_float("value", const_value);
+    }
+    return props;
+}
+
 /// Helper function to check if attributes are fully specified
 static void check_attributes(XMLSource &src, const pugi::xml_node &node,
                              std::set<std::string> &&attrs, bool expect_all = true) {
@@ -794,8 +932,9 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
 
                     if (!within_spectrum) {
                         std::string name = node.attribute("name").value();
-                        ref<Object> obj = detail::create_texture_from_rgb(
-                            name, color, ctx.variant, within_emitter);
+                        ref<Object> obj = create_object(
+                            ctx, rgb_texture_properties(name, color, within_emitter),
+                            Class::for_name("Texture", ctx.variant));
                         props.set_object(name, obj);
                     } else {
                         props.set_color("color", color);
@@ -851,11 +990,23 @@ static std::pair<std::string, std::string> parse_xml(XMLSource &src, XMLParseCon
                         }
                     }
 
-                    ref<Object> obj = detail::create_texture_from_spectrum(
-                        name, const_value, wavelengths, values, ctx.variant,
-                        within_emitter,
-                        ctx.color_mode == ColorMode::Spectral,
-                        ctx.color_mode == ColorMode::Monochromatic);
+                    ref<Object> obj;
+                    if (wavelengths.empty()) {
+                        obj = create_object(
+                            ctx, uniform_texture_properties(const_value, within_emitter,
+                                                            ctx.color_mode == ColorMode::Spectral),
+                            Class::for_name("Texture", ctx.variant));
+                        auto expanded = expand_object(ctx, obj);
+                        Assert(expanded.size() <= 1);
+                        if (!expanded.empty())
+                            obj = expanded[0];
+                    } else {
+                        obj = detail::create_texture_from_spectrum(
+                            name, const_value, wavelengths, values, ctx.variant,
+                            within_emitter,
+                            ctx.color_mode == ColorMode::Spectral,
+                            ctx.color_mode == ColorMode::Monochromatic);
+                    }
 
                     props.set_object(name, obj);
                 }
@@ -1011,7 +1162,7 @@ static ref<Object> instantiate_node(XMLParseContext &ctx, const std::string &id)
                     instantiate_recursively();
 
                 // Give the object a chance to recursively expand into sub-objects
-                std::vector<ref<Object>> children = obj->expand();
+                std::vector<ref<Object>> children = expand_object(ctx, obj);
                 if (children.empty()) {
                     props.set_object(kv.first, obj, false);
                 } else if (children.size() == 1) {
@@ -1038,8 +1189,9 @@ static ref<Object> instantiate_node(XMLParseContext &ctx, const std::string &id)
     else
         functor(range);
 
+    bool shared = false;
     try {
-        inst.object = PluginManager::instance()->create_object(props, inst.class_);
+        inst.object = create_object(ctx, props, inst.class_, &shared);
     } catch (const std::exception &e) {
         Throw("Error while loading \"%s\" (near %s): could not instantiate "
               "%s plugin of type \"%s\": %s", inst.src_id, inst.offset(inst.location),
@@ -1047,6 +1199,10 @@ static ref<Object> instantiate_node(XMLParseContext &ctx, const std::string &id)
               e.what());
     }
 
+    // The properties of a shared object were already checked by its first declaration
+    if (shared)
+        return inst.object;
+
     auto unqueried = props.unqueried();
     if (!unqueried.empty()) {
         for (auto &v : unqueried) {
@@ -1074,14 +1230,9 @@ ref<Object> create_texture_from_rgb(const std::string &name,
                                     Color<float, 3> color,
                                     const std::string &variant,
                                     bool within_emitter) {
-    Properties props(within_emitter ? "srgb_d65" : "srgb");
-    props.set_color("color", color);
-
-    if (!within_emitter && is_unbounded_spectrum(name))
-        props.set_bool("unbounded", true);
-
     return PluginManager::instance()->create_object(
-        props, Class::for_name("Texture", variant));
+        rgb_texture_properties(name, color, within_emitter),
+        Class::for_name("Texture", variant));
 }
 
 ref<Object> create_texture_from_spectrum(const std::string &name,
@@ -1095,15 +1246,8 @@ ref<Object> create_texture_from_spectrum(const std::string &name,
     const Class *class_ = Class::for_name("Texture", variant);
 
     if (wavelengths.empty()) {
-        Properties props("uniform");
-        if (within_emitter && is_spectral_mode) {
-            props.set_plugin_name("d65");
-            props.set_float("scale", const_value);
-        } else {
-            props.set_float("value", const_value);
-        }
-
-        ref<Object> obj = PluginManager::instance()->create_object(props, class_);
+        ref<Object> obj = PluginManager::instance()->create_object(
+            uniform_texture_properties(const_value, within_emitter, is_spectral_mode), class_);
         auto expanded = obj->expand();
         Assert(expanded.size() <= 1);
         if (!expanded.empty())
@@ -1176,7 +1320,7 @@ ref<Object> create_texture_from_spectrum(const std::string &name,
 NAMESPACE_END(detail)
 
 ref<Object> load_string(const std::string &string, const std::string &variant,
-                        ParameterList param) {
+                        ParameterList param, bool deduplicate) {
     ScopedPhase sp(ProfilerPhase::InitScene);
     pugi::xml_document doc;
     pugi::xml_parse_result result = doc.load_buffer(string.c_str(), string.length(),
@@ -1197,7 +1341,7 @@ ref<Object> load_string(const std::string &string, const std::string &variant,
 
     try {
         pugi::xml_node root = doc.document_element();
-        detail::XMLParseContext ctx(variant);
+        detail::XMLParseContext ctx(variant, deduplicate);
         Properties prop;
         size_t arg_counter; // Unused
         auto scene_id = detail::parse_xml(src, ctx, root, Tag::Invalid, prop,
@@ -1212,7 +1356,7 @@ ref<Object> load_string(const std::string &string, const std::string &variant,
 }
 
 ref<Object> load_file(const fs::path &filename_, const std::string &variant,
-                      ParameterList param, bool write_update) {
+                      ParameterList param, bool write_update, bool deduplicate) {
     ScopedPhase sp(ProfilerPhase::InitScene);
     fs::path filename = filename_;
     if (!fs::exists(filename))
@@ -1241,7 +1385,7 @@ ref<Object> load_file(const fs::path &filename_, const std::string &variant,
 
     try {
         pugi::xml_node root = doc.document_element();
-        detail::XMLParseContext ctx(variant);
+        detail::XMLParseContext ctx(variant, deduplicate);
         Properties prop;
         size_t arg_counter = 0; // Unused
         auto scene_id = detail::parse_xml(src, ctx, root, Tag::Invalid, prop,
@@ -1,5 +1,7 @@
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/render/texture.h>
+#include <unordered_set>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -8,6 +10,36 @@ MTS_VARIANT BSDF<Float, Spectrum>::BSDF(const Properties &props)
 
 MTS_VARIANT BSDF<Float, Spectrum>::~BSDF() { }
 
+NAMESPACE_BEGIN(detail)
+/// Traversal callback that looks for textures requiring ray differentials
+template <typename Texture> class DifferentialsCallback : public TraversalCallback {
+public:
+    void put_object(const std::string &/*name*/, Object *obj) override {
+        if (!obj || !m_visited.insert(obj).second)
+            return;
+        const Texture *texture = dynamic_cast<const Texture *>(obj);
+        if (texture && texture->needs_differentials())
+            needs_differentials = true;
+        obj->traverse(this);
+    }
+
+    bool needs_differentials = false;
+
+protected:
+    void put_parameter_impl(const std::string &, const std::type_info &, void *) override { }
+
+private:
+    std::unordered_set<Object *> m_visited;
+};
+NAMESPACE_END(detail)
+
+MTS_VARIANT void BSDF<Float, Spectrum>::update_differentials_flag() {
+    detail::DifferentialsCallback<Texture<Float, Spectrum>> callback;
+    traverse(&callback);
+    if (callback.needs_differentials)
+        m_flags = m_flags | BSDFFlags::NeedsDifferentials;
+}
+
 MTS_VARIANT Spectrum BSDF<Float, Spectrum>::eval_null_transmission(
     const SurfaceInteraction3f & /* si */, Mask /* active */) const {
     return 0.f;
@@ -78,6 +78,7 @@ MTS_VARIANT bool SamplingIntegrator<Float, Spectrum>::render(Scene *scene, Senso
     film->prepare(channels);
 
     m_render_timer.reset();
+    scene->reset_occlusion_cache_statistics();
     if constexpr (!is_cuda_array_v<Float>) {
         /// Render on the CPU using a spiral pattern
         size_t n_threads = __global_thread_count;
@@ -180,6 +181,12 @@ MTS_VARIANT bool SamplingIntegrator<Float, Spectrum>::render(Scene *scene, Senso
         Log(Info, "Rendering finished. (took %s)",
             util::time_string(m_render_timer.value(), true));
 
+    OcclusionCacheStatistics stats = scene->occlusion_cache_statistics();
+    uint64_t shadow_rays = stats.hits + stats.misses;
+    if (shadow_rays > 0)
+        Log(Debug, "Occlusion cache: %i shadow rays, %.2f%% blocked by the cached primitive.",
+            shadow_rays, stats.hits * 100.0 / shadow_rays);
+
     return !m_stop;
 }
 
@@ -222,6 +229,7 @@ MTS_VARIANT void SamplingIntegrator<Float, Spectrum>::render_block(const Scene *
             Point2u pos = enoki::morton_decode<Point2u>(index / UInt32(sample_count));
             active &= !any(pos >= block->size());
             pos += block->offset();
+            sampler->set_sample_index(index % UInt32(sample_count));
             render_sample(scene, sensor, sampler, block, aovs, pos, diff_scale_factor, active);
         }
     } else {
@@ -244,6 +252,7 @@ SamplingIntegrator<Float, Spectrum>::render_sample(const Scene *scene,
                                                    const Vector2f &pos,
                                                    ScalarFloat diff_scale_factor,
                                                    Mask active) const {
+    sampler->set_pixel(Point2u(pos));
     Vector2f position_sample = pos + sampler->next_2d(active);
 
     Point2f aperture_sample(.5f);
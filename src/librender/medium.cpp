@@ -31,6 +31,23 @@ MTS_VARIANT Medium<Float, Spectrum>::Medium(const Properties &props) : m_id(prop
 
 MTS_VARIANT Medium<Float, Spectrum>::~Medium() {}
 
+/// Return the entry \c channel of a spectrum
+template <typename Value, typename UInt32>
+MTS_INLINE auto index_channel(const Value &value, const UInt32 &channel) {
+    auto result = value[0];
+    for (size_t i = 1; i < array_size_v<Value>; ++i)
+        masked(result, eq(channel, (uint32_t) i)) = value[i];
+    return result;
+}
+
+/// Reduce a spectrally varying PDF to the PDF of the channel selection strategy
+template <typename Value, typename UInt32>
+MTS_INLINE auto strategy_pdf(const Value &pdf, const UInt32 &channel, bool spectral_mis) {
+    if (spectral_mis)
+        return hmean(pdf);
+    return index_channel(pdf, channel);
+}
+
 MTS_VARIANT
 typename Medium<Float, Spectrum>::MediumInteraction3f
 Medium<Float, Spectrum>::sample_interaction(const Ray3f &ray, Float sample,
@@ -53,15 +70,45 @@ Medium<Float, Spectrum>::sample_interaction(const Ray3f &ray, Float sample,
     mint = max(ray.mint, mint);
     maxt = min(ray.maxt, maxt);
 
-    auto combined_extinction = get_combined_extinction(mi, active);
-    Float m                  = combined_extinction[0];
-    if constexpr (is_rgb_v<Spectrum>) { // Handle RGB rendering
-        masked(m, eq(channel, 1u)) = combined_extinction[1];
-        masked(m, eq(channel, 2u)) = combined_extinction[2];
-    } else {
-        ENOKI_MARK_USED(channel);
+    if (has_majorant_grid()) {
+        Float tau = -enoki::log(1 - sample);
+
+        // The grid only bounds the residual of a homogeneous control component
+        UnpolarizedSpectrum sigma_c(0.f);
+        Float c = 0.f;
+        if (has_control_extinction()) {
+            sigma_c = eval_control_extinction(mi, active);
+            c       = index_channel(sigma_c, channel);
+        } else {
+            ENOKI_MARK_USED(channel);
+        }
+        auto [sampled_t, m] = sample_majorant_grid(ray, mint, maxt, tau, active, c);
+
+        Mask valid_mi = active && (sampled_t <= maxt);
+        mi.t          = select(valid_mi, sampled_t, math::Infinity<Float>);
+        mi.p          = ray(sampled_t);
+        mi.medium     = this;
+
+        /* The integrators evaluate the free-flight transmittance and PDF as
+           exp(-(t - mint) * combined_extinction). Shift 'mint' so that this
+           reproduces the optical depth accumulated along the grid. With a
+           chromatic control component, the grid's optical depth is common to
+           all channels and cancels out in the ratio of transmittance and PDF,
+           hence 'mint' is left unchanged to keep the control part exact. */
+        if (has_control_extinction())
+            mi.mint = mint;
+        else
+            mi.mint = select(valid_mi, sampled_t - tau / m, mint);
+        std::tie(mi.sigma_s, mi.sigma_n, mi.sigma_t) =
+            get_scattering_coefficients(mi, valid_mi);
+        mi.combined_extinction = m + sigma_c;
+        mi.sigma_n             = mi.combined_extinction - mi.sigma_t;
+        return mi;
     }
 
+    auto combined_extinction = get_combined_extinction(mi, active);
+    Float m                  = index_channel(combined_extinction, channel);
+
     Float sampled_t = mint + (-enoki::log(1 - sample) / m);
     Mask valid_mi   = active && (sampled_t <= maxt);
     mi.t            = select(valid_mi, sampled_t, math::Infinity<Float>);
@@ -74,6 +121,159 @@ Medium<Float, Spectrum>::sample_interaction(const Ray3f &ray, Float sample,
     return mi;
 }
 
+MTS_VARIANT
+typename Medium<Float, Spectrum>::MediumInteraction3f
+Medium<Float, Spectrum>::sample_ratio_tracking(const Ray3f &ray, Float sample,
+                                               UInt32 channel, Mask active) const {
+    if (!has_control_extinction())
+        return sample_interaction(ray, sample, channel, active);
+
+    MTS_MASKED_FUNCTION(ProfilerPhase::MediumSample, active);
+
+    MediumInteraction3f mi;
+    mi.sh_frame    = Frame3f(ray.d);
+    mi.wi          = -ray.d;
+    mi.time        = ray.time;
+    mi.wavelengths = ray.wavelengths;
+
+    auto [aabb_its, mint, maxt] = intersect_aabb(ray);
+    aabb_its &= (enoki::isfinite(mint) || enoki::isfinite(maxt));
+    active &= aabb_its;
+    masked(mint, !active) = 0.f;
+    masked(maxt, !active) = math::Infinity<Float>;
+
+    mint = max(ray.mint, mint);
+    maxt = min(ray.maxt, maxt);
+
+    /* Only the residual component (majorant minus control extinction) is
+       tracked. As in sample_interaction(), 'mint' is not shifted when walking
+       the majorant grid: its optical depth is common to all channels and
+       cancels out in eval_ratio_tracking_weight(). */
+    UnpolarizedSpectrum sigma_c = eval_control_extinction(mi, active),
+                        m_residual;
+    Float tau = -enoki::log(1 - sample), sampled_t;
+    if (has_majorant_grid()) {
+        Float m_grid;
+        std::tie(sampled_t, m_grid) = sample_majorant_grid(ray, mint, maxt, tau, active);
+        m_residual = m_grid;
+    } else {
+        m_residual = get_combined_extinction(mi, active) - sigma_c;
+        sampled_t  = mint + tau / index_channel(m_residual, channel);
+    }
+
+    Mask valid_mi = active && (sampled_t <= maxt);
+    mi.t          = select(valid_mi, sampled_t, math::Infinity<Float>);
+    mi.p          = ray(sampled_t);
+    mi.medium     = this;
+    mi.mint       = mint;
+    std::tie(mi.sigma_s, mi.sigma_n, mi.sigma_t) =
+        get_scattering_coefficients(mi, valid_mi);
+    mi.sigma_n             = m_residual + sigma_c - mi.sigma_t;
+    mi.combined_extinction = m_residual;
+    return mi;
+}
+
+MTS_VARIANT std::pair<Float, Float>
+Medium<Float, Spectrum>::sample_majorant_grid(const Ray3f &ray, Float mint,
+                                              Float maxt, Float tau,
+                                              Mask active, Float offset) const {
+    ScalarVector3f res(m_majorant_resolution),
+                   cell_size = m_majorant_bbox.extents() / res;
+
+    // Cell containing the start of the segment. Cell indices are stored as
+    // floating point values so that all masks below have the same type.
+    Vector3f cell = floor((ray(mint) - m_majorant_bbox.min) / cell_size);
+    cell = clamp(cell, 0.f, res - 1.f);
+
+    // Parametric distances to the next cell boundary and between boundaries
+    auto positive = ray.d >= 0.f;
+    Vector3f step    = select(positive, 1.f, -1.f),
+             t_next  = (m_majorant_bbox.min + (cell + select(positive, 1.f, 0.f)) * cell_size - ray.o) * ray.d_rcp,
+             t_delta = abs(cell_size * ray.d_rcp);
+    masked(t_next, eq(ray.d, 0.f)) = math::Infinity<Float>;
+
+    Float t = mint, majorant = 0.f,
+          sampled_t = math::Infinity<Float>;
+
+    Mask loop = active;
+    while (any(loop)) {
+        Int32 index = Int32(fmadd(fmadd(cell.z(), res.y(), cell.y()), res.x(), cell.x()));
+        Float m = gather<Float>(m_majorant_grid, index, loop),
+              m_tracked = m + offset;
+
+        // Optical depth of the segment within the current cell
+        Float t_exit = min(hmin(t_next), maxt),
+              dtau   = m_tracked * max(t_exit - t, 0.f);
+
+        Mask found = loop && (m_tracked > 0.f) && (dtau >= tau);
+        masked(sampled_t, found) = t + tau / m_tracked;
+        masked(majorant, loop)   = m;
+        masked(tau, loop && !found) -= dtau;
+        loop &= !found && (t_exit < maxt);
+
+        // Advance to the neighboring cell(s) along the closest boundary
+        auto advance = eq(t_next, hmin(t_next)) && loop;
+        masked(cell, advance)   += step;
+        masked(t_next, advance) += t_delta;
+        masked(t, loop)          = t_exit;
+        loop &= all(cell >= 0.f && cell < res);
+    }
+
+    return { sampled_t, majorant };
+}
+
+MTS_VARIANT void
+Medium<Float, Spectrum>::set_majorant_grid(const ScalarBoundingBox3f &bbox,
+                                           const ScalarVector3u &resolution,
+                                           const std::vector<ScalarFloat> &values) {
+    if (values.size() != hprod(resolution))
+        Throw("set_majorant_grid(): expected %i values, got %i!",
+              hprod(resolution), values.size());
+    m_majorant_bbox       = bbox;
+    m_majorant_resolution = resolution;
+    m_majorant_grid       = DynamicBuffer<Float>::copy(values.data(), values.size());
+}
+
+MTS_VARIANT Float
+Medium<Float, Spectrum>::eval_majorant_grid(const Point3f &p, Mask active) const {
+    ScalarVector3f res(m_majorant_resolution);
+    Vector3f cell = floor((p - m_majorant_bbox.min) / m_majorant_bbox.extents() * res);
+    cell = clamp(cell, 0.f, res - 1.f);
+    Int32 index = Int32(fmadd(fmadd(cell.z(), res.y(), cell.y()), res.x(), cell.x()));
+    return gather<Float>(m_majorant_grid, index, active);
+}
+
+MTS_VARIANT void Medium<Float, Spectrum>::set_control_extinction(Volume *volume) {
+    if (volume->class_()->name() != "ConstVolume" && hprod(volume->resolution()) != 1)
+        Throw("The control extinction must be spatially constant (i.e. a "
+              "\"constvolume\" or a single voxel), got: %s", volume);
+    m_control_sigma_t = volume;
+
+    if constexpr (!is_spectral_v<Spectrum>) {
+        Interaction3f it;
+        it.p    = volume->bbox().center();
+        it.time = 0.f;
+        m_control_extinction = volume->eval(it);
+    }
+}
+
+MTS_VARIANT typename Medium<Float, Spectrum>::UnpolarizedSpectrum
+Medium<Float, Spectrum>::eval_control_extinction(const MediumInteraction3f &mi,
+                                                 Mask active) const {
+    if constexpr (is_spectral_v<Spectrum>) {
+        // The value only depends on the wavelengths
+        Interaction3f it;
+        it.p           = m_control_sigma_t->bbox().center();
+        it.time        = mi.time;
+        it.wavelengths = mi.wavelengths;
+        return m_control_sigma_t->eval(it, active);
+    } else {
+        ENOKI_MARK_USED(mi);
+        ENOKI_MARK_USED(active);
+        return m_control_extinction;
+    }
+}
+
 MTS_VARIANT
 std::pair<typename Medium<Float, Spectrum>::UnpolarizedSpectrum,
           typename Medium<Float, Spectrum>::UnpolarizedSpectrum>
@@ -88,6 +288,65 @@ Medium<Float, Spectrum>::eval_tr_and_pdf(const MediumInteraction3f &mi,
     return { tr, pdf };
 }
 
+MTS_VARIANT
+typename Medium<Float, Spectrum>::UnpolarizedSpectrum
+Medium<Float, Spectrum>::eval_tr_weight(const MediumInteraction3f &mi,
+                                        const SurfaceInteraction3f &si,
+                                        UInt32 channel, bool spectral_mis,
+                                        Mask active) const {
+    auto [tr, pdf] = eval_tr_and_pdf(mi, si, active);
+    Float tr_pdf   = strategy_pdf(pdf, channel, spectral_mis);
+    return select(tr_pdf > 0.f, tr / tr_pdf, 0.f);
+}
+
+MTS_VARIANT
+std::pair<typename Medium<Float, Spectrum>::Mask,
+          typename Medium<Float, Spectrum>::UnpolarizedSpectrum>
+Medium<Float, Spectrum>::sample_collision(const MediumInteraction3f &mi,
+                                          Float sample, UInt32 channel,
+                                          bool spectral_mis, Mask active) const {
+    MTS_MASKED_FUNCTION(ProfilerPhase::MediumSample, active);
+
+    if (spectral_mis) {
+        // Reuse the sample to select the channel that drives the decision
+        uint32_t n_channels = (uint32_t) array_size_v<UnpolarizedSpectrum>;
+        Float scaled = sample * n_channels;
+        channel = (UInt32) min(scaled, n_channels - 1);
+        sample  = scaled - Float(channel);
+    }
+
+    UnpolarizedSpectrum prob_real = mi.sigma_t / mi.combined_extinction,
+                        prob_null = mi.sigma_n / mi.combined_extinction;
+    Mask real = active && sample < index_channel(prob_real, channel);
+
+    Float p_real = strategy_pdf(prob_real, channel, spectral_mis),
+          p_null = strategy_pdf(prob_null, channel, spectral_mis);
+    UnpolarizedSpectrum weight =
+        select(real, mi.sigma_s / p_real, mi.sigma_n / p_null);
+    return { real, select(active && (select(real, p_real, p_null) > 0.f), weight, 0.f) };
+}
+
+MTS_VARIANT
+typename Medium<Float, Spectrum>::UnpolarizedSpectrum
+Medium<Float, Spectrum>::eval_ratio_tracking_weight(const MediumInteraction3f &mi,
+                                                    Float maxt, UInt32 channel,
+                                                    bool spectral_mis,
+                                                    Mask active) const {
+    MTS_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
+
+    Mask collided = mi.is_valid() && mi.t <= maxt;
+    Float t = min(mi.t, maxt) - mi.mint;
+    UnpolarizedSpectrum tr  = exp(-t * mi.combined_extinction);
+    UnpolarizedSpectrum pdf = select(collided, tr * mi.combined_extinction, tr);
+    Float tr_pdf = strategy_pdf(pdf, channel, spectral_mis);
+
+    UnpolarizedSpectrum weight = select(tr_pdf > 0.f, tr / tr_pdf, 0.f);
+    if (has_control_extinction())
+        weight *= exp(-t * eval_control_extinction(mi, active));
+    masked(weight, collided) *= mi.sigma_n;
+    return weight;
+}
+
 MTS_IMPLEMENT_CLASS_VARIANT(Medium, Object, "medium")
 MTS_INSTANTIATE_CLASS(Medium)
 NAMESPACE_END(mitsuba)
@@ -8,6 +8,8 @@
 #include <mitsuba/render/mesh.h>
 #include <mitsuba/render/records.h>
 #include <mitsuba/render/scene.h>
+#include <tbb/tbb.h>
+#include <atomic>
 #include <mutex>
 
 #if defined(MTS_ENABLE_EMBREE)
@@ -21,6 +23,9 @@
     #include "../shapes/optix/mesh.cuh"
 #endif
 
+/// Number of vertices/faces processed per task by the parallel mesh routines
+#define MTS_MESH_GRAIN_SIZE 16384
+
 NAMESPACE_BEGIN(mitsuba)
 
 MTS_VARIANT Mesh<Float, Spectrum>::Mesh(const Properties &props) : Base(props) {
@@ -29,6 +34,11 @@ MTS_VARIANT Mesh<Float, Spectrum>::Mesh(const Properties &props) : Base(props) {
        appearance. Default: ``false`` */
     if (props.bool_("face_normals", false))
         m_disable_vertex_normals = true;
+
+    /* When set to ``true``, vertex positions, normals and texture coordinates
+       are quantized after loading to reduce the memory footprint of very large
+       meshes. The mesh can no longer be modified afterwards. Default: ``false`` */
+    m_compact_storage = props.bool_("compact", false);
 }
 
 MTS_VARIANT
@@ -145,18 +155,33 @@ MTS_VARIANT void Mesh<Float, Spectrum>::write_ply(const std::string &filename) c
         vertex_attributes_ptr.push_back(attribute.buf.data());
 
     for (size_t i = 0; i < m_vertex_count; i++) {
-        // Write positions
-        stream->write(position_ptr, 3 * sizeof(InputFloat));
-        position_ptr += 3;
-        // Write normals
-        if (has_vertex_normals()) {
-            stream->write(normal_ptr, 3 * sizeof(InputFloat));
-            normal_ptr += 3;
-        }
-        // Write texture coordinates
-        if (has_vertex_texcoords()) {
-            stream->write(texcoord_ptr, 2 * sizeof(InputFloat));
-            texcoord_ptr += 2;
+        if (m_compact_storage) {
+            // Dequantize the vertex data on the fly
+            InputFloat tmp[3];
+            store_unaligned(tmp, InputPoint3f(vertex_position((ScalarIndex) i)));
+            stream->write(tmp, 3 * sizeof(InputFloat));
+            if (has_vertex_normals()) {
+                store_unaligned(tmp, InputNormal3f(vertex_normal((ScalarIndex) i)));
+                stream->write(tmp, 3 * sizeof(InputFloat));
+            }
+            if (has_vertex_texcoords()) {
+                store_unaligned(tmp, InputVector2f(vertex_texcoord((ScalarIndex) i)));
+                stream->write(tmp, 2 * sizeof(InputFloat));
+            }
+        } else {
+            // Write positions
+            stream->write(position_ptr, 3 * sizeof(InputFloat));
+            position_ptr += 3;
+            // Write normals
+            if (has_vertex_normals()) {
+                stream->write(normal_ptr, 3 * sizeof(InputFloat));
+                normal_ptr += 3;
+            }
+            // Write texture coordinates
+            if (has_vertex_texcoords()) {
+                stream->write(texcoord_ptr, 2 * sizeof(InputFloat));
+                texcoord_ptr += 2;
+            }
         }
 
         for (size_t j = 0; j < vertex_attributes_ptr.size(); ++j) {
@@ -201,57 +226,94 @@ MTS_VARIANT void Mesh<Float, Spectrum>::recompute_vertex_normals() {
     if (!has_vertex_normals())
         Throw("Storing new normals in a Mesh that didn't have normals at "
               "construction time is not implemented yet.");
+    if (slices(m_vertex_normals_packed_buf) != 0)
+        Throw("recompute_vertex_normals(): not supported for meshes using "
+              "compact storage.");
 
     /* Weighting scheme based on "Computing Vertex Normals from Polygonal Facets"
        by Grit Thuermer and Charles A. Wuethrich, JGT 1998, Vol 3 */
 
     if constexpr (!is_dynamic_v<Float>) {
-        size_t invalid_counter = 0;
-        std::vector<InputNormal3f> normals(m_vertex_count, zero<InputNormal3f>());
-
-        for (ScalarSize i = 0; i < m_face_count; ++i) {
-            auto fi = face_indices(i);
-            Assert(fi[0] < m_vertex_count &&
-                   fi[1] < m_vertex_count &&
-                   fi[2] < m_vertex_count);
-
-            InputPoint3f v[3] = { vertex_position(fi[0]),
-                                  vertex_position(fi[1]),
-                                  vertex_position(fi[2]) };
-
-            InputVector3f side_0 = v[1] - v[0],
-                          side_1 = v[2] - v[0];
-            InputNormal3f n = cross(side_0, side_1);
-            InputFloat length_sqr = squared_norm(n);
-            if (likely(length_sqr > 0)) {
-                n *= rsqrt(length_sqr);
-
-                // Use Enoki to compute the face angles at the same time
-                auto side1 = transpose(Array<Packet<InputFloat, 3>, 3>{ side_0, v[2] - v[1], v[0] - v[2] });
-                auto side2 = transpose(Array<Packet<InputFloat, 3>, 3>{ side_1, v[0] - v[1], v[1] - v[2] });
-                InputVector3f face_angles = unit_angle(normalize(side1), normalize(side2));
-
-                for (size_t j = 0; j < 3; ++j)
-                    normals[fi[j]] += n * face_angles[j];
+        /* Faces are processed in parallel, and their contributions are
+           accumulated using atomic floating point additions. Contention is
+           rare, since adjacent faces are mostly processed by the same task. */
+        std::unique_ptr<std::atomic<InputFloat>[]> normals(
+            new std::atomic<InputFloat>[m_vertex_count * 3]);
+
+        auto atomic_add = [](std::atomic<InputFloat> &target, InputFloat value) {
+            InputFloat current = target.load(std::memory_order_relaxed);
+            while (!target.compare_exchange_weak(current, current + value,
+                                                 std::memory_order_relaxed))
+                ;
+        };
+
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, m_vertex_count * (size_t) 3, MTS_MESH_GRAIN_SIZE),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i)
+                    normals[i].store(0.f, std::memory_order_relaxed);
             }
-        }
+        );
 
-        for (ScalarSize i = 0; i < m_vertex_count; i++) {
-            InputNormal3f n = normals[i];
-            InputFloat length = norm(n);
-            if (likely(length != 0.f)) {
-                n /= length;
-            } else {
-                n = InputNormal3f(1, 0, 0); // Choose some bogus value
-                invalid_counter++;
+        tbb::parallel_for(
+            tbb::blocked_range<ScalarSize>(0, m_face_count, MTS_MESH_GRAIN_SIZE),
+            [&](const tbb::blocked_range<ScalarSize> &range) {
+                for (ScalarSize i = range.begin(); i != range.end(); ++i) {
+                    auto fi = face_indices(i);
+                    Assert(fi[0] < m_vertex_count &&
+                           fi[1] < m_vertex_count &&
+                           fi[2] < m_vertex_count);
+
+                    InputPoint3f v[3] = { vertex_position(fi[0]),
+                                          vertex_position(fi[1]),
+                                          vertex_position(fi[2]) };
+
+                    InputVector3f side_0 = v[1] - v[0],
+                                  side_1 = v[2] - v[0];
+                    InputNormal3f n = cross(side_0, side_1);
+                    InputFloat length_sqr = squared_norm(n);
+                    if (likely(length_sqr > 0)) {
+                        n *= rsqrt(length_sqr);
+
+                        // Use Enoki to compute the face angles at the same time
+                        auto side1 = transpose(Array<Packet<InputFloat, 3>, 3>{ side_0, v[2] - v[1], v[0] - v[2] });
+                        auto side2 = transpose(Array<Packet<InputFloat, 3>, 3>{ side_1, v[0] - v[1], v[1] - v[2] });
+                        InputVector3f face_angles = unit_angle(normalize(side1), normalize(side2));
+
+                        for (size_t j = 0; j < 3; ++j)
+                            for (size_t k = 0; k < 3; ++k)
+                                atomic_add(normals[fi[j] * (size_t) 3 + k], n[k] * face_angles[j]);
+                    }
+                }
             }
+        );
 
-            store(m_vertex_normals_buf.data() + 3 * i, n);
-        }
+        std::atomic<size_t> invalid_counter { 0 };
+        tbb::parallel_for(
+            tbb::blocked_range<ScalarSize>(0, m_vertex_count, MTS_MESH_GRAIN_SIZE),
+            [&](const tbb::blocked_range<ScalarSize> &range) {
+                size_t invalid = 0;
+                for (ScalarSize i = range.begin(); i != range.end(); ++i) {
+                    InputNormal3f n(normals[3 * (size_t) i].load(std::memory_order_relaxed),
+                                    normals[3 * (size_t) i + 1].load(std::memory_order_relaxed),
+                                    normals[3 * (size_t) i + 2].load(std::memory_order_relaxed));
+                    InputFloat length = norm(n);
+                    if (likely(length != 0.f)) {
+                        n /= length;
+                    } else {
+                        n = InputNormal3f(1, 0, 0); // Choose some bogus value
+                        invalid++;
+                    }
+
+                    store_unaligned(m_vertex_normals_buf.data() + 3 * i, n);
+                }
+                invalid_counter += invalid;
+            }
+        );
 
         if (invalid_counter > 0)
             Log(Warn, "\"%s\": computed vertex normals (%i invalid vertices!)",
-                m_name, invalid_counter);
+                m_name, (size_t) invalid_counter);
     } else {
         auto fi = face_indices(arange<UInt32>(m_face_count));
 
@@ -277,9 +339,140 @@ MTS_VARIANT void Mesh<Float, Spectrum>::recompute_vertex_normals() {
 }
 
 MTS_VARIANT void Mesh<Float, Spectrum>::recompute_bbox() {
-    m_bbox.reset();
-    for (ScalarSize i = 0; i < m_vertex_count; ++i)
-        m_bbox.expand(vertex_position(i));
+    m_bbox = tbb::parallel_reduce(
+        tbb::blocked_range<ScalarSize>(0, m_vertex_count, MTS_MESH_GRAIN_SIZE),
+        ScalarBoundingBox3f(),
+
+        /* MAP: Compute the bounding box of a range of vertices */
+        [&](const tbb::blocked_range<ScalarSize> &range, ScalarBoundingBox3f bbox) {
+            for (ScalarSize i = range.begin(); i != range.end(); ++i)
+                bbox.expand(vertex_position(i));
+            return bbox;
+        },
+
+        /* REDUCE: Merge two bounding boxes */
+        [](ScalarBoundingBox3f b1, const ScalarBoundingBox3f &b2) {
+            b1.expand(b2);
+            return b1;
+        }
+    );
+}
+
+namespace {
+/// Map a unit vector onto the octahedron and quantize it to 2x16 bit
+template <typename Vector3>
+uint32_t encode_octahedral(const Vector3 &n_) {
+    using Value = value_t<Vector3>;
+    Vector3 n = n_ / (abs(n_.x()) + abs(n_.y()) + abs(n_.z()));
+
+    Value x = n.x(), y = n.y();
+    if (n.z() < 0.f) {
+        x = (1.f - abs(n.y())) * (n.x() >= 0.f ? 1.f : -1.f);
+        y = (1.f - abs(n.x())) * (n.y() >= 0.f ? 1.f : -1.f);
+    }
+
+    auto quantize = [](Value v) {
+        return (uint32_t) std::lround(clamp(fmadd(v, .5f, .5f), 0.f, 1.f) * 65535.f);
+    };
+
+    return quantize(x) | (quantize(y) << 16);
+}
+} // end namespace
+
+MTS_VARIANT void Mesh<Float, Spectrum>::compact_vertex_data() {
+    if constexpr (is_dynamic_v<Float>) {
+        Log(Warn, "\"%s\": compact mesh storage is not supported by this "
+                  "variant, keeping full-precision vertex data.", m_name);
+        m_compact_storage = false;
+    } else {
+        if (m_vertex_count == 0)
+            return;
+
+        Timer timer;
+        size_t bytes_before = m_vertex_count * vertex_data_bytes();
+
+        if (slices(m_vertex_normals_buf) != 0) {
+            m_vertex_normals_packed_buf = empty<DynamicBuffer<UInt32>>(m_vertex_count);
+            const InputFloat *src = m_vertex_normals_buf.data();
+            ScalarIndex *dst = m_vertex_normals_packed_buf.data();
+            for (ScalarSize i = 0; i < m_vertex_count; ++i)
+                dst[i] = encode_octahedral(load_unaligned<InputNormal3f>(src + 3 * i));
+            m_vertex_normals_buf = FloatStorage();
+        }
+
+        if (slices(m_vertex_texcoords_buf) != 0) {
+            const InputFloat *src = m_vertex_texcoords_buf.data();
+            InputVector2f uv_min(math::Infinity<InputFloat>),
+                          uv_max(-math::Infinity<InputFloat>);
+            for (ScalarSize i = 0; i < m_vertex_count; ++i) {
+                InputVector2f uv = load_unaligned<InputVector2f>(src + 2 * i);
+                uv_min = min(uv_min, uv);
+                uv_max = max(uv_max, uv);
+            }
+
+            m_texcoord_offset = uv_min;
+            m_texcoord_scale = (uv_max - uv_min) / 65535.f;
+            InputVector2f inv_scale = select(m_texcoord_scale > 0.f,
+                                             rcp(m_texcoord_scale), InputVector2f(0.f));
+
+            m_vertex_texcoords_packed_buf = empty<DynamicBuffer<UInt32>>(m_vertex_count);
+            ScalarIndex *dst = m_vertex_texcoords_packed_buf.data();
+            for (ScalarSize i = 0; i < m_vertex_count; ++i) {
+                InputVector2f q = (load_unaligned<InputVector2f>(src + 2 * i) - uv_min) * inv_scale;
+                dst[i] = (uint32_t) std::lround(q.x()) | ((uint32_t) std::lround(q.y()) << 16);
+            }
+            m_vertex_texcoords_buf = FloatStorage();
+        }
+
+#if !defined(MTS_ENABLE_EMBREE)
+        /* Positions are quantized relative to the bounding box of clusters of
+           consecutive vertices, which are usually spatially coherent in
+           scanned and tessellated meshes. (Embree requires the original
+           full-precision position buffer and is left unchanged.) */
+        const uint32_t cluster_size = 1u << CompactClusterShift;
+        ScalarSize cluster_count = (m_vertex_count + cluster_size - 1) / cluster_size;
+        const InputVector3f bits(2097151.f, 2097151.f, 4194303.f);
+
+        m_vertex_positions_packed_buf = empty<DynamicBuffer<UInt32>>(m_vertex_count * 2);
+        m_vertex_position_clusters_buf = empty<FloatStorage>(cluster_count * 6);
+
+        const InputFloat *src = m_vertex_positions_buf.data();
+        ScalarIndex *dst = m_vertex_positions_packed_buf.data();
+        InputFloat *clusters = m_vertex_position_clusters_buf.data();
+
+        for (ScalarSize c = 0; c < cluster_count; ++c) {
+            ScalarSize start = c * cluster_size,
+                       end   = std::min(start + cluster_size, m_vertex_count);
+
+            BoundingBox<InputPoint3f> bbox;
+            for (ScalarSize i = start; i < end; ++i)
+                bbox.expand(load_unaligned<InputPoint3f>(src + 3 * i));
+
+            InputVector3f scale = bbox.extents() / bits,
+                          inv_scale = select(scale > 0.f, rcp(scale), InputVector3f(0.f));
+            store_unaligned(clusters + 6 * c, bbox.min);
+            store_unaligned(clusters + 6 * c + 3, scale);
+
+            for (ScalarSize i = start; i < end; ++i) {
+                InputVector3f q = (load_unaligned<InputPoint3f>(src + 3 * i) - bbox.min) * inv_scale;
+                uint32_t qx = (uint32_t) std::lround(q.x()),
+                         qy = (uint32_t) std::lround(q.y()),
+                         qz = (uint32_t) std::lround(q.z());
+                dst[2 * i]     = qx | (qy << 21);
+                dst[2 * i + 1] = (qy >> 11) | (qz << 10);
+            }
+        }
+        m_vertex_positions_buf = FloatStorage();
+
+        // Use the dequantized positions from now on
+        recompute_bbox();
+#endif
+
+        size_t bytes_after = m_vertex_count * vertex_data_bytes();
+        Log(Info, "\"%s\": compact storage reduced vertex data from %s to %s (took %s)",
+            m_name, util::mem_string(bytes_before), util::mem_string(bytes_after),
+            util::time_string(timer.value()));
+    }
 }
 
 MTS_VARIANT void Mesh<Float, Spectrum>::build_pmf() {
@@ -293,13 +486,68 @@ MTS_VARIANT void Mesh<Float, Spectrum>::build_pmf() {
 
     // TODO could use manage() as area_pmf doesn't need to be differentiable
     if constexpr (!is_dynamic_v<Float>) {
-        std::vector<ScalarFloat> table(m_face_count);
-        for (ScalarIndex i = 0; i < m_face_count; i++)
-            table[i] = face_area(i);
+        using FloatStorage = DynamicBuffer<Float>;
+        using ScalarVector2u = typename DiscreteDistribution<Float>::ScalarVector2u;
+
+        /* Face areas and the CDF are computed using a two-pass parallel
+           prefix sum over fixed-size blocks, which makes the result
+           independent of the number of threads */
+        size_t block_count = (m_face_count + MTS_MESH_GRAIN_SIZE - 1) / MTS_MESH_GRAIN_SIZE;
+        std::vector<double> block_offset(block_count + 1, 0.0);
+        std::vector<ScalarVector2u> block_valid(block_count, ScalarVector2u((uint32_t) -1));
+
+        FloatStorage pmf = empty<FloatStorage>(m_face_count),
+                     cdf = empty<FloatStorage>(m_face_count);
+        ScalarFloat *pmf_ptr = pmf.data(), *cdf_ptr = cdf.data();
+
+        auto for_each_block = [&](auto func) {
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, block_count, 1),
+                [&](const tbb::blocked_range<size_t> &range) {
+                    for (size_t b = range.begin(); b != range.end(); ++b)
+                        func(b, (ScalarIndex) (b * MTS_MESH_GRAIN_SIZE),
+                             (ScalarIndex) std::min((b + 1) * MTS_MESH_GRAIN_SIZE,
+                                                    (size_t) m_face_count));
+                }
+            );
+        };
+
+        for_each_block([&](size_t b, ScalarIndex start, ScalarIndex end) {
+            double sum = 0.0;
+            for (ScalarIndex i = start; i < end; ++i) {
+                ScalarFloat area = face_area(i);
+                pmf_ptr[i] = area;
+                sum += (double) area;
+                if (area > 0.f) {
+                    if (block_valid[b].x() == (uint32_t) -1)
+                        block_valid[b].x() = i;
+                    block_valid[b].y() = i;
+                }
+            }
+            block_offset[b + 1] = sum;
+        });
+
+        ScalarVector2u valid((uint32_t) -1);
+        for (size_t b = 0; b < block_count; ++b) {
+            block_offset[b + 1] += block_offset[b];
+            if (block_valid[b].x() != (uint32_t) -1) {
+                if (valid.x() == (uint32_t) -1)
+                    valid.x() = block_valid[b].x();
+                valid.y() = block_valid[b].y();
+            }
+        }
+
+        for_each_block([&](size_t b, ScalarIndex start, ScalarIndex end) {
+            double sum = block_offset[b];
+            for (ScalarIndex i = start; i < end; ++i) {
+                sum += (double) pmf_ptr[i];
+                cdf_ptr[i] = (ScalarFloat) sum;
+            }
+        });
 
         m_area_pmf = DiscreteDistribution<Float>(
-            table.data(),
-            m_face_count
+            std::move(pmf), std::move(cdf), valid,
+            (ScalarFloat) block_offset[block_count]
         );
     } else {
         Float table = face_area(arange<UInt32>(m_face_count)).managed();
@@ -736,6 +984,9 @@ MTS_VARIANT std::string Mesh<Float, Spectrum>::to_string() const {
         << "  face_count = " << m_face_count << "," << std::endl
         << "  faces = [" << util::mem_string(face_data_bytes() * m_face_count) << " of face data]," << std::endl;
 
+    if (m_compact_storage)
+        oss << "  compact_storage = 1," << std::endl;
+
     if (!m_area_pmf.empty())
         oss << "  surface_area = " << m_area_pmf.sum() << "," << std::endl;
 
@@ -758,11 +1009,21 @@ MTS_VARIANT std::string Mesh<Float, Spectrum>::to_string() const {
 }
 
 MTS_VARIANT size_t Mesh<Float, Spectrum>::vertex_data_bytes() const {
-    size_t vertex_data_bytes = 3 * sizeof(InputFloat);
+    size_t vertex_data_bytes = 0;
+
+    if (slices(m_vertex_positions_packed_buf) != 0)
+        vertex_data_bytes += 2 * sizeof(ScalarIndex);
+    else
+        vertex_data_bytes += 3 * sizeof(InputFloat);
 
-    if (has_vertex_normals())
+    if (slices(m_vertex_normals_packed_buf) != 0)
+        vertex_data_bytes += sizeof(ScalarIndex);
+    else if (has_vertex_normals())
         vertex_data_bytes += 3 * sizeof(InputFloat);
-    if (has_vertex_texcoords())
+
+    if (slices(m_vertex_texcoords_packed_buf) != 0)
+        vertex_data_bytes += sizeof(ScalarIndex);
+    else if (has_vertex_texcoords())
         vertex_data_bytes += 2 * sizeof(InputFloat);
 
     for (const auto&[name, attribute]: m_mesh_attributes)
@@ -838,9 +1099,13 @@ MTS_VARIANT void Mesh<Float, Spectrum>::traverse(TraversalCallback *callback) {
     callback->put_parameter("vertex_count",         m_vertex_count);
     callback->put_parameter("face_count",           m_face_count);
     callback->put_parameter("faces_buf",            m_faces_buf);
-    callback->put_parameter("vertex_positions_buf", m_vertex_positions_buf);
-    callback->put_parameter("vertex_normals_buf",   m_vertex_normals_buf);
-    callback->put_parameter("vertex_texcoords_buf", m_vertex_texcoords_buf);
+
+    // Quantized vertex data is read-only
+    if (!m_compact_storage) {
+        callback->put_parameter("vertex_positions_buf", m_vertex_positions_buf);
+        callback->put_parameter("vertex_normals_buf",   m_vertex_normals_buf);
+        callback->put_parameter("vertex_texcoords_buf", m_vertex_texcoords_buf);
+    }
 
     for(auto &[name, attribute]: m_mesh_attributes)
         callback->put_parameter(tfm::format("%s_buf", name.c_str()), attribute.buf);
@@ -856,7 +1121,7 @@ MTS_VARIANT void Mesh<Float, Spectrum>::parameters_changed(const std::vector<std
 
         recompute_bbox();
 
-        if (has_vertex_normals())
+        if (has_vertex_normals() && !m_compact_storage)
             recompute_vertex_normals();
 
         if (!m_area_pmf.empty())
@@ -1,7 +1,194 @@
 #include <mitsuba/render/microfacet.h>
+#include <future>
+#include <map>
+#include <mutex>
 
 NAMESPACE_BEGIN(mitsuba)
 
 MTS_INSTANTIATE_CLASS(MicrofacetDistribution)
 
+// =======================================================================
+//! @{ \name Process-wide cache of microfacet tables
+// =======================================================================
+
+NAMESPACE_BEGIN(detail)
+
+enum class MicrofacetTableKind : uint32_t {
+    Reflectance, Transmittance, Albedo, AverageAlbedo
+};
+
+template <typename Float> struct MicrofacetTableCache {
+    using Table    = std::vector<Float>;
+    using TablePtr = std::shared_ptr<const Table>;
+    using Key      = std::tuple<MicrofacetTableKind, MicrofacetType, Float, Float, size_t>;
+
+    std::mutex mutex;
+    std::map<Key, std::shared_future<TablePtr>> tables;
+
+    static MicrofacetTableCache &instance() {
+        static MicrofacetTableCache cache;
+        return cache;
+    }
+
+    /**
+     * \brief Look up a table, and build it if it is not cached yet
+     *
+     * The table is built outside of the lock, so that tables with different
+     * parameters can be built concurrently.
+     */
+    template <typename Func>
+    TablePtr get(const Key &key, Func build) {
+        std::promise<TablePtr> promise;
+        std::shared_future<TablePtr> future;
+        bool owner = false;
+
+        /* Critical section */ {
+            std::lock_guard<std::mutex> guard(mutex);
+            auto it = tables.find(key);
+            if (it == tables.end()) {
+                future = promise.get_future().share();
+                tables.emplace(key, future);
+                owner = true;
+            } else {
+                future = it->second;
+            }
+        }
+
+        if (owner) {
+            try {
+                promise.set_value(std::make_shared<const Table>(build()));
+            } catch (...) {
+                /* Critical section */ {
+                    std::lock_guard<std::mutex> guard(mutex);
+                    tables.erase(key);
+                }
+                promise.set_exception(std::current_exception());
+            }
+        }
+
+        return future.get();
+    }
+};
+
+/// Tabulate an integral over the visible normals for regularly spaced incident angles
+template <typename Float, typename Func>
+std::vector<Float> tabulate_microfacet(MicrofacetType type, Float alpha,
+                                       size_t resolution, Func func) {
+    using FloatP    = Packet<Float>;
+    using Vector3fX = Vector<DynamicArray<FloatP>, 3>;
+
+    if (resolution < 2)
+        Throw("Microfacet tables require a resolution of at least 2!");
+
+    mitsuba::MicrofacetDistribution<FloatP, Color<FloatP, 1>> distr(type, alpha);
+    Vector3fX wi = zero<Vector3fX>(resolution);
+    for (size_t i = 0; i < resolution; ++i) {
+        Float mu = std::max((Float) 1e-6f, Float(i) / Float(resolution - 1));
+        slice(wi, i) = Vector<Float, 3>(std::sqrt(1 - mu * mu), 0.f, mu);
+    }
+
+    auto values = func(distr, wi);
+    return std::vector<Float>(values.data(), values.data() + resolution);
+}
+
+NAMESPACE_END(detail)
+
+template <typename Float>
+std::shared_ptr<const std::vector<Float>>
+MicrofacetTables<Float>::reflectance(MicrofacetType type, Float alpha, Float eta,
+                                     size_t resolution) {
+    using Cache = detail::MicrofacetTableCache<Float>;
+    return Cache::instance().get(
+        { detail::MicrofacetTableKind::Reflectance, type, alpha, eta, resolution }, [&]() {
+            return detail::tabulate_microfacet(type, alpha, resolution,
+                [&](const auto &distr, const auto &wi) {
+                    return eval_reflectance(distr, wi, eta);
+                });
+        });
+}
+
+template <typename Float>
+std::shared_ptr<const std::vector<Float>>
+MicrofacetTables<Float>::transmittance(MicrofacetType type, Float alpha, Float eta,
+                                       size_t resolution) {
+    using Cache = detail::MicrofacetTableCache<Float>;
+    return Cache::instance().get(
+        { detail::MicrofacetTableKind::Transmittance, type, alpha, eta, resolution }, [&]() {
+            return detail::tabulate_microfacet(type, alpha, resolution,
+                [&](const auto &distr, const auto &wi) {
+                    return eval_transmittance(distr, wi, eta);
+                });
+        });
+}
+
+template <typename Float>
+std::shared_ptr<const std::vector<Float>>
+MicrofacetTables<Float>::albedo(MicrofacetType type, size_t resolution) {
+    using Cache = detail::MicrofacetTableCache<Float>;
+    return Cache::instance().get(
+        { detail::MicrofacetTableKind::Albedo, type, 0.f, 0.f, resolution }, [&]() {
+            if (resolution < 2)
+                Throw("Microfacet tables require a resolution of at least 2!");
+
+            // Rows are independent, process them in parallel as well
+            std::vector<Float> table(resolution * resolution);
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, resolution, 1),
+                [&](const tbb::blocked_range<size_t> &range) {
+                    for (size_t i = range.begin(); i != range.end(); ++i) {
+                        Float alpha = std::max((Float) 1e-3f, Float(i) / Float(resolution - 1));
+                        std::vector<Float> row = detail::tabulate_microfacet(
+                            type, alpha, resolution, [&](const auto &distr, const auto &wi) {
+                                return eval_albedo(distr, wi);
+                            });
+                        std::copy(row.begin(), row.end(), table.begin() + i * resolution);
+                    }
+                }
+            );
+            return table;
+        });
+}
+
+template <typename Float>
+std::shared_ptr<const std::vector<Float>>
+MicrofacetTables<Float>::average_albedo(MicrofacetType type, size_t resolution) {
+    using Cache = detail::MicrofacetTableCache<Float>;
+    return Cache::instance().get(
+        { detail::MicrofacetTableKind::AverageAlbedo, type, 0.f, 0.f, resolution }, [&]() {
+            std::shared_ptr<const Table> albedo_table = albedo(type, resolution);
+
+            // Integrate 2 * albedo(mu) * mu using the trapezoidal rule
+            std::vector<Float> table(resolution);
+            Float h = Float(1) / Float(resolution - 1);
+            for (size_t i = 0; i < resolution; ++i) {
+                const Float *row = albedo_table->data() + i * resolution;
+                double sum = 0.0;
+                for (size_t j = 0; j < resolution; ++j) {
+                    Float weight = (j == 0 || j == resolution - 1) ? .5f : 1.f;
+                    sum += weight * row[j] * (j * h);
+                }
+                table[i] = Float(2.0 * sum * h);
+            }
+            return table;
+        });
+}
+
+template <typename Float> size_t MicrofacetTables<Float>::size() {
+    auto &cache = detail::MicrofacetTableCache<Float>::instance();
+    std::lock_guard<std::mutex> guard(cache.mutex);
+    return cache.tables.size();
+}
+
+template <typename Float> void MicrofacetTables<Float>::clear() {
+    auto &cache = detail::MicrofacetTableCache<Float>::instance();
+    std::lock_guard<std::mutex> guard(cache.mutex);
+    cache.tables.clear();
+}
+
+template class MTS_EXPORT_RENDER MicrofacetTables<float>;
+template class MTS_EXPORT_RENDER MicrofacetTables<double>;
+
+//! @}
+// =======================================================================
+
 NAMESPACE_END(mitsuba)
@@ -42,8 +42,18 @@ MTS_PY_EXPORT(Medium) {
             .def("get_scattering_coefficients", vectorize(&Medium::get_scattering_coefficients), "mi"_a, "active"_a=true)
             .def("sample_interaction", vectorize(&Medium::sample_interaction), "ray"_a, "sample"_a, "channel"_a, "active"_a=true)
             .def("eval_tr_and_pdf", vectorize(&Medium::eval_tr_and_pdf), "mi"_a, "si"_a, "active"_a=true)
+            .def("eval_tr_weight", vectorize(&Medium::eval_tr_weight),
+                 "mi"_a, "si"_a, "channel"_a, "spectral_mis"_a, "active"_a=true)
+            .def("sample_collision", vectorize(&Medium::sample_collision),
+                 "mi"_a, "sample"_a, "channel"_a, "spectral_mis"_a, "active"_a=true)
+            .def("sample_ratio_tracking", vectorize(&Medium::sample_ratio_tracking),
+                 "ray"_a, "sample"_a, "channel"_a, "active"_a=true)
+            .def("eval_ratio_tracking_weight", vectorize(&Medium::eval_ratio_tracking_weight),
+                 "mi"_a, "maxt"_a, "channel"_a, "spectral_mis"_a, "active"_a=true)
             .def_method(Medium, phase_function)
             .def_method(Medium, use_emitter_sampling)
+            .def_method(Medium, has_majorant_grid)
+            .def_method(Medium, has_control_extinction)
             // .def_method(Medium, is_homogeneous)
             // .def_method(Medium, has_spectral_extinction)
             .def_method(Medium, id)
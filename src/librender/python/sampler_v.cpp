@@ -14,5 +14,9 @@ MTS_PY_EXPORT(Sampler) {
         .def("next_1d", vectorize(&Sampler::next_1d),
              "active"_a = true, D(Sampler, next_1d))
         .def("next_2d", vectorize(&Sampler::next_2d),
-             "active"_a = true, D(Sampler, next_2d));
+             "active"_a = true, D(Sampler, next_2d))
+        .def("set_pixel", vectorize(&Sampler::set_pixel),
+             "pixel"_a, D(Sampler, set_pixel))
+        .def("set_sample_index", vectorize(&Sampler::set_sample_index),
+             "index"_a, D(Sampler, set_sample_index));
 }
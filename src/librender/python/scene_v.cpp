@@ -60,6 +60,23 @@ MTS_PY_EXPORT(Scene) {
         .def("pdf_emitter_direction",
             vectorize(&Scene::pdf_emitter_direction),
             "ref"_a, "ds"_a, "active"_a = true)
+        .def("sample_emitter",
+            vectorize([](const Scene &scene, const Interaction3f &ref, Float sample,
+                         Mask active) {
+                auto [index, pmf] = scene.sample_emitter(ref, sample, active);
+                return std::make_tuple(index, pmf, sample);
+            }),
+            "ref"_a, "sample"_a, "active"_a = true, D(Scene, sample_emitter))
+        .def("pdf_emitter", vectorize(&Scene::pdf_emitter),
+            "ref"_a, "index"_a, "active"_a = true, D(Scene, pdf_emitter))
+        .def("occlusion_cache_statistics", [](const Scene &scene) {
+                OcclusionCacheStatistics stats = scene.occlusion_cache_statistics();
+                py::dict result;
+                result["hits"] = stats.hits;
+                result["misses"] = stats.misses;
+                return result;
+            }, D(Scene, occlusion_cache_statistics))
+        .def_method(Scene, reset_occlusion_cache_statistics)
         // Accessors
         .def_method(Scene, bbox)
         .def("sensors", py::overload_cast<>(&Scene::sensors), D(Scene, sensors))
@@ -63,6 +63,7 @@ MTS_PY_EXPORT(Shape) {
         .def_method(Mesh, face_count)
         .def_method(Mesh, has_vertex_normals)
         .def_method(Mesh, has_vertex_texcoords)
+        .def_method(Mesh, has_compact_storage)
         .def_method(Mesh, recompute_vertex_normals)
         .def_method(Mesh, recompute_bbox)
         .def("write_ply", &Mesh::write_ply, "filename"_a,
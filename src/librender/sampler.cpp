@@ -42,6 +42,10 @@ Sampler<Float, Spectrum>::next_2d(Mask) {
     NotImplementedError("next_2d");
 }
 
+MTS_VARIANT void Sampler<Float, Spectrum>::set_pixel(const Point2u &) { }
+
+MTS_VARIANT void Sampler<Float, Spectrum>::set_sample_index(const UInt32 &) { }
+
 MTS_VARIANT void
 Sampler<Float, Spectrum>::set_samples_per_wavefront(uint32_t samples_per_wavefront) {
     if constexpr (is_scalar_v<Float>)
@@ -1,7 +1,9 @@
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/plugin.h>
+#include <mitsuba/core/random.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/medium.h>
+#include <mitsuba/render/mesh.h>
 #include <mitsuba/render/scene.h>
 #include <mitsuba/render/kdtree.h>
 #include <mitsuba/render/integrator.h>
@@ -19,6 +21,9 @@
 
 NAMESPACE_BEGIN(mitsuba)
 
+/// Source of the identifiers of scenes in the thread-local occlusion caches
+static std::atomic<uint64_t> occlusion_cache_counter { 0 };
+
 MTS_VARIANT Scene<Float, Spectrum>::Scene(const Properties &props) {
     for (auto &kv : props.objects()) {
         m_children.push_back(kv.second.get());
@@ -100,6 +105,17 @@ MTS_VARIANT Scene<Float, Spectrum>::Scene(const Properties &props) {
     for (Emitter *emitter: m_emitters)
         emitter->set_scene(this);
 
+    emitter_selection_init(props);
+
+    /* Remember the primitives blocking shadow rays towards emitters. This is
+       currently supported by the scalar variants using the builtin kd-tree. */
+    m_occlusion_cache = props.bool_("occlusion_cache", true);
+    m_occlusion_cache_id = occlusion_cache_counter++;
+    m_occlusion_cell_size =
+        std::max(hmax(m_bbox.extents()) / 64.f, math::Epsilon<ScalarFloat>);
+    if (!m_bbox.valid())
+        m_occlusion_cache = false;
+
     m_shapes_grad_enabled = false;
 }
 
@@ -173,19 +189,14 @@ Scene<Float, Spectrum>::sample_emitter_direction(const Interaction3f &ref, const
     Spectrum spec;
 
     if (likely(!m_emitters.empty())) {
+        UInt32 index = 0;
         if (m_emitters.size() == 1) {
             // Fast path if there is only one emitter
             std::tie(ds, spec) = m_emitters[0]->sample_direction(ref, sample, active);
         } else {
-            ScalarFloat emitter_pdf = 1.f / m_emitters.size();
-
-            // Randomly pick an emitter
-            UInt32 index =
-                min(UInt32(sample.x() * (ScalarFloat) m_emitters.size()),
-                    (uint32_t) m_emitters.size() - 1);
-
-            // Rescale sample.x() to lie in [0,1) again
-            sample.x() = (sample.x() - index*emitter_pdf) * m_emitters.size();
+            // Select an emitter, sample.x() is rescaled to lie in [0,1) again
+            Float emitter_pdf;
+            std::tie(index, emitter_pdf) = sample_emitter(ref, sample.x(), active);
 
             EmitterPtr emitter = gather<EmitterPtr>(m_emitters.data(), index, active);
 
@@ -194,7 +205,7 @@ Scene<Float, Spectrum>::sample_emitter_direction(const Interaction3f &ref, const
 
             // Account for the discrete probability of sampling this emitter
             ds.pdf *= emitter_pdf;
-            spec *= rcp(emitter_pdf);
+            spec *= select(emitter_pdf > 0.f, rcp(emitter_pdf), 0.f);
         }
 
         active &= neq(ds.pdf, 0.f);
@@ -203,7 +214,7 @@ Scene<Float, Spectrum>::sample_emitter_direction(const Interaction3f &ref, const
         if (test_visibility && any_or<true>(active)) {
             Ray3f ray(ref.p, ds.d, math::RayEpsilon<Float> * (1.f + hmax(abs(ref.p))),
                       ds.dist * (1.f - math::ShadowEpsilon<Float>), ref.time, ref.wavelengths);
-            spec[ray_test(ray, active)] = 0.f;
+            spec[ray_test_emitter(ray, ref, index, active)] = 0.f;
         }
     } else {
         ds = zero<DirectionSample3f>();
@@ -213,6 +224,32 @@ Scene<Float, Spectrum>::sample_emitter_direction(const Interaction3f &ref, const
     return { ds, spec };
 }
 
+MTS_VARIANT typename Scene<Float, Spectrum>::Mask
+Scene<Float, Spectrum>::ray_test_emitter(const Ray3f &ray, const Interaction3f &ref,
+                                         UInt32 index, Mask active) const {
+#if !defined(MTS_ENABLE_EMBREE)
+    if constexpr (!is_cuda_array_v<Float>) {
+        if (m_occlusion_cache)
+            return ray_test_cached_cpu(ray, ref.p, index, active);
+    }
+#endif
+    ENOKI_MARK_USED(ref);
+    ENOKI_MARK_USED(index);
+    return ray_test(ray, active);
+}
+
+MTS_VARIANT OcclusionCacheStatistics Scene<Float, Spectrum>::occlusion_cache_statistics() const {
+    OcclusionCacheStatistics stats;
+    stats.hits   = m_occlusion_hits;
+    stats.misses = m_occlusion_misses;
+    return stats;
+}
+
+MTS_VARIANT void Scene<Float, Spectrum>::reset_occlusion_cache_statistics() {
+    m_occlusion_hits   = 0;
+    m_occlusion_misses = 0;
+}
+
 MTS_VARIANT Float
 Scene<Float, Spectrum>::pdf_emitter_direction(const Interaction3f &ref,
                                               const DirectionSample3f &ds,
@@ -225,11 +262,306 @@ Scene<Float, Spectrum>::pdf_emitter_direction(const Interaction3f &ref,
         // Fast path if there is only one emitter
         return m_emitters[0]->pdf_direction(ref, ds, active);
     } else {
-        return reinterpret_array<EmitterPtr>(ds.object)->pdf_direction(ref, ds, active) *
-            (1.f / m_emitters.size());
+        EmitterPtr emitter = reinterpret_array<EmitterPtr>(ds.object);
+        return emitter->pdf_direction(ref, ds, active) *
+               pdf_emitter(ref, emitter->scene_index(), active);
+    }
+}
+
+MTS_VARIANT std::pair<typename Scene<Float, Spectrum>::UInt32, Float>
+Scene<Float, Spectrum>::sample_emitter(const Interaction3f &ref, Float &sample,
+                                       Mask active) const {
+    MTS_MASK_ARGUMENT(active);
+    uint32_t emitter_count = (uint32_t) m_emitters.size();
+
+    if (unlikely(emitter_count == 0))
+        return { UInt32(0), Float(0.f) };
+
+    if constexpr (!is_cuda_array_v<Float>) {
+        if (m_emitter_selection == EmitterSelection::Power) {
+            auto [index, sample_new, pmf] = m_emitter_distr.sample_reuse_pmf(sample, active);
+            sample = sample_new;
+            return { index, pmf };
+        } else if (m_emitter_selection == EmitterSelection::LightTree) {
+            UInt32 index = 0;
+            Float pmf = 0.f;
+
+            // Emitters at infinity are selected uniformly, all others using the tree
+            Mask pick_infinite = active && sample < m_infinite_prob;
+            if (m_infinite_prob > 0.f && any_or<true>(pick_infinite)) {
+                uint32_t infinite_count = (uint32_t) m_infinite_emitters.size();
+                Float sample_inf = sample / m_infinite_prob * (ScalarFloat) infinite_count;
+                UInt32 slot = min(UInt32(sample_inf), infinite_count - 1);
+
+                masked(index, pick_infinite) =
+                    gather<UInt32>(m_infinite_emitters, slot, pick_infinite);
+                masked(pmf, pick_infinite) = m_infinite_prob / (ScalarFloat) infinite_count;
+                masked(sample, pick_infinite) = sample_inf - Float(slot);
+            }
+
+            Mask pick_tree = active && !pick_infinite;
+            if (m_infinite_prob < 1.f && any_or<true>(pick_tree)) {
+                Float sample_tree = (sample - m_infinite_prob) / (1.f - m_infinite_prob);
+                auto [index_tree, pmf_tree] = m_light_tree.sample(ref.p, sample_tree, pick_tree);
+
+                masked(index, pick_tree) = index_tree;
+                masked(pmf, pick_tree) = pmf_tree * (1.f - m_infinite_prob);
+                masked(sample, pick_tree) = sample_tree;
+            }
+
+            return { index, pmf };
+        }
+    }
+
+    ScalarFloat emitter_pdf = 1.f / emitter_count;
+
+    // Randomly pick an emitter
+    UInt32 index = min(UInt32(sample * (ScalarFloat) emitter_count), emitter_count - 1);
+
+    // Rescale sample to lie in [0,1) again
+    sample = (sample - index * emitter_pdf) * (ScalarFloat) emitter_count;
+
+    return { index, Float(emitter_pdf) };
+}
+
+MTS_VARIANT Float Scene<Float, Spectrum>::pdf_emitter(const Interaction3f &ref, UInt32 index,
+                                                      Mask active) const {
+    MTS_MASK_ARGUMENT(active);
+    using EmitterPtr = replace_scalar_t<Float, const Emitter *>;
+
+    if (unlikely(m_emitters.empty()))
+        return 0.f;
+
+    if constexpr (!is_cuda_array_v<Float>) {
+        if (m_emitter_selection == EmitterSelection::Power) {
+            return m_emitter_distr.eval_pmf_normalized(index, active);
+        } else if (m_emitter_selection == EmitterSelection::LightTree) {
+            EmitterPtr emitter = gather<EmitterPtr>(m_emitters.data(), index, active);
+            Mask infinite = has_flag(emitter->flags(), EmitterFlags::Infinite);
+
+            Float pmf = 0.f;
+            if (!m_infinite_emitters.empty())
+                masked(pmf, infinite) = m_infinite_prob / (ScalarFloat) m_infinite_emitters.size();
+            if (!m_light_tree.empty())
+                masked(pmf, !infinite) = (1.f - m_infinite_prob) *
+                    m_light_tree.pmf(ref.p, index, active && !infinite);
+            return select(active, pmf, 0.f);
+        }
+    }
+
+    ENOKI_MARK_USED(ref);
+    ENOKI_MARK_USED(index);
+    return select(active, 1.f / (ScalarFloat) m_emitters.size(), 0.f);
+}
+
+MTS_VARIANT void Scene<Float, Spectrum>::emitter_selection_init(const Properties &props) {
+    std::string selection = props.string("emitter_selection", "power");
+    if (selection == "uniform")
+        m_emitter_selection = EmitterSelection::Uniform;
+    else if (selection == "power")
+        m_emitter_selection = EmitterSelection::Power;
+    else if (selection == "tree")
+        m_emitter_selection = EmitterSelection::LightTree;
+    else
+        Throw("Invalid emitter selection strategy \"%s\", must be one of: \"uniform\", "
+              "\"power\", or \"tree\"!", selection);
+
+    size_t emitter_count = m_emitters.size();
+    for (size_t i = 0; i < emitter_count; ++i)
+        m_emitters[i]->set_scene_index((uint32_t) i);
+
+    if constexpr (is_cuda_array_v<Float>) {
+        if (props.has_property("emitter_selection") &&
+            m_emitter_selection != EmitterSelection::Uniform)
+            Log(Warn, "Emitter selection strategy \"%s\" is not supported on the GPU, "
+                      "selecting emitters uniformly.", selection);
+        m_emitter_selection = EmitterSelection::Uniform;
+    }
+
+    if (emitter_count < 2 || m_emitter_selection == EmitterSelection::Uniform) {
+        m_emitter_selection = EmitterSelection::Uniform;
+        return;
+    }
+
+    /* Estimate the power of all emitters. Emitters that don't support this
+       (e.g. environment maps) are assigned the mean power of the others, and
+       the selection probability of every emitter is clamped from below so
+       that the estimator remains unbiased when the estimate is poor. */
+    std::vector<ScalarFloat> power(emitter_count);
+    double power_sum = 0.0;
+    size_t power_count = 0;
+    for (size_t i = 0; i < emitter_count; ++i) {
+        power[i] = emitter_power(m_emitters[i].get());
+        if (power[i] >= 0.f) {
+            power_sum += power[i];
+            power_count++;
+        }
+    }
+
+    ScalarFloat power_mean = power_count > 0 ? ScalarFloat(power_sum / power_count) : 0.f;
+    if (!(power_mean > 0.f))
+        power_mean = 1.f;
+    for (size_t i = 0; i < emitter_count; ++i) {
+        if (power[i] < 0.f)
+            power[i] = power_mean;
+        power[i] = std::max(power[i], 1e-2f * power_mean);
+    }
+
+    if (m_emitter_selection == EmitterSelection::Power) {
+        m_emitter_distr = DiscreteDistribution<Float>(power.data(), emitter_count);
+        Log(Debug, "Selecting %i emitters proportional to their power.", emitter_count);
+        return;
+    }
+
+    std::vector<typename LightTree<Float>::Bounds> bounds;
+    std::vector<uint32_t> tree_indices, infinite_indices;
+    for (size_t i = 0; i < emitter_count; ++i) {
+        const Emitter *emitter = m_emitters[i].get();
+        if (has_flag(emitter->flags(), EmitterFlags::Infinite)) {
+            infinite_indices.push_back((uint32_t) i);
+        } else {
+            tree_indices.push_back((uint32_t) i);
+            bounds.push_back(emitter_bounds(emitter, power[i]));
+        }
+    }
+
+    m_light_tree = LightTree<Float>(bounds, tree_indices, emitter_count);
+    m_infinite_emitters =
+        DynamicBuffer<UInt32>::copy(infinite_indices.data(), infinite_indices.size());
+
+    /* An emitter at infinity is as likely to be chosen as the tree (which
+       must then choose among the remaining emitters) */
+    if (infinite_indices.empty())
+        m_infinite_prob = 0.f;
+    else if (tree_indices.empty())
+        m_infinite_prob = 1.f;
+    else
+        m_infinite_prob = infinite_indices.size() / (infinite_indices.size() + 1.f);
+
+    Log(Debug, "Built a light tree with %i nodes over %i emitters (%i emitters at infinity).",
+        m_light_tree.node_count(), tree_indices.size(), infinite_indices.size());
+}
+
+MTS_VARIANT typename Scene<Float, Spectrum>::ScalarFloat
+Scene<Float, Spectrum>::emitter_power(const Emitter *emitter) const {
+    if constexpr (is_dynamic_array_v<Float>) {
+        ENOKI_MARK_USED(emitter);
+        return -1.f;
+    } else {
+        /* The expected weight of a ray sampled from an emitter equals its
+           power. Average the weights of a fixed number of rays, using a fixed
+           seed so that the estimate (and thus rendering) is deterministic. */
+        constexpr size_t SampleCount = 1024,
+                         Width = array_size_v<Float>;
+
+        PCG32<UInt32> rng;
+        rng.seed(PCG32_DEFAULT_STATE, PCG32_DEFAULT_STREAM + arange<UInt64>());
+        auto next = [&]() { return rng.template next_float<Float>(Mask(true)); };
+
+        double sum = 0.0;
+        try {
+            for (size_t i = 0; i < SampleCount; i += Width) {
+                Float wavelength_sample = next();
+                Point2f sample2(next(), next()), sample3(next(), next());
+
+                Spectrum weight =
+                    emitter->sample_ray(0.f, wavelength_sample, sample2, sample3, true).second;
+
+                Float value = hsum(depolarize(weight)) /
+                              (ScalarFloat) array_size_v<UnpolarizedSpectrum>;
+                sum += (double) hsum(select(enoki::isfinite(value), value, 0.f));
+            }
+        } catch (const std::exception &) {
+            // Emitter doesn't support ray sampling, power is unknown
+            return -1.f;
+        }
+
+        return ScalarFloat(sum / SampleCount);
     }
 }
 
+MTS_VARIANT typename LightTree<Float>::Bounds
+Scene<Float, Spectrum>::emitter_bounds(const Emitter *emitter, ScalarFloat power) const {
+    using Mesh = mitsuba::Mesh<Float, Spectrum>;
+
+    typename LightTree<Float>::Bounds bounds;
+    bounds.bbox = emitter->bbox();
+    bounds.power = power;
+
+    const Shape *shape = emitter->shape();
+    if (!shape)
+        return bounds; // Emission into all directions (e.g. point lights)
+
+    // Area lights emit into the hemisphere around the surface normal
+    bounds.cos_theta_e = 0.f;
+
+    std::vector<ScalarVector3f> normals;
+    bool planar = false;
+    if (shape->is_mesh()) {
+        const Mesh *mesh = static_cast<const Mesh *>(shape);
+        if (mesh->has_vertex_normals()) {
+            for (uint32_t i = 0; i < mesh->vertex_count(); ++i)
+                normals.push_back(normalize(ScalarVector3f(mesh->vertex_normal(i))));
+        } else {
+            for (uint32_t i = 0; i < mesh->face_count(); ++i) {
+                auto fi = mesh->face_indices(i);
+                ScalarPoint3f p0 = mesh->vertex_position(fi[0]),
+                              p1 = mesh->vertex_position(fi[1]),
+                              p2 = mesh->vertex_position(fi[2]);
+                ScalarVector3f n = cross(p1 - p0, p2 - p0);
+                if (squared_norm(n) > 0.f)
+                    normals.push_back(normalize(n));
+            }
+        }
+    } else {
+        /* Other shapes are either planar (e.g. rectangles and disks), or
+           emit into all directions. Detect the former by sampling normals. */
+        constexpr size_t Resolution = 8;
+        planar = true;
+        ScalarVector3f n0;
+        for (size_t i = 0; i < Resolution * Resolution && planar; ++i) {
+            Point2f sample((i % Resolution + .5f) / Resolution,
+                           (i / Resolution + .5f) / Resolution);
+            Normal3f n_ = shape->sample_position(0.f, sample).n;
+
+            ScalarVector3f n;
+            if constexpr (is_array_v<Float>)
+                n = normalize(ScalarVector3f(slice(n_, 0)));
+            else
+                n = normalize(ScalarVector3f(n_));
+
+            if (i == 0)
+                n0 = n;
+            planar = dot(n, n0) > 1.f - 1e-4f;
+        }
+        if (planar)
+            normals.push_back(n0);
+    }
+
+    if (normals.empty())
+        return bounds;
+
+    ScalarVector3f axis = 0.f;
+    for (const auto &n : normals)
+        axis += n;
+    if (squared_norm(axis) == 0.f)
+        return bounds;
+    axis = normalize(axis);
+
+    ScalarFloat cos_theta_o = 1.f;
+    for (const auto &n : normals)
+        cos_theta_o = std::min(cos_theta_o, dot(axis, n));
+
+    /* Interpolated normals only stay within the cone if it is convex,
+       otherwise fall back to the full sphere */
+    if (cos_theta_o <= 0.f)
+        return bounds;
+
+    bounds.axis = axis;
+    bounds.cos_theta_o = planar ? 1.f : std::max(cos_theta_o - 1e-4f, ScalarFloat(0));
+    return bounds;
+}
+
 MTS_VARIANT void Scene<Float, Spectrum>::traverse(TraversalCallback *callback) {
     for (auto& child : m_children) {
         std::string id = child->id();
@@ -1,5 +1,25 @@
 NAMESPACE_BEGIN(mitsuba)
 
+/// Number of entries of the thread-local occlusion caches (must be a power of two)
+static constexpr uint32_t occlusion_cache_size = 1024;
+
+/// Number of queries after which a thread reports its occlusion cache statistics
+static constexpr uint64_t occlusion_cache_flush_interval = 256;
+
+/// Direct-mapped cache of the primitives that recently blocked shadow rays, one per thread
+struct OcclusionCacheLocal {
+    struct Entry {
+        uint64_t key = (uint64_t) -1;
+        uint32_t prim_index = 0;
+    };
+
+    Entry entries[occlusion_cache_size];
+    uint64_t scene_id = (uint64_t) -1;
+    uint64_t pending_hits = 0, pending_misses = 0;
+};
+
+static thread_local OcclusionCacheLocal occlusion_cache_local;
+
 MTS_VARIANT void Scene<Float, Spectrum>::accel_init_cpu(const Properties &props) {
     ShapeKDTree *kdtree = new ShapeKDTree(props);
     kdtree->inc_ref();
@@ -66,4 +86,61 @@ Scene<Float, Spectrum>::ray_test_cpu(const Ray3f &ray, Mask active) const {
     return kdtree->template ray_intersect_preliminary<true>(ray, active).is_valid();
 }
 
+MTS_VARIANT typename Scene<Float, Spectrum>::Mask
+Scene<Float, Spectrum>::ray_test_cached_cpu(const Ray3f &ray, const Point3f &p,
+                                            UInt32 index, Mask active) const {
+    const ShapeKDTree *kdtree = (ShapeKDTree *) m_accel;
+
+    if constexpr (is_array_v<Float>) {
+        // Packets of shadow rays are traced jointly through the tree instead
+        ENOKI_MARK_USED(p);
+        ENOKI_MARK_USED(index);
+        return kdtree->template ray_intersect_preliminary<true>(ray, active).is_valid();
+    } else {
+        if (!active)
+            return false;
+
+        OcclusionCacheLocal &local = occlusion_cache_local;
+        if (unlikely(local.scene_id != m_occlusion_cache_id)) {
+            for (auto &entry : local.entries)
+                entry.key = (uint64_t) -1;
+            local.scene_id = m_occlusion_cache_id;
+            local.pending_hits = local.pending_misses = 0;
+        }
+
+        /* Shading points within the same grid cell share the cache entry
+           of an emitter (10 bits per dimension) */
+        ScalarVector3u cell = ScalarVector3u(
+            clamp((p - m_bbox.min) / m_occlusion_cell_size, 0.f, 1023.f));
+        uint64_t key = ((uint64_t) index << 32) | ((uint64_t) cell.x() << 20) |
+                       ((uint64_t) cell.y() << 10) | (uint64_t) cell.z();
+
+        auto &entry = local.entries[(key * 0x9E3779B97F4A7C15ull) >> 54];
+        static_assert(occlusion_cache_size == 1u << (64 - 54));
+
+        bool hit = false;
+        if (entry.key == key && kdtree->ray_test_primitive(entry.prim_index, ray, true)) {
+            hit = true;
+            local.pending_hits++;
+        } else {
+            PreliminaryIntersection3f pi =
+                kdtree->template ray_intersect_preliminary<true>(ray, true);
+            hit = pi.is_valid();
+            if (hit) {
+                entry.key = key;
+                entry.prim_index = pi.prim_index;
+            }
+            local.pending_misses++;
+        }
+
+        if (unlikely(local.pending_hits + local.pending_misses >= occlusion_cache_flush_interval)) {
+            m_occlusion_hits += local.pending_hits;
+            m_occlusion_misses += local.pending_misses;
+            local.pending_hits = local.pending_misses = 0;
+        }
+
+        return hit;
+    }
+}
+
 NAMESPACE_END(mitsuba)
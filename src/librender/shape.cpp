@@ -79,6 +79,9 @@ MTS_VARIANT Shape<Float, Spectrum>::Shape(const Properties &props) : m_id(props.
             props2.set_float("reflectance", 0.f);
         m_bsdf = PluginManager::instance()->create_object<BSDF>(props2);
     }
+
+    // Request texture-space differentials for filtered texture lookups
+    m_bsdf->update_differentials_flag();
 }
 
 MTS_VARIANT Shape<Float, Spectrum>::~Shape() {
@@ -1,3 +1,4 @@
+import time
 import mitsuba
 import pytest
 import enoki as ek
@@ -130,3 +131,45 @@ def test06_phase_tir(variant_scalar_rgb):
     phi_delta = 4*ek.atan(eta)
     a_s, a_p, _, _, _ = fresnel_polarized(cos_theta_min, eta)
     assert ek.allclose(ek.arg(a_s) - ek.arg(a_p), phi_delta)
+
+
+@pytest.mark.slow
+def test07_benchmark_fresnel_table(variant_packet_spectral):
+    import numpy as np
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import BSDFContext, SurfaceInteraction3f
+
+    def normalize(v):
+        return v / np.linalg.norm(v, axis=1)[:, None]
+
+    n = 1000000
+    si = SurfaceInteraction3f.zero(n)
+    si.wi = normalize(np.random.normal(size=(n, 3)) + [0, 0, 2])
+    si.wavelengths = np.random.uniform(360, 830, size=(n, 4))
+    wo = normalize(np.random.normal(size=(n, 3)))
+    sample = np.random.uniform(size=(n, 2))
+    ctx = BSDFContext()
+
+    plugins = {
+        'roughconductor': '<string name="material" value="Au"/>',
+        'roughdielectric': '<float name="int_ior" value="1.5"/>'
+    }
+
+    for name, params in plugins.items():
+        timings = []
+        for fresnel_table in ['false', 'true']:
+            bsdf = load_string("""<bsdf version="2.0.0" type="{}">
+                    <float name="alpha" value="0.3"/>
+                    <boolean name="fresnel_table" value="{}"/>
+                    {}
+                </bsdf>""".format(name, fresnel_table, params))
+            bsdf.eval(ctx, si, wo)
+            start = time.time()
+            for i in range(10):
+                bsdf.sample(ctx, si, sample[:, 0], sample)
+                bsdf.eval(ctx, si, wo)
+            timings.append((time.time() - start) / 10)
+
+        print('\n%s.sample() + eval() with %i lanes: %.2f ms (exact), %.2f ms (table), '
+              'speedup: %.2fx' % (name, n, timings[0] * 1000, timings[1] * 1000,
+                                  timings[0] / timings[1]))
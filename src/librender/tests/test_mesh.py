@@ -648,3 +648,193 @@ def test16_differentiable_surface_interaction_params_backward(variant_gpu_autodi
     assert ek.allclose(ek.gradient(params[vertex_texcoords_key]),
                        [0, 2, 0, 0, 0, 0, 0, -2], atol=1e-5)
 
+
+
+@fresolver_append_path
+def test17_compact_storage(variant_scalar_rgb):
+    from mitsuba.core import xml, Ray3f, Vector3f
+
+    def load(compact):
+        return xml.load_string('''
+            <scene version="2.0.0">
+                <shape type="ply">
+                    <string name="filename" value="resources/data/tests/ply/rectangle_normals_uv.ply"/>
+                    <boolean name="compact" value="{0}"/>
+                </shape>
+            </scene>
+        '''.format(str(compact).lower()))
+
+    scene_ref, scene_compact = load(False), load(True)
+    mesh = scene_compact.shapes()[0]
+
+    assert mesh.has_compact_storage()
+    assert mesh.has_vertex_normals() and mesh.has_vertex_texcoords()
+    assert ek.allclose(mesh.bbox().min, scene_ref.shapes()[0].bbox().min, atol=1e-4)
+    assert ek.allclose(mesh.bbox().max, scene_ref.shapes()[0].bbox().max, atol=1e-4)
+    assert ek.allclose(mesh.surface_area(), scene_ref.shapes()[0].surface_area(), rtol=1e-4)
+
+    for x, z in [(0.1, -3.0), (-2.0, -7.0), (2.5, 0.2)]:
+        ray = Ray3f(Vector3f(x, 1.0, z), Vector3f(0.0, -1.0, 0.0), 0, [])
+        si_ref, si = scene_ref.ray_intersect(ray), scene_compact.ray_intersect(ray)
+        assert si.is_valid()
+        assert ek.allclose(si.p, si_ref.p, atol=1e-4)
+        assert ek.allclose(si.uv, si_ref.uv, atol=1e-4)
+        assert ek.allclose(si.sh_frame.n, si_ref.sh_frame.n, atol=1e-4)
+
+
+@fresolver_append_path
+@pytest.mark.parametrize('compress', [True, False])
+def test18_serialized_v5(variant_scalar_rgb, tmpdir, compress):
+    from mitsuba.core import Thread
+    from mitsuba.core.xml import load_string
+    from mitsuba.python import serialized
+
+    fs = Thread.thread().file_resolver()
+    src = str(fs.resolve('resources/data/tests/serialized/rectangle_normals_uv.serialized'))
+    dst = str(tmpdir.join('rectangle_v5.serialized'))
+
+    # Use a tiny chunk size so that every array consists of several chunks
+    serialized.convert(src, dst, compress=compress, chunk_size=64)
+
+    def load(filename, mmap=False):
+        return load_string("""
+            <shape type="serialized" version="2.0.0">
+                <string name="filename" value="{0}"/>
+                <boolean name="mmap" value="{1}"/>
+            </shape>
+        """.format(filename, str(mmap).lower()))
+
+    ref = load(src)
+    for shape in [load(dst), load(dst, mmap=not compress)]:
+        assert shape.vertex_count() == ref.vertex_count()
+        assert shape.face_count() == ref.face_count()
+        assert ek.allclose(shape.vertex_positions_buffer(), ref.vertex_positions_buffer())
+        assert ek.allclose(shape.vertex_normals_buffer(), ref.vertex_normals_buffer())
+        assert ek.allclose(shape.vertex_texcoords_buffer(), ref.vertex_texcoords_buffer())
+        assert ek.allclose(shape.faces_buffer(), ref.faces_buffer())
+        assert ek.allclose(shape.bbox().min, ref.bbox().min)
+        assert ek.allclose(shape.bbox().max, ref.bbox().max)
+
+
+def test19_large_mesh_parallel_build(variant_scalar_rgb):
+    """Normals, bounding box, and area distribution of a mesh that is large
+    enough to be processed by several tasks"""
+    from mitsuba.core import Properties
+    from mitsuba.render import Mesh
+    import numpy as np
+
+    n = 300
+    x, y = np.meshgrid(np.linspace(0, 1, n + 1), np.linspace(0, 2, n + 1))
+    z = 0.1 * np.sin(x * 7) * np.cos(y * 3)
+    positions = np.stack([x, y, z], axis=-1).astype(np.float32).ravel()
+
+    i, j = np.meshgrid(np.arange(n), np.arange(n))
+    v0 = (j * (n + 1) + i).ravel()
+    v1, v2, v3 = v0 + 1, v0 + n + 1, v0 + n + 2
+    faces = np.stack([np.stack([v0, v1, v3], -1),
+                      np.stack([v0, v3, v2], -1)], 1).astype(np.uint32).ravel()
+
+    m = Mesh("grid", (n + 1) ** 2, 2 * n * n, Properties(), True)
+    m.vertex_positions_buffer()[:] = positions
+    m.faces_buffer()[:] = faces
+    m.parameters_changed()
+
+    assert ek.allclose(m.bbox().min, [0, 0, positions[2::3].min()])
+    assert ek.allclose(m.bbox().max, [1, 2, positions[2::3].max()])
+
+    p = positions.reshape(-1, 3)
+    f = faces.reshape(-1, 3)
+    area = 0.5 * np.linalg.norm(np.cross(p[f[:, 1]] - p[f[:, 0]],
+                                         p[f[:, 2]] - p[f[:, 0]]), axis=1)
+    assert ek.allclose(m.surface_area(), area.sum(), rtol=1e-5)
+
+    normals = np.array(m.vertex_normals_buffer()).reshape(-1, 3)
+    assert np.allclose(np.linalg.norm(normals, axis=1), 1, atol=1e-5)
+    assert np.all(normals[:, 2] > 0.5)
+
+
+@fresolver_append_path
+def test20_serialized_v5_mmap_update(variant_scalar_rgb, tmpdir):
+    """Modifying a memory-mapped mesh must leave the underlying file untouched"""
+    from mitsuba.core import Thread
+    from mitsuba.core.xml import load_string
+    from mitsuba.python import serialized
+    import numpy as np
+
+    fs = Thread.thread().file_resolver()
+    src = str(fs.resolve('resources/data/tests/serialized/rectangle_normals_uv.serialized'))
+    dst = str(tmpdir.join('rectangle_v5.serialized'))
+    serialized.convert(src, dst, compress=False)
+
+    def load():
+        return load_string("""
+            <shape type="serialized" version="2.0.0">
+                <string name="filename" value="{0}"/>
+                <boolean name="mmap" value="true"/>
+            </shape>
+        """.format(dst))
+
+    shape = load()
+    positions = np.array(shape.vertex_positions_buffer())
+    faces = np.array(shape.faces_buffer())
+
+    params = traverse(shape)
+    key = 'vertex_positions_buf'
+    # Swap the x and z coordinates, which also changes the vertex normals
+    params[key][:] = positions.reshape(-1, 3)[:, [2, 1, 0]].ravel()
+    params.set_dirty(key)
+    params.update()
+
+    p = positions.reshape(-1, 3)[:, [2, 1, 0]]
+    assert ek.allclose(shape.vertex_positions_buffer(), p.ravel())
+    assert ek.allclose(shape.faces_buffer(), faces)
+    assert ek.allclose(shape.bbox().min, p.min(axis=0))
+    assert ek.allclose(shape.bbox().max, p.max(axis=0))
+
+    normals = np.array(shape.vertex_normals_buffer()).reshape(-1, 3)
+    assert np.allclose(np.abs(normals[:, 0]), 1, atol=1e-5)
+
+    # The file (and other meshes mapping it) must be unaffected
+    ref = load()
+    assert ek.allclose(ref.vertex_positions_buffer(), positions)
+
+
+def test21_obj_float_parsing(variant_scalar_rgb, tmpdir):
+    """The OBJ loader's fast float parser must round correctly (i.e. only once)"""
+    from mitsuba.core.xml import load_string
+    from fractions import Fraction
+    import numpy as np
+
+    def correctly_rounded(s):
+        x, f = Fraction(s), np.float32(float(s))
+        candidates = [np.nextafter(f, np.float32(-np.inf)), f,
+                      np.nextafter(f, np.float32(np.inf))]
+        # Nearest single precision value, ties to even
+        return min(candidates, key=lambda v: (abs(Fraction(float(v)) - x),
+                                              int(v.view(np.uint32)) & 1))
+
+    values = [
+        '0.1', '-0.3', '1.5e-3', '16777217', '2.85', '-7.600000', '0.599999',
+        '123456.789', '1e10', '1e-10', '2.5e-5', '3.4028235e38', '1.17549435e-38',
+        '1.00000005960464477550', '0.333333333333333333',
+        # Double rounding (via double precision) yields the wrong result
+        '72057624102699e3', '360288120513495e2', '14412383813999e4'
+    ]
+
+    filename = str(tmpdir.join('values.obj'))
+    with open(filename, 'w') as f:
+        for i in range(0, len(values), 3):
+            f.write('v %s %s %s\n' % tuple(values[i:i + 3]))
+        for i in range(0, len(values) // 3, 3):
+            f.write('f %i %i %i\n' % (i + 1, i + 2, i + 3))
+
+    shape = load_string("""
+        <shape type="obj" version="2.0.0">
+            <string name="filename" value="{}"/>
+            <boolean name="face_normals" value="true"/>
+        </shape>
+    """.format(filename))
+
+    positions = np.array(shape.vertex_positions_buffer(), dtype=np.float32)
+    expected = np.array([correctly_rounded(s) for s in values], dtype=np.float32)
+    assert np.array_equal(positions, expected)
@@ -102,3 +102,137 @@ def test03_shapes_parameters_grad_enabled(variant_gpu_autodiff_rgb):
     params.set_dirty(shape_param_key)
     params.update()
     assert scene.shapes_grad_enabled() == True
+
+
+EMITTER_SELECTION_SCENE = """<scene version="2.0.0">
+    <string name="emitter_selection" value="{}"/>
+    <emitter type="point">
+        <point name="position" x="-2" y="0" z="2"/>
+        <spectrum name="intensity" value="1"/>
+    </emitter>
+    <emitter type="point">
+        <point name="position" x="2" y="0" z="2"/>
+        <spectrum name="intensity" value="100"/>
+    </emitter>
+    <shape type="rectangle">
+        <transform name="to_world">
+            <rotate x="1" angle="180"/>
+            <translate z="3"/>
+        </transform>
+        <emitter type="area">
+            <spectrum name="radiance" value="5"/>
+        </emitter>
+    </shape>
+    <emitter type="constant">
+        <spectrum name="radiance" value="0.1"/>
+    </emitter>
+</scene>"""
+
+
+def point_light_indices(scene):
+    """Returns the indices of the dim and of the bright point light"""
+    indices = {}
+    for i, emitter in enumerate(scene.emitters()):
+        bbox = emitter.bbox()
+        if ek.allclose(bbox.min, bbox.max):
+            indices[bbox.min.x > 0] = i
+    return indices[False], indices[True]
+
+
+@pytest.mark.parametrize("selection", ['uniform', 'power', 'tree'])
+def test04_emitter_selection_pdf(variant_scalar_rgb, selection):
+    """Checks that the selection probabilities are consistent with sampling"""
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import SurfaceInteraction3f
+
+    scene = load_string(EMITTER_SELECTION_SCENE.format(selection))
+    assert len(scene.emitters()) == 4
+
+    it = SurfaceInteraction3f()
+    it.p = [0.1, 0.2, 0.3]
+    it.time = 0.0
+
+    assert ek.allclose(sum(scene.pdf_emitter(it, i) for i in range(4)), 1.0)
+
+    for i in range(50):
+        sample = (i + 0.5) / 50
+        index, pmf, sample_new = scene.sample_emitter(it, sample)
+        assert pmf > 0
+        assert 0 <= sample_new < 1
+        assert ek.allclose(pmf, scene.pdf_emitter(it, index))
+
+        ds, _ = scene.sample_emitter_direction(it, [sample, 0.3], False)
+        if not ds.delta:
+            assert ek.allclose(ds.pdf, scene.pdf_emitter_direction(it, ds), rtol=1e-4)
+
+
+def test05_emitter_selection_power(variant_scalar_rgb):
+    """Checks that emitters are selected proportional to their power"""
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import SurfaceInteraction3f
+
+    it = SurfaceInteraction3f()
+    it.p = [0.1, 0.2, 0.3]
+
+    scene = load_string(EMITTER_SELECTION_SCENE.format('uniform'))
+    assert ek.allclose([scene.pdf_emitter(it, i) for i in range(4)], 0.25)
+
+    scene = load_string(EMITTER_SELECTION_SCENE.format('power'))
+    dim, bright = point_light_indices(scene)
+    assert ek.allclose(scene.pdf_emitter(it, bright) / scene.pdf_emitter(it, dim), 100, rtol=1e-3)
+
+    # The light tree additionally accounts for the distance to the emitters
+    scene = load_string(EMITTER_SELECTION_SCENE.format('tree'))
+    dim, bright = point_light_indices(scene)
+    it.p = [1.9, 0.0, 1.9]
+    pmf_near = scene.pdf_emitter(it, bright)
+    it.p = [-1.9, 0.0, 1.9]
+    assert pmf_near > scene.pdf_emitter(it, bright)
+
+
+OCCLUSION_CACHE_SCENE = """<scene version="2.0.0">
+    <boolean name="occlusion_cache" value="{}"/>
+    <shape type="rectangle">
+        <transform name="to_world">
+            <rotate x="1" angle="180"/>
+            <translate z="3"/>
+        </transform>
+        <emitter type="area"/>
+    </shape>
+    <shape type="rectangle">
+        <transform name="to_world">
+            <scale value="2"/>
+            <translate y="{}" z="1"/>
+        </transform>
+    </shape>
+</scene>"""
+
+
+@pytest.mark.parametrize("offset", [0, 1.5])
+def test06_occlusion_cache(variant_scalar_rgb, offset):
+    """Checks that the occlusion cache doesn't change the result of shadow rays"""
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import SurfaceInteraction3f
+
+    if mitsuba.core.MTS_ENABLE_EMBREE:
+        pytest.skip("The occlusion cache requires the builtin kd-tree")
+
+    it = SurfaceInteraction3f()
+    it.p = [0.1, 0.2, 0.0]
+
+    scenes = [load_string(OCCLUSION_CACHE_SCENE.format(cache, offset))
+              for cache in ['true', 'false']]
+
+    for i in range(1024):
+        sample = [(i % 32 + 0.5) / 32, (i // 32 + 0.5) / 32]
+        spec_cached = scenes[0].sample_emitter_direction(it, sample, True)[1]
+        spec_ref = scenes[1].sample_emitter_direction(it, sample, True)[1]
+        assert ek.allclose(spec_cached, spec_ref)
+        if offset == 0:
+            assert ek.allclose(spec_ref, 0)
+
+    stats = scenes[0].occlusion_cache_statistics()
+    if offset == 0:
+        # Every shadow ray after the first one is blocked by the cached primitive
+        assert stats['hits'] > 0.9 * (stats['hits'] + stats['misses'])
+    assert scenes[1].occlusion_cache_statistics()['hits'] == 0
@@ -119,6 +119,12 @@ Volume<Float, Spectrum>::resolution() const {
     return ScalarVector3i(1, 1, 1);
 }
 
+MTS_VARIANT std::vector<typename Volume<Float, Spectrum>::ScalarFloat>
+Volume<Float, Spectrum>::max_per_cell(const ScalarBoundingBox3f & /*bbox*/,
+                                      const ScalarVector3u &resolution) const {
+    return std::vector<ScalarFloat>(hprod(resolution), max());
+}
+
 //! @}
 // =======================================================================
 
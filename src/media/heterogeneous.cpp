@@ -15,7 +15,10 @@ NAMESPACE_BEGIN(mitsuba)
 template <typename Float, typename Spectrum>
 class HeterogeneousMedium final : public Medium<Float, Spectrum> {
 public:
-    MTS_IMPORT_BASE(Medium, m_is_homogeneous, m_has_spectral_extinction)
+    MTS_IMPORT_BASE(Medium, m_is_homogeneous, m_has_spectral_extinction,
+                    m_majorant_resolution, m_control_sigma_t, has_majorant_grid,
+                    has_control_extinction, set_majorant_grid, eval_majorant_grid,
+                    set_control_extinction, eval_control_extinction)
     MTS_IMPORT_TYPES(Scene, Sampler, Texture, Volume)
 
     HeterogeneousMedium(const Properties &props) : Base(props) {
@@ -26,16 +29,31 @@ public:
         m_scale = props.float_("scale", 1.0f);
         m_has_spectral_extinction = props.bool_("has_spectral_extinction", true);
 
-        m_max_density = m_scale * m_sigmat->max();
-        m_aabb        = m_sigmat->bbox();
+        /* Optional homogeneous control component that is added to sigma_t.
+           Ratio tracking then only tracks the residual (decomposition tracking) */
+        if (props.has_property("control_sigma_t"))
+            set_control_extinction(props.volume<Volume>("control_sigma_t"));
+
+        /* Resolution of the coarse grid of local majorants used for
+           free-flight sampling (0: use a single global majorant) */
+        ScalarUInt32 majorant_resolution = props.int_("majorant_resolution", 16);
+        m_majorant_resolution = min(ScalarVector3u(majorant_resolution),
+                                    ScalarVector3u(m_sigmat->resolution()));
+
+        m_aabb = m_sigmat->bbox();
+        update_majorants();
     }
 
     UnpolarizedSpectrum
-    get_combined_extinction(const MediumInteraction3f & /* mi */,
+    get_combined_extinction(const MediumInteraction3f &mi,
                             Mask active) const override {
         // TODO: This could be a spectral quantity (at least in RGB mode)
         MTS_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
-        return m_max_density;
+        UnpolarizedSpectrum majorant =
+            has_majorant_grid() ? eval_majorant_grid(mi.p, active) : Float(m_max_density);
+        if (has_control_extinction())
+            majorant += eval_control_extinction(mi, active);
+        return majorant;
     }
 
     std::tuple<UnpolarizedSpectrum, UnpolarizedSpectrum, UnpolarizedSpectrum>
@@ -43,6 +61,8 @@ public:
                                 Mask active) const override {
         MTS_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
         auto sigmat = m_scale * m_sigmat->eval(mi, active);
+        if (has_control_extinction())
+            sigmat += eval_control_extinction(mi, active);
         auto sigmas = sigmat * m_albedo->eval(mi, active);
         auto sigman = get_combined_extinction(mi, active) - sigmat;
         return { sigmas, sigman, sigmat };
@@ -57,21 +77,45 @@ public:
         callback->put_parameter("scale", m_scale);
         callback->put_object("albedo", m_albedo.get());
         callback->put_object("sigma_t", m_sigmat.get());
+        if (has_control_extinction())
+            callback->put_object("control_sigma_t", m_control_sigma_t.get());
         Base::traverse(callback);
     }
 
+    void parameters_changed(const std::vector<std::string> &/*keys*/) override {
+        if (has_control_extinction())
+            set_control_extinction(m_control_sigma_t.get());
+        update_majorants();
+    }
+
     std::string to_string() const override {
         std::ostringstream oss;
         oss << "HeterogeneousMedium[" << std::endl
             << "  albedo  = " << string::indent(m_albedo) << std::endl
             << "  sigma_t = " << string::indent(m_sigmat) << std::endl
-            << "  scale   = " << string::indent(m_scale) << std::endl
-            << "]";
+            << "  scale   = " << string::indent(m_scale) << std::endl;
+        if (has_control_extinction())
+            oss << "  control_sigma_t = " << string::indent(m_control_sigma_t) << std::endl;
+        oss << "]";
         return oss.str();
     }
 
     MTS_DECLARE_CLASS()
 private:
+    void update_majorants() {
+        m_max_density = m_scale * m_sigmat->max();
+
+        // The grid only pays off if sigma_t is stored at a finer resolution
+        if (hprod(m_majorant_resolution) <= 1)
+            return;
+
+        std::vector<ScalarFloat> values =
+            m_sigmat->max_per_cell(m_aabb, m_majorant_resolution);
+        for (ScalarFloat &v : values)
+            v *= m_scale;
+        set_majorant_grid(m_aabb, m_majorant_resolution, values);
+    }
+
     ref<Volume> m_sigmat, m_albedo;
     ScalarFloat m_scale;
 
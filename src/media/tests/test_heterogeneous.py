@@ -0,0 +1,196 @@
+import numpy as np
+import pytest
+
+import enoki as ek
+import mitsuba
+
+from mitsuba.python.test.util import tmpfile
+
+
+def write_volume(filename, values):
+    """Write a single-channel grid with bounds [0, 1]^3 ('values' is indexed as [z, y, x])"""
+    values = np.array(values, dtype=np.float32)
+    with open(filename, 'wb') as f:
+        f.write(b'VOL')
+        f.write(np.uint8(3).tobytes())   # Version
+        f.write(np.int32(1).tobytes())   # Float32 data
+        f.write(np.array(values.shape[::-1], dtype=np.int32).tobytes())
+        f.write(np.int32(1).tobytes())   # Channel count
+        f.write(np.array([0, 0, 0, 1, 1, 1], dtype=np.float32).tobytes())
+        f.write(values.tobytes())
+
+
+def create_medium(filename, majorant_resolution=16):
+    from mitsuba.core.xml import load_string
+    return load_string("""
+        <medium type="heterogeneous" version="2.0.0">
+            <integer name="majorant_resolution" value="{}"/>
+            <volume type="gridvolume" name="sigma_t">
+                <string name="filename" value="{}"/>
+            </volume>
+        </medium>
+    """.format(majorant_resolution, filename))
+
+
+@pytest.fixture
+def sparse_volume(tmpfile):
+    # Unit density with a single bright voxel in the corner
+    values = np.ones((16, 16, 16))
+    values[0, 0, 0] = 100
+    write_volume(tmpfile, values)
+    return tmpfile
+
+
+def test01_majorant_grid(variant_scalar_rgb, sparse_volume):
+    from mitsuba.render import MediumInteraction3f
+
+    medium = create_medium(sparse_volume)
+    assert medium.has_majorant_grid()
+
+    mi = MediumInteraction3f()
+    mi.p = [0.01, 0.01, 0.01]
+    assert ek.allclose(medium.get_combined_extinction(mi), 100)
+    mi.p = [0.75, 0.75, 0.75]
+    assert ek.allclose(medium.get_combined_extinction(mi), 1)
+
+    medium = create_medium(sparse_volume, majorant_resolution=0)
+    assert not medium.has_majorant_grid()
+    assert ek.allclose(medium.get_combined_extinction(mi), 100)
+
+
+def test02_sample_interaction(variant_scalar_rgb, sparse_volume):
+    from mitsuba.core import Ray3f
+
+    medium = create_medium(sparse_volume)
+    tau = -np.log(1 - 0.5)
+
+    # Far away from the bright voxel, free-flight distances follow the unit density
+    ray = Ray3f([-1, 0.75, 0.75], [1, 0, 0], 0.0, [])
+    mi = medium.sample_interaction(ray, 0.5, 0)
+    assert mi.is_valid()
+    assert ek.allclose(mi.t, 1 + tau)
+    assert ek.allclose(mi.combined_extinction, 1)
+    assert ek.allclose(mi.sigma_n, 0, atol=1e-5)
+
+    # The first cells along this ray are bounded by the bright voxel
+    ray = Ray3f([-1, 0.01, 0.01], [1, 0, 0], 0.0, [])
+    mi = medium.sample_interaction(ray, 0.5, 0)
+    assert ek.allclose(mi.t, 1 + tau / 100)
+    assert ek.allclose(mi.combined_extinction, 100)
+
+    # The transmittance and PDF reproduce the optical depth along the grid
+    ray = Ray3f([-1, 0.75, 0.75], [1, 0, 0], 0.0, [])
+    for sample in [0.1, 0.3, 0.6]:
+        mi = medium.sample_interaction(ray, sample, 0)
+        tr = ek.exp(-(mi.t - mi.mint) * mi.combined_extinction)
+        assert ek.allclose(tr, 1 - sample)
+
+    # Large optical depths let the ray leave the medium
+    mi = medium.sample_interaction(ray, 1 - 1e-6, 0)
+    assert not mi.is_valid()
+
+
+def test03_sample_interaction_vec(variant_packet_rgb, sparse_volume):
+    from mitsuba.core import Ray3f
+
+    medium = create_medium(sparse_volume)
+
+    # Rows of cells that are not influenced by the bright voxel
+    n = 64
+    y = np.linspace(0.2, 0.99, n)
+    o = np.stack([-np.ones(n), y, y[::-1]], axis=1)
+    d = np.tile([1.0, 0, 0], (n, 1))
+    samples = np.linspace(0.0, 0.6, n)
+
+    mi = medium.sample_interaction(Ray3f(o, d, 0.0, []), samples, 0)
+    assert ek.allclose(mi.t, 1 - np.log(1 - samples), rtol=1e-4)
+    assert ek.allclose(mi.combined_extinction[0], 1)
+
+
+def test04_decomposition_tracking(variant_scalar_rgb, sparse_volume):
+    from mitsuba.core import Ray3f
+    from mitsuba.core.xml import load_string
+
+    medium = load_string("""
+        <medium type="heterogeneous" version="2.0.0">
+            <volume type="gridvolume" name="sigma_t">
+                <string name="filename" value="{}"/>
+            </volume>
+            <rgb name="control_sigma_t" value="0.25, 0.5, 1"/>
+        </medium>
+    """.format(sparse_volume))
+    assert medium.has_control_extinction()
+    sigma_c = [0.25, 0.5, 1]
+
+    # Scattering: the control component is part of the extinction and majorant
+    ray = Ray3f([-1, 0.75, 0.75], [1, 0, 0], 0.0, [])
+    for channel in range(3):
+        mi = medium.sample_interaction(ray, 0.5, channel)
+        assert ek.allclose(mi.t, 1 - np.log(0.5) / (1 + sigma_c[channel]))
+        assert ek.allclose(mi.combined_extinction, [1.25, 1.5, 2])
+        assert ek.allclose(mi.sigma_t, [1.25, 1.5, 2])
+
+    # Ratio tracking only samples collisions with the residual component
+    mi = medium.sample_ratio_tracking(ray, 0.5, 2)
+    assert ek.allclose(mi.t, 1 - np.log(0.5))
+    assert ek.allclose(mi.combined_extinction, 1)
+    assert ek.allclose(mi.sigma_n, 0, atol=1e-5)
+
+    # .. and the control component is accounted for analytically
+    mi = medium.sample_ratio_tracking(ray, 1 - 1e-6, 0)
+    assert not mi.is_valid()
+    for spectral_mis in [False, True]:
+        weight = medium.eval_ratio_tracking_weight(mi, 2, 0, spectral_mis)
+        assert ek.allclose(weight, np.exp(-np.array(sigma_c)))
+
+
+def test05_spectral_mis(variant_scalar_rgb):
+    from mitsuba.core import Ray3f
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import SurfaceInteraction3f
+
+    medium = load_string("""
+        <medium type="homogeneous" version="2.0.0">
+            <rgb name="sigma_t" value="0.25, 0.5, 1"/>
+            <float name="scale" value="4"/>
+            <float name="albedo" value="0.5"/>
+        </medium>
+    """)
+    sigma_t = np.array([1, 2, 4])
+
+    si = SurfaceInteraction3f()
+    si.t = float('inf')
+    ray = Ray3f([0, 0, 0], [0, 0, 1], 0.0, [])
+    mi = medium.sample_interaction(ray, 0.5, 1)
+    assert ek.allclose(mi.t, -np.log(0.5) / 2)
+
+    # Single channel: the PDF of the channel that drove the sampling
+    tr = np.exp(-mi.t * sigma_t)
+    weight = medium.eval_tr_weight(mi, si, 1, False)
+    assert ek.allclose(weight, tr / (tr[1] * sigma_t[1]))
+
+    # Spectral MIS: the average PDF over all channels bounds the weights
+    weight = medium.eval_tr_weight(mi, si, 1, True)
+    assert ek.allclose(weight, tr / np.mean(tr * sigma_t))
+
+    # Collisions in a homogeneous medium are always real
+    for sample in [0.1, 0.5, 0.9]:
+        real, weight = medium.sample_collision(mi, sample, 0, True)
+        assert real
+        assert ek.allclose(weight, 0.5 * sigma_t)
+
+
+def test06_control_extinction_must_be_constant(variant_scalar_rgb, sparse_volume):
+    from mitsuba.core.xml import load_string
+
+    with pytest.raises(RuntimeError, match='spatially constant'):
+        load_string("""
+            <medium type="heterogeneous" version="2.0.0">
+                <volume type="gridvolume" name="sigma_t">
+                    <string name="filename" value="{0}"/>
+                </volume>
+                <volume type="gridvolume" name="control_sigma_t">
+                    <string name="filename" value="{0}"/>
+                </volume>
+            </medium>
+        """.format(sparse_volume))
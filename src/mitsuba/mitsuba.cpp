@@ -6,6 +6,7 @@
 #include <mitsuba/core/jit.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/profiler.h>
+#include <mitsuba/core/texcache.h>
 #include <mitsuba/core/thread.h>
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/vector.h>
@@ -65,11 +66,19 @@ Options:
         When specified, Mitsuba will update the scene's
         XML description to the latest version.
 
+    --deduplicate
+        Share a single instance between identical textures and
+        BSDFs that are declared multiple times in the scene.
+
     -a <path1>;<path2>;..
         Add one or more entries to the resource search path.
 
     -o <filename>, --output <filename>
         Write the output image to the file "filename".
+
+    --texture-cache <size>
+        Memory budget of the cache used by out-of-core (tiled)
+        textures in MiB. Default value: 1024.
 )";
 }
 
@@ -142,6 +151,8 @@ int main(int argc, char *argv[]) {
     auto arg_help      = parser.add(StringVec{ "-h", "--help" });
     auto arg_mode      = parser.add(StringVec{ "-m", "--mode" }, true);
     auto arg_paths     = parser.add(StringVec{ "-a" }, true);
+    auto arg_tex_cache = parser.add(StringVec{ "--texture-cache" }, true);
+    auto arg_dedup     = parser.add(StringVec{ "--deduplicate" }, false);
     auto arg_extra     = parser.add("", true);
     bool print_profile = false;
     xml::ParameterList params;
@@ -189,6 +200,13 @@ int main(int argc, char *argv[]) {
 
         size_t sensor_i  = (*arg_sensor_i ? arg_sensor_i->as_int() : 0);
 
+        if (*arg_tex_cache) {
+            int budget = arg_tex_cache->as_int();
+            if (budget < 1)
+                Throw("Texture cache size must be >= 1 MiB!");
+            TextureCache::instance()->set_budget(size_t(budget) << 20);
+        }
+
         // Initialize Intel Thread Building Blocks with the requested number of threads
         if (*arg_threads)
             __global_thread_count = arg_threads->as_int();
@@ -239,7 +257,8 @@ int main(int argc, char *argv[]) {
 
             // Try and parse a scene from the passed file.
             ref<Object> parsed =
-                xml::load_file(arg_extra->as_string(), mode, params, *arg_update);
+                xml::load_file(arg_extra->as_string(), mode, params, *arg_update,
+                               *arg_dedup);
 
             bool success = MTS_INVOKE_VARIANT(mode, render, parsed.get(),
                                               sensor_i, filename);
@@ -0,0 +1,161 @@
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/render/phase.h>
+#include "phase_table.h"
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _phase-hgmix:
+
+Mixture of Henyey-Greenstein lobes (:monosp:`hgmix`)
+----------------------------------------------------
+
+.. list-table::
+ :widths: 20 15 65
+ :header-rows: 1
+ :class: paramstable
+
+ * - Parameter
+   - Type
+   - Description
+ * - g
+   - |string|
+   - A comma-separated list of asymmetry parameters, one per lobe. Each of
+     them must lie in the open interval (-1, 1).
+ * - weights
+   - |string|
+   - A comma-separated list of non-negative lobe weights. They are normalized
+     to sum up to one. (Default: equal weights)
+ * - resolution
+   - |int|
+   - Number of entries of the table that represents the mixture.
+     (Default: 1024)
+
+This plugin implements a convex combination of Henyey-Greenstein phase
+functions (see :ref:`hg <phase-hg>`), such as a strongly forward scattering
+lobe combined with a weaker backward scattering one. The mixture is
+tabulated upon construction and then sampled and evaluated like the
+:ref:`tabphase <phase-tabphase>` plugin, i.e. without evaluating any of the
+lobes at render time.
+
+The table is linearly interpolated over the cosine of the scattering angle.
+Very narrow lobes (:math:`|g|` close to one) are smoothed out by this
+representation unless the resolution is increased accordingly.
+
+.. code-block:: xml
+
+    <phase type="hgmix">
+        <string name="g" value="0.9, -0.3"/>
+        <string name="weights" value="0.8, 0.2"/>
+    </phase>
+
+*/
+template <typename Float, typename Spectrum>
+class HGMixturePhaseFunction final : public PhaseFunction<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(PhaseFunction, m_flags)
+    MTS_IMPORT_TYPES(PhaseFunctionContext)
+
+    HGMixturePhaseFunction(const Properties &props) : Base(props) {
+        m_g = parse_list(props.string("g"));
+        if (m_g.empty())
+            Throw("At least one lobe must be specified!");
+        for (ScalarFloat g : m_g) {
+            if (g >= 1 || g <= -1)
+                Throw("The asymmetry parameters must lie in the interval (-1, 1)!");
+        }
+
+        if (props.has_property("weights"))
+            m_weights = parse_list(props.string("weights"));
+        else
+            m_weights = std::vector<ScalarFloat>(m_g.size(), 1.f);
+        if (m_weights.size() != m_g.size())
+            Throw("Expected %i lobe weights, got %i!", m_g.size(), m_weights.size());
+
+        m_resolution = props.size_("resolution", 1024);
+        if (m_resolution < 2)
+            Throw("The resolution must be at least 2!");
+
+        m_flags = +PhaseFunctionFlags::Anisotropic;
+        tabulate();
+    }
+
+    std::pair<Vector3f, Float> sample(const PhaseFunctionContext & /* ctx */,
+                                      const MediumInteraction3f &mi, const Point2f &sample,
+                                      Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::PhaseFunctionSample, active);
+        return m_table.sample(mi, sample, active);
+    }
+
+    Float eval(const PhaseFunctionContext & /* ctx */, const MediumInteraction3f &mi,
+               const Vector3f &wo, Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::PhaseFunctionEvaluate, active);
+        return m_table.eval(mi, wo, active);
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "HGMixturePhaseFunction[" << std::endl
+            << "  g = [";
+        for (size_t i = 0; i < m_g.size(); ++i)
+            oss << m_g[i] << (i + 1 < m_g.size() ? ", " : "");
+        oss << "]," << std::endl
+            << "  weights = [";
+        for (size_t i = 0; i < m_weights.size(); ++i)
+            oss << m_weights[i] << (i + 1 < m_weights.size() ? ", " : "");
+        oss << "]," << std::endl
+            << "  resolution = " << m_resolution << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    static std::vector<ScalarFloat> parse_list(const std::string &str) {
+        std::vector<ScalarFloat> result;
+        for (const auto &s : string::tokenize(str, " ,")) {
+            try {
+                result.push_back((ScalarFloat) std::stod(s));
+            } catch (...) {
+                Throw("Could not parse floating point value '%s'", s);
+            }
+        }
+        return result;
+    }
+
+    /// Evaluate the mixture over the cosine of the scattering angle and build the table
+    void tabulate() {
+        double weight_sum = 0.0;
+        for (ScalarFloat w : m_weights) {
+            if (w < 0)
+                Throw("The lobe weights must be non-negative!");
+            weight_sum += w;
+        }
+        if (weight_sum == 0)
+            Throw("The lobe weights must not all be zero!");
+
+        std::vector<ScalarFloat> values(m_resolution);
+        for (size_t i = 0; i < m_resolution; ++i) {
+            double cos_theta = -1.0 + 2.0 * i / (m_resolution - 1), value = 0.0;
+            for (size_t j = 0; j < m_g.size(); ++j) {
+                double g = m_g[j],
+                       temp = 1.0 + g * g - 2.0 * g * cos_theta;
+                value += m_weights[j] * (1.0 - g * g) / (temp * std::sqrt(temp));
+            }
+            values[i] = (ScalarFloat) (value / weight_sum);
+        }
+
+        m_table = PhaseFunctionTable<Float, Spectrum>(values.data(), values.size());
+    }
+
+private:
+    std::vector<ScalarFloat> m_g, m_weights;
+    size_t m_resolution;
+    PhaseFunctionTable<Float, Spectrum> m_table;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(HGMixturePhaseFunction, PhaseFunction)
+MTS_EXPORT_PLUGIN(HGMixturePhaseFunction, "Mixture of Henyey-Greenstein phase functions")
+NAMESPACE_END(mitsuba)
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <mitsuba/core/distr_1d.h>
+#include <mitsuba/core/frame.h>
+#include <mitsuba/render/interaction.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Shared implementation of phase functions that are tabulated over the
+ * cosine of the scattering angle
+ *
+ * The table is stored as a \ref ContinuousDistribution on the interval
+ * [-1, 1], where a cosine of 1 denotes forward scattering (i.e. no change of
+ * the propagation direction). Sampling inverts the precomputed CDF using a
+ * fixed number of table lookups, and evaluation linearly interpolates the
+ * table. Both operations are thus independent of the model that produced the
+ * table.
+ */
+template <typename Float, typename Spectrum>
+struct PhaseFunctionTable {
+    MTS_IMPORT_TYPES()
+
+    PhaseFunctionTable() = default;
+
+    PhaseFunctionTable(const ScalarFloat *values, size_t size)
+        : distr(ScalarVector2f(-1.f, 1.f), values, size) { }
+
+    /// Sample a direction, returns the direction and its (solid angle) density
+    std::pair<Vector3f, Float> sample(const MediumInteraction3f &mi, const Point2f &sample,
+                                      Mask active) const {
+        auto [cos_theta, pdf] = distr.sample_pdf(sample.x(), active);
+
+        Float sin_theta = enoki::safe_sqrt(1.f - cos_theta * cos_theta);
+        auto [sin_phi, cos_phi] = enoki::sincos(2.f * math::Pi<ScalarFloat> * sample.y());
+        Vector3f wo = mi.to_world(
+            Vector3f(sin_theta * cos_phi, sin_theta * sin_phi, cos_theta));
+
+        return { wo, pdf * math::InvTwoPi<ScalarFloat> };
+    }
+
+    /// Evaluate the phase function (which equals the density of \ref sample())
+    Float eval(const MediumInteraction3f &mi, const Vector3f &wo, Mask active) const {
+        Float cos_theta = clamp(-dot(wo, mi.wi), -1.f, 1.f);
+        return distr.eval_pdf_normalized(cos_theta, active) * math::InvTwoPi<ScalarFloat>;
+    }
+
+    ContinuousDistribution<Float> distr;
+};
+
+NAMESPACE_END(mitsuba)
@@ -0,0 +1,101 @@
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/render/phase.h>
+#include "phase_table.h"
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _phase-tabphase:
+
+Tabulated phase function (:monosp:`tabphase`)
+---------------------------------------------
+
+.. list-table::
+ :widths: 20 15 65
+ :header-rows: 1
+ :class: paramstable
+
+ * - Parameter
+   - Type
+   - Description
+ * - values
+   - |string|
+   - A comma-separated list of phase function values, regularly spaced over
+     the cosine of the scattering angle from -1 (backward scattering) to 1
+     (forward scattering). The values need not be normalized.
+
+This plugin implements a phase function that is specified by a table, e.g.
+of measured data. The table is linearly interpolated, and its cumulative
+distribution function is precomputed, hence sampling and evaluation only
+perform table lookups regardless of the complexity of the underlying model.
+
+.. code-block:: xml
+
+    <phase type="tabphase">
+        <string name="values" value="0.5, 0.6, 0.9, 1.5, 3.0"/>
+    </phase>
+
+*/
+template <typename Float, typename Spectrum>
+class TabulatedPhaseFunction final : public PhaseFunction<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(PhaseFunction, m_flags)
+    MTS_IMPORT_TYPES(PhaseFunctionContext)
+
+    TabulatedPhaseFunction(const Properties &props) : Base(props) {
+        std::vector<std::string> values_str =
+            string::tokenize(props.string("values"), " ,");
+        std::vector<ScalarFloat> data;
+        data.reserve(values_str.size());
+
+        for (const auto &s : values_str) {
+            try {
+                data.push_back((ScalarFloat) std::stod(s));
+            } catch (...) {
+                Throw("Could not parse floating point value '%s'", s);
+            }
+        }
+
+        m_table = PhaseFunctionTable<Float, Spectrum>(data.data(), data.size());
+        m_flags = +PhaseFunctionFlags::Anisotropic;
+    }
+
+    std::pair<Vector3f, Float> sample(const PhaseFunctionContext & /* ctx */,
+                                      const MediumInteraction3f &mi, const Point2f &sample,
+                                      Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::PhaseFunctionSample, active);
+        return m_table.sample(mi, sample, active);
+    }
+
+    Float eval(const PhaseFunctionContext & /* ctx */, const MediumInteraction3f &mi,
+               const Vector3f &wo, Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::PhaseFunctionEvaluate, active);
+        return m_table.eval(mi, wo, active);
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        callback->put_parameter("values", m_table.distr.pdf());
+    }
+
+    void parameters_changed(const std::vector<std::string> &/*keys*/) override {
+        m_table.distr.update();
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "TabulatedPhaseFunction[" << std::endl
+            << "  distr = " << string::indent(m_table.distr) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    PhaseFunctionTable<Float, Spectrum> m_table;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(TabulatedPhaseFunction, PhaseFunction)
+MTS_EXPORT_PLUGIN(TabulatedPhaseFunction, "Tabulated phase function")
+NAMESPACE_END(mitsuba)
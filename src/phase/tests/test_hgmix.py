@@ -0,0 +1,94 @@
+import time
+
+import numpy as np
+
+import mitsuba
+import pytest
+import enoki as ek
+
+
+def test01_create(variant_scalar_rgb):
+    from mitsuba.core.xml import load_string
+    p = load_string("""<phase version='2.0.0' type='hgmix'>
+        <string name="g" value="0.8, -0.2"/>
+        <string name="weights" value="0.7, 0.3"/>
+    </phase>""")
+    assert p is not None
+
+
+def test02_eval_single_lobe(variant_scalar_rgb):
+    from mitsuba.render import PhaseFunctionContext, MediumInteraction3f
+    from mitsuba.core.xml import load_string
+
+    # A single lobe closely approximates the analytic model
+    hg = load_string("""<phase version='2.0.0' type='hg'>
+        <float name="g" value="0.4"/>
+    </phase>""")
+    mix = load_string("""<phase version='2.0.0' type='hgmix'>
+        <string name="g" value="0.4"/>
+    </phase>""")
+
+    ctx = PhaseFunctionContext(None)
+    mi = MediumInteraction3f()
+    mi.wi = [0, 0, 1]
+    for theta in np.linspace(0, np.pi, 10):
+        wo = [np.sin(theta), 0, np.cos(theta)]
+        assert np.allclose(mix.eval(ctx, mi, wo), hg.eval(ctx, mi, wo), rtol=1e-3)
+
+
+def test03_chi2(variant_packet_rgb):
+    from mitsuba.python.chi2 import PhaseFunctionAdapter, ChiSquareTest, SphericalDomain
+
+    sample_func, pdf_func = PhaseFunctionAdapter(
+        "hgmix", '<string name="g" value="0.6, -0.4"/>'
+                 '<string name="weights" value="0.6, 0.4"/>')
+
+    chi2 = ChiSquareTest(
+        domain = SphericalDomain(),
+        sample_func = sample_func,
+        pdf_func = pdf_func,
+        sample_dim = 2
+    )
+
+    result = chi2.run(0.1)
+    chi2._dump_tables()
+    assert result
+
+
+@pytest.mark.slow
+def test04_benchmark(variant_packet_rgb):
+    from mitsuba.core import Frame3f
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import PhaseFunctionContext, MediumInteraction3f
+
+    n = 1000000
+    mi = MediumInteraction3f.zero(n)
+    mi.wi = [0, 0, 1]
+    ek.set_slices(mi.wi, n)
+    mi.sh_frame = Frame3f(-mi.wi)
+    ctx = PhaseFunctionContext(None)
+    sample = np.random.uniform(size=(n, 2))
+    wo = np.random.normal(size=(n, 3))
+    wo /= np.linalg.norm(wo, axis=1)[:, None]
+
+    plugins = [
+        load_string("""<phase version='2.0.0' type='hg'>
+            <float name="g" value="0.6"/>
+        </phase>"""),
+        load_string("""<phase version='2.0.0' type='hgmix'>
+            <string name="g" value="0.6"/>
+        </phase>""")
+    ]
+
+    timings = []
+    for p in plugins:
+        p.sample(ctx, mi, sample)
+        start = time.time()
+        for i in range(10):
+            p.sample(ctx, mi, sample)
+            p.eval(ctx, mi, wo)
+        timings.append((time.time() - start) / 10)
+
+    print('\nsample() + eval() with %i queries: %.2f ms (hg), %.2f ms (hgmix), '
+          'speedup: %.2fx' % (n, timings[0] * 1000, timings[1] * 1000,
+                              timings[0] / timings[1]))
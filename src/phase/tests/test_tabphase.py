@@ -0,0 +1,48 @@
+import numpy as np
+
+import mitsuba
+import pytest
+import enoki as ek
+
+
+def test01_create(variant_scalar_rgb):
+    from mitsuba.core.xml import load_string
+    p = load_string("""<phase version='2.0.0' type='tabphase'>
+        <string name="values" value="0.5, 1.0, 1.5"/>
+    </phase>""")
+    assert p is not None
+
+
+def test02_eval(variant_scalar_rgb):
+    from mitsuba.core.math import Pi
+    from mitsuba.render import PhaseFunctionContext, MediumInteraction3f
+    from mitsuba.core.xml import load_string
+
+    # Phase function proportional to 2 + cos(theta)
+    p = load_string("""<phase version='2.0.0' type='tabphase'>
+        <string name="values" value="1, 3"/>
+    </phase>""")
+    ctx = PhaseFunctionContext(None)
+    mi = MediumInteraction3f()
+    mi.wi = [0, 0, 1]
+    for theta in np.linspace(0, np.pi, 5):
+        wo = [np.sin(theta), 0, -np.cos(theta)]
+        assert np.allclose(p.eval(ctx, mi, wo), (2 + np.cos(theta)) / (8 * Pi))
+
+
+def test03_chi2(variant_packet_rgb):
+    from mitsuba.python.chi2 import PhaseFunctionAdapter, ChiSquareTest, SphericalDomain
+
+    sample_func, pdf_func = PhaseFunctionAdapter(
+        "tabphase", '<string name="values" value="0.2, 0.1, 0.4, 1.0, 3.0, 8.0"/>')
+
+    chi2 = ChiSquareTest(
+        domain = SphericalDomain(),
+        sample_func = sample_func,
+        pdf_func = pdf_func,
+        sample_dim = 2
+    )
+
+    result = chi2.run(0.1)
+    chi2._dump_tables()
+    assert result
@@ -0,0 +1,300 @@
+"""
+Reading and writing of Mitsuba's ``.serialized`` mesh format.
+
+This module converts existing version 3 and 4 files (a single ``zlib``
+stream per mesh) into the chunked version 5 format, whose attribute arrays
+can be decompressed in parallel or, when stored without compression, be
+memory-mapped directly into the mesh buffers. It only depends on the
+Python standard library and can be used as a command line tool:
+
+.. code-block:: bash
+
+    python -m mitsuba.python.serialized input.serialized output.serialized [--uncompressed]
+"""
+
+import math
+import struct
+import sys
+import zlib
+from array import array
+from concurrent.futures import ThreadPoolExecutor
+
+FILEFORMAT_HEADER = 0x041C
+
+FLAG_HAS_NORMALS = 0x0001
+FLAG_HAS_TEXCOORDS = 0x0002
+FLAG_HAS_COLORS = 0x0008
+FLAG_FACE_NORMALS = 0x0010
+FLAG_SINGLE_PRECISION = 0x1000
+FLAG_DOUBLE_PRECISION = 0x2000
+FLAG_UNCOMPRESSED = 0x4000
+
+# Attribute arrays in file order: (name, flag, number of components)
+ATTRIBUTES = [
+    ('positions', None, 3),
+    ('normals', FLAG_HAS_NORMALS, 3),
+    ('texcoords', FLAG_HAS_TEXCOORDS, 2),
+    ('colors', FLAG_HAS_COLORS, 3)
+]
+
+
+class Mesh:
+    """
+    Mesh stored in a ``.serialized`` file. Vertex attributes are single
+    precision ``array('f')`` instances (or ``None``), and ``faces`` is an
+    ``array('I')`` of triangle indices.
+    """
+
+    def __init__(self, name='', positions=None, faces=None, normals=None,
+                 texcoords=None, colors=None, face_normals=False):
+        self.name = name
+        self.positions = positions
+        self.normals = normals
+        self.texcoords = texcoords
+        self.colors = colors
+        self.faces = faces
+        self.face_normals = face_normals
+
+    @property
+    def vertex_count(self):
+        return len(self.positions) // 3
+
+    @property
+    def face_count(self):
+        return len(self.faces) // 3
+
+    def flags(self):
+        flags = FLAG_SINGLE_PRECISION
+        for name, flag, _ in ATTRIBUTES:
+            if flag is not None and getattr(self, name) is not None:
+                flags |= flag
+        if self.face_normals:
+            flags |= FLAG_FACE_NORMALS
+        return flags
+
+
+def _to_little_endian(values):
+    if sys.byteorder == 'big':
+        values = array(values.typecode, values)
+        values.byteswap()
+    return values
+
+
+def _from_bytes(typecode, data):
+    values = array(typecode)
+    values.frombytes(data)
+    return _to_little_endian(values)
+
+
+def _read_name(data, offset):
+    end = data.index(b'\0', offset)
+    return data[offset:end].decode('utf-8'), end + 1
+
+
+def _parse_v4(data, version, default_name):
+    """Parse the decompressed contents of a version 3/4 mesh"""
+    flags, = struct.unpack_from('<I', data, 0)
+    offset = 4
+    name = default_name
+    if version == 4:
+        name, offset = _read_name(data, offset)
+    vertex_count, face_count = struct.unpack_from('<QQ', data, offset)
+    offset += 16
+
+    double_precision = (flags & FLAG_DOUBLE_PRECISION) != 0
+    typecode = 'd' if double_precision else 'f'
+    item_size = 8 if double_precision else 4
+
+    mesh = Mesh(name=name, face_normals=(flags & FLAG_FACE_NORMALS) != 0)
+    for attr, flag, dim in ATTRIBUTES:
+        if flag is not None and (flags & flag) == 0:
+            continue
+        size = vertex_count * dim * item_size
+        values = _from_bytes(typecode, data[offset:offset + size])
+        if double_precision:
+            values = array('f', values)
+        setattr(mesh, attr, values)
+        offset += size
+
+    if vertex_count > 0xFFFFFFFF:
+        raise Exception('Meshes with more than 2^32 vertices are not supported')
+    mesh.faces = _from_bytes('I', data[offset:offset + face_count * 3 * 4])
+    return mesh
+
+
+def _parse_v5(data, offset):
+    """Parse a version 5 mesh starting at the given file offset"""
+    offset += 4
+    flags, = struct.unpack_from('<I', data, offset)
+    name, offset = _read_name(data, offset + 4)
+    vertex_count, face_count, chunk_size = struct.unpack_from('<QQI', data, offset)
+    offset += 20
+
+    def read_array(typecode, offset):
+        count, = struct.unpack_from('<I', data, offset)
+        table = struct.unpack_from('<%iQ' % (2 * count), data, offset + 4)
+        chunks = []
+        for i in range(count):
+            chunk = data[table[2 * i]:table[2 * i] + table[2 * i + 1]]
+            if (flags & FLAG_UNCOMPRESSED) == 0:
+                chunk = zlib.decompress(chunk)
+            chunks.append(chunk)
+        return _from_bytes(typecode, b''.join(chunks)), offset + 4 + 16 * count
+
+    mesh = Mesh(name=name, face_normals=(flags & FLAG_FACE_NORMALS) != 0)
+    for attr, flag, dim in ATTRIBUTES:
+        if flag is not None and (flags & flag) == 0:
+            continue
+        values, offset = read_array('f', offset)
+        setattr(mesh, attr, values)
+    mesh.faces, offset = read_array('I', offset)
+    return mesh
+
+
+def read(filename):
+    """Read all meshes stored in a version 3, 4, or 5 ``.serialized`` file"""
+    with open(filename, 'rb') as f:
+        data = f.read()
+
+    fmt, version = struct.unpack_from('<HH', data, 0)
+    if fmt != FILEFORMAT_HEADER or version not in (3, 4, 5):
+        raise Exception('"%s": not a supported .serialized file' % filename)
+
+    # End-of-file dictionary
+    count, = struct.unpack_from('<I', data, len(data) - 4)
+    if version == 3:
+        offsets = struct.unpack_from('<%iI' % count, data, len(data) - 4 * (count + 1))
+        dict_start = len(data) - 4 * (count + 1)
+    else:
+        offsets = struct.unpack_from('<%iQ' % count, data, len(data) - 4 - 8 * count)
+        dict_start = len(data) - 4 - 8 * count
+
+    meshes = []
+    for i, offset in enumerate(offsets):
+        if version == 5:
+            meshes.append(_parse_v5(data, offset))
+            continue
+        end = offsets[i + 1] if i + 1 < count else dict_start
+        contents = zlib.decompressobj().decompress(data[offset + 4:end])
+        meshes.append(_parse_v4(contents, version, '%s@%i' % (filename, i)))
+    return meshes
+
+
+def _align(value, alignment):
+    return (value + alignment - 1) // alignment * alignment
+
+
+def write(filename, meshes, compress=True, chunk_size=1 << 20, level=6):
+    """
+    Write a list of meshes into a version 5 ``.serialized`` file.
+
+    Parameter ``compress``:
+        Compress every chunk of every attribute array separately. When set to
+        ``False``, the arrays are stored contiguously and aligned so that the
+        resulting file can be memory-mapped by the ``serialized`` plugin.
+
+    Parameter ``chunk_size``:
+        Size of a chunk in bytes (before compression)
+
+    Parameter ``level``:
+        ``zlib`` compression level
+    """
+
+    if chunk_size <= 0 or chunk_size % 64 != 0:
+        raise Exception('The chunk size must be a positive multiple of 64')
+
+    out = bytearray()
+    offsets = []
+
+    with ThreadPoolExecutor() as pool:
+        for mesh in meshes:
+            arrays = []
+            for attr, flag, _ in ATTRIBUTES:
+                values = getattr(mesh, attr)
+                if values is None:
+                    continue
+                if attr == 'normals' and not compress:
+                    # Mapped normals are used as-is by the loader
+                    values = _normalize(values)
+                arrays.append(_to_little_endian(values).tobytes())
+            arrays.append(_to_little_endian(array('I', mesh.faces)).tobytes())
+
+            flags = mesh.flags() | (0 if compress else FLAG_UNCOMPRESSED)
+            name = mesh.name.encode('utf-8') + b'\0'
+
+            # Split the arrays into (compressed) chunks
+            chunks = []
+            for data in arrays:
+                parts = [data[i:i + chunk_size] for i in range(0, len(data), chunk_size)]
+                if compress:
+                    parts = list(pool.map(lambda p: zlib.compress(p, level), parts))
+                chunks.append(parts)
+
+            offset = _align(len(out), 64)
+            out.extend(b'\0' * (offset - len(out)))
+            offsets.append(offset)
+
+            header_size = 4 + 4 + len(name) + 20 + \
+                sum(4 + 16 * len(parts) for parts in chunks)
+            position = offset + header_size
+
+            header = bytearray(struct.pack('<HHI', FILEFORMAT_HEADER, 5, flags))
+            header += name
+            header += struct.pack('<QQI', mesh.vertex_count, mesh.face_count, chunk_size)
+            data = bytearray()
+            for parts in chunks:
+                if not compress:
+                    aligned = _align(position, 64)
+                    data += b'\0' * (aligned - position)
+                    position = aligned
+                header += struct.pack('<I', len(parts))
+                for part in parts:
+                    header += struct.pack('<QQ', position, len(part))
+                    data += part
+                    position += len(part)
+                if not compress:
+                    # Padding for vectorized loads past the end of the array
+                    data += b'\0' * 16
+                    position += 16
+
+            out += header
+            out += data
+
+    out += struct.pack('<%iQI' % len(offsets), *offsets, len(offsets))
+
+    with open(filename, 'wb') as f:
+        f.write(out)
+
+
+def _normalize(normals):
+    result = array('f', normals)
+    for i in range(0, len(result), 3):
+        x, y, z = result[i], result[i + 1], result[i + 2]
+        length = math.sqrt(x * x + y * y + z * z)
+        if length > 0:
+            result[i], result[i + 1], result[i + 2] = x / length, y / length, z / length
+    return result
+
+
+def convert(src, dst, compress=True, chunk_size=1 << 20, level=6):
+    """Convert a ``.serialized`` file into the version 5 format"""
+    write(dst, read(src), compress=compress, chunk_size=chunk_size, level=level)
+
+
+if __name__ == '__main__':
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        description='Convert .serialized mesh files into the chunked version 5 format')
+    parser.add_argument('input', help='Input file (version 3, 4, or 5)')
+    parser.add_argument('output', help='Output file')
+    parser.add_argument('--uncompressed', action='store_true',
+                        help='Store the data without compression (memory-mappable)')
+    parser.add_argument('--chunk-size', type=int, default=1 << 20,
+                        help='Chunk size in bytes (default: 1 MiB)')
+    parser.add_argument('--level', type=int, default=6,
+                        help='zlib compression level (default: 6)')
+    args = parser.parse_args()
+
+    convert(args.input, args.output, compress=not args.uncompressed,
+            chunk_size=args.chunk_size, level=args.level)
@@ -0,0 +1,233 @@
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/random.h>
+#include <mitsuba/render/sampler.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+// Defined in dither-matrix256.cpp
+extern MTS_EXPORT_CORE const float dither_matrix256[65536];
+
+/**!
+
+.. _sampler-bluenoise:
+
+Blue noise sampler (:monosp:`bluenoise`)
+----------------------------------------
+
+.. pluginparameters::
+
+ * - sample_count
+   - |int|
+   - Number of samples per pixel. Should be a power of two, and is rounded
+     up to the next power of two otherwise. (Default: 4)
+ * - seed
+   - |int|
+   - Seed offset (Default: 0)
+
+This sampler distributes the error of the rendered image as blue noise in
+screen space, following the dithered sampling approach of Georgiev and
+Fajardo :cite:`Georgiev2016Blue`. All pixels share the same rank-1 lattice
+as their point set, whose generator vector is chosen upon construction so that
+the minimum distance between the points is maximized. Each pixel then applies
+a Cranley-Patterson rotation (i.e. a toroidal shift) to the lattice, whose
+offset is looked up from a tiled 256x256 blue noise mask. The mask is shifted
+pseudorandomly for each dimension, and the sample order is permuted per
+dimension to avoid correlations between dimensions.
+
+Since the rotations of neighboring pixels are very different, their errors
+are negatively correlated, which causes the remaining noise to be
+concentrated at high frequencies. This is visually much less objectionable
+than the white noise produced by the other samplers, especially at the low
+sample counts used for previews or as input to a denoiser.
+
+The sampler relies on the rendering algorithm to provide the pixel of each
+sample. When it is not available, the mask is indexed with a pseudorandom
+position that is unique per sequence, which still produces a randomized
+lattice per pixel.
+
+ */
+
+template <typename Float, typename Spectrum>
+class BlueNoiseSampler final : public Sampler<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Sampler, m_sample_count, m_base_seed, seeded,
+                    m_samples_per_wavefront, m_dimension_index,
+                    current_sample_index, compute_per_sequence_seed)
+    MTS_IMPORT_TYPES()
+
+    BlueNoiseSampler(const Properties &props = Properties()) : Base(props) {
+        // Make sure sample_count is a power of two (e.g. 1, 2, 4, 8, 16, ...)
+        ScalarUInt32 sample_count = math::round_to_power_of_two(m_sample_count);
+
+        if (m_sample_count != sample_count)
+            Log(Warn, "Sample count should be a power of two, rounding to %i", sample_count);
+
+        m_sample_count = sample_count;
+
+        // Spacing of the lattice points in 32 bit fixed point (0 when there is a single point)
+        m_spacing = uint32_t((1ull << 32) >> log2i(m_sample_count));
+        m_generator = lattice_generator(m_sample_count);
+
+        // Convert the dither matrix to fixed point rotations
+        std::unique_ptr<uint32_t[]> mask(new uint32_t[65536]);
+        for (size_t i = 0; i < 65536; ++i)
+            mask[i] = uint32_t(std::lround((dither_matrix256[i] + 0.5) * 65535.0)) << 16;
+        m_mask = DynamicBuffer<UInt32>::copy(mask.get(), 65536);
+    }
+
+    ref<Sampler<Float, Spectrum>> clone() override {
+        BlueNoiseSampler *sampler        = new BlueNoiseSampler();
+        sampler->m_sample_count          = m_sample_count;
+        sampler->m_samples_per_wavefront = m_samples_per_wavefront;
+        sampler->m_base_seed             = m_base_seed;
+        sampler->m_spacing               = m_spacing;
+        sampler->m_generator             = m_generator;
+        return sampler;
+    }
+
+    void seed(uint64_t seed_offset, size_t wavefront_size) override {
+        Base::seed(seed_offset, wavefront_size);
+
+        // Fallback mask position, used until the pixel is known
+        UInt32 seed = compute_per_sequence_seed(seed_offset);
+        m_pixel = Point2u(seed & 0xff, sr<8>(seed) & 0xff);
+        m_lane_sample_index = 0;
+    }
+
+    void set_pixel(const Point2u &pixel) override {
+        m_pixel = pixel;
+    }
+
+    void set_sample_index(const UInt32 &index) override {
+        m_lane_sample_index = index;
+    }
+
+    Float next_1d(Mask active = true) override {
+        Assert(seeded());
+
+        UInt32 dim_seed = dimension_seed();
+        UInt32 i = permute(sample_index(), m_sample_count, dim_seed);
+
+        UInt32 x = i * m_spacing + rotation(dim_seed, active);
+        return to_float(x);
+    }
+
+    Point2f next_2d(Mask active = true) override {
+        Assert(seeded());
+
+        UInt32 dim_seed = dimension_seed();
+        UInt32 i = permute(sample_index(), m_sample_count, dim_seed);
+
+        // The second coordinate wraps around, i.e. is computed modulo one
+        UInt32 x = i * m_spacing + rotation(dim_seed, active),
+               y = i * (m_generator * m_spacing) +
+                   rotation(sample_tea_32(dim_seed, UInt32(0x04223e2du)), active);
+
+        return Point2f(to_float(x), to_float(y));
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "BlueNoiseSampler[" << std::endl
+            << "  sample_count = " << m_sample_count << "," << std::endl
+            << "  generator = (1, " << m_generator << ")" << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    /**
+     * \brief Find the generator vector <tt>(1, g)</tt> of the rank-1 lattice
+     * with \c n points whose minimum (toroidal) point distance is largest
+     */
+    static uint32_t lattice_generator(uint32_t n) {
+        // Generators must be odd (i.e. coprime to n); large point counts only try a subset
+        uint32_t step = 2 * std::max(1u, n / 2048);
+
+        uint32_t best = 1;
+        uint64_t best_dist = 0;
+        for (uint32_t g = 1; g <= n / 2; g += step) {
+            uint64_t dist = (uint64_t) -1;
+            for (uint32_t i = 1; i < n && dist > best_dist; ++i) {
+                uint64_t x = i,
+                         y = ((uint64_t) i * g) % n;
+                x = std::min(x, n - x);
+                y = std::min(y, n - y);
+                dist = std::min(dist, x * x + y * y);
+            }
+            if (dist > best_dist) {
+                best = g;
+                best_dist = dist;
+            }
+        }
+
+        return best;
+    }
+
+    /**
+     * \brief Index of the current sample of every lane within its pixel
+     *
+     * Scalar and wavefront variants advance the sample index, while packet
+     * variants render several samples of a pixel in one packet and provide
+     * the index of every lane through \ref set_sample_index(). The samples
+     * of a pixel can span several packets, whose lanes already carry the
+     * index within the pixel, hence the number of advanced packets must not
+     * be added in this case.
+     */
+    UInt32 sample_index() const {
+        if constexpr (is_static_array_v<Float>)
+            return m_lane_sample_index & (m_sample_count - 1);
+        else
+            return current_sample_index() & (m_sample_count - 1);
+    }
+
+    /**
+     * \brief Seed of the next dimension
+     *
+     * All samples of a pixel must share the permutation and rotation of a
+     * dimension, the seed thus only depends on the base seed.
+     */
+    UInt32 dimension_seed() {
+        return sample_tea_32(UInt32(uint32_t(m_base_seed)), UInt32(m_dimension_index++));
+    }
+
+    /// Look up the Cranley-Patterson rotation of the current pixel from the blue noise mask
+    UInt32 rotation(const UInt32 &seed, Mask active) const {
+        // Toroidally shift the mask differently for every dimension
+        UInt32 x = (m_pixel.x() + seed) & 0xff,
+               y = (m_pixel.y() + sr<8>(seed)) & 0xff;
+
+        // Randomize the bits below the resolution of the mask
+        return gather<UInt32>(m_mask, y * 256u + x, active) | sr<16>(seed);
+    }
+
+    /// Convert a 32 bit fixed point value to a floating point value in [0, 1)
+    static Float to_float(const UInt32 &value) {
+        if constexpr (is_double_v<Float>)
+            return Float(value) * ScalarFloat(1.0 / 4294967296.0);
+        else
+            return reinterpret_array<Float>(sr<9>(value) | 0x3f800000u) - 1.f;
+    }
+
+private:
+    /// Blue noise mask, stored as 32 bit fixed point values
+    DynamicBuffer<UInt32> m_mask;
+
+    /// Pixel of the current sample, used to index the mask
+    Point2u m_pixel;
+
+    /// Index of the sample of every lane within its pixel (packet variants)
+    UInt32 m_lane_sample_index;
+
+    /// Spacing of the lattice points in 32 bit fixed point
+    uint32_t m_spacing;
+
+    /// Second component of the lattice generator vector
+    uint32_t m_generator;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(BlueNoiseSampler, Sampler)
+MTS_EXPORT_PLUGIN(BlueNoiseSampler, "Blue Noise Sampler");
+NAMESPACE_END(mitsuba)
@@ -0,0 +1,184 @@
+#include <mitsuba/core/profiler.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/random.h>
+#include <mitsuba/render/sampler.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _sampler-sobol:
+
+Sobol sampler (:monosp:`sobol`)
+-------------------------------
+
+.. pluginparameters::
+
+ * - sample_count
+   - |int|
+   - Number of samples per pixel. Should be a power of two, and is rounded
+     up to the next power of two otherwise. (Default: 4)
+ * - seed
+   - |int|
+   - Seed offset (Default: 0)
+
+This plugin implements an Owen-scrambled Sobol sampler based on the
+hash-based nested uniform scrambling technique described by Burley
+:cite:`Burley2020Practical`. Each 2D request is answered using the first two
+dimensions of the Sobol sequence, which form a (0, 2)-sequence. The samples
+of every pixel and dimension are decorrelated by shuffling the sample order and
+Owen-scrambling the resulting coordinates, both using hash functions that are
+seeded per pixel and per dimension.
+
+Owen scrambling preserves the stratification of the underlying sequence in
+every 1D and 2D projection while randomizing the points in a way that
+improves the convergence rate for smooth integrands. Compared to the
+:ref:`ldsampler <sampler-ldsampler>`, the shuffle is a closed-form hash
+rather than a shuffle network evaluated with the Tiny Encryption Algorithm,
+and the Sobol points are obtained by multiplying the sample index with
+precomputed generator matrices. The cost of a sample therefore only depends
+on the (logarithm of the) sample count and not on the dimension.
+
+ */
+
+template <typename Float, typename Spectrum>
+class SobolSampler final : public Sampler<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Sampler, m_sample_count, m_base_seed, seeded,
+                    m_samples_per_wavefront, m_dimension_index,
+                    current_sample_index, compute_per_sequence_seed)
+    MTS_IMPORT_TYPES()
+
+    SobolSampler(const Properties &props = Properties()) : Base(props) {
+        // Make sure sample_count is a power of two (e.g. 1, 2, 4, 8, 16, ...)
+        ScalarUInt32 sample_count = math::round_to_power_of_two(m_sample_count);
+
+        if (m_sample_count != sample_count)
+            Log(Warn, "Sample count should be a power of two, rounding to %i", sample_count);
+
+        m_sample_count = sample_count;
+        m_log2_sample_count = log2i(m_sample_count);
+    }
+
+    ref<Sampler<Float, Spectrum>> clone() override {
+        SobolSampler *sampler            = new SobolSampler();
+        sampler->m_sample_count          = m_sample_count;
+        sampler->m_log2_sample_count     = m_log2_sample_count;
+        sampler->m_samples_per_wavefront = m_samples_per_wavefront;
+        sampler->m_base_seed             = m_base_seed;
+        return sampler;
+    }
+
+    void seed(uint64_t seed_offset, size_t wavefront_size) override {
+        Base::seed(seed_offset, wavefront_size);
+        m_scramble_seed = compute_per_sequence_seed(seed_offset);
+    }
+
+    Float next_1d(Mask /*active*/ = true) override {
+        Assert(seeded());
+
+        UInt32 dim_seed = sample_tea_32(m_scramble_seed, UInt32(m_dimension_index++));
+        UInt32 i = shuffled_index(dim_seed);
+
+        return sobol(i, 0, sample_tea_32(dim_seed, UInt32(0x48bc48eb)));
+    }
+
+    Point2f next_2d(Mask /*active*/ = true) override {
+        Assert(seeded());
+
+        UInt32 dim_seed = sample_tea_32(m_scramble_seed, UInt32(m_dimension_index++));
+        UInt32 i = shuffled_index(dim_seed);
+
+        // Both axes share the shuffled index to retain the 2D stratification
+        Float x = sobol(i, 0, sample_tea_32(dim_seed, UInt32(0x98bc51ab))),
+              y = sobol(i, 1, sample_tea_32(dim_seed, UInt32(0x04223e2d)));
+
+        return Point2f(x, y);
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "SobolSampler[" << std::endl
+            << "  sample_count = " << m_sample_count << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    /// Reverse the order of the bits of a 32 bit integer
+    static UInt32 reverse_bits(UInt32 x) {
+        x = (x << 16) | (x >> 16);
+        x = ((x & 0x00ff00ff) << 8) | ((x & 0xff00ff00) >> 8);
+        x = ((x & 0x0f0f0f0f) << 4) | ((x & 0xf0f0f0f0) >> 4);
+        x = ((x & 0x33333333) << 2) | ((x & 0xcccccccc) >> 2);
+        x = ((x & 0x55555555) << 1) | ((x & 0xaaaaaaaa) >> 1);
+        return x;
+    }
+
+    /**
+     * \brief Hash-based Owen scrambling of the bits of \c x
+     *
+     * The Laine-Karras style permutation only lets each bit depend on the
+     * less significant ones. Applying it to the reversed bits thus flips each
+     * digit of \c x depending on the preceding, more significant digits,
+     * which is exactly a nested uniform scramble.
+     */
+    static UInt32 nested_uniform_scramble(UInt32 x, const UInt32 &seed) {
+        x = reverse_bits(x);
+        x += seed;
+        x ^= x * 0x6c50b47c;
+        x ^= x * 0xb82f1e52;
+        x ^= x * 0xc7afe638;
+        x ^= x * 0x8d22f6e6;
+        return reverse_bits(x);
+    }
+
+    /// Pseudorandomly permute the sample indices of the current pixel
+    UInt32 shuffled_index(const UInt32 &dim_seed) const {
+        // The low bits of the scrambled index only depend on the low bits of the index
+        UInt32 mask = m_sample_count - 1;
+        return nested_uniform_scramble(current_sample_index() & mask, dim_seed) & mask;
+    }
+
+    /// Evaluate a dimension of the Owen-scrambled Sobol sequence
+    Float sobol(const UInt32 &index, uint32_t dim, const UInt32 &scramble) const {
+        UInt32 result = 0;
+        for (uint32_t j = 0; j < m_log2_sample_count; ++j)
+            masked(result, neq(index & (1u << j), 0u)) ^= generator_matrices[dim][j];
+
+        result = nested_uniform_scramble(result, scramble);
+
+        if constexpr (is_double_v<Float>)
+            return Float(result) * ScalarFloat(1.0 / 4294967296.0);
+        else
+            return reinterpret_array<Float>(sr<9>(result) | 0x3f800000u) - 1.f;
+    }
+
+private:
+    /// Per-sequence scramble seed
+    UInt32 m_scramble_seed;
+
+    /// Base-2 logarithm of the sample count
+    uint32_t m_log2_sample_count;
+
+    /// Generator matrices (columns) of the first two dimensions of the Sobol sequence
+    static constexpr uint32_t generator_matrices[2][32] = {
+        { 0x80000000, 0x40000000, 0x20000000, 0x10000000, 0x08000000, 0x04000000,
+          0x02000000, 0x01000000, 0x00800000, 0x00400000, 0x00200000, 0x00100000,
+          0x00080000, 0x00040000, 0x00020000, 0x00010000, 0x00008000, 0x00004000,
+          0x00002000, 0x00001000, 0x00000800, 0x00000400, 0x00000200, 0x00000100,
+          0x00000080, 0x00000040, 0x00000020, 0x00000010, 0x00000008, 0x00000004,
+          0x00000002, 0x00000001 },
+        { 0x80000000, 0xc0000000, 0xa0000000, 0xf0000000, 0x88000000, 0xcc000000,
+          0xaa000000, 0xff000000, 0x80800000, 0xc0c00000, 0xa0a00000, 0xf0f00000,
+          0x88880000, 0xcccc0000, 0xaaaa0000, 0xffff0000, 0x80008000, 0xc000c000,
+          0xa000a000, 0xf000f000, 0x88008800, 0xcc00cc00, 0xaa00aa00, 0xff00ff00,
+          0x80808080, 0xc0c0c0c0, 0xa0a0a0a0, 0xf0f0f0f0, 0x88888888, 0xcccccccc,
+          0xaaaaaaaa, 0xffffffff }
+    };
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(SobolSampler, Sampler)
+MTS_EXPORT_PLUGIN(SobolSampler, "Sobol Sampler");
+NAMESPACE_END(mitsuba)
@@ -0,0 +1,176 @@
+import mitsuba
+import pytest
+import enoki as ek
+import numpy as np
+
+from .utils import check_uniform_scalar_sampler, check_uniform_wavefront_sampler
+
+def test01_bluenoise_scalar(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "bluenoise",
+        "sample_count" : 1024,
+    })
+
+    # The 2D projection is a lattice, which is not stratified per bin
+    check_uniform_scalar_sampler(sampler, atol=2.5)
+
+
+def test02_bluenoise_wavefront(variant_gpu_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "bluenoise",
+        "sample_count" : 1024,
+    })
+
+    check_uniform_wavefront_sampler(sampler, atol=2.5)
+
+
+def test03_bluenoise_stratified_dimensions(variant_scalar_rgb):
+    """ Every 1D projection should be stratified, also with a pixel set """
+    from mitsuba.core import xml
+
+    sample_count = 64
+    sampler = xml.load_dict({
+        "type" : "bluenoise",
+        "sample_count" : sample_count,
+    })
+
+    dims = 16
+    hist = np.zeros((dims, sample_count))
+
+    sampler.seed(0)
+    for i in range(sample_count):
+        sampler.set_pixel([13, 7])
+        for d in range(dims):
+            hist[d, int(sampler.next_1d() * sample_count)] += 1
+        sampler.advance()
+
+    assert np.all(hist == 1)
+
+
+def test04_bluenoise_screen_space(variant_scalar_rgb):
+    """ Neighboring pixels should receive very different samples """
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "bluenoise",
+        "sample_count" : 1,
+    })
+
+    res = 64
+    values = np.zeros((2, res, res))
+    for y in range(res):
+        for x in range(res):
+            sampler.seed(y * res + x)
+            sampler.set_pixel([x, y])
+            values[0, y, x] = sampler.next_1d()
+            values[1, y, x] = sampler.next_2d().y
+
+    # White noise would produce a mean absolute difference of 1/3
+    for v in values:
+        assert np.mean(np.abs(v[:, 1:] - v[:, :-1])) > 0.42
+        assert np.mean(np.abs(v[1:, :] - v[:-1, :])) > 0.42
+
+
+def test05_bluenoise_packet_lanes(variant_packet_rgb):
+    """ Lanes rendering the same pixel in packet variants must receive
+        different samples of the pixel """
+    from mitsuba.core import xml
+
+    scene = xml.load_string("""
+        <scene version="2.0.0">
+            <integrator type="direct"/>
+            <sensor type="perspective">
+                <float name="fov" value="30"/>
+                <transform name="to_world">
+                    <lookat origin="0, 0, 5" target="0, 0, 0" up="0, 1, 0"/>
+                </transform>
+                <sampler type="bluenoise">
+                    <integer name="sample_count" value="16"/>
+                </sampler>
+                <film type="hdrfilm">
+                    <integer name="width" value="16"/>
+                    <integer name="height" value="16"/>
+                    <rfilter type="box"/>
+                </film>
+            </sensor>
+            <emitter type="constant"/>
+            <shape type="sphere">
+                <bsdf type="diffuse">
+                    <rgb name="reflectance" value="0"/>
+                </bsdf>
+            </shape>
+        </scene>""")
+
+    sensor = scene.sensors()[0]
+    assert scene.integrator().render(scene, sensor)
+    # Raw film storage: X, Y, Z, alpha and weight channels
+    raw = np.array(sensor.film().bitmap(raw=True), copy=False)
+    image = raw[:, :, 1] / raw[:, :, 4]
+
+    # Pixels along the silhouette of the sphere are only partially covered,
+    # which is invisible when all samples of a pixel are identical
+    partial = (image > 0.05) & (image < 0.95)
+    assert np.count_nonzero(partial) > 8
+
+
+def test06_bluenoise_packet_lattice(variant_packet_rgb, tmpdir):
+    """ Every pixel must receive each lattice point exactly once, also when
+        its samples span several packets """
+    from mitsuba.core import xml, Bitmap
+
+    # The radiance varies sinusoidally with a period of one pixel along u.
+    # The 1D projections of a complete lattice are stratified, hence the mean
+    # of the sinusoid over the samples of a pixel vanishes.
+    periods, texels = 8, 64
+    u = (np.arange(periods * texels) + 0.5) / (periods * texels)
+    data = np.zeros((4, periods * texels, 3), dtype=np.float32)
+    data[:, :, 0] = 1 + 0.5 * np.cos(2 * np.pi * periods * u)
+    data[:, :, 1] = 1 + 0.5 * np.sin(2 * np.pi * periods * u)
+    data[:, :, 2] = 1
+    filename = str(tmpdir.join('pattern.exr'))
+    Bitmap(data).write(filename)
+
+    # Larger than the packet width of every instruction set
+    sample_count = 32
+
+    # The view covers half of the rectangle, i.e. four periods
+    scene = xml.load_string("""
+        <scene version="2.0.0">
+            <integrator type="direct"/>
+            <sensor type="perspective">
+                <float name="fov" value="{}"/>
+                <transform name="to_world">
+                    <lookat origin="0, 0, 1" target="0, 0, 0" up="0, 1, 0"/>
+                </transform>
+                <sampler type="bluenoise">
+                    <integer name="sample_count" value="{}"/>
+                </sampler>
+                <film type="hdrfilm">
+                    <integer name="width" value="4"/>
+                    <integer name="height" value="4"/>
+                    <string name="component_format" value="float32"/>
+                    <rfilter type="box"/>
+                </film>
+            </sensor>
+            <shape type="rectangle">
+                <emitter type="area">
+                    <texture type="bitmap" name="radiance">
+                        <string name="filename" value="{}"/>
+                        <boolean name="raw" value="true"/>
+                    </texture>
+                </emitter>
+            </shape>
+        </scene>""".format(2 * np.degrees(np.arctan(0.5)), sample_count, filename))
+
+    sensor = scene.sensors()[0]
+    assert scene.integrator().render(scene, sensor)
+    image = np.array(sensor.film().bitmap(), copy=False)
+
+    # Duplicated (and missing) lattice points leave a nonzero mean, e.g. 1/16
+    # when the first point of the lattice replaces the opposite one
+    mean = 2 * np.sqrt((image[:, :, 0] - 1) ** 2 + (image[:, :, 1] - 1) ** 2)
+    assert np.all(mean < 0.01)
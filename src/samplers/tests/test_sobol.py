@@ -0,0 +1,88 @@
+import mitsuba
+import pytest
+import enoki as ek
+import numpy as np
+
+from .utils import check_uniform_scalar_sampler, check_uniform_wavefront_sampler
+
+def test01_sobol_scalar(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "sobol",
+        "sample_count" : 1024,
+    })
+
+    check_uniform_scalar_sampler(sampler)
+
+
+def test02_sobol_wavefront(variant_gpu_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "sobol",
+        "sample_count" : 1024,
+    })
+
+    check_uniform_wavefront_sampler(sampler)
+
+
+def test03_sobol_deterministic_values(variant_scalar_rgb):
+    from mitsuba.core import xml
+
+    sampler = xml.load_dict({
+        "type" : "sobol",
+        "sample_count" : 1024,
+    })
+
+    sampler.seed(0)
+
+    values_1d_dim0 = [0.226141, 0.9983765, 0.6063455, 0.4401556, 0.847839]
+
+    values_2d_dim0 = [[0.163891, 0.216153], [0.695468, 0.033744], [0.583318, 0.909014],
+                      [0.907914, 0.436932], [0.212431, 0.514416]]
+
+    values_1d_dim1 = [0.9803157, 0.2374744, 0.2412789, 0.7606905, 0.4167402]
+
+    values_2d_dim1 = [[0.546136, 0.953597], [0.07777, 0.815731], [0.193634, 0.315956],
+                      [0.313285, 0.571347], [0.571262, 0.125802]]
+
+    for v in values_1d_dim0:
+        assert ek.allclose(sampler.next_1d(), v)
+
+    for v in values_2d_dim0:
+        assert ek.allclose(sampler.next_2d(), v)
+
+    sampler.advance()
+
+    for v in values_1d_dim1:
+        assert ek.allclose(sampler.next_1d(), v)
+
+    for v in values_2d_dim1:
+        assert ek.allclose(sampler.next_2d(), v)
+
+
+def test04_sobol_stratified_dimensions(variant_scalar_rgb):
+    """ Every dimension should be stratified, not only the first ones """
+    from mitsuba.core import xml
+
+    sample_count = 64
+    sampler = xml.load_dict({
+        "type" : "sobol",
+        "sample_count" : sample_count,
+    })
+
+    dims = 16
+    hist_1d = np.zeros((dims, sample_count))
+    hist_2d = np.zeros((dims, 8, 8))
+
+    sampler.seed(0)
+    for i in range(sample_count):
+        for d in range(dims):
+            hist_1d[d, int(sampler.next_1d() * sample_count)] += 1
+            v = sampler.next_2d()
+            hist_2d[d, int(v.x * 8), int(v.y * 8)] += 1
+        sampler.advance()
+
+    assert np.all(hist_1d == 1)
+    assert np.all(hist_2d == 1)
@@ -0,0 +1,533 @@
+#include <mitsuba/core/bitmap.h>
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/math.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/fwd.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/shape.h>
+#include <tbb/tbb.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/// Maximum depth of the traversal stack (sufficient for 2^32 x 2^32 height fields)
+#define MTS_HEIGHTFIELD_STACK_SIZE 128
+
+/**!
+
+.. _shape-heightfield:
+
+Height field (:monosp:`heightfield`)
+------------------------------------
+
+.. pluginparameters::
+
+ * - filename
+   - |string|
+   - Filename of the bitmap containing the height values. Color images are
+     converted to luminance, and no sRGB gamma correction is applied.
+ * - scale
+   - |float|
+   - Scale factor applied to the height values (Default: 1)
+ * - shading_normals
+   - |bool|
+   - When set to |true|, smooth shading normals are obtained by interpolating
+     finite-difference normals of the height samples. Otherwise, the
+     geometric normal of the displaced surface is used. (Default: |true|)
+ * - flip_normals
+   - |bool|
+   - Is the surface inverted, i.e. should the normal vectors be flipped? (Default: |false|)
+ * - to_world
+   - |transform|
+   - Specifies a linear object-to-world transformation. (Default: none (i.e. object space = world space))
+
+This shape plugin displaces the rectangle :math:`[-1,1]\times[-1,1]` (see
+:ref:`rectangle <shape-rectangle>`) along the positive Z-direction according
+to a height map, and ray traces the displaced surface directly without
+tessellating it into triangles. The memory usage is therefore roughly that of
+the height map itself, compared to several dozen bytes per texel for an
+equivalent triangle mesh.
+
+The height values are located at the pixel centers, and the surface between
+them is the bilinear interpolant of the four surrounding samples. The surface
+thus exactly matches a :ref:`bitmap <texture-bitmap>` texture with bilinear
+filtering that is evaluated at the surface's UV coordinates, which makes it
+possible to use the same height map for shading computations. (The outermost
+half-pixel border of the rectangle is not covered.)
+
+Ray intersections use a min/max mip-pyramid over the height values: rays are
+tested against the bounding boxes of successively smaller blocks of height
+samples in front-to-back order, and only the bilinear patches in the
+remaining leaf cells are intersected exactly.
+
+The following XML snippet places a height field scaled to 5 cm with an emboss
+depth of 0.5 mm:
+
+.. code-block:: xml
+
+    <shape type="heightfield">
+        <string name="filename" value="leather_height.png"/>
+        <float name="scale" value="0.0005"/>
+        <transform name="to_world">
+            <scale x="0.025" y="0.025" z="1"/>
+        </transform>
+    </shape>
+
+Only CPU (scalar and packet) variants are supported.
+ */
+
+template <typename Float, typename Spectrum>
+class HeightField final : public Shape<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Shape, m_to_world, m_to_object, set_children,
+                    get_children_string)
+    MTS_IMPORT_TYPES()
+
+    using typename Base::ScalarSize;
+    using FloatStorage = DynamicBuffer<Float>;
+
+    HeightField(const Properties &props) : Base(props) {
+        if constexpr (is_dynamic_v<Float>)
+            Throw("The heightfield shape is only supported by CPU variants!");
+
+        auto fs = Thread::thread()->file_resolver();
+        fs::path file_path = fs->resolve(props.string("filename"));
+        m_name = file_path.filename().string();
+        m_scale = props.float_("scale", 1.f);
+        m_shading_normals = props.bool_("shading_normals", true);
+        m_flip_normals = props.bool_("flip_normals", false);
+
+        Log(Debug, "Loading height field from \"%s\" ..", m_name);
+        Timer timer;
+
+        ref<Bitmap> bitmap = new Bitmap(file_path);
+        bitmap->set_srgb_gamma(false);
+        bitmap = bitmap->convert(Bitmap::PixelFormat::Y, struct_type_v<ScalarFloat>, false);
+
+        m_resolution = ScalarVector2u(bitmap->size());
+        if (any(m_resolution < 2u))
+            Throw("Height field \"%s\" must be at least 2x2 pixels in size!", m_name);
+
+        size_t pixel_count = (size_t) m_resolution.x() * m_resolution.y();
+        m_heights = empty<FloatStorage>(pixel_count);
+        const ScalarFloat *src = (const ScalarFloat *) bitmap->data();
+        ScalarFloat *heights = m_heights.data();
+        for (size_t i = 0; i < pixel_count; ++i)
+            heights[i] = src[i] * m_scale;
+
+        build_pyramid();
+        update();
+
+        Log(Debug, "\"%s\": %ix%i height samples, %i pyramid levels (took %s)",
+            m_name, m_resolution.x(), m_resolution.y(), m_pyramid.size(),
+            util::time_string(timer.value()));
+
+        set_children();
+    }
+
+    /// Build the min/max pyramid over the bilinear patches of the height field
+    void build_pyramid() {
+        const ScalarFloat *heights = m_heights.data();
+        uint32_t width = m_resolution.x();
+
+        // Level 0: one entry per cell, i.e. per 2x2 block of height samples
+        ScalarVector2u size = m_resolution - 1u;
+        std::unique_ptr<ScalarVector2f[]> level(new ScalarVector2f[(size_t) size.x() * size.y()]);
+
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0, size.y(), 64),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t y = range.begin(); y != range.end(); ++y) {
+                    for (uint32_t x = 0; x < size.x(); ++x) {
+                        const ScalarFloat *p = heights + y * width + x;
+                        ScalarFloat h00 = p[0], h10 = p[1],
+                                    h01 = p[width], h11 = p[width + 1];
+                        level[y * size.x() + x] = ScalarVector2f(
+                            std::min(std::min(h00, h10), std::min(h01, h11)),
+                            std::max(std::max(h00, h10), std::max(h01, h11)));
+                    }
+                }
+            }
+        );
+
+        m_pyramid.clear();
+        m_level_size.clear();
+        m_pyramid.push_back(std::move(level));
+        m_level_size.push_back(size);
+
+        // Coarser levels: combine up to 2x2 entries of the previous level
+        while (any(size > 1u)) {
+            ScalarVector2u prev_size = size;
+            const ScalarVector2f *prev = m_pyramid.back().get();
+            size = (size + 1u) / 2u;
+            level.reset(new ScalarVector2f[(size_t) size.x() * size.y()]);
+
+            tbb::parallel_for(
+                tbb::blocked_range<uint32_t>(0, size.y(), 64),
+                [&](const tbb::blocked_range<uint32_t> &range) {
+                    for (uint32_t y = range.begin(); y != range.end(); ++y) {
+                        for (uint32_t x = 0; x < size.x(); ++x) {
+                            ScalarVector2f value(math::Infinity<ScalarFloat>,
+                                                 -math::Infinity<ScalarFloat>);
+                            for (uint32_t dy = 0; dy < 2; ++dy) {
+                                for (uint32_t dx = 0; dx < 2; ++dx) {
+                                    uint32_t cx = 2 * x + dx, cy = 2 * y + dy;
+                                    if (cx >= prev_size.x() || cy >= prev_size.y())
+                                        continue;
+                                    ScalarVector2f child = prev[cy * prev_size.x() + cx];
+                                    value.x() = std::min(value.x(), child.x());
+                                    value.y() = std::max(value.y(), child.y());
+                                }
+                            }
+                            level[y * size.x() + x] = value;
+                        }
+                    }
+                }
+            );
+
+            m_pyramid.push_back(std::move(level));
+            m_level_size.push_back(size);
+        }
+    }
+
+    void update() {
+        m_to_object = m_to_world.inverse();
+
+        /* Transformation from object space into "grid space", where the
+           height samples are located at integer XY coordinates */
+        m_grid_scale = ScalarVector2f(m_resolution) * .5f;
+        m_grid_offset = m_grid_scale - .5f;
+
+        // Surface area (each bilinear patch is approximated by two triangles)
+        const ScalarFloat *heights = m_heights.data();
+        uint32_t width = m_resolution.x();
+        m_surface_area = tbb::parallel_reduce(
+            tbb::blocked_range<uint32_t>(0, m_resolution.y() - 1, 64),
+            ScalarFloat(0.f),
+            [&](const tbb::blocked_range<uint32_t> &range, ScalarFloat area) {
+                for (uint32_t y = range.begin(); y != range.end(); ++y) {
+                    for (uint32_t x = 0; x < width - 1; ++x) {
+                        ScalarPoint3f p00 = grid_to_world(x,     y,     heights[y * width + x]),
+                                      p10 = grid_to_world(x + 1, y,     heights[y * width + x + 1]),
+                                      p01 = grid_to_world(x,     y + 1, heights[(y + 1) * width + x]),
+                                      p11 = grid_to_world(x + 1, y + 1, heights[(y + 1) * width + x + 1]);
+                        area += .5f * (norm(cross(p10 - p00, p11 - p00)) +
+                                       norm(cross(p11 - p00, p01 - p00)));
+                    }
+                }
+                return area;
+            },
+            [](ScalarFloat a, ScalarFloat b) { return a + b; }
+        );
+    }
+
+    ScalarBoundingBox3f bbox() const override {
+        ScalarVector2f z_range = m_pyramid.back()[0];
+        ScalarVector2f border = rcp(ScalarVector2f(m_resolution));
+
+        ScalarBoundingBox3f bbox;
+        for (int i = 0; i < 8; ++i)
+            bbox.expand(m_to_world.transform_affine(ScalarPoint3f(
+                (i & 1) ? 1.f - border.x() : border.x() - 1.f,
+                (i & 2) ? 1.f - border.y() : border.y() - 1.f,
+                (i & 4) ? z_range.y() : z_range.x())));
+        return bbox;
+    }
+
+    ScalarFloat surface_area() const override {
+        return m_surface_area;
+    }
+
+    // =============================================================
+    //! @{ \name Ray tracing routines
+    // =============================================================
+
+    PreliminaryIntersection3f ray_intersect_preliminary(const Ray3f &ray,
+                                                        Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+
+        PreliminaryIntersection3f pi = zero<PreliminaryIntersection3f>();
+        pi.t = math::Infinity<Float>;
+        pi.shape = this;
+
+        if constexpr (!is_dynamic_v<Float>) {
+            auto [hit, t, xy] = intersect<false>(ray, active);
+            pi.t = select(hit, t, math::Infinity<Float>);
+            pi.prim_uv = xy;
+        } else {
+            ENOKI_MARK_USED(ray);
+        }
+
+        return pi;
+    }
+
+    Mask ray_test(const Ray3f &ray, Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+
+        if constexpr (!is_dynamic_v<Float>) {
+            return std::get<0>(intersect<true>(ray, active));
+        } else {
+            ENOKI_MARK_USED(ray);
+            return false;
+        }
+    }
+
+    SurfaceInteraction3f compute_surface_interaction(const Ray3f &ray,
+                                                     PreliminaryIntersection3f pi,
+                                                     HitComputeFlags /*flags*/,
+                                                     Mask active) const override {
+        MTS_MASK_ARGUMENT(active);
+
+        active &= pi.is_valid();
+
+        SurfaceInteraction3f si = zero<SurfaceInteraction3f>();
+        si.t = select(active, pi.t, math::Infinity<Float>);
+        si.p = ray(pi.t);
+
+        // 'prim_uv' stores the grid space position of the intersection
+        int32_t width = (int32_t) m_resolution.x(), height = (int32_t) m_resolution.y();
+        Int32 x = clamp(floor2int<Int32>(pi.prim_uv.x()), 0, width - 2),
+              y = clamp(floor2int<Int32>(pi.prim_uv.y()), 0, height - 2);
+        Float a = clamp(pi.prim_uv.x() - Float(x), 0.f, 1.f),
+              b = clamp(pi.prim_uv.y() - Float(y), 0.f, 1.f);
+
+        Int32 index = y * width + x;
+        Float h00 = gather<Float>(m_heights, index, active),
+              h10 = gather<Float>(m_heights, index + 1, active),
+              h01 = gather<Float>(m_heights, index + width, active),
+              h11 = gather<Float>(m_heights, index + width + 1, active);
+
+        // Partial derivatives of the bilinear patch in object space
+        Float c = h00 - h10 - h01 + h11;
+        Vector3f dp_du(2.f, 0.f, fmadd(c, b, h10 - h00) * ScalarFloat(m_resolution.x())),
+                 dp_dv(0.f, 2.f, fmadd(c, a, h01 - h00) * ScalarFloat(m_resolution.y()));
+
+        si.dp_du = m_to_world.transform_affine(dp_du);
+        si.dp_dv = m_to_world.transform_affine(dp_dv);
+        si.n = normalize(m_to_world.transform_affine(Normal3f(cross(dp_du, dp_dv))));
+
+        if (m_shading_normals) {
+            // Bilinearly interpolated finite-difference gradients of the height samples
+            Vector2f grad = zero<Vector2f>();
+            for (int32_t j = 0; j < 4; ++j) {
+                Int32 cx = x + (j & 1), cy = y + (j >> 1);
+                Float weight = ((j & 1) ? a : 1.f - a) * ((j >> 1) ? b : 1.f - b);
+                Int32 x0 = max(cx - 1, 0), x1 = min(cx + 1, width - 1),
+                      y0 = max(cy - 1, 0), y1 = min(cy + 1, height - 1);
+
+                Float gx = (gather<Float>(m_heights, cy * width + x1, active) -
+                            gather<Float>(m_heights, cy * width + x0, active)) / Float(x1 - x0),
+                      gy = (gather<Float>(m_heights, y1 * width + cx, active) -
+                            gather<Float>(m_heights, y0 * width + cx, active)) / Float(y1 - y0);
+                grad += weight * Vector2f(gx, gy);
+            }
+
+            Normal3f n(-grad.x() * m_grid_scale.x(), -grad.y() * m_grid_scale.y(), 1.f);
+            si.sh_frame.n = normalize(m_to_world.transform_affine(n));
+        } else {
+            si.sh_frame.n = si.n;
+        }
+
+        if (m_flip_normals) {
+            si.n = -si.n;
+            si.sh_frame.n = -si.sh_frame.n;
+        }
+
+        si.uv = (pi.prim_uv + .5f) / ScalarVector2f(m_resolution);
+        si.dn_du = si.dn_dv = zero<Vector3f>();
+
+        return si;
+    }
+
+    //! @}
+    // =============================================================
+
+    void traverse(TraversalCallback *callback) override {
+        Base::traverse(callback);
+    }
+
+    void parameters_changed(const std::vector<std::string> &/*keys*/) override {
+        update();
+        Base::parameters_changed();
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "HeightField[" << std::endl
+            << "  name = \"" << m_name << "\"," << std::endl
+            << "  resolution = " << m_resolution << "," << std::endl
+            << "  scale = " << m_scale << "," << std::endl
+            << "  to_world = " << string::indent(m_to_world, 13) << "," << std::endl
+            << "  surface_area = " << surface_area() << "," << std::endl
+            << "  " << string::indent(get_children_string()) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+private:
+    /// Map a grid space position to world space
+    ScalarPoint3f grid_to_world(uint32_t x, uint32_t y, ScalarFloat z) const {
+        return m_to_world.transform_affine(ScalarPoint3f(
+            (x - m_grid_offset.x()) / m_grid_scale.x(),
+            (y - m_grid_offset.y()) / m_grid_scale.y(), z));
+    }
+
+    /**
+     * \brief Traverse the min/max pyramid and intersect the bilinear patches
+     * of the leaf cells
+     *
+     * Returns the hit mask, the ray distance, and the grid space XY position
+     * of the closest intersection. Shadow rays stop at the first intersection.
+     */
+    template <bool ShadowRay>
+    std::tuple<Mask, Float, Point2f> intersect(const Ray3f &ray_, Mask active) const {
+        struct StackEntry {
+            Float tnear;
+            Mask active;
+            uint32_t level, x, y;
+        };
+
+        // Transform the ray into grid space (this preserves ray distances)
+        Ray3f ray = m_to_object.transform_affine(ray_);
+        Point3f o(fmadd(ray.o.x(), m_grid_scale.x(), m_grid_offset.x()),
+                  fmadd(ray.o.y(), m_grid_scale.y(), m_grid_offset.y()),
+                  ray.o.z());
+        Vector3f d(ray.d.x() * m_grid_scale.x(), ray.d.y() * m_grid_scale.y(), ray.d.z()),
+                 d_rcp = rcp(d);
+
+        Float mint = ray.mint, maxt = ray.maxt;
+        Mask hit = false;
+        Point2f hit_xy = zero<Point2f>();
+
+        auto intersect_box = [&](uint32_t level, uint32_t x, uint32_t y, Mask active_) {
+            ScalarVector2f z_range = m_pyramid[level][y * m_level_size[level].x() + x];
+            ScalarPoint3f p_min(ScalarFloat(x << level), ScalarFloat(y << level), z_range.x()),
+                          p_max(ScalarFloat(std::min((x + 1) << level, m_resolution.x() - 1)),
+                                ScalarFloat(std::min((y + 1) << level, m_resolution.y() - 1)),
+                                z_range.y());
+
+            Vector3f t1 = (p_min - o) * d_rcp,
+                     t2 = (p_max - o) * d_rcp;
+            Float tnear = max(hmax(min(t1, t2)), mint),
+                  tfar  = min(hmin(max(t1, t2)), maxt);
+
+            return std::make_pair(tnear, active_ && tnear <= tfar);
+        };
+
+        /* Children are visited front-to-back. For a 2x2 block, this order
+           only depends on the signs of the ray direction. (For packets, the
+           order is chosen based on the average direction, which only affects
+           performance.) */
+        uint32_t near_x = hsum(d.x()) < 0.f ? 1 : 0,
+                 near_y = hsum(d.y()) < 0.f ? 1 : 0;
+        const uint32_t child_order[4][2] = {
+            { near_x, near_y }, { 1 - near_x, near_y },
+            { near_x, 1 - near_y }, { 1 - near_x, 1 - near_y }
+        };
+
+        StackEntry stack[MTS_HEIGHTFIELD_STACK_SIZE];
+        size_t stack_size = 0;
+
+        uint32_t root = (uint32_t) m_pyramid.size() - 1;
+        auto [root_tnear, root_active] = intersect_box(root, 0, 0, active);
+        if (any(root_active))
+            stack[stack_size++] = { root_tnear, root_active, root, 0, 0 };
+
+        while (stack_size > 0) {
+            StackEntry entry = stack[--stack_size];
+            Mask active_e = entry.active && entry.tnear <= maxt;
+            if constexpr (ShadowRay)
+                active_e &= !hit;
+            if (none(active_e))
+                continue;
+
+            if (entry.level > 0) {
+                // Push the children in reverse order so that the nearest one is processed first
+                uint32_t level = entry.level - 1;
+                for (int i = 3; i >= 0; --i) {
+                    uint32_t x = 2 * entry.x + child_order[i][0],
+                             y = 2 * entry.y + child_order[i][1];
+                    if (x >= m_level_size[level].x() || y >= m_level_size[level].y())
+                        continue;
+
+                    auto [tnear, active_c] = intersect_box(level, x, y, active_e);
+                    if (any(active_c)) {
+                        Assert(stack_size < MTS_HEIGHTFIELD_STACK_SIZE);
+                        stack[stack_size++] = { tnear, active_c, level, x, y };
+                    }
+                }
+            } else {
+                auto [found, t, xy] = intersect_patch(o, d, mint, maxt, entry.x, entry.y, active_e);
+                maxt = select(found, t, maxt);
+                hit_xy = select(found, xy, hit_xy);
+                hit |= found;
+            }
+        }
+
+        return { hit, maxt, hit_xy };
+    }
+
+    /// Intersect the bilinear patch of grid cell (x, y) in grid space
+    std::tuple<Mask, Float, Point2f> intersect_patch(const Point3f &o, const Vector3f &d,
+                                                     const Float &mint, const Float &maxt,
+                                                     uint32_t x, uint32_t y, Mask active) const {
+        const ScalarFloat *p = m_heights.data() + y * m_resolution.x() + x;
+        ScalarFloat h00 = p[0], h10 = p[1],
+                    h01 = p[m_resolution.x()], h11 = p[m_resolution.x() + 1];
+        ScalarFloat ca = h10 - h00, cb = h01 - h00, cc = h00 - h10 - h01 + h11;
+
+        /* Substitute the ray into h(a, b) - z = 0, where (a, b) are the cell
+           coordinates and h is the bilinear interpolant of the heights */
+        Float a0 = o.x() - ScalarFloat(x), b0 = o.y() - ScalarFloat(y);
+        Float qa = cc * d.x() * d.y(),
+              qb = fmadd(ca, d.x(), fmadd(cb, d.y(), fmadd(cc, fmadd(a0, d.y(), b0 * d.x()), -d.z()))),
+              qc = fmadd(ca, a0, fmadd(cb, b0, fmadd(cc, a0 * b0, h00 - o.z())));
+
+        Mask linear = eq(qa, 0.f);
+        Float discrim = fmsub(qb, qb, 4.f * qa * qc);
+        active &= select(linear, neq(qb, 0.f), discrim >= 0.f);
+
+        Float temp = -.5f * (qb + copysign(sqrt(max(discrim, 0.f)), qb)),
+              x0 = select(linear, -qc / qb, temp / qa),
+              x1 = select(linear, x0, qc / temp);
+
+        Float t0 = min(x0, x1), t1 = max(x0, x1);
+
+        const ScalarFloat eps = 1e-4f;
+        auto valid = [&](const Float &t) {
+            Float a = fmadd(d.x(), t, a0), b = fmadd(d.y(), t, b0);
+            return active && t >= mint && t <= maxt &&
+                   a >= -eps && a <= 1.f + eps && b >= -eps && b <= 1.f + eps;
+        };
+
+        Mask valid0 = valid(t0), valid1 = valid(t1);
+        Float t = select(valid0, t0, t1);
+        Point2f xy(fmadd(d.x(), t, o.x()), fmadd(d.y(), t, o.y()));
+
+        return { valid0 || valid1, t, xy };
+    }
+
+    std::string m_name;
+    ScalarVector2u m_resolution;
+    ScalarFloat m_scale;
+    bool m_shading_normals;
+    bool m_flip_normals;
+
+    /// Height samples (scaled), stored row by row
+    FloatStorage m_heights;
+
+    /// Min/max height per pyramid node, starting with the finest level
+    std::vector<std::unique_ptr<ScalarVector2f[]>> m_pyramid;
+    std::vector<ScalarVector2u> m_level_size;
+
+    ScalarVector2f m_grid_scale, m_grid_offset;
+    ScalarFloat m_surface_area;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(HeightField, Shape)
+MTS_EXPORT_PLUGIN(HeightField, "Height field intersection primitive");
+NAMESPACE_END(mitsuba)
@@ -1,9 +1,13 @@
 #include <mitsuba/render/mesh.h>
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/hash.h>
 #include <mitsuba/core/mmap.h>
+#include <mitsuba/core/string.h>
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/timer.h>
+#include <tbb/tbb.h>
+#include <tbb/concurrent_hash_map.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -27,6 +31,13 @@ Wavefront OBJ mesh loader (:monosp:`obj`)
  * - flip_tex_coords
    - |bool|
    - Treat the vertical component of the texture as inverted? Most OBJ files use this convention. (Default: |true|)
+ * - compact
+   - |bool|
+   - When set to |true|, vertex positions, normals and texture coordinates are
+     quantized after loading (positions to 21-22 bit per component, normals to
+     a 32-bit octahedral encoding, texture coordinates to 16 bit per component),
+     which cuts the vertex memory footprint in half. The mesh cannot be modified
+     afterwards. Only supported by CPU variants. (Default: |false|)
  * - to_world
    - |transform|
    - Specifies an optional linear object-to-world transformation.
@@ -77,7 +88,7 @@ public:
     MTS_IMPORT_BASE(Mesh, m_name, m_bbox, m_to_world, m_vertex_count, m_face_count,
                     m_vertex_positions_buf, m_vertex_normals_buf, m_vertex_texcoords_buf,
                     m_faces_buf, m_disable_vertex_normals, recompute_vertex_normals,
-                    has_vertex_normals, set_children)
+                    has_vertex_normals, m_compact_storage, compact_vertex_data, set_children)
     MTS_IMPORT_TYPES()
 
     using typename Base::ScalarSize;
@@ -89,11 +100,35 @@ public:
     using typename Base::InputNormal3f;
     using typename Base::FloatStorage;
 
-    InputFloat strtof(const char *nptr, char **endptr) {
-            return std::strtof(nptr, endptr);
-    }
+    using ScalarIndex3 = std::array<ScalarIndex, 3>;
+
+    /// Contents of a contiguous range of lines of the OBJ file
+    struct Chunk {
+        std::vector<InputVector3f> vertices;
+        std::vector<InputNormal3f> normals;
+        std::vector<InputVector2f> texcoords;
+        /// (position, texcoord, normal) index triplets of all triangle corners
+        std::vector<ScalarIndex3> corners;
+        ScalarBoundingBox3f bbox;
+    };
+
+    struct IndexHashCompare {
+        static size_t hash(const ScalarIndex3 &key) {
+            return hash_combine(hash_combine(mitsuba::hash(key[0]), mitsuba::hash(key[1])),
+                                mitsuba::hash(key[2]));
+        }
+
+        static bool equal(const ScalarIndex3 &a, const ScalarIndex3 &b) { return a == b; }
+    };
+
+    using VertexMap = tbb::concurrent_hash_map<ScalarIndex3, ScalarIndex, IndexHashCompare>;
 
     OBJMesh(const Properties &props) : Base(props) {
+        /// Parse the file in chunks of (approximately) 4 MiB
+        constexpr size_t chunk_size = 4 * 1024 * 1024;
+        /// Granularity of the parallel passes over triangle corners
+        constexpr size_t block_size = 64 * 1024;
+
         /* Causes all texture coordinates to be vertically flipped.
            Enabled by default, for consistence with the Mitsuba 1 behavior. */
         bool flip_tex_coords = props.bool_("flip_tex_coords", true);
@@ -113,40 +148,212 @@ public:
             fail("file not found");
 
         ref<MemoryMappedFile> mmap = new MemoryMappedFile(file_path);
+        const char *data = (const char *) mmap->data();
+        const char *eof = data + mmap->size();
+        Timer timer;
+
+        // Split the file into chunks starting at line boundaries
+        size_t chunk_count = (mmap->size() + chunk_size - 1) / chunk_size;
+        std::vector<const char *> chunk_start(chunk_count + 1, eof);
+        if (chunk_count > 0)
+            chunk_start[0] = data;
+        for (size_t i = 1; i < chunk_count; ++i) {
+            const char *ptr = std::max(data + i * chunk_size, chunk_start[i - 1]);
+            while (ptr < eof && ptr[-1] != '\n')
+                ++ptr;
+            chunk_start[i] = ptr;
+        }
 
-        using ScalarIndex3 = std::array<ScalarIndex, 3>;
+        // Parse all chunks in parallel
+        std::vector<Chunk> chunks(chunk_count);
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, chunk_count, 1),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i)
+                    parse_chunk(chunk_start[i], chunk_start[i + 1], chunks[i],
+                                flip_tex_coords, fail);
+            }
+        );
+
+        // Concatenate the per-chunk vertex data
+        std::vector<size_t> vertex_offset(chunk_count + 1, 0),
+                            normal_offset(chunk_count + 1, 0),
+                            texcoord_offset(chunk_count + 1, 0),
+                            corner_offset(chunk_count + 1, 0);
+
+        for (size_t i = 0; i < chunk_count; ++i) {
+            vertex_offset[i + 1]   = vertex_offset[i]   + chunks[i].vertices.size();
+            normal_offset[i + 1]   = normal_offset[i]   + chunks[i].normals.size();
+            texcoord_offset[i + 1] = texcoord_offset[i] + chunks[i].texcoords.size();
+            corner_offset[i + 1]   = corner_offset[i]   + chunks[i].corners.size();
+            m_bbox.expand(chunks[i].bbox);
+        }
 
-        struct VertexBinding {
-            ScalarIndex3 key {{ 0, 0, 0 }};
-            ScalarIndex value { 0 };
-            VertexBinding *next { nullptr };
+        std::vector<InputVector3f> vertices(vertex_offset.back());
+        std::vector<InputNormal3f> normals(normal_offset.back());
+        std::vector<InputVector2f> texcoords(texcoord_offset.back());
+        std::vector<ScalarIndex3> corners(corner_offset.back());
+
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, chunk_count, 1),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    Chunk &chunk = chunks[i];
+                    std::copy(chunk.vertices.begin(), chunk.vertices.end(),
+                              vertices.begin() + vertex_offset[i]);
+                    std::copy(chunk.normals.begin(), chunk.normals.end(),
+                              normals.begin() + normal_offset[i]);
+                    std::copy(chunk.texcoords.begin(), chunk.texcoords.end(),
+                              texcoords.begin() + texcoord_offset[i]);
+                    std::copy(chunk.corners.begin(), chunk.corners.end(),
+                              corners.begin() + corner_offset[i]);
+                    chunk = Chunk();
+                }
+            }
+        );
+
+        size_t corner_count = corners.size(),
+               block_count  = (corner_count + block_size - 1) / block_size;
+
+        /* Vertex deduplication. To produce exactly the same vertex order as a
+           serial implementation, the unique (position, texcoord, normal)
+           triplets are numbered in the order of their first occurrence:
+
+           1. Determine the first corner referencing every unique triplet
+           2. Count the first occurrences within each block of corners
+           3. Assign consecutive vertex indices to first occurrences
+           4. Resolve the vertex index of every corner */
+        VertexMap vertex_map(vertices.size());
+        std::vector<ScalarIndex> first(corner_count), vertex_id(corner_count);
+        std::vector<ScalarSize> block_vertex_offset(block_count + 1, 0);
+
+        auto parallel_for_blocks = [&](auto func) {
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, block_count, 1),
+                [&](const tbb::blocked_range<size_t> &range) {
+                    for (size_t i = range.begin(); i != range.end(); ++i)
+                        func(i, i * block_size, std::min((i + 1) * block_size, corner_count));
+                }
+            );
         };
 
-        /// Temporary buffers for vertices, normals, and texture coordinates
-        std::vector<InputVector3f> vertices;
-        std::vector<InputNormal3f> normals;
-        std::vector<InputVector2f> texcoords;
-        std::vector<ScalarIndex3> triangles;
-        std::vector<VertexBinding> vertex_map;
+        parallel_for_blocks([&](size_t, size_t start, size_t end) {
+            for (size_t j = start; j < end; ++j) {
+                const ScalarIndex3 &key = corners[j];
+                if (unlikely(key[0] == 0 || key[0] > vertices.size()))
+                    fail("reference to invalid vertex %i!", key[0]);
+                if (unlikely(key[1] > texcoords.size()))
+                    fail("reference to invalid texture coordinate %i!", key[1]);
+                if (unlikely(!m_disable_vertex_normals && key[2] > normals.size()))
+                    fail("reference to invalid normal %i!", key[2]);
+
+                typename VertexMap::accessor acc;
+                if (vertex_map.insert(acc, key))
+                    acc->second = (ScalarIndex) j;
+                else
+                    acc->second = std::min(acc->second, (ScalarIndex) j);
+            }
+        });
+
+        parallel_for_blocks([&](size_t i, size_t start, size_t end) {
+            ScalarSize count = 0;
+            for (size_t j = start; j < end; ++j) {
+                typename VertexMap::const_accessor acc;
+                vertex_map.find(acc, corners[j]);
+                first[j] = acc->second;
+                count += first[j] == j;
+            }
+            block_vertex_offset[i + 1] = count;
+        });
 
-        size_t vertex_guess = mmap->size() / 100;
-        vertices.reserve(vertex_guess);
-        normals.reserve(vertex_guess);
-        texcoords.reserve(vertex_guess);
-        triangles.reserve(vertex_guess * 2);
-        vertex_map.resize(vertex_guess);
+        vertex_map.clear();
+        for (size_t i = 0; i < block_count; ++i)
+            block_vertex_offset[i + 1] += block_vertex_offset[i];
 
-        ScalarIndex vertex_ctr = 0;
+        m_vertex_count = block_vertex_offset.back();
+        m_face_count = (ScalarSize) (corner_count / 3);
+
+        m_faces_buf = empty<DynamicBuffer<UInt32>>(m_face_count * 3);
+        m_vertex_positions_buf = empty<FloatStorage>(m_vertex_count * 3);
+        if (!m_disable_vertex_normals)
+            m_vertex_normals_buf = empty<FloatStorage>(m_vertex_count * 3);
+        if (!texcoords.empty())
+            m_vertex_texcoords_buf = empty<FloatStorage>(m_vertex_count * 2);
+
+        // TODO this is needed for the bbox(..) methods, but is it slower?
+        m_faces_buf.managed();
+        m_vertex_positions_buf.managed();
+        m_vertex_normals_buf.managed();
+        m_vertex_texcoords_buf.managed();
+
+        if constexpr (is_cuda_array_v<Float>)
+            cuda_sync();
+
+        parallel_for_blocks([&](size_t i, size_t start, size_t end) {
+            ScalarIndex id = block_vertex_offset[i];
+            for (size_t j = start; j < end; ++j) {
+                if (first[j] != j)
+                    continue;
+
+                InputFloat* position_ptr = m_vertex_positions_buf.data() + id * 3;
+                InputFloat* normal_ptr   = m_vertex_normals_buf.data() + id * 3;
+                InputFloat* texcoord_ptr = m_vertex_texcoords_buf.data() + id * 2;
+                const ScalarIndex3 &key = corners[j];
+
+                store_unaligned(position_ptr, vertices[key[0] - 1]);
+
+                if (key[1])
+                    store_unaligned(texcoord_ptr, texcoords[key[1] - 1]);
+
+                if (!m_disable_vertex_normals && key[2])
+                    store_unaligned(normal_ptr, normals[key[2] - 1]);
+
+                vertex_id[j] = id++;
+            }
+        });
+
+        parallel_for_blocks([&](size_t, size_t start, size_t end) {
+            ScalarIndex *face_ptr = m_faces_buf.data();
+            for (size_t j = start; j < end; ++j)
+                face_ptr[j] = vertex_id[first[j]];
+        });
+
+        size_t vertex_data_bytes = 3 * sizeof(InputFloat);
+        if (has_vertex_normals())
+            vertex_data_bytes += 3 * sizeof(InputFloat);
+        if (!texcoords.empty())
+            vertex_data_bytes += 2 * sizeof(InputFloat);
+
+        Log(Debug, "\"%s\": read %i faces, %i vertices (%s in %s)",
+            m_name, m_face_count, m_vertex_count,
+            util::mem_string(m_face_count * 3 * sizeof(ScalarIndex) +
+                             m_vertex_count * vertex_data_bytes),
+            util::time_string(timer.value())
+        );
 
-        const char *ptr = (const char *) mmap->data();
-        const char *eof = ptr + mmap->size();
+        if (!m_disable_vertex_normals && normals.empty()) {
+            Timer timer2;
+            recompute_vertex_normals();
+            Log(Debug, "\"%s\": computed vertex normals (took %s)", m_name,
+                util::time_string(timer2.value()));
+        }
+
+        if (m_compact_storage)
+            compact_vertex_data();
+
+        set_children();
+    }
+
+    /// Parse the lines in <tt>[ptr, end)</tt> and append their contents to \c chunk
+    template <typename Fail>
+    void parse_chunk(const char *ptr, const char *end, Chunk &chunk,
+                     bool flip_tex_coords, const Fail &fail) {
         char buf[1025];
-        Timer timer;
 
-        while (ptr < eof) {
+        while (ptr < end) {
             // Determine the offset of the next newline
             const char *next = ptr;
-            advance<false>(&next, eof, "\n");
+            advance<false>(&next, end, "\n");
 
             // Copy buf into a 0-terminated buffer
             size_t size = next - ptr;
@@ -166,47 +373,47 @@ public:
                 cur += 2;
                 for (size_t i = 0; i < 3; ++i) {
                     const char *orig = cur;
-                    p[i] = strtof(cur, (char **) &cur);
+                    p[i] = string::strtof<InputFloat>(cur, (char **) &cur);
                     parse_error |= cur == orig;
                 }
                 p = m_to_world.transform_affine(p);
                 if (unlikely(!all(enoki::isfinite(p))))
                     fail("mesh contains invalid vertex position data");
-                m_bbox.expand(p);
-                vertices.push_back(p);
+                chunk.bbox.expand(p);
+                chunk.vertices.push_back(p);
             } else if (cur[0] == 'v' && cur[1] == 'n' && (cur[2] == ' ' || cur[2] == '\t')) {
                 // Vertex normal
                 InputNormal3f n;
                 cur += 3;
                 for (size_t i = 0; i < 3; ++i) {
                     const char *orig = cur;
-                    n[i] = strtof(cur, (char **) &cur);
+                    n[i] = string::strtof<InputFloat>(cur, (char **) &cur);
                     parse_error |= cur == orig;
                 }
                 n = normalize(m_to_world.transform_affine(n));
                 if (unlikely(!all(enoki::isfinite(n))))
                     fail("mesh contains invalid vertex normal data");
-                normals.push_back(n);
+                chunk.normals.push_back(n);
             } else if (cur[0] == 'v' && cur[1] == 't' && (cur[2] == ' ' || cur[2] == '\t')) {
                 // Texture coordinate
                 InputVector2f uv;
                 cur += 3;
                 for (size_t i = 0; i < 2; ++i) {
                     const char *orig = cur;
-                    uv[i] = strtof(cur, (char **) &cur);
+                    uv[i] = string::strtof<InputFloat>(cur, (char **) &cur);
                     parse_error |= cur == orig;
                 }
                 if (flip_tex_coords)
                     uv.y() = 1.f - uv.y();
 
-                texcoords.push_back(uv);
+                chunk.texcoords.push_back(uv);
             } else if (cur[0] == 'f' && (cur[1] == ' ' || cur[1] == '\t')) {
                 // Face specification
                 cur += 2;
                 size_t vertex_index = 0;
                 size_t type_index = 0;
                 ScalarIndex3 key {{ (ScalarIndex) 0, (ScalarIndex) 0, (ScalarIndex) 0 }};
-                ScalarIndex3 tri;
+                ScalarIndex3 tri[3];
 
                 while (true) {
                     const char *next2;
@@ -228,42 +435,18 @@ public:
 
                     if (*next2 == ' ' || *next2 == '\t' || *next2 == '\0' || *next2 == '\r') {
                         type_index = 0;
-                        size_t map_index = key[0] - 1;
-
-                        if (unlikely(map_index >= vertices.size()))
-                            fail("reference to invalid vertex %i!", key[0]);
-                        if (unlikely(vertex_map.size() < vertices.size()))
-                            vertex_map.resize(vertices.size());
-
-                        // Hash table lookup
-                        VertexBinding *entry = &vertex_map[map_index];
-                        while (entry->key != key && entry->next != nullptr)
-                            entry = entry->next;
-
-                        ScalarIndex id;
-                        if (entry->key == key) {
-                            // Hit
-                            id = entry->value;
-                        } else {
-                            // Miss
-                            if (entry->key != ScalarIndex3{{0, 0, 0}}) {
-                                entry->next = new VertexBinding();
-                                entry = entry->next;
-                            }
-                            entry->key = key;
-                            id = entry->value = vertex_ctr++;
-                        }
 
+                        // Polygons are triangulated as a fan around the first vertex
                         if (vertex_index < 3) {
-                            tri[vertex_index] = id;
+                            tri[vertex_index] = key;
                         } else {
                             tri[1] = tri[2];
-                            tri[2] = id;
+                            tri[2] = key;
                         }
                         vertex_index++;
 
                         if (vertex_index >= 3)
-                            triangles.push_back(tri);
+                            chunk.corners.insert(chunk.corners.end(), tri, tri + 3);
                     }
 
                     cur = next2;
@@ -274,76 +457,6 @@ public:
                 fail("could not parse line \"%s\"", buf);
             ptr = next + 1;
         }
-
-        m_vertex_count = vertex_ctr;
-        m_face_count = (ScalarSize) triangles.size();
-
-        m_faces_buf = DynamicBuffer<UInt32>::copy(triangles.data(), m_face_count * 3);
-        m_vertex_positions_buf = empty<FloatStorage>(m_vertex_count * 3);
-        if (!m_disable_vertex_normals)
-            m_vertex_normals_buf = empty<FloatStorage>(m_vertex_count * 3);
-        if (!texcoords.empty())
-            m_vertex_texcoords_buf = empty<FloatStorage>(m_vertex_count * 2);
-
-        // TODO this is needed for the bbox(..) methods, but is it slower?
-        m_faces_buf.managed();
-        m_vertex_positions_buf.managed();
-        m_vertex_normals_buf.managed();
-        m_vertex_texcoords_buf.managed();
-
-        if constexpr (is_cuda_array_v<Float>)
-            cuda_sync();
-
-        for (const auto& v_ : vertex_map) {
-            const VertexBinding *v = &v_;
-
-            while (v && v->key != ScalarIndex3{{0, 0, 0}}) {
-                InputFloat* position_ptr   = m_vertex_positions_buf.data() + v->value * 3;
-                InputFloat* normal_ptr   = m_vertex_normals_buf.data() + v->value * 3;
-                InputFloat* texcoord_ptr = m_vertex_texcoords_buf.data() + v->value * 2;
-                auto key = v->key;
-
-                store_unaligned(position_ptr, vertices[key[0] - 1]);
-
-                if (key[1]) {
-                    size_t map_index = key[1] - 1;
-                    if (unlikely(map_index >= texcoords.size()))
-                        fail("reference to invalid texture coordinate %i!", key[1]);
-                    store_unaligned(texcoord_ptr, texcoords[map_index]);
-                }
-
-                if (!m_disable_vertex_normals && key[2]) {
-                    size_t map_index = key[2] - 1;
-                    if (unlikely(map_index >= normals.size()))
-                        fail("reference to invalid normal %i!", key[2]);
-                    store_unaligned(normal_ptr, normals[key[2] - 1]);
-                }
-
-                v = v->next;
-            }
-        }
-
-        size_t vertex_data_bytes = 3 * sizeof(InputFloat);
-        if (has_vertex_normals())
-            vertex_data_bytes += 3 * sizeof(InputFloat);
-        if (!texcoords.empty())
-            vertex_data_bytes += 2 * sizeof(InputFloat);
-
-        Log(Debug, "\"%s\": read %i faces, %i vertices (%s in %s)",
-            m_name, m_face_count, m_vertex_count,
-            util::mem_string(m_face_count * 3 * sizeof(ScalarIndex) +
-                             m_vertex_count * vertex_data_bytes),
-            util::time_string(timer.value())
-        );
-
-        if (!m_disable_vertex_normals && normals.empty()) {
-            Timer timer2;
-            recompute_vertex_normals();
-            Log(Debug, "\"%s\": computed vertex normals (took %s)", m_name,
-                util::time_string(timer2.value()));
-        }
-
-        set_children();
     }
 
     MTS_DECLARE_CLASS()
@@ -1,14 +1,15 @@
 #include <mitsuba/render/mesh.h>
 #include <mitsuba/core/fstream.h>
-#include <mitsuba/core/mstream.h>
 #include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/mmap.h>
 #include <mitsuba/core/properties.h>
+#include <mitsuba/core/string.h>
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/timer.h>
 #include <enoki/half.h>
+#include <tbb/tbb.h>
 #include <unordered_map>
 #include <unordered_set>
-#include <fstream>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -29,6 +30,13 @@ PLY (Stanford Triangle Format) mesh loader (:monosp:`ply`)
    - When set to |true|, any existing or computed vertex normals are
      discarded and *face normals* will instead be used during rendering.
      This gives the rendered object a faceted appearance. (Default: |false|)
+ * - compact
+   - |bool|
+   - When set to |true|, vertex positions, normals and texture coordinates are
+     quantized after loading (positions to 21-22 bit per component, normals to
+     a 32-bit octahedral encoding, texture coordinates to 16 bit per component),
+     which cuts the vertex memory footprint in half. The mesh cannot be modified
+     afterwards. Only supported by CPU variants. (Default: |false|)
  * - to_world
    - |transform|
    - Specifies an optional linear object-to-world transformation.
@@ -69,7 +77,8 @@ public:
     MTS_IMPORT_BASE(Mesh, m_name, m_bbox, m_to_world, m_vertex_count, m_face_count,
                     m_vertex_positions_buf, m_vertex_normals_buf, m_vertex_texcoords_buf,
                     m_faces_buf, add_attribute, m_disable_vertex_normals, has_vertex_normals,
-                    has_vertex_texcoords, recompute_vertex_normals, set_children)
+                    has_vertex_texcoords, recompute_vertex_normals, m_compact_storage,
+                    compact_vertex_data, set_children)
     MTS_IMPORT_TYPES()
 
     using typename Base::ScalarSize;
@@ -116,24 +125,47 @@ public:
         if (!fs::exists(file_path))
             fail("file not found");
 
-        ref<Stream> stream = new FileStream(file_path);
         Timer timer;
 
         PLYHeader header;
+        size_t header_size = 0;
         try {
+            ref<Stream> stream = new FileStream(file_path);
             header = parse_ply_header(stream);
-            if (header.ascii) {
-                if (stream->size() > 100 * 1024)
-                    Log(Warn,
-                        "\"%s\": performance warning -- this file uses the ASCII PLY format, which "
-                        "is slow to parse. Consider converting it to the binary PLY format.",
-                        m_name);
-                stream = parse_ascii((FileStream *) stream.get(), header.elements);
-            }
+            header_size = stream->tell();
         } catch (const std::exception &e) {
             fail(e.what());
         }
 
+        /* The element data is converted in parallel straight from a memory
+           mapping of the file into the final mesh buffers */
+        ref<MemoryMappedFile> mmap = new MemoryMappedFile(file_path);
+        const uint8_t *data     = (const uint8_t *) mmap->data() + header_size,
+                      *data_end = (const uint8_t *) mmap->data() + mmap->size();
+
+        std::unique_ptr<uint8_t[]> ascii_data;
+        if (header.ascii) {
+            if (mmap->size() > 100 * 1024)
+                Log(Warn,
+                    "\"%s\": performance warning -- this file uses the ASCII PLY format, which "
+                    "is slow to parse. Consider converting it to the binary PLY format.",
+                    m_name);
+            try {
+                size_t size = 0;
+                ascii_data = parse_ascii((const char *) data, (const char *) data_end,
+                                         header.elements, size);
+                data = ascii_data.get();
+                data_end = data + size;
+            } catch (const std::exception &e) {
+                fail(e.what());
+            }
+        }
+
+        auto check_size = [&](const PLYElement &el) {
+            if ((size_t) (data_end - data) < el.struct_->size() * el.count)
+                fail("unexpected end of file");
+        };
+
         bool has_vertex_normals = false;
         bool has_vertex_texcoords = false;
 
@@ -210,70 +242,76 @@ public:
                 if constexpr (is_cuda_array_v<Float>)
                     cuda_sync();
 
-                size_t packet_count     = el.count / elements_per_packet;
-                size_t remainder_count  = el.count % elements_per_packet;
-                size_t i_packet_size    = i_struct_size * elements_per_packet;
-                size_t i_remainder_size = i_struct_size * remainder_count;
-                size_t o_packet_size    = o_struct_size * elements_per_packet;
-
-                std::unique_ptr<uint8_t[]> buf(new uint8_t[i_packet_size]);
-                std::unique_ptr<uint8_t[]> buf_o(new uint8_t[o_packet_size]);
-
-                InputFloat* position_ptr = m_vertex_positions_buf.data();
-                InputFloat* normal_ptr   = m_vertex_normals_buf.data();
-                InputFloat* texcoord_ptr = m_vertex_texcoords_buf.data();
-
-                for (size_t i = 0; i <= packet_count; ++i) {
-                    uint8_t *target = (uint8_t *) buf_o.get();
-                    size_t psize = (i != packet_count) ? i_packet_size : i_remainder_size;
-                    size_t count = (i != packet_count) ? elements_per_packet : remainder_count;
-                    stream->read(buf.get(), psize);
-                    if (unlikely(!conv->convert(count, buf.get(), buf_o.get())))
-                        fail("incompatible contents -- is this a triangle mesh?");
-
-                    for (size_t j = 0; j < count; ++j) {
-                        InputPoint3f p = enoki::load<InputPoint3f>(target);
-                        p = m_to_world.transform_affine(p);
-                        if (unlikely(!all(enoki::isfinite(p))))
-                            fail("mesh contains invalid vertex positions/normal data");
-                        m_bbox.expand(p);
-                        store_unaligned(position_ptr, p);
-                        position_ptr += 3;
-
-                        if (has_vertex_normals) {
-                            InputNormal3f n = enoki::load<InputNormal3f>(
-                                target + sizeof(InputFloat) * 3);
-                            n = normalize(m_to_world.transform_affine(n));
-                            store_unaligned(normal_ptr, n);
-                            normal_ptr += 3;
-                        }
-
-                        if (has_vertex_texcoords) {
-                            InputVector2f uv = enoki::load<InputVector2f>(
-                                target + (m_disable_vertex_normals
-                                              ? sizeof(InputFloat) * 3
-                                              : sizeof(InputFloat) * 6));
-                            store_unaligned(texcoord_ptr, uv);
-                            texcoord_ptr += 2;
-                        }
-
-                        size_t target_offset =
-                            sizeof(InputFloat) *
-                            (!m_disable_vertex_normals
-                                 ? (has_vertex_texcoords ? 8 : 6)
-                                 : (has_vertex_texcoords ? 5 : 3));
-
-                        for (size_t k = 0; k < vertex_attributes_descriptors.size(); ++k) {
-                            auto& descr = vertex_attributes_descriptors[k];
-                            memcpy(descr.buf.data() + (i * elements_per_packet + j) * descr.dim,
-                                   target + target_offset,
-                                   descr.dim * sizeof(InputFloat));
-                            target_offset += descr.dim * sizeof(InputFloat);
+                size_t packet_count = (el.count + elements_per_packet - 1) / elements_per_packet;
+                check_size(el);
+
+                tbb::spin_mutex bbox_mutex;
+                tbb::parallel_for(
+                    tbb::blocked_range<size_t>(0, packet_count, 1),
+                    [&](const tbb::blocked_range<size_t> &range) {
+                        std::unique_ptr<uint8_t[]> buf_o(new uint8_t[o_struct_size * elements_per_packet]);
+                        ScalarBoundingBox3f bbox;
+
+                        for (size_t i = range.begin(); i != range.end(); ++i) {
+                            uint8_t *target = (uint8_t *) buf_o.get();
+                            size_t offset = i * elements_per_packet;
+                            size_t count = std::min(elements_per_packet, el.count - offset);
+                            if (unlikely(!conv->convert(count, data + offset * i_struct_size, buf_o.get())))
+                                fail("incompatible contents -- is this a triangle mesh?");
+
+                            InputFloat* position_ptr = m_vertex_positions_buf.data() + offset * 3;
+                            InputFloat* normal_ptr   = m_vertex_normals_buf.data() + offset * 3;
+                            InputFloat* texcoord_ptr = m_vertex_texcoords_buf.data() + offset * 2;
+
+                            for (size_t j = 0; j < count; ++j) {
+                                InputPoint3f p = enoki::load<InputPoint3f>(target);
+                                p = m_to_world.transform_affine(p);
+                                if (unlikely(!all(enoki::isfinite(p))))
+                                    fail("mesh contains invalid vertex positions/normal data");
+                                bbox.expand(p);
+                                store_unaligned(position_ptr, p);
+                                position_ptr += 3;
+
+                                if (has_vertex_normals) {
+                                    InputNormal3f n = enoki::load<InputNormal3f>(
+                                        target + sizeof(InputFloat) * 3);
+                                    n = normalize(m_to_world.transform_affine(n));
+                                    store_unaligned(normal_ptr, n);
+                                    normal_ptr += 3;
+                                }
+
+                                if (has_vertex_texcoords) {
+                                    InputVector2f uv = enoki::load<InputVector2f>(
+                                        target + (m_disable_vertex_normals
+                                                      ? sizeof(InputFloat) * 3
+                                                      : sizeof(InputFloat) * 6));
+                                    store_unaligned(texcoord_ptr, uv);
+                                    texcoord_ptr += 2;
+                                }
+
+                                size_t target_offset =
+                                    sizeof(InputFloat) *
+                                    (!m_disable_vertex_normals
+                                         ? (has_vertex_texcoords ? 8 : 6)
+                                         : (has_vertex_texcoords ? 5 : 3));
+
+                                for (size_t k = 0; k < vertex_attributes_descriptors.size(); ++k) {
+                                    auto& descr = vertex_attributes_descriptors[k];
+                                    memcpy(descr.buf.data() + (offset + j) * descr.dim,
+                                           target + target_offset,
+                                           descr.dim * sizeof(InputFloat));
+                                    target_offset += descr.dim * sizeof(InputFloat);
+                                }
+
+                                target += o_struct_size;
+                            }
                         }
 
-                        target += o_struct_size;
+                        std::lock_guard<tbb::spin_mutex> lock(bbox_mutex);
+                        m_bbox.expand(bbox);
                     }
-                }
+                );
+                data += i_struct_size * el.count;
 
                 for (auto& descr: vertex_attributes_descriptors) {
                     add_attribute(descr.name, descr.dim, descr.buf);
@@ -319,54 +357,56 @@ public:
                     descr.buf.managed();
                 }
 
-                ScalarIndex* face_ptr = m_faces_buf.data();
-
-                size_t packet_count     = el.count / elements_per_packet;
-                size_t remainder_count  = el.count % elements_per_packet;
-                size_t i_packet_size    = i_struct_size * elements_per_packet;
-                size_t i_remainder_size = i_struct_size * remainder_count;
-                size_t o_packet_size    = o_struct_size * elements_per_packet;
-
-                std::unique_ptr<uint8_t[]> buf(new uint8_t[i_packet_size]);
-                std::unique_ptr<uint8_t[]> buf_o(new uint8_t[o_packet_size]);
-
-                for (size_t i = 0; i <= packet_count; ++i) {
-                    uint8_t *target = (uint8_t *) buf_o.get();
-                    size_t psize = (i != packet_count) ? i_packet_size : i_remainder_size;
-                    size_t count = (i != packet_count) ? elements_per_packet : remainder_count;
-
-                    stream->read(buf.get(), psize);
-                    if (unlikely(!conv->convert(count, buf.get(), buf_o.get())))
-                        fail("incompatible contents -- is this a triangle mesh?");
-
-                    for (size_t j = 0; j < count; ++j) {
-                        ScalarIndex3 fi = enoki::load<ScalarIndex3>(target);
-                        store_unaligned(face_ptr, fi);
-                        face_ptr += 3;
-
-                        size_t target_offset = sizeof(InputFloat) * 3;
-                        for (size_t k = 0; k < face_attributes_descriptors.size(); ++k) {
-                            auto& descr = face_attributes_descriptors[k];
-                            memcpy(descr.buf.data() + (i * elements_per_packet + j) * descr.dim,
-                                   target + target_offset,
-                                   descr.dim * sizeof(InputFloat));
-                            target_offset += descr.dim * sizeof(InputFloat);
-                        }
+                size_t packet_count = (el.count + elements_per_packet - 1) / elements_per_packet;
+                check_size(el);
+
+                tbb::parallel_for(
+                    tbb::blocked_range<size_t>(0, packet_count, 1),
+                    [&](const tbb::blocked_range<size_t> &range) {
+                        std::unique_ptr<uint8_t[]> buf_o(new uint8_t[o_struct_size * elements_per_packet]);
+
+                        for (size_t i = range.begin(); i != range.end(); ++i) {
+                            uint8_t *target = (uint8_t *) buf_o.get();
+                            size_t offset = i * elements_per_packet;
+                            size_t count = std::min(elements_per_packet, el.count - offset);
+
+                            if (unlikely(!conv->convert(count, data + offset * i_struct_size, buf_o.get())))
+                                fail("incompatible contents -- is this a triangle mesh?");
+
+                            ScalarIndex* face_ptr = m_faces_buf.data() + offset * 3;
 
-                        target += o_struct_size;
+                            for (size_t j = 0; j < count; ++j) {
+                                ScalarIndex3 fi = enoki::load<ScalarIndex3>(target);
+                                store_unaligned(face_ptr, fi);
+                                face_ptr += 3;
+
+                                size_t target_offset = sizeof(InputFloat) * 3;
+                                for (size_t k = 0; k < face_attributes_descriptors.size(); ++k) {
+                                    auto& descr = face_attributes_descriptors[k];
+                                    memcpy(descr.buf.data() + (offset + j) * descr.dim,
+                                           target + target_offset,
+                                           descr.dim * sizeof(InputFloat));
+                                    target_offset += descr.dim * sizeof(InputFloat);
+                                }
+
+                                target += o_struct_size;
+                            }
+                        }
                     }
-                }
+                );
+                data += i_struct_size * el.count;
 
                 for (auto& descr: face_attributes_descriptors) {
                     add_attribute(descr.name, descr.dim, descr.buf);
                 }
             } else {
                 Log(Warn, "\"%s\": Skipping unknown element \"%s\"", m_name, el.name);
-                stream->seek(stream->tell() + el.struct_->size() * el.count);
+                check_size(el);
+                data += el.struct_->size() * el.count;
             }
         }
 
-        if (stream->tell() != stream->size())
+        if (data != data_end)
             fail("invalid file -- trailing content");
 
         Log(Debug, "\"%s\": read %i faces, %i vertices (%s in %s)",
@@ -383,6 +423,9 @@ public:
                 util::time_string(timer2.value()));
         }
 
+        if (m_compact_storage)
+            compact_vertex_data();
+
         set_children();
     }
 
@@ -523,106 +566,233 @@ private:
         return header;
     }
 
-    ref<Stream> parse_ascii(FileStream *in, const std::vector<PLYElement> &elements) {
-        ref<Stream> out = new MemoryStream();
-        std::fstream &is = *in->native();
-        for (auto const &el : elements) {
-            for (size_t i = 0; i < el.count; ++i) {
-                for (auto const &field : *(el.struct_)) {
-                    switch (field.type) {
-                        case Struct::Type::Int8: {
-                                int value;
-                                if (!(is >> value)) Throw("Could not parse \"char\" value for field %s", field.name);
-                                if (value < -128 || value > 127)
-                                    Throw("Could not parse \"char\" value for field %s", field.name);
-                                out->write((int8_t) value);
-                            }
-                            break;
-
-                        case Struct::Type::UInt8: {
-                                int value;
-                                if (!(is >> value))
-                                    Throw("Could not parse \"uchar\" value for field %s (may be due to non-triangular faces)", field.name);
-                                if (value < 0 || value > 255)
-                                    Throw("Could not parse \"uchar\" value for field %s (may be due to non-triangular faces)", field.name);
-                                out->write((uint8_t) value);
-                            }
-                            break;
+    /**
+     * \brief Convert the ASCII element data into the equivalent binary representation
+     *
+     * The input is split into chunks that are processed in parallel. A first
+     * pass counts the (non-empty) lines of each chunk, which determines the
+     * element and output location of every line. The second pass then parses
+     * the lines of each chunk independently. Every element is expected to be
+     * stored on a separate line.
+     */
+    std::unique_ptr<uint8_t[]> parse_ascii(const char *begin, const char *end,
+                                           const std::vector<PLYElement> &elements,
+                                           size_t &size) {
+        /// Process the input in chunks of (approximately) 1 MiB
+        constexpr size_t chunk_size = 1024 * 1024;
+
+        std::vector<size_t> line_offset(elements.size() + 1),
+                            byte_offset(elements.size() + 1);
+        for (size_t i = 0; i < elements.size(); ++i) {
+            line_offset[i + 1] = line_offset[i] + elements[i].count;
+            byte_offset[i + 1] = byte_offset[i] + elements[i].count * elements[i].struct_->size();
+        }
+        size_t line_count = line_offset.back();
+        size = byte_offset.back();
+
+        std::unique_ptr<uint8_t[]> out(new uint8_t[size]);
+
+        // Chunk boundaries are moved to the beginning of the next line
+        size_t chunk_count = ((size_t) (end - begin) + chunk_size - 1) / chunk_size;
+        std::vector<const char *> chunk_start(chunk_count + 1, end);
+        chunk_start[0] = begin;
+        for (size_t i = 1; i < chunk_count; ++i) {
+            const char *ptr = std::max(begin + i * chunk_size, chunk_start[i - 1]);
+            while (ptr < end && ptr[-1] != '\n')
+                ++ptr;
+            chunk_start[i] = ptr;
+        }
 
-                        case Struct::Type::Int16: {
-                                int16_t value;
-                                if (!(is >> value)) Throw("Could not parse \"short\" value for field %s", field.name);
-                                out->write(value);
-                            }
-                            break;
+        auto next_line = [end](const char *ptr, const char **line_end, bool *empty) {
+            const char *cur = ptr;
+            *empty = true;
+            while (cur < end && *cur != '\n') {
+                if (*cur != ' ' && *cur != '\t' && *cur != '\r')
+                    *empty = false;
+                ++cur;
+            }
+            *line_end = cur;
+            return cur < end ? cur + 1 : end;
+        };
 
-                        case Struct::Type::UInt16: {
-                                uint16_t value;
-                                if (!(is >> value)) Throw("Could not parse \"ushort\" value for field %s", field.name);
-                                out->write(value);
-                            }
-                            break;
+        // First pass: count the number of non-empty lines per chunk
+        std::vector<size_t> chunk_lines(chunk_count + 1, 0);
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, chunk_count, 1),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    size_t count = 0;
+                    const char *ptr = chunk_start[i], *line_end;
+                    bool empty;
+                    while (ptr < chunk_start[i + 1]) {
+                        ptr = next_line(ptr, &line_end, &empty);
+                        count += !empty;
+                    }
+                    chunk_lines[i + 1] = count;
+                }
+            }
+        );
 
-                        case Struct::Type::Int32: {
-                                int32_t value;
-                                if (!(is >> value)) Throw("Could not parse \"int\" value for field %s", field.name);
-                                out->write(value);
-                            }
-                            break;
+        for (size_t i = 0; i < chunk_count; ++i)
+            chunk_lines[i + 1] += chunk_lines[i];
 
-                        case Struct::Type::UInt32: {
-                                uint32_t value;
-                                if (!(is >> value)) Throw("Could not parse \"uint\" value for field %s", field.name);
-                                out->write(value);
-                            }
-                            break;
+        if (chunk_lines.back() < line_count)
+            Throw("Unexpected end of file (expected %i element records, found %i)",
+                  line_count, chunk_lines.back());
+        else if (chunk_lines.back() > line_count)
+            Throw("Trailing tokens after end of PLY file");
 
-                        case Struct::Type::Int64: {
-                                int64_t value;
-                                if (!(is >> value)) Throw("Could not parse \"long\" value for field %s", field.name);
-                                out->write(value);
-                            }
-                            break;
+        // Second pass: parse every line into its final location
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, chunk_count, 1),
+            [&](const tbb::blocked_range<size_t> &range) {
+                std::string line;
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    size_t line_index = chunk_lines[i], el_index = 0;
+                    const char *ptr = chunk_start[i], *line_end;
+                    bool empty;
+
+                    while (ptr < chunk_start[i + 1]) {
+                        const char *line_start = ptr;
+                        ptr = next_line(ptr, &line_end, &empty);
+                        if (empty)
+                            continue;
+
+                        while (line_index >= line_offset[el_index + 1])
+                            ++el_index;
+
+                        const PLYElement &el = elements[el_index];
+                        uint8_t *target = out.get() + byte_offset[el_index] +
+                            (line_index - line_offset[el_index]) * el.struct_->size();
+
+                        // Copy into a zero-terminated buffer for parsing
+                        line.assign(line_start, line_end);
+                        parse_ascii_line(line.c_str(), *el.struct_, target);
+                        ++line_index;
+                    }
+                }
+            }
+        );
 
-                        case Struct::Type::UInt64: {
-                                uint64_t value;
-                                if (!(is >> value)) Throw("Could not parse \"ulong\" value for field %s", field.name);
-                                out->write(value);
-                            }
-                            break;
+        return out;
+    }
 
-                        case Struct::Type::Float16: {
-                                float value;
-                                if (!(is >> value)) Throw("Could not parse \"half\" value for field %s", field.name);
-                                out->write(enoki::half::float32_to_float16(value));
-                            }
-                            break;
+    void parse_ascii_line(const char *cur, const Struct &struct_, uint8_t *target) {
+        auto next_token = [&](const Struct::Field &field) {
+            while (*cur == ' ' || *cur == '\t' || *cur == '\r')
+                ++cur;
+            if (*cur == '\0')
+                Throw("Could not parse value for field %s (missing value, may "
+                      "be due to non-triangular faces)", field.name);
+        };
 
-                        case Struct::Type::Float32: {
-                                float value;
-                                if (!(is >> value)) Throw("Could not parse \"float\" value for field %s", field.name);
-                                out->write(value);
-                            }
-                            break;
+        auto parse_int = [&](const Struct::Field &field, int64_t min_value,
+                             int64_t max_value, const char *type_name) {
+            next_token(field);
+            char *next = nullptr;
+            long long value = std::strtoll(cur, &next, 10);
+            if (next == cur || value < min_value || value > max_value)
+                Throw("Could not parse \"%s\" value for field %s", type_name, field.name);
+            cur = next;
+            return value;
+        };
 
-                        case Struct::Type::Float64: {
-                                double value;
-                                if (!(is >> value)) Throw("Could not parse \"double\" value for field %s", field.name);
-                                out->write(value);
-                            }
-                            break;
+        auto parse_float = [&](const Struct::Field &field, auto type, const char *type_name) {
+            using T = decltype(type);
+            next_token(field);
+            char *next = nullptr;
+            T value = string::strtof<T>(cur, &next);
+            if (next == cur)
+                Throw("Could not parse \"%s\" value for field %s", type_name, field.name);
+            cur = next;
+            return value;
+        };
 
-                        default:
-                            Throw("internal error");
+        for (auto const &field : struct_) {
+            uint8_t *ptr = target + field.offset;
+            switch (field.type) {
+                case Struct::Type::Int8: {
+                        int8_t value = (int8_t) parse_int(field, -128, 127, "char");
+                        memcpy(ptr, &value, sizeof(value));
                     }
-                }
+                    break;
+
+                case Struct::Type::UInt8: {
+                        uint8_t value = (uint8_t) parse_int(field, 0, 255, "uchar");
+                        memcpy(ptr, &value, sizeof(value));
+                    }
+                    break;
+
+                case Struct::Type::Int16: {
+                        int16_t value = (int16_t) parse_int(field, INT16_MIN, INT16_MAX, "short");
+                        memcpy(ptr, &value, sizeof(value));
+                    }
+                    break;
+
+                case Struct::Type::UInt16: {
+                        uint16_t value = (uint16_t) parse_int(field, 0, UINT16_MAX, "ushort");
+                        memcpy(ptr, &value, sizeof(value));
+                    }
+                    break;
+
+                case Struct::Type::Int32: {
+                        int32_t value = (int32_t) parse_int(field, INT32_MIN, INT32_MAX, "int");
+                        memcpy(ptr, &value, sizeof(value));
+                    }
+                    break;
+
+                case Struct::Type::UInt32: {
+                        uint32_t value = (uint32_t) parse_int(field, 0, UINT32_MAX, "uint");
+                        memcpy(ptr, &value, sizeof(value));
+                    }
+                    break;
+
+                case Struct::Type::Int64: {
+                        int64_t value = (int64_t) parse_int(field, INT64_MIN, INT64_MAX, "long");
+                        memcpy(ptr, &value, sizeof(value));
+                    }
+                    break;
+
+                case Struct::Type::UInt64: {
+                        next_token(field);
+                        char *next = nullptr;
+                        uint64_t value = std::strtoull(cur, &next, 10);
+                        if (next == cur)
+                            Throw("Could not parse \"ulong\" value for field %s", field.name);
+                        cur = next;
+                        memcpy(ptr, &value, sizeof(value));
+                    }
+                    break;
+
+                case Struct::Type::Float16: {
+                        uint16_t value = enoki::half::float32_to_float16(
+                            parse_float(field, float(), "half"));
+                        memcpy(ptr, &value, sizeof(value));
+                    }
+                    break;
+
+                case Struct::Type::Float32: {
+                        float value = parse_float(field, float(), "float");
+                        memcpy(ptr, &value, sizeof(value));
+                    }
+                    break;
+
+                case Struct::Type::Float64: {
+                        double value = parse_float(field, double(), "double");
+                        memcpy(ptr, &value, sizeof(value));
+                    }
+                    break;
+
+                default:
+                    Throw("internal error");
             }
         }
-        std::string token;
-        if (is >> token)
-            Throw("Trailing tokens after end of PLY file");
-        out->seek(0);
-        return out;
+
+        while (*cur == ' ' || *cur == '\t' || *cur == '\r')
+            ++cur;
+        if (*cur != '\0')
+            Throw("Trailing tokens after element record (may be due to "
+                  "non-triangular faces)");
     }
 
     void find_other_fields(const std::string& type, std::vector<PLYAttributeDescriptor> &vertex_attributes_descriptors, ref<Struct> target_struct,
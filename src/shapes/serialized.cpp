@@ -1,9 +1,12 @@
 #include <mitsuba/render/mesh.h>
 #include <mitsuba/core/fstream.h>
+#include <mitsuba/core/mstream.h>
 #include <mitsuba/core/zstream.h>
+#include <mitsuba/core/mmap.h>
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/timer.h>
+#include <tbb/tbb.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -28,6 +31,21 @@ Serialized mesh loader (:monosp:`serialized`)
    - When set to |true|, any existing or computed vertex normals are
      discarded and \emph{face normals} will instead be used during rendering.
      This gives the rendered object a faceted appearance.(Default: |false|)
+ * - compact
+   - |bool|
+   - When set to |true|, vertex positions, normals and texture coordinates are
+     quantized after loading (positions to 21-22 bit per component, normals to
+     a 32-bit octahedral encoding, texture coordinates to 16 bit per component),
+     which cuts the vertex memory footprint in half. The mesh cannot be modified
+     afterwards. Only supported by CPU variants. (Default: |false|)
+ * - mmap
+   - |bool|
+   - Only relevant for uncompressed version 5 files (see below). When set to |true|,
+     the mesh buffers directly reference the memory-mapped file instead of
+     holding a copy of its contents. This requires an identity :monosp:`to_world`
+     transformation. The buffers are copied into memory once the mesh parameters
+     are traversed or updated, hence the file itself is never modified.
+     Only supported by CPU variants. (Default: |false|)
  * - to_world
    - |transform|
    - Specifies an optional linear object-to-world transformation.
@@ -107,6 +125,59 @@ Hence, after each mesh, the stream briefly reverts back to an
 uncompressed format, followed by an uncompressed header, and so on.
 This is neccessary for efficient read access to arbitrary sub-meshes.
 
+Version 5 (chunked) format
+**************************
+
+Version 4 files must be decompressed serially from the start of a mesh.
+Version 5 (:code:`0x0005`) instead stores each attribute array as a
+sequence of independently compressed chunks, which can be decompressed in
+parallel and in any order. The header is not compressed:
+
+.. figtable::
+    :label: table-serialized-format-v5
+
+    .. list-table::
+        :widths: 20 80
+        :header-rows: 1
+
+        * - Type
+          - Content
+        * - :monosp:`uint16`
+          - File format identifier: :code:`0x041C`
+        * - :monosp:`uint16`
+          - File version identifier: :code:`0x0005`
+        * - :monosp:`uint32`
+          - Flags as in version 4. The data must be stored in single precision
+            (:code:`0x1000`). The additional flag :code:`0x4000` denotes that chunks
+            are stored without compression.
+        * - :monosp:`string`
+          - A null-terminated string (utf-8), which denotes the name of the shape.
+        * - :monosp:`uint64`
+          - Number of vertices in the mesh
+        * - :monosp:`uint64`
+          - Number of triangles in the mesh
+        * - :monosp:`uint32`
+          - Chunk size :math:`s` in bytes. Every chunk holds :math:`s` bytes of the
+            (uncompressed) attribute array, except for the last one.
+        * - :monosp:`table`
+          - One chunk table per attribute array, in the same order and with the same
+            presence rules as the arrays of version 4 (positions, normals, texture
+            coordinates, colors, and :monosp:`uint32` triangle indices). A chunk table
+            consists of a :monosp:`uint32` chunk count followed by a
+            (:monosp:`uint64` file offset, :monosp:`uint64` size) pair per chunk.
+        * - :monosp:`data`
+          - Chunk data. Compressed chunks are independent :monosp:`zlib` streams.
+
+Uncompressed arrays are stored contiguously, start at a 64-byte aligned file
+offset, and are followed by at least 16 bytes of padding. Such files can be
+mapped into memory and used without any copies (see the :monosp:`mmap`
+parameter). The converter in :monosp:`mitsuba.python.serialized` translates
+existing files into this format, e.g.
+
+.. code-block:: bash
+
+    python -m mitsuba.python.serialized input.serialized output.serialized [--uncompressed]
+
 End-of-file dictionary
 **********************
 In addition to the previous table, a :monosp:`.serialized` file also concludes with a brief summary
@@ -137,6 +208,7 @@ at the end of the file, which specifies the starting position of each sub-mesh:
 #define MTS_FILEFORMAT_HEADER     0x041C
 #define MTS_FILEFORMAT_VERSION_V3 0x0003
 #define MTS_FILEFORMAT_VERSION_V4 0x0004
+#define MTS_FILEFORMAT_VERSION_V5 0x0005
 
 template <typename Float, typename Spectrum>
 class SerializedMesh final : public Mesh<Float, Spectrum> {
@@ -144,7 +216,8 @@ public:
     MTS_IMPORT_BASE(Mesh,m_name, m_bbox, m_to_world, m_vertex_count, m_face_count,
                     m_vertex_positions_buf, m_vertex_normals_buf, m_vertex_texcoords_buf,
                     m_faces_buf, m_disable_vertex_normals, has_vertex_normals, has_vertex_texcoords,
-                    recompute_vertex_normals, vertex_position, vertex_normal, set_children)
+                    recompute_vertex_normals, vertex_position, vertex_normal,
+                    m_compact_storage, compact_vertex_data, set_children)
     MTS_IMPORT_TYPES()
 
     using typename Base::ScalarSize;
@@ -161,7 +234,8 @@ public:
         HasColors       = 0x0008,
         FaceNormals     = 0x0010,
         SinglePrecision = 0x1000,
-        DoublePrecision = 0x2000
+        DoublePrecision = 0x2000,
+        Uncompressed    = 0x4000
     };
 
     constexpr bool has_flag(TriMeshFlags flags, TriMeshFlags f) {
@@ -203,9 +277,129 @@ public:
             fail("encountered an invalid file format!");
 
         if (version != MTS_FILEFORMAT_VERSION_V3 &&
-            version != MTS_FILEFORMAT_VERSION_V4)
+            version != MTS_FILEFORMAT_VERSION_V4 &&
+            version != MTS_FILEFORMAT_VERSION_V5)
             fail("encountered an incompatible file version!");
 
+        uint32_t flags = 0;
+        bool mapped = false;
+        if (version == MTS_FILEFORMAT_VERSION_V5) {
+            stream->close();
+            flags = load_v5(file_path, shape_index, props.bool_("mmap", false), fail);
+            mapped = m_mmap != nullptr;
+        } else {
+            flags = load_v4(stream, version, shape_index, fail);
+        }
+
+        size_t vertex_data_bytes = 3 * sizeof(InputFloat);
+        if (has_vertex_normals())
+            vertex_data_bytes += 3 * sizeof(InputFloat);
+        if (has_vertex_texcoords())
+            vertex_data_bytes += 2 * sizeof(InputFloat);
+
+        Log(Debug, "\"%s\": read %i faces, %i vertices (%s in %s%s)",
+            m_name, m_face_count, m_vertex_count,
+            util::mem_string(m_face_count * 3 * sizeof(ScalarIndex) +
+                             m_vertex_count * vertex_data_bytes),
+            util::time_string(timer.value()),
+            mapped ? ", memory-mapped" : ""
+        );
+
+        // Post-processing: mapped buffers are read-only and already in world space
+        tbb::spin_mutex bbox_mutex;
+        tbb::parallel_for(
+            tbb::blocked_range<ScalarSize>(0, m_vertex_count, 16384),
+            [&](const tbb::blocked_range<ScalarSize> &range) {
+                InputFloat *position_ptr = m_vertex_positions_buf.data();
+                InputFloat *normal_ptr   = m_vertex_normals_buf.data();
+                ScalarBoundingBox3f bbox;
+
+                for (ScalarSize i = range.begin(); i != range.end(); ++i) {
+                    InputPoint3f p = vertex_position(i);
+                    if (!mapped) {
+                        p = m_to_world.transform_affine(p);
+                        store_unaligned(position_ptr + i * 3, p);
+
+                        if (has_vertex_normals()) {
+                            InputNormal3f n = normalize(m_to_world.transform_affine(vertex_normal(i)));
+                            store_unaligned(normal_ptr + i * 3, n);
+                        }
+                    }
+                    bbox.expand(p);
+                }
+
+                std::lock_guard<tbb::spin_mutex> lock(bbox_mutex);
+                m_bbox.expand(bbox);
+            }
+        );
+
+        if (!m_disable_vertex_normals && !has_flag(flags, TriMeshFlags::HasNormals)) {
+            Timer timer2;
+            recompute_vertex_normals();
+            Log(Debug, "\"%s\": computed vertex normals (took %s)", m_name,
+                util::time_string(timer2.value()));
+        }
+
+        if (m_compact_storage)
+            compact_vertex_data();
+
+        set_children();
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        // Exposed buffers may be modified, hence they must not reference the mapping
+        unmap();
+        Base::traverse(callback);
+    }
+
+    void parameters_changed(const std::vector<std::string> &keys = {}) override {
+        unmap();
+        Base::parameters_changed(keys);
+    }
+
+    /// Replace buffers referencing the read-only file mapping by private copies
+    void unmap() {
+        if (!m_mmap)
+            return;
+
+        if constexpr (!is_cuda_array_v<Float>) {
+            m_vertex_positions_buf = FloatStorage::copy(m_vertex_positions_buf.data(),
+                                                        m_vertex_count * 3);
+            if (has_vertex_normals())
+                m_vertex_normals_buf = FloatStorage::copy(m_vertex_normals_buf.data(),
+                                                          m_vertex_count * 3);
+            if (has_vertex_texcoords())
+                m_vertex_texcoords_buf = FloatStorage::copy(m_vertex_texcoords_buf.data(),
+                                                            m_vertex_count * 2);
+            m_faces_buf = DynamicBuffer<UInt32>::copy(m_faces_buf.data(), m_face_count * 3);
+        }
+
+        Log(Debug, "\"%s\": copied memory-mapped buffers before modification", m_name);
+        m_mmap = nullptr;
+    }
+
+    /// Allocate the mesh buffers after the vertex and face count are known
+    void allocate_buffers(uint32_t flags) {
+        m_vertex_positions_buf = empty<FloatStorage>(m_vertex_count * 3);
+        if (!m_disable_vertex_normals)
+            m_vertex_normals_buf = empty<FloatStorage>(m_vertex_count * 3);
+        if (has_flag(flags, TriMeshFlags::HasTexcoords))
+            m_vertex_texcoords_buf = empty<FloatStorage>(m_vertex_count * 2);
+
+        m_faces_buf = empty<DynamicBuffer<UInt32>>(m_face_count * 3);
+
+        m_vertex_positions_buf.managed();
+        m_vertex_normals_buf.managed();
+        m_vertex_texcoords_buf.managed();
+        m_faces_buf.managed();
+
+        if constexpr (is_cuda_array_v<Float>)
+            cuda_sync();
+    }
+
+    /// Load a mesh from a version 3 or 4 file (a single zlib stream per mesh)
+    template <typename Fail>
+    uint32_t load_v4(ref<Stream> stream, short version, int shape_index, const Fail &fail) {
         if (shape_index != 0) {
             size_t file_size = stream->size();
 
@@ -245,16 +439,8 @@ public:
 
         uint32_t flags = 0;
         stream->read(flags);
-        if (version == MTS_FILEFORMAT_VERSION_V4) {
-            char ch = 0;
-            m_name = "";
-            do {
-                stream->read(ch);
-                if (ch == 0)
-                    break;
-                m_name += ch;
-            } while (true);
-        }
+        if (version == MTS_FILEFORMAT_VERSION_V4)
+            m_name = read_name(stream);
 
         size_t vertex_count, face_count;
         stream->read(vertex_count);
@@ -263,21 +449,7 @@ public:
         m_vertex_count = (ScalarSize) vertex_count;
         m_face_count = (ScalarSize) face_count;
 
-        m_vertex_positions_buf = empty<FloatStorage>(m_vertex_count * 3);
-        if (!m_disable_vertex_normals)
-            m_vertex_normals_buf = empty<FloatStorage>(m_vertex_count * 3);
-        if (has_flag(flags, TriMeshFlags::HasTexcoords))
-            m_vertex_texcoords_buf = empty<FloatStorage>(m_vertex_count * 2);
-
-        m_faces_buf = empty<DynamicBuffer<UInt32>>(m_face_count * 3);
-
-        m_vertex_positions_buf.managed();
-        m_vertex_normals_buf.managed();
-        m_vertex_texcoords_buf.managed();
-        m_faces_buf.managed();
-
-        if constexpr (is_cuda_array_v<Float>)
-            cuda_sync();
+        allocate_buffers(flags);
 
         bool double_precision = has_flag(flags, TriMeshFlags::DoublePrecision);
 
@@ -299,43 +471,184 @@ public:
 
         stream->read(m_faces_buf.data(), m_face_count * sizeof(ScalarIndex) * 3);
 
-        size_t vertex_data_bytes = 3 * sizeof(InputFloat);
-        if (has_vertex_normals())
-            vertex_data_bytes += 3 * sizeof(InputFloat);
-        if (has_vertex_texcoords())
-            vertex_data_bytes += 2 * sizeof(InputFloat);
+        return flags;
+    }
 
-        Log(Debug, "\"%s\": read %i faces, %i vertices (%s in %s)",
-            m_name, m_face_count, m_vertex_count,
-            util::mem_string(m_face_count * 3 * sizeof(ScalarIndex) +
-                             m_vertex_count * vertex_data_bytes),
-            util::time_string(timer.value())
-        );
+    /**
+     * \brief Load a mesh from a version 5 file
+     *
+     * The file is memory-mapped, and the chunks of all attribute arrays are
+     * decompressed (or copied) in parallel. When \c mmap is set and the file
+     * is uncompressed, the mesh buffers directly reference the mapped file.
+     */
+    template <typename Fail>
+    uint32_t load_v5(const fs::path &file_path, int shape_index, bool mmap, const Fail &fail) {
+        ref<MemoryMappedFile> file = new MemoryMappedFile(file_path);
+        uint8_t *base = (uint8_t *) file->data();
+        size_t file_size = file->size();
 
-        // Post-processing
-        InputFloat* position_ptr = m_vertex_positions_buf.data();
-        InputFloat* normal_ptr   = m_vertex_normals_buf.data();
-        for (ScalarSize i = 0; i < m_vertex_count; ++i) {
-            InputPoint3f p = m_to_world.transform_affine(vertex_position(i));
-            store_unaligned(position_ptr, p);
-            position_ptr += 3;
-            m_bbox.expand(p);
-
-            if (has_vertex_normals()) {
-                InputNormal3f n = normalize(m_to_world.transform_affine(vertex_normal(i)));
-                store_unaligned(normal_ptr, n);
-                normal_ptr += 3;
-            }
+        ref<Stream> stream = new MemoryStream(base, file_size);
+        stream->set_byte_order(Stream::ELittleEndian);
+
+        uint64_t offset = 0;
+        if (shape_index != 0) {
+            stream->seek(file_size - sizeof(uint32_t));
+            uint32_t count = 0;
+            stream->read(count);
+
+            if (shape_index >= (int) count)
+                fail(tfm::format("Unable to unserialize mesh, shape index is "
+                                 "out of range! (requested %i out of 0..%i)",
+                                 shape_index, count - 1));
+
+            stream->seek(file_size - sizeof(uint64_t) * (count - shape_index) -
+                         sizeof(uint32_t));
+            stream->read(offset);
         }
+        stream->seek(offset + sizeof(short) * 2); // Skip the header
 
-        if (!m_disable_vertex_normals && !has_flag(flags, TriMeshFlags::HasNormals)) {
-            Timer timer2;
-            recompute_vertex_normals();
-            Log(Debug, "\"%s\": computed vertex normals (took %s)", m_name,
-                util::time_string(timer2.value()));
+        uint32_t flags = 0, chunk_size = 0;
+        uint64_t vertex_count = 0, face_count = 0;
+        stream->read(flags);
+        m_name = read_name(stream);
+        stream->read(vertex_count);
+        stream->read(face_count);
+        stream->read(chunk_size);
+
+        if (!has_flag(flags, TriMeshFlags::SinglePrecision))
+            fail("version 5 files must be stored in single precision");
+        if (chunk_size == 0)
+            fail("invalid chunk size");
+
+        m_vertex_count = (ScalarSize) vertex_count;
+        m_face_count = (ScalarSize) face_count;
+
+        auto read_table = [&](size_t size) {
+            uint32_t count = 0;
+            stream->read(count);
+            if (count != (size + chunk_size - 1) / chunk_size)
+                fail("invalid chunk table");
+            std::vector<uint64_t> table(2 * (size_t) count);
+            stream->read_array(table.data(), table.size());
+            for (size_t i = 0; i < count; ++i) {
+                size_t expected = std::min((size_t) chunk_size, size - i * chunk_size);
+                if (table[2 * i] + table[2 * i + 1] > file_size)
+                    fail("chunk extends beyond the end of the file");
+                if (has_flag(flags, TriMeshFlags::Uncompressed) && table[2 * i + 1] != expected)
+                    fail("invalid size of an uncompressed chunk");
+            }
+            return table;
+        };
+
+        size_t vertex_bytes = m_vertex_count * sizeof(InputFloat);
+        std::vector<uint64_t> positions = read_table(vertex_bytes * 3), normals, texcoords;
+        if (has_flag(flags, TriMeshFlags::HasNormals))
+            normals = read_table(vertex_bytes * 3);
+        if (has_flag(flags, TriMeshFlags::HasTexcoords))
+            texcoords = read_table(vertex_bytes * 2);
+        if (has_flag(flags, TriMeshFlags::HasColors))
+            read_table(vertex_bytes * 3); // TODO
+        std::vector<uint64_t> faces = read_table(m_face_count * sizeof(ScalarIndex) * 3);
+
+        /* Buffers can only reference the mapped file when no further processing
+           is required and every array is stored contiguously and aligned */
+        auto mappable = [&](const std::vector<uint64_t> &table) {
+            for (size_t i = 1; i < table.size() / 2; ++i)
+                if (table[2 * i] != table[0] + i * chunk_size)
+                    return false;
+            return table.empty() || table[0] % 64 == 0;
+        };
+
+        if (mmap) {
+            bool can_map = !is_cuda_array_v<Float> &&
+                           has_flag(flags, TriMeshFlags::Uncompressed) &&
+                           m_to_world == ScalarTransform4f() && !m_compact_storage &&
+                           (m_disable_vertex_normals || has_flag(flags, TriMeshFlags::HasNormals)) &&
+                           mappable(positions) && mappable(normals) &&
+                           mappable(texcoords) && mappable(faces);
+
+            if (!can_map) {
+                Log(Warn, "\"%s\": unable to reference the mapped file (this requires "
+                    "an uncompressed file, an identity \"to_world\" transformation, and a "
+                    "CPU variant), copying its contents instead.", m_name);
+            } else if constexpr (!is_cuda_array_v<Float>) {
+                auto map = [&](const std::vector<uint64_t> &table, size_t size) {
+                    return FloatStorage::map(base + (table.empty() ? 0 : table[0]), size);
+                };
+
+                m_vertex_positions_buf = map(positions, m_vertex_count * 3);
+                if (!m_disable_vertex_normals)
+                    m_vertex_normals_buf = map(normals, m_vertex_count * 3);
+                if (has_flag(flags, TriMeshFlags::HasTexcoords))
+                    m_vertex_texcoords_buf = map(texcoords, m_vertex_count * 2);
+                m_faces_buf = DynamicBuffer<UInt32>::map(
+                    base + (faces.empty() ? 0 : faces[0]), m_face_count * 3);
+
+                // The buffers reference the mapping, which must outlive the mesh
+                m_mmap = file;
+                return flags;
+            }
         }
 
-        set_children();
+        allocate_buffers(flags);
+
+        struct ArrayTask {
+            const std::vector<uint64_t> *table;
+            uint8_t *target;
+            size_t size;
+        };
+
+        std::vector<ArrayTask> arrays;
+        arrays.push_back({ &positions, (uint8_t *) m_vertex_positions_buf.data(), vertex_bytes * 3 });
+        if (!m_disable_vertex_normals && !normals.empty())
+            arrays.push_back({ &normals, (uint8_t *) m_vertex_normals_buf.data(), vertex_bytes * 3 });
+        if (!texcoords.empty())
+            arrays.push_back({ &texcoords, (uint8_t *) m_vertex_texcoords_buf.data(), vertex_bytes * 2 });
+        arrays.push_back({ &faces, (uint8_t *) m_faces_buf.data(), m_face_count * sizeof(ScalarIndex) * 3 });
+
+        // Flatten the chunks of all arrays into a single list of work items
+        std::vector<std::pair<size_t, size_t>> work;
+        for (size_t i = 0; i < arrays.size(); ++i)
+            for (size_t j = 0; j < arrays[i].table->size() / 2; ++j)
+                work.emplace_back(i, j);
+
+        bool compressed = !has_flag(flags, TriMeshFlags::Uncompressed);
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, work.size(), 1),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t k = range.begin(); k != range.end(); ++k) {
+                    const ArrayTask &array = arrays[work[k].first];
+                    size_t j = work[k].second;
+                    uint64_t chunk_offset = (*array.table)[2 * j],
+                             chunk_bytes  = (*array.table)[2 * j + 1];
+                    size_t size = std::min((size_t) chunk_size, array.size - j * chunk_size);
+                    uint8_t *target = array.target + j * chunk_size;
+
+                    if (compressed) {
+                        ref<ZStream> zstream =
+                            new ZStream(new MemoryStream(base + chunk_offset, chunk_bytes));
+                        zstream->read(target, size);
+                    } else {
+                        memcpy(target, base + chunk_offset, size);
+                    }
+                }
+            }
+        );
+
+        return flags;
+    }
+
+    /// Read a null-terminated shape name
+    std::string read_name(Stream *stream) {
+        std::string name;
+        char ch = 0;
+        do {
+            stream->read(ch);
+            if (ch == 0)
+                break;
+            name += ch;
+        } while (true);
+        return name;
     }
 
     void read_helper(Stream *stream, bool dp, InputFloat* dst, size_t dim) {
@@ -367,6 +680,9 @@ public:
     }
 
     MTS_DECLARE_CLASS()
+private:
+    /// File mapping referenced by the mesh buffers (if any)
+    ref<MemoryMappedFile> m_mmap;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(SerializedMesh, Mesh)
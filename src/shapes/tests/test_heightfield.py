@@ -0,0 +1,102 @@
+import mitsuba
+import pytest
+import enoki as ek
+import numpy as np
+
+
+def write_heightfield(tmpdir, heights):
+    from mitsuba.core import Bitmap
+
+    filename = str(tmpdir.join('heights.exr'))
+    Bitmap(np.array(heights, dtype=np.float32)[:, :, None]).write(filename)
+    return filename
+
+
+def test01_create(variant_scalar_rgb, tmpdir):
+    from mitsuba.core import xml
+
+    filename = write_heightfield(tmpdir, np.full((8, 4), 0.5))
+    s = xml.load_dict({"type" : "heightfield", "filename" : filename})
+    assert s is not None
+
+    # Flat height field covering the pixel centers of the rectangle
+    assert ek.allclose(s.bbox().min, [-0.75, -0.875, 0.5])
+    assert ek.allclose(s.bbox().max, [0.75, 0.875, 0.5])
+    assert ek.allclose(s.surface_area(), 1.5 * 1.75)
+
+
+def test02_ray_intersect(variant_scalar_rgb, tmpdir):
+    from mitsuba.core import xml, Ray3f, Vector3f
+
+    # Heights increase linearly along X, so the bilinear surface is a plane
+    res = 65
+    x = np.arange(res)
+    heights = np.tile(x * 0.01, (res, 1))
+    filename = write_heightfield(tmpdir, heights)
+
+    scene = xml.load_dict({
+        "type" : "scene",
+        "foo" : {
+            "type" : "heightfield",
+            "filename" : filename,
+            "scale" : 2.0,
+            "shading_normals" : False
+        }
+    })
+
+    for px, py in [(-0.5, 0.3), (0.0, 0.0), (0.7, -0.9), (0.33, 0.61)]:
+        ray = Ray3f(Vector3f(px, py, 10.0), Vector3f(0.0, 0.0, -1.0), 0, [])
+        si = scene.ray_intersect(ray)
+        assert si.is_valid() and scene.ray_test(ray)
+
+        # Grid position of the hit and expected height
+        gx = (px + 1) * 0.5 * res - 0.5
+        assert ek.allclose(si.p, [px, py, 2.0 * 0.01 * gx], atol=1e-4)
+        assert ek.allclose(si.uv, [(px + 1) * 0.5, (py + 1) * 0.5], atol=1e-4)
+
+        slope = 2.0 * 0.01 * res * 0.5
+        n = ek.normalize(Vector3f(-slope, 0, 1))
+        assert ek.allclose(si.n, n, atol=1e-4)
+
+    # Grazing ray that passes above the surface
+    ray = Ray3f(Vector3f(-2.0, 0.0, 2.0), Vector3f(1.0, 0.0, 0.0), 0, [])
+    assert not scene.ray_intersect(ray).is_valid()
+    assert not scene.ray_test(ray)
+
+    # Oblique ray entering from the side and hitting the sloped surface at x=-0.635
+    ray = Ray3f(Vector3f(-2.0, 0.1, 0.5), ek.normalize(Vector3f(1.0, 0.0, -0.2)), 0, [])
+    si = scene.ray_intersect(ray)
+    assert si.is_valid()
+    assert ek.allclose(si.p.x, -0.54 / 0.85, atol=1e-3)
+    gx = (si.p.x + 1) * 0.5 * res - 0.5
+    assert ek.allclose(si.p.z, 2.0 * 0.01 * gx, atol=1e-4)
+
+
+def test03_bumps(variant_scalar_rgb, tmpdir):
+    from mitsuba.core import xml, Ray3f, Vector3f
+
+    # Random height field: compare against brute-force bilinear patch intersection
+    res = 33
+    rng = np.random.RandomState(0)
+    heights = rng.uniform(0, 0.2, (res, res))
+    filename = write_heightfield(tmpdir, heights)
+
+    scene = xml.load_dict({
+        "type" : "scene",
+        "foo" : {"type" : "heightfield", "filename" : filename}
+    })
+
+    def height(px, py):
+        gx = (px + 1) * 0.5 * res - 0.5
+        gy = (py + 1) * 0.5 * res - 0.5
+        x, y = min(int(gx), res - 2), min(int(gy), res - 2)
+        a, b = gx - x, gy - y
+        return (heights[y, x] * (1 - a) * (1 - b) + heights[y, x + 1] * a * (1 - b) +
+                heights[y + 1, x] * (1 - a) * b + heights[y + 1, x + 1] * a * b)
+
+    for i in range(50):
+        o = Vector3f(rng.uniform(-0.9, 0.9), rng.uniform(-0.9, 0.9), 1.0)
+        d = ek.normalize(Vector3f(rng.uniform(-0.2, 0.2), rng.uniform(-0.2, 0.2), -1.0))
+        si = scene.ray_intersect(Ray3f(o, d, 0, []))
+        assert si.is_valid()
+        assert ek.allclose(si.p.z, height(si.p.x, si.p.y), atol=1e-4)
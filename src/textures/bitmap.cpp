@@ -3,11 +3,14 @@
 #include <mitsuba/core/plugin.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/util.h>
 #include <mitsuba/core/distr_2d.h>
 #include <mitsuba/render/interaction.h>
 #include <mitsuba/render/texture.h>
 #include <mitsuba/render/srgb.h>
 #include <mutex>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
 #include <tbb/spin_mutex.h>
 
 NAMESPACE_BEGIN(mitsuba)
@@ -35,6 +38,19 @@ Bitmap texture (:monosp:`bitmap`)
      - ``nearest``: disable filtering and interpolation. In this mode, the plugin
        performs nearest neighbor lookups of texture values.
 
+     - ``trilinear``: perform bilinear interpolation on the two levels of a MIP map
+       that best match the pixel footprint, and interpolate linearly between them.
+
+     - ``ewa``: perform anisotropic filtering with an elliptically weighted average
+       over the MIP map :cite:`Heckbert1989Fundamentals`. This provides the highest
+       quality but is also the most expensive option.
+
+ * - max_anisotropy
+   - |float|
+   - Maximum ratio between the major and minor axis of the filter footprint used by
+     the ``ewa`` filter. Larger values reduce blurring at grazing angles at the cost
+     of more texel lookups. (Default: 8)
+
  * - wrap_mode
    - |string|
    - Controls the behavior of texture evaluations that fall outside of the
@@ -52,6 +68,22 @@ Bitmap texture (:monosp:`bitmap`)
      spectral upsampling) be disabled? You will want to enable this when working
      with bitmaps storing normal maps that use a linear encoding. (Default: false)
 
+ * - interpolate_coefficients
+   - |bool|
+   - In :monosp:`spectral` modes, interpolate the coefficients of the spectral upsampling
+     model between neighboring texels instead of the spectra they represent. The model
+     is then evaluated once per lookup instead of four times, which is faster but only
+     approximates the interpolated spectrum (most noticeably between highly saturated
+     and black or white texels). This applies to the ``bilinear`` filter. (Default: false)
+
+ * - compact
+   - |bool|
+   - Keep 8-bit and half precision images in their native component format and
+     decode texels on the fly during lookups. This reduces the memory usage of
+     such textures by a factor of 2-4. The texel data is then not exposed as a
+     parameter that can be modified, hence this option is ignored in differentiable
+     variants. (Default: true)
+
  * - to_uv
    - |transform|
    - Specifies an optional 3x3 transformation matrix that will be applied to UV
@@ -74,10 +106,118 @@ These conversions can alternatively be disabled with the :paramtype:`raw` flag,
 e.g. when textured data is already in linear space or does not represent colors
 at all.
 
+The ``trilinear`` and ``ewa`` filters rely on a MIP map that is built once when the
+plugin is loaded, and on the UV partials of the surface interaction. The BSDFs
+referencing such a texture automatically request these differentials.
+
+Images with 8-bit or half precision components (e.g. PNG/JPEG files or half
+precision OpenEXR files) are stored in this compact form unless the
+:paramtype:`compact` parameter is disabled. Only the image itself uses this
+representation, while the coarser MIP map levels are filtered and stored in
+floating point, so that filtered lookups match those of the floating point
+representation. 8-bit sRGB values are linearized using a lookup table. This
+does not apply to RGB textures in :monosp:`spectral` modes, whose texels are stored
+as coefficients of the spectral upsampling model.
+
 */
 
-enum class FilterType { Nearest, Bilinear };
+enum class FilterType { Nearest, Bilinear, Trilinear, EWA };
 enum class WrapMode { Repeat, Mirror, Clamp };
+enum class TexelFormat { Float32, Float16, UInt8, SRGB8 };
+
+NAMESPACE_BEGIN(detail)
+/// Convert the bit representation of half precision values into floating point values
+template <typename Float, typename UInt32> MTS_INLINE Float half_to_float(const UInt32 &h) {
+    using Float32 = float32_array_t<UInt32>;
+    UInt32 exp_mant = (h & 0x7fffu) << 13;
+
+    // Rescaling the exponent also takes care of denormalized values
+    Float32 value = reinterpret_array<Float32>(exp_mant) * 0x1p112f;
+    masked(value, eq(h & 0x7c00u, 0x7c00u)) =
+        reinterpret_array<Float32>(exp_mant | 0x7f800000u);
+
+    return Float(reinterpret_array<Float32>(reinterpret_array<UInt32>(value) |
+                                            ((h & 0x8000u) << 16)));
+}
+
+/// Convert an 8-bit component into a linear floating point value
+inline float uint8_to_float(uint8_t value, bool srgb) {
+    float result = value * (1.f / 255.f);
+    return srgb ? srgb_to_linear(result) : result;
+}
+
+/**
+ * \brief Downsample a bitmap into the coarser levels 1, 2, .. of a MIP map
+ *
+ * Level \c i has a resolution of <tt>max(size >> i, 1)</tt> and is computed
+ * directly from the provided bitmap using a box filter. The levels are
+ * resampled in parallel.
+ */
+inline std::vector<ref<Bitmap>> build_mip_levels(const Bitmap *bitmap, WrapMode wrap_mode) {
+    using ReconstructionFilter = Bitmap::ReconstructionFilter;
+    ref<ReconstructionFilter> rfilter =
+        PluginManager::instance()->create_object<ReconstructionFilter>(Properties("box"));
+
+    FilterBoundaryCondition bc = FilterBoundaryCondition::Clamp;
+    if (wrap_mode == WrapMode::Repeat)
+        bc = FilterBoundaryCondition::Repeat;
+    else if (wrap_mode == WrapMode::Mirror)
+        bc = FilterBoundaryCondition::Mirror;
+
+    Bitmap::Vector2u size = bitmap->size();
+    uint32_t level_count = 1 + log2i(hmax(size));
+
+    std::vector<ref<Bitmap>> levels(level_count - 1);
+    tbb::parallel_for(
+        tbb::blocked_range<uint32_t>(1, level_count),
+        [&](const tbb::blocked_range<uint32_t> &range) {
+            for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                Bitmap::Vector2u level_size =
+                    max(Bitmap::Vector2u(size.x() >> i, size.y() >> i), 1u);
+                levels[i - 1] = bitmap->resample(level_size, rfilter.get(), { bc, bc });
+            }
+        }
+    );
+
+    return levels;
+}
+
+/**
+ * \brief Replace the sRGB values of an RGB bitmap by the coefficients of the
+ * spectral upsampling model
+ *
+ * The texels are processed in parallel. Returns the sum of the mean values of
+ * the resulting spectra, and whether any sRGB value exceeds the [0, 1] range.
+ */
+template <typename ScalarFloat>
+std::pair<double, bool> fetch_srgb_coefficients(Bitmap *bitmap, bool finite) {
+    using ScalarColor3f = Color<ScalarFloat, 3>;
+    ScalarFloat *data = (ScalarFloat *) bitmap->data();
+
+    return tbb::parallel_reduce(
+        tbb::blocked_range<size_t>(0, bitmap->pixel_count(), 4096),
+        std::make_pair(0.0, false),
+        [&](const tbb::blocked_range<size_t> &range, std::pair<double, bool> result) {
+            for (size_t i = range.begin(); i != range.end(); ++i) {
+                ScalarFloat *ptr = data + 3 * i;
+                ScalarColor3f value = load_unaligned<ScalarColor3f>(ptr);
+                if (!all(value >= 0 && value <= 1))
+                    result.second = true;
+                if (finite)
+                    value = srgb_model_fetch_finite(value);
+                else
+                    value = srgb_model_fetch(value);
+                result.first += (double) srgb_model_mean(value);
+                store_unaligned(ptr, value);
+            }
+            return result;
+        },
+        [](std::pair<double, bool> a, const std::pair<double, bool> &b) {
+            return std::make_pair(a.first + b.first, a.second || b.second);
+        }
+    );
+}
+NAMESPACE_END(detail)
 
 // Forward declaration of specialized bitmap texture
 template <typename Float, typename Spectrum, uint32_t Channels, bool Raw>
@@ -102,9 +242,17 @@ public:
             m_filter_type = FilterType::Nearest;
         else if (filter_type == "bilinear")
             m_filter_type = FilterType::Bilinear;
+        else if (filter_type == "trilinear")
+            m_filter_type = FilterType::Trilinear;
+        else if (filter_type == "ewa")
+            m_filter_type = FilterType::EWA;
         else
-            Throw("Invalid filter type \"%s\", must be one of: \"nearest\", or "
-                  "\"bilinear\"!", filter_type);
+            Throw("Invalid filter type \"%s\", must be one of: \"nearest\", "
+                  "\"bilinear\", \"trilinear\", or \"ewa\"!", filter_type);
+
+        m_max_anisotropy = props.float_("max_anisotropy", 8.f);
+        if (m_max_anisotropy < 1.f)
+            Throw("The 'max_anisotropy' parameter must be >= 1!");
 
         std::string wrap_mode = props.string("wrap_mode", "repeat");
         if (wrap_mode == "repeat")
@@ -143,12 +291,23 @@ public:
         /* Should Mitsuba disable transformations to the stored color data?
            (e.g. sRGB to linear, spectral upsampling, etc.) */
         m_raw = props.bool_("raw", false);
+        m_interpolate_coefficients = props.bool_("interpolate_coefficients", false);
         if (m_raw) {
             /* Don't undo gamma correction in the conversion below.
                This is needed, e.g., for normal maps. */
             m_bitmap->set_srgb_gamma(false);
         }
 
+        /* Keep 8-bit and half precision images in their native component
+           format? This isn't possible for the coefficients of the spectral
+           upsampling model and for differentiable texel data. */
+        Struct::Type component_format = m_bitmap->component_format();
+        bool compact = props.bool_("compact", true) && !is_diff_array_v<Float> &&
+            (component_format == Struct::Type::UInt8 ||
+             (component_format == Struct::Type::Float16 && !m_bitmap->srgb_gamma())) &&
+            !(is_spectral_v<Spectrum> && !m_raw && pixel_format == Bitmap::PixelFormat::RGB);
+        ref<Bitmap> source = m_bitmap;
+
         // Convert the image into the working floating point representation
         m_bitmap = m_bitmap->convert(pixel_format, struct_type_v<ScalarFloat>, false);
 
@@ -158,8 +317,30 @@ public:
             ref<ReconstructionFilter> rfilter =
                 PluginManager::instance()->create_object<ReconstructionFilter>(Properties("tent"));
             m_bitmap = m_bitmap->resample(max(m_bitmap->size(), 2), rfilter);
+            source = m_bitmap;
         }
 
+        /* Build the MIP map used by the trilinear and EWA filters. This must
+           happen before the spectral conversion below, since the coefficients
+           of the spectral upsampling model cannot be averaged. */
+        if (m_filter_type == FilterType::Trilinear || m_filter_type == FilterType::EWA) {
+            m_mip_levels = detail::build_mip_levels(m_bitmap, m_wrap_mode);
+
+            if (is_spectral_v<Spectrum> && !m_raw && m_bitmap->channel_count() == 3) {
+                for (Bitmap *level : m_mip_levels)
+                    detail::fetch_srgb_coefficients<ScalarFloat>(level, false);
+            }
+        }
+
+        /* Compact representation of the image. The floating point version is
+           only used to compute the mean value below. The coarser MIP map
+           levels remain in floating point, since quantizing the filtered
+           values would change the result of trilinear and EWA lookups. */
+        ref<Bitmap> compact_bitmap;
+        if (compact)
+            compact_bitmap = source->convert(pixel_format, component_format,
+                                             source->srgb_gamma());
+
         ScalarFloat *ptr = (ScalarFloat *) m_bitmap->data();
         size_t pixel_count = m_bitmap->pixel_count();
         bool bad = false;
@@ -167,15 +348,8 @@ public:
         double mean = 0.0;
         if (m_bitmap->channel_count() == 3) {
             if (is_spectral_v<Spectrum> && !m_raw) {
-                for (size_t i = 0; i < pixel_count; ++i) {
-                    ScalarColor3f value = load_unaligned<ScalarColor3f>(ptr);
-                    if (!all(value >= 0 && value <= 1))
-                        bad = true;
-                    value = srgb_model_fetch(value);
-                    mean += (double) srgb_model_mean(value);
-                    store_unaligned(ptr, value);
-                    ptr += 3;
-                }
+                std::tie(mean, bad) = detail::fetch_srgb_coefficients<ScalarFloat>(
+                    m_bitmap, m_interpolate_coefficients);
             } else {
                 for (size_t i = 0; i < pixel_count; ++i) {
                     ScalarColor3f value = load_unaligned<ScalarColor3f>(ptr);
@@ -203,6 +377,9 @@ public:
                 "exceed the [0, 1] range!", m_name);
 
         m_mean = ScalarFloat(mean / pixel_count);
+
+        if (compact_bitmap)
+            m_bitmap = compact_bitmap;
     }
 
     /**
@@ -215,6 +392,8 @@ public:
         return { ref<Object>(expand_1()) };
     }
 
+    bool needs_differentials() const override { return !m_mip_levels.empty(); }
+
     MTS_DECLARE_CLASS()
 
 protected:
@@ -229,7 +408,8 @@ protected:
     template <uint32_t Channels, bool Raw> Object* expand_3() const {
         Properties props;
         return new BitmapTextureImpl<Float, Spectrum, Channels, Raw>(
-            props, m_bitmap, m_name, m_transform, m_mean, m_filter_type, m_wrap_mode);
+            props, m_bitmap, m_name, m_transform, m_mean, m_filter_type,
+            m_wrap_mode, m_mip_levels, m_max_anisotropy, m_interpolate_coefficients);
     }
 
 protected:
@@ -240,6 +420,9 @@ protected:
     ScalarFloat m_mean;
     FilterType m_filter_type;
     WrapMode m_wrap_mode;
+    std::vector<ref<Bitmap>> m_mip_levels;
+    ScalarFloat m_max_anisotropy;
+    bool m_interpolate_coefficients;
 };
 
 template <typename Float, typename Spectrum, uint32_t Channels, bool Raw>
@@ -247,21 +430,54 @@ class BitmapTextureImpl final : public Texture<Float, Spectrum> {
 public:
     MTS_IMPORT_TYPES(Texture)
 
+    // Storage representation underlying this texture
+    using StorageType = std::conditional_t<Channels == 1, Float, Color3f>;
+
+    // Representation of texel values after evaluating the spectral upsampling model
+    using ResultType = std::conditional_t<is_spectral_v<Spectrum> && !Raw && Channels == 3,
+                                          UnpolarizedSpectrum, StorageType>;
+
     BitmapTextureImpl(const Properties &props,
                       const Bitmap *bitmap,
                       const std::string &name,
                       const ScalarTransform3f &transform,
                       ScalarFloat mean,
                       FilterType filter_type,
-                      WrapMode wrap_mode)
+                      WrapMode wrap_mode,
+                      const std::vector<ref<Bitmap>> &mip_levels,
+                      ScalarFloat max_anisotropy,
+                      bool interpolate_coefficients)
         : Texture(props),
           m_resolution(ScalarVector2i(bitmap->size())),
           m_inv_resolution_x((int) bitmap->width()),
           m_inv_resolution_y((int) bitmap->height()),
           m_name(name), m_transform(transform), m_mean(mean),
-          m_filter_type(filter_type), m_wrap_mode(wrap_mode){
-        m_data = DynamicBuffer<Float>::copy(bitmap->data(),
-            hprod(m_resolution) * Channels);
+          m_filter_type(filter_type), m_wrap_mode(wrap_mode),
+          m_max_anisotropy(max_anisotropy),
+          m_interpolate_coefficients(interpolate_coefficients) {
+        switch (bitmap->component_format()) {
+            case Struct::Type::UInt8:
+                m_texel_format = bitmap->srgb_gamma() ? TexelFormat::SRGB8
+                                                      : TexelFormat::UInt8;
+                break;
+
+            case Struct::Type::Float16:
+                m_texel_format = TexelFormat::Float16;
+                break;
+
+            default:
+                m_texel_format = TexelFormat::Float32;
+                break;
+        }
+
+        if (m_texel_format == TexelFormat::Float32)
+            m_data = DynamicBuffer<Float>::copy(bitmap->data(),
+                hprod(m_resolution) * Channels);
+        else
+            set_compact_texels(bitmap);
+
+        if (!mip_levels.empty())
+            set_mip_levels(mip_levels);
     }
 
     UnpolarizedSpectrum eval(const SurfaceInteraction3f &si, Mask active) const override {
@@ -312,9 +528,8 @@ public:
                   to_string());
         }
         else {
-            if (m_filter_type == FilterType::Bilinear) {
-                // Storage representation underlying this texture
-                using StorageType = std::conditional_t<Channels == 1, Float, Color3f>;
+            // The MIP-mapped filters use the gradient of the finest level
+            if (m_filter_type != FilterType::Nearest) {
                 using Int4 = Array<Int32, 4>;
                 using Int24 = Array<Int4, 2>;
 
@@ -345,10 +560,10 @@ public:
                         return a;
                 };
 
-                Float f00 = convert_to_monochrome(gather<StorageType>(m_data, index.x(), active));
-                Float f10 = convert_to_monochrome(gather<StorageType>(m_data, index.y(), active));
-                Float f01 = convert_to_monochrome(gather<StorageType>(m_data, index.z(), active));
-                Float f11 = convert_to_monochrome(gather<StorageType>(m_data, index.w(), active));
+                Float f00 = convert_to_monochrome(fetch_texel(index.x(), active));
+                Float f10 = convert_to_monochrome(fetch_texel(index.y(), active));
+                Float f01 = convert_to_monochrome(fetch_texel(index.z(), active));
+                Float f11 = convert_to_monochrome(fetch_texel(index.w(), active));
 
                 // Partials w.r.t. pixel coordinate x and y
                 Vector2f df_xy{ fmadd(w0.y(), f10 - f00, w1.y() * (f11 - f01)),
@@ -401,14 +616,14 @@ public:
     }
 
     MTS_INLINE auto interpolate(const SurfaceInteraction3f &si, Mask active) const {
-        // Storage representation underlying this texture
-        using StorageType = std::conditional_t<Channels == 1, Float, Color3f>;
-
         if constexpr (!is_array_v<Mask>)
             active = true;
 
         Point2f uv = m_transform.transform_affine(si.uv);
 
+        if (m_mip_levels > 1)
+            return eval_mipmap(si, uv, active);
+
         if (m_filter_type == FilterType::Bilinear) {
             using Int4  = Array<Int32, 4>;
             using Int24 = Array<Int4, 2>;
@@ -430,13 +645,22 @@ public:
             Int4 index = uv_i_w.x() + uv_i_w.y() * m_resolution.x();
 
             /// TODO: merge into a single gather with the upcoming Enoki
-            StorageType v00 = gather<StorageType>(m_data, index.x(), active),
-                        v10 = gather<StorageType>(m_data, index.y(), active),
-                        v01 = gather<StorageType>(m_data, index.z(), active),
-                        v11 = gather<StorageType>(m_data, index.w(), active);
+            StorageType v00 = fetch_texel(index.x(), active),
+                        v10 = fetch_texel(index.y(), active),
+                        v01 = fetch_texel(index.z(), active),
+                        v11 = fetch_texel(index.w(), active);
 
             // Bilinear interpolation
             if constexpr (is_spectral_v<Spectrum> && !Raw && Channels == 3) {
+                if (m_interpolate_coefficients) {
+                    // Interpolate the coefficients, then evaluate the model only once
+                    StorageType v0 = fmadd(w0.x(), v00, w1.x() * v10),
+                                v1 = fmadd(w0.x(), v01, w1.x() * v11);
+
+                    return srgb_model_eval<UnpolarizedSpectrum>(
+                        fmadd(w0.y(), v0, w1.y() * v1), si.wavelengths);
+                }
+
                 // Evaluate spectral upsampling model from stored coefficients
                 UnpolarizedSpectrum c00, c10, c01, c11, c0, c1;
 
@@ -465,7 +689,7 @@ public:
 
             Int32 index = uv_i_w.x() + uv_i_w.y() * m_resolution.x();
 
-            StorageType v = gather<StorageType>(m_data, index, active);
+            StorageType v = fetch_texel(index, active);
             if constexpr (is_spectral_v<Spectrum> && !Raw && Channels == 3)
                 return srgb_model_eval<UnpolarizedSpectrum>(v, si.wavelengths);
             else
@@ -473,6 +697,260 @@ public:
         }
     }
 
+    /// Trilinear or EWA lookup into the MIP map, driven by the UV partials of \c si
+    ResultType eval_mipmap(const SurfaceInteraction3f &si, const Point2f &uv,
+                           Mask active) const {
+        ScalarVector2f res(m_resolution);
+        Int32 last = Int32(m_mip_levels - 1);
+
+        // Footprint of the pixel in UV space (after applying the UV transform)
+        Vector2f dst0 = m_transform * si.duv_dx,
+                 dst1 = m_transform * si.duv_dy;
+
+        if (m_filter_type == FilterType::Trilinear) {
+            // Choose the levels based on the largest extent in texels of the finest level
+            Float width = max(norm(dst0 * res), norm(dst1 * res)),
+                  lod   = min(log2(max(width, 1.f)), ScalarFloat(m_mip_levels - 1));
+
+            Int32 level0 = floor2int<Int32>(lod),
+                  level1 = min(level0 + 1, last);
+            Float t = lod - Float(level0);
+
+            ResultType v0 = eval_bilinear(level0, uv, si.wavelengths, active),
+                       v1 = eval_bilinear(level1, uv, si.wavelengths, active && t > 0.f);
+
+            return fmadd(t, v1 - v0, v0);
+        }
+
+        // EWA filtering: swap the axes of the footprint so that 'dst0' is the major one
+        Mask swap = squared_norm(dst0 * res) < squared_norm(dst1 * res);
+        Vector2f tmp = dst0;
+        dst0 = select(swap, dst1, dst0);
+        dst1 = select(swap, tmp, dst1);
+
+        Float major = norm(dst0 * res),
+              minor = norm(dst1 * res);
+
+        // Clamp the eccentricity of the ellipse to bound the number of lookups
+        Mask clamp_aniso = minor * m_max_anisotropy < major && minor > 0.f;
+        Float scale = select(clamp_aniso, major / (minor * m_max_anisotropy), 1.f);
+        dst1 *= scale;
+        minor *= scale;
+
+        // The minor axis determines the level, so that it spans about one texel
+        Mask has_footprint = minor > 0.f;
+        Float lod = max(log2(select(has_footprint, minor, 1.f)), 0.f);
+        Mask filtered = active && has_footprint && lod < Float(last),
+             coarsest = active && has_footprint && lod >= Float(last);
+
+        // Lookups without differentials fall back to bilinear interpolation
+        ResultType result = eval_bilinear(Int32(0), uv, si.wavelengths,
+                                          active && !has_footprint);
+
+        if (any(coarsest))
+            masked(result, coarsest) = eval_bilinear(last, uv, si.wavelengths, coarsest);
+
+        if (any(filtered)) {
+            Int32 level = floor2int<Int32>(lod);
+            Float t = lod - Float(level);
+
+            ResultType v0 = eval_ewa(level, uv, dst0, dst1, si.wavelengths, filtered),
+                       v1 = eval_ewa(level + 1, uv, dst0, dst1, si.wavelengths,
+                                     filtered && t > 0.f);
+
+            masked(result, filtered) = fmadd(t, v1 - v0, v0);
+        }
+
+        return result;
+    }
+
+    /// Bilinear interpolation on a level of the MIP map
+    ResultType eval_bilinear(const Int32 &level, const Point2f &uv_,
+                             const Wavelength &wavelengths, Mask active) const {
+        Vector2i res = level_resolution(level);
+
+        // Scale to level resolution and apply shift
+        Point2f uv = fmadd(uv_, Vector2f(res), -.5f);
+
+        // Integer pixel positions for bilinear interpolation
+        Vector2i uv_i = floor2int<Vector2i>(uv);
+
+        // Interpolation weights
+        Point2f w1 = uv - Point2f(uv_i),
+                w0 = 1.f - w1;
+
+        ResultType v00 = fetch(level, uv_i, res, wavelengths, active),
+                   v10 = fetch(level, uv_i + Vector2i(1, 0), res, wavelengths, active),
+                   v01 = fetch(level, uv_i + Vector2i(0, 1), res, wavelengths, active),
+                   v11 = fetch(level, uv_i + Vector2i(1, 1), res, wavelengths, active);
+
+        ResultType v0 = fmadd(w0.x(), v00, w1.x() * v10),
+                   v1 = fmadd(w0.x(), v01, w1.x() * v11);
+
+        return fmadd(w0.y(), v0, w1.y() * v1);
+    }
+
+    /**
+     * \brief Elliptically weighted average on a level of the MIP map
+     *
+     * Follows the formulation of PBRT: the ellipse spanned by the two UV
+     * partials is widened by one texel, and texels within it are weighted
+     * by a truncated Gaussian.
+     */
+    ResultType eval_ewa(const Int32 &level, const Point2f &uv_, Vector2f dst0,
+                        Vector2f dst1, const Wavelength &wavelengths,
+                        Mask active) const {
+        Vector2i res = level_resolution(level);
+        Vector2f res_f(res);
+
+        // Convert the lookup position and footprint into texels of this level
+        Point2f uv = fmadd(uv_, res_f, -.5f);
+        dst0 *= res_f;
+        dst1 *= res_f;
+
+        // Implicit ellipse equation A s^2 + B s t + C t^2 < 1
+        Float A = sqr(dst0.y()) + sqr(dst1.y()) + 1.f,
+              B = -2.f * (dst0.x() * dst0.y() + dst1.x() * dst1.y()),
+              C = sqr(dst0.x()) + sqr(dst1.x()) + 1.f,
+              inv_f = rcp(A * C - B * B * .25f);
+        A *= inv_f;
+        B *= inv_f;
+        C *= inv_f;
+
+        // Bounding box of the ellipse in texel space
+        Float det     = 4.f * A * C - B * B,
+              inv_det = rcp(det),
+              u_ext   = 2.f * inv_det * safe_sqrt(det * C),
+              v_ext   = 2.f * inv_det * safe_sqrt(det * A);
+
+        Int32 s0 = ceil2int<Int32>(uv.x() - u_ext),
+              s1 = floor2int<Int32>(uv.x() + u_ext),
+              t0 = ceil2int<Int32>(uv.y() - v_ext),
+              t1 = floor2int<Int32>(uv.y() + v_ext);
+
+        const ScalarFloat alpha = 2.f, weight_offset = std::exp(-alpha);
+
+        ResultType sum = zero<ResultType>();
+        Float weight_sum = 0.f;
+
+        Int32 t = t0;
+        Mask active_t = active && t <= t1;
+        while (any(active_t)) {
+            Int32 s = s0;
+            Mask active_s = active_t && s <= s1;
+            while (any(active_s)) {
+                Float ds = Float(s) - uv.x(),
+                      dt = Float(t) - uv.y(),
+                      r2 = A * ds * ds + B * ds * dt + C * dt * dt;
+
+                Mask inside = active_s && r2 < 1.f;
+                Float weight = exp(-alpha * r2) - weight_offset;
+
+                masked(sum, inside) +=
+                    weight * fetch(level, Vector2i(s, t), res, wavelengths, inside);
+                masked(weight_sum, inside) += weight;
+
+                s += 1;
+                active_s &= s <= s1;
+            }
+            t += 1;
+            active_t &= t <= t1;
+        }
+
+        return sum * select(weight_sum > 0.f, rcp(weight_sum), 0.f);
+    }
+
+    /// Resolution of a level of the MIP map
+    MTS_INLINE Vector2i level_resolution(const Int32 &level) const {
+        return max(Vector2i(Int32(m_resolution.x()) >> level,
+                            Int32(m_resolution.y()) >> level), 1);
+    }
+
+    /// Apply the wrap mode to integer texel positions on a level of resolution \c res
+    MTS_INLINE Vector2i wrap_level(const Vector2i &p, const Vector2i &res) const {
+        if (m_wrap_mode == WrapMode::Clamp)
+            return clamp(p, 0, res - 1);
+
+        // The resolution varies per lane, use floating point division
+        Vector2i div = floor2int<Vector2i>(Vector2f(p) / Vector2f(res)),
+                 mod = clamp(p - div * res, 0, res - 1);
+
+        if (m_wrap_mode == WrapMode::Mirror)
+            mod = select(eq(div & 1, 0), mod, res - 1 - mod);
+
+        return mod;
+    }
+
+    /// Fetch a texel from a level of the MIP map (level 0 refers to \c m_data)
+    MTS_INLINE ResultType fetch(const Int32 &level, const Vector2i &p, const Vector2i &res,
+                                const Wavelength &wavelengths, Mask active) const {
+        Vector2i p_w = wrap_level(p, res);
+        Int32 index = p_w.x() + p_w.y() * res.x();
+
+        Mask finest = eq(level, 0),
+             coarse = active && !finest;
+
+        StorageType v = fetch_texel(index, active && finest);
+        index += gather<Int32>(m_mip_offset, level, coarse);
+        masked(v, coarse) = gather<StorageType>(m_mip_data, index, coarse);
+
+        if constexpr (is_spectral_v<Spectrum> && !Raw && Channels == 3) {
+            return srgb_model_eval<UnpolarizedSpectrum>(v, wavelengths);
+        } else {
+            ENOKI_MARK_USED(wavelengths);
+            return v;
+        }
+    }
+
+    /// Fetch a texel of the finest level
+    MTS_INLINE StorageType fetch_texel(const Int32 &index, Mask active) const {
+        if (m_texel_format == TexelFormat::Float32)
+            return gather<StorageType>(m_data, index, active);
+        else
+            return decode_texel(index, active);
+    }
+
+    /**
+     * \brief Fetch and decode a texel stored in the compact representation
+     *
+     * Single-channel texels are packed into 32-bit words (4 components with
+     * 8 bits or 2 with 16 bits), while RGB texels occupy one (8 bits) or two
+     * (16 bits) words. See \ref set_compact_texels().
+     */
+    MTS_INLINE StorageType decode_texel(const Int32 &index_, Mask active) const {
+        UInt32 index = UInt32(index_);
+
+        if constexpr (Channels == 1) {
+            uint32_t shift = m_texel_format == TexelFormat::Float16 ? 1 : 2,
+                     bits  = 32 >> shift;
+            UInt32 word = gather<UInt32>(m_texels, index >> shift, active);
+            return decode_component(
+                (word >> ((index & ((1u << shift) - 1)) * bits)) & ((1u << bits) - 1),
+                active);
+        } else {
+            if (m_texel_format == TexelFormat::Float16) {
+                using UInt32x2 = Array<UInt32, 2>;
+                UInt32x2 words = gather<UInt32x2>(m_texels, index, active);
+                return StorageType(decode_component(words.x() & 0xffffu, active),
+                                   decode_component(words.x() >> 16, active),
+                                   decode_component(words.y() & 0xffffu, active));
+            } else {
+                UInt32 word = gather<UInt32>(m_texels, index, active);
+                return StorageType(decode_component(word & 0xffu, active),
+                                   decode_component((word >> 8) & 0xffu, active),
+                                   decode_component((word >> 16) & 0xffu, active));
+            }
+        }
+    }
+
+    /// Convert a half precision or 8-bit component into a linear floating point value
+    MTS_INLINE Float decode_component(const UInt32 &value, Mask active) const {
+        if (m_texel_format == TexelFormat::Float16)
+            return detail::half_to_float<Float>(value);
+        else
+            return gather<Float>(m_lut, value, active);
+    }
+
     std::pair<Point2f, Float> sample_position(const Point2f &sample,
                                               Mask active = true) const override {
         if (!m_distr2d) {
@@ -524,7 +1002,7 @@ public:
             }
         }
 
-        if (m_filter_type == FilterType::Bilinear) {
+        if (m_filter_type != FilterType::Nearest) {
             using Int4  = Array<Int32, 4>;
             using Int24 = Array<Int4, 2>;
 
@@ -559,7 +1037,9 @@ public:
     }
 
     void traverse(TraversalCallback *callback) override {
-        callback->put_parameter("data", m_data);
+        // The compact representation can't be modified
+        if (m_texel_format == TexelFormat::Float32)
+            callback->put_parameter("data", m_data);
         callback->put_parameter("resolution", m_resolution);
         callback->put_parameter("transform", m_transform);
     }
@@ -568,6 +1048,9 @@ public:
         if (keys.empty() || string::contains(keys, "data")) {
             /// Convert m_data into a managed array (available in CPU/GPU address space)
             rebuild_internals(true, m_distr2d != nullptr);
+
+            if (m_mip_levels > 1 && m_texel_format == TexelFormat::Float32)
+                rebuild_mip_levels();
         }
     }
 
@@ -579,13 +1062,17 @@ public:
 
     bool is_spatially_varying() const override { return true; }
 
+    bool needs_differentials() const override { return m_mip_levels > 1; }
+
     std::string to_string() const override {
         std::ostringstream oss;
         oss << "BitmapTextureImpl[" << std::endl
             << "  name = \"" << m_name << "\"," << std::endl
             << "  resolution = \"" << m_resolution << "\"," << std::endl
             << "  raw = " << (int) Raw << "," << std::endl
+            << "  texel_format = " << texel_format_name() << "," << std::endl
             << "  mean = " << m_mean << "," << std::endl
+            << "  mip_levels = " << m_mip_levels << "," << std::endl
             << "  transform = " << string::indent(m_transform) << std::endl
             << "]";
         return oss.str();
@@ -600,8 +1087,15 @@ protected:
      */
     void rebuild_internals(bool init_mean, bool init_distr) {
         // Recompute the mean texture value following an update
-        m_data = m_data.managed();
-        const ScalarFloat *ptr = m_data.data();
+        std::unique_ptr<ScalarFloat[]> decoded;
+        const ScalarFloat *ptr;
+        if (m_texel_format == TexelFormat::Float32) {
+            m_data = m_data.managed();
+            ptr = m_data.data();
+        } else {
+            decoded = decode_texels();
+            ptr = decoded.get();
+        }
 
         double mean = 0.0;
         size_t pixel_count = (size_t) hprod(m_resolution);
@@ -652,6 +1146,117 @@ protected:
                 "exceed the [0, 1] range!", m_name);
     }
 
+    /// Upload the coarser levels of the MIP map into a single buffer
+    void set_mip_levels(const std::vector<ref<Bitmap>> &levels) {
+        m_mip_levels = (uint32_t) levels.size() + 1;
+
+        std::unique_ptr<int32_t[]> offset(new int32_t[m_mip_levels]);
+        size_t pixel_count = 0;
+        offset[0] = 0;
+        for (size_t i = 0; i < levels.size(); ++i) {
+            offset[i + 1] = (int32_t) pixel_count;
+            pixel_count += levels[i]->pixel_count();
+        }
+
+        std::unique_ptr<ScalarFloat[]> data(new ScalarFloat[pixel_count * Channels]);
+        for (size_t i = 0; i < levels.size(); ++i)
+            memcpy(data.get() + offset[i + 1] * Channels, levels[i]->data(),
+                   levels[i]->buffer_size());
+
+        m_mip_offset = DynamicBuffer<Int32>::copy(offset.get(), m_mip_levels);
+        m_mip_data = DynamicBuffer<Float>::copy(data.get(), pixel_count * Channels);
+    }
+
+    /**
+     * \brief Pack the texels of the image into a buffer of 32-bit words
+     *
+     * This relies on a little endian byte order, which is also assumed by
+     * \ref decode_texel().
+     */
+    void set_compact_texels(const Bitmap *bitmap) {
+        size_t component_size = m_texel_format == TexelFormat::Float16 ? 2 : 1,
+               texel_size = component_size * (Channels == 1 ? 1 : 4),
+               texels_per_word = std::max(sizeof(uint32_t) / texel_size, (size_t) 1),
+               texel_count = (bitmap->pixel_count() + texels_per_word - 1) /
+                             texels_per_word * texels_per_word;
+
+        size_t word_count = texel_count * texel_size / sizeof(uint32_t);
+        std::unique_ptr<uint32_t[]> words(new uint32_t[word_count]());
+
+        const uint8_t *src = bitmap->uint8_data();
+        uint8_t *dst = (uint8_t *) words.get();
+        for (size_t j = 0; j < bitmap->pixel_count(); ++j)
+            memcpy(dst + j * texel_size, src + j * Channels * component_size,
+                   Channels * component_size);
+
+        m_texels = DynamicBuffer<UInt32>::copy(words.get(), word_count);
+
+        if (m_texel_format != TexelFormat::Float16) {
+            // Lookup table to convert 8-bit components into linear values
+            ScalarFloat lut[256];
+            for (int i = 0; i < 256; ++i)
+                lut[i] = (ScalarFloat) detail::uint8_to_float(
+                    (uint8_t) i, m_texel_format == TexelFormat::SRGB8);
+            m_lut = DynamicBuffer<Float>::copy(lut, 256);
+        }
+
+        Log(Debug, "BitmapTexture: storing texture \"%s\" using %s (%s texels)",
+            m_name, util::mem_string(word_count * sizeof(uint32_t)), texel_format_name());
+    }
+
+    /// Decode the finest level of the compact representation on the host
+    std::unique_ptr<ScalarFloat[]> decode_texels() {
+        m_texels = m_texels.managed();
+
+        size_t pixel_count = (size_t) hprod(m_resolution),
+               component_size = m_texel_format == TexelFormat::Float16 ? 2 : 1,
+               texel_size = component_size * (Channels == 1 ? 1 : 4);
+        const uint8_t *src = (const uint8_t *) m_texels.data();
+
+        std::unique_ptr<ScalarFloat[]> result(new ScalarFloat[pixel_count * Channels]);
+        for (size_t i = 0; i < pixel_count; ++i) {
+            for (size_t ch = 0; ch < Channels; ++ch) {
+                const uint8_t *value = src + i * texel_size + ch * component_size;
+                if (m_texel_format == TexelFormat::Float16) {
+                    uint16_t bits;
+                    memcpy(&bits, value, sizeof(uint16_t));
+                    result[i * Channels + ch] =
+                        detail::half_to_float<ScalarFloat>((uint32_t) bits);
+                } else {
+                    result[i * Channels + ch] = (ScalarFloat) detail::uint8_to_float(
+                        *value, m_texel_format == TexelFormat::SRGB8);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    const char *texel_format_name() const {
+        switch (m_texel_format) {
+            case TexelFormat::Float16: return "float16";
+            case TexelFormat::UInt8:   return "uint8";
+            case TexelFormat::SRGB8:   return "uint8 (sRGB)";
+            default:                   return "float32";
+        }
+    }
+
+    /// Recompute the coarser levels of the MIP map following an update of \c m_data
+    void rebuild_mip_levels() {
+        if constexpr (is_spectral_v<Spectrum> && !Raw && Channels == 3) {
+            Log(Warn, "BitmapTexture: the MIP map of texture \"%s\" can't be "
+                      "rebuilt from spectral coefficients, keeping the previous "
+                      "levels.", m_name);
+        } else {
+            // 'm_data' was converted into a managed array by rebuild_internals()
+            ref<Bitmap> bitmap = new Bitmap(
+                Channels == 1 ? Bitmap::PixelFormat::Y : Bitmap::PixelFormat::RGB,
+                struct_type_v<ScalarFloat>, Bitmap::Vector2u(m_resolution));
+            memcpy(bitmap->data(), m_data.data(), bitmap->buffer_size());
+            set_mip_levels(detail::build_mip_levels(bitmap, m_wrap_mode));
+        }
+    }
+
 protected:
     DynamicBuffer<Float> m_data;
     ScalarVector2i m_resolution;
@@ -663,6 +1268,19 @@ protected:
     FilterType m_filter_type;
     WrapMode m_wrap_mode;
 
+    // Coarser levels of the MIP map (trilinear and EWA filters only)
+    DynamicBuffer<Float> m_mip_data;
+    DynamicBuffer<Int32> m_mip_offset;
+    uint32_t m_mip_levels = 1;
+    ScalarFloat m_max_anisotropy;
+    bool m_interpolate_coefficients;
+
+    /* Compact representation of the finest level (8-bit or half precision
+       texels), and lookup table that converts 8-bit components into linear values */
+    TexelFormat m_texel_format;
+    DynamicBuffer<UInt32> m_texels;
+    DynamicBuffer<Float> m_lut;
+
     // Optional: distribution for importance sampling
     mutable tbb::spin_mutex m_mutex;
     std::unique_ptr<DiscreteDistribution2D<Float>> m_distr2d;
@@ -0,0 +1,458 @@
+#include <mitsuba/core/mmap.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/texture.h>
+#include <mitsuba/render/volume_texture.h>
+#include <tbb/parallel_for.h>
+
+#include "volume_data.h"
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _volume-brickvolume:
+
+Sparse bricked volume (:monosp:`brickvolume`)
+---------------------------------------------
+
+.. pluginparameters::
+
+ * - filename
+   - |string|
+   - Filename of the single-channel volume to be loaded (binary ``VOL`` file,
+     version 3)
+
+ * - storage
+   - |string|
+   - Precision of the stored voxel values. The following options are available:
+
+     - ``float32`` (default): store the values without loss of precision.
+
+     - ``uint16``: quantize the values to 16 bits relative to the value range
+       of the surrounding brick.
+
+     - ``uint8``: quantize the values to 8 bits relative to the value range
+       of the surrounding brick.
+
+ * - filter_type
+   - |string|
+   - ``trilinear`` (default) or ``nearest`` interpolation of the voxel values.
+
+ * - wrap_mode
+   - |string|
+   - Behavior of lookups outside of the volume: ``repeat``, ``mirror``, or
+     ``clamp`` (default).
+
+ * - use_grid_bbox
+   - |bool|
+   - Use the bounding box stored in the volume file (Default: false)
+
+ * - to_world
+   - |transform|
+   - Specifies an optional transformation of the volume's unit cube.
+
+This plugin provides a memory-efficient alternative to :monosp:`gridvolume` for
+large and sparse density grids (e.g. smoke). The input file is memory-mapped
+and streamed into bricks of :math:`8^3` voxels without ever holding a dense copy
+of the data. Bricks whose voxels all share the same value (in particular empty
+space) do not occupy any storage: their entry in the brick table refers to a
+shared zero brick and encodes the constant value instead.
+
+Lookups first fetch the entry of the brick containing a voxel and then the
+voxel value from the brick pool. The conversion of the stored values back into
+floating point is folded into the same per-brick offset and scale, hence the
+quantized modes do not incur any extra cost.
+
+*/
+
+enum class FilterType { Nearest, Trilinear };
+enum class WrapMode { Repeat, Mirror, Clamp };
+
+/// Number of voxels along each side of a brick
+#define MTS_BRICK_SIZE 8
+
+template <typename Float, typename Spectrum>
+class BrickVolume final : public Volume<Float, Spectrum> {
+public:
+    MTS_IMPORT_BASE(Volume, update_bbox, m_world_to_local)
+    MTS_IMPORT_TYPES()
+
+    static constexpr uint32_t BrickVoxels = MTS_BRICK_SIZE * MTS_BRICK_SIZE * MTS_BRICK_SIZE;
+
+    BrickVolume(const Properties &props) : Base(props) {
+        std::string filter_type = props.string("filter_type", "trilinear");
+        if (filter_type == "nearest")
+            m_filter_type = FilterType::Nearest;
+        else if (filter_type == "trilinear")
+            m_filter_type = FilterType::Trilinear;
+        else
+            Throw("Invalid filter type \"%s\", must be one of: \"nearest\" or "
+                  "\"trilinear\"!", filter_type);
+
+        std::string wrap_mode = props.string("wrap_mode", "clamp");
+        if (wrap_mode == "repeat")
+            m_wrap_mode = WrapMode::Repeat;
+        else if (wrap_mode == "mirror")
+            m_wrap_mode = WrapMode::Mirror;
+        else if (wrap_mode == "clamp")
+            m_wrap_mode = WrapMode::Clamp;
+        else
+            Throw("Invalid wrap mode \"%s\", must be one of: \"repeat\", "
+                  "\"mirror\", or \"clamp\"!", wrap_mode);
+
+        std::string storage = props.string("storage", "float32");
+        if (storage == "float32")
+            m_bits = 32;
+        else if (storage == "uint16")
+            m_bits = 16;
+        else if (storage == "uint8")
+            m_bits = 8;
+        else
+            Throw("Invalid storage type \"%s\", must be one of: \"float32\", "
+                  "\"uint16\", or \"uint8\"!", storage);
+
+        auto [metadata, mmap, values] = map_binary_volume_data<Float>(props.string("filename"));
+        m_metadata = metadata;
+        if (m_metadata.channel_count != 1)
+            Throw("Only single-channel volumes are supported (\"%s\" has %i channels)",
+                  m_metadata.filename, m_metadata.channel_count);
+
+        m_inv_resolution_x = enoki::divisor<int32_t>(m_metadata.shape.x());
+        m_inv_resolution_y = enoki::divisor<int32_t>(m_metadata.shape.y());
+        m_inv_resolution_z = enoki::divisor<int32_t>(m_metadata.shape.z());
+
+        build(values);
+
+        if (props.bool_("use_grid_bbox", false)) {
+            m_world_to_local = m_metadata.transform * m_world_to_local;
+            update_bbox();
+        }
+    }
+
+    UnpolarizedSpectrum eval(const Interaction3f &it, Mask active) const override {
+        return UnpolarizedSpectrum(eval_1(it, active));
+    }
+
+    Float eval_1(const Interaction3f &it, Mask active = true) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        auto p = m_world_to_local * it.p;
+        if (none_or<false>(active))
+            return 0.f;
+        return select(active, interpolate(p, active), 0.f);
+    }
+
+    Vector3f eval_3(const Interaction3f & /* it */, Mask /* active */ = true) const override {
+        Throw("eval_3(): The BrickVolume texture %s was queried for a 3D vector, but it has "
+              "only a single channel!", to_string());
+    }
+
+    ScalarFloat max() const override { return m_metadata.max; }
+    ScalarVector3i resolution() const override { return m_metadata.shape; };
+
+    std::vector<ScalarFloat> max_per_cell(const ScalarBoundingBox3f &bbox,
+                                          const ScalarVector3u &resolution) const override {
+        const ScalarVector3i shape = m_metadata.shape;
+        const ScalarVector3f shape_f(shape);
+        ScalarVector3f cell_size = bbox.extents() / ScalarVector3f(resolution);
+        std::vector<ScalarFloat> result(hprod(resolution));
+
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0, resolution.z()),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t z = range.begin(); z != range.end(); ++z) {
+                    for (uint32_t y = 0; y < resolution.y(); ++y) {
+                        for (uint32_t x = 0; x < resolution.x(); ++x) {
+                            // Bounding box of the cell in the volume's local coordinates
+                            ScalarPoint3f p_min = bbox.min + ScalarVector3f(x, y, z) * cell_size;
+                            ScalarBoundingBox3f local;
+                            for (int i = 0; i < 8; ++i) {
+                                ScalarVector3f offset((i & 1) ? cell_size.x() : 0.f,
+                                                      (i & 2) ? cell_size.y() : 0.f,
+                                                      (i & 4) ? cell_size.z() : 0.f);
+                                local.expand(m_world_to_local * (p_min + offset));
+                            }
+
+                            // Range of voxels that can influence lookups within the cell
+                            ScalarVector3i lo, hi;
+                            if (m_filter_type == FilterType::Trilinear) {
+                                lo = floor2int<ScalarVector3i>(fmadd(local.min, shape_f, -.5f));
+                                hi = floor2int<ScalarVector3i>(fmadd(local.max, shape_f, -.5f)) + 1;
+                            } else {
+                                lo = floor2int<ScalarVector3i>(local.min * shape_f);
+                                hi = floor2int<ScalarVector3i>(local.max * shape_f);
+                            }
+
+                            // Wrapped lookups outside of the grid may touch any brick along an axis
+                            for (int i = 0; i < 3; ++i) {
+                                if (m_wrap_mode != WrapMode::Clamp &&
+                                    (lo[i] < 0 || hi[i] >= shape[i])) {
+                                    lo[i] = 0;
+                                    hi[i] = shape[i] - 1;
+                                }
+                            }
+                            lo = clamp(lo, 0, shape - 1) / MTS_BRICK_SIZE;
+                            hi = clamp(hi, 0, shape - 1) / MTS_BRICK_SIZE;
+
+                            // Use the per-brick maxima, which is conservative
+                            ScalarFloat value = 0.f;
+                            for (int32_t k = lo.z(); k <= hi.z(); ++k)
+                                for (int32_t j = lo.y(); j <= hi.y(); ++j)
+                                    for (int32_t i = lo.x(); i <= hi.x(); ++i)
+                                        value = std::max(value, m_brick_max[
+                                            (size_t(k) * m_brick_count.y() + j) * m_brick_count.x() + i]);
+
+                            result[(size_t(z) * resolution.y() + y) * resolution.x() + x] = value;
+                        }
+                    }
+                }
+            });
+
+        return result;
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "BrickVolume[" << std::endl
+            << "  world_to_local = " << m_world_to_local << "," << std::endl
+            << "  dimensions = " << m_metadata.shape << "," << std::endl
+            << "  bricks = " << m_brick_count << "," << std::endl
+            << "  occupied_bricks = " << m_occupied_bricks << "," << std::endl
+            << "  storage = " << (m_bits == 32 ? "float32" : (m_bits == 16 ? "uint16" : "uint8")) << "," << std::endl
+            << "  mean = " << m_metadata.mean << "," << std::endl
+            << "  max = " << m_metadata.max << "," << std::endl
+            << "  memory = " << util::mem_string(memory_size()) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+protected:
+    /// Stream the mapped dense grid into the brick table and pool
+    void build(const float *values) {
+        const ScalarVector3i shape = m_metadata.shape;
+        m_brick_count = (shape + (MTS_BRICK_SIZE - 1)) / MTS_BRICK_SIZE;
+        size_t brick_count = hprod(m_brick_count);
+
+        auto brick_origin = [&](size_t index) {
+            return ScalarVector3i(int32_t(index % m_brick_count.x()),
+                                  int32_t((index / m_brick_count.x()) % m_brick_count.y()),
+                                  int32_t(index / (size_t(m_brick_count.x()) * m_brick_count.y()))) *
+                   MTS_BRICK_SIZE;
+        };
+
+        // Voxels beyond the end of the grid replicate the last one (never accessed)
+        auto voxel = [&](const ScalarVector3i &origin, uint32_t i) {
+            ScalarVector3i p = min(origin + ScalarVector3i(i % MTS_BRICK_SIZE,
+                                                           (i / MTS_BRICK_SIZE) % MTS_BRICK_SIZE,
+                                                           i / (MTS_BRICK_SIZE * MTS_BRICK_SIZE)),
+                                   shape - 1);
+            return values[(size_t(p.z()) * shape.y() + p.y()) * shape.x() + p.x()];
+        };
+
+        // 1. Value range (and sum) of every brick
+        std::vector<ScalarFloat> brick_min(brick_count);
+        std::vector<double> brick_sum(brick_count);
+        m_brick_max.resize(brick_count);
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, brick_count),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t b = range.begin(); b != range.end(); ++b) {
+                    ScalarVector3i origin = brick_origin(b),
+                                   size   = min(shape - origin, MTS_BRICK_SIZE);
+                    ScalarFloat v_min = math::Infinity<ScalarFloat>,
+                                v_max = -math::Infinity<ScalarFloat>;
+                    double sum = 0.0;
+                    for (int32_t z = 0; z < size.z(); ++z) {
+                        for (int32_t y = 0; y < size.y(); ++y) {
+                            const float *row = values + ((size_t(origin.z() + z) * shape.y() +
+                                                          origin.y() + y) * shape.x() + origin.x());
+                            for (int32_t x = 0; x < size.x(); ++x) {
+                                v_min = std::min(v_min, (ScalarFloat) row[x]);
+                                v_max = std::max(v_max, (ScalarFloat) row[x]);
+                                sum += row[x];
+                            }
+                        }
+                    }
+                    brick_min[b] = v_min;
+                    m_brick_max[b] = v_max;
+                    brick_sum[b] = sum;
+                }
+            });
+
+        // 2. Assign pool slots to non-uniform bricks. Slot 0 is a shared zero brick.
+        std::unique_ptr<uint32_t[]> brick_offset(new uint32_t[brick_count]);
+        std::unique_ptr<ScalarFloat[]> brick_range(new ScalarFloat[brick_count * 2]);
+        const ScalarFloat quant_max = ScalarFloat((uint64_t(1) << m_bits) - 1);
+        double sum = 0.0;
+        m_metadata.max = -math::Infinity<ScalarFloat>;
+        m_occupied_bricks = 0;
+        for (size_t b = 0; b < brick_count; ++b) {
+            ScalarFloat v_min = brick_min[b], v_max = m_brick_max[b];
+            sum += brick_sum[b];
+            m_metadata.max = std::max(m_metadata.max, v_max);
+            if (v_min == v_max) {
+                brick_offset[b] = 0;
+                brick_range[2 * b] = v_min;
+                brick_range[2 * b + 1] = 0.f;
+            } else {
+                brick_offset[b] = ++m_occupied_bricks * BrickVoxels;
+                brick_range[2 * b] = m_bits == 32 ? 0.f : v_min;
+                brick_range[2 * b + 1] = m_bits == 32 ? 1.f : (v_max - v_min) / quant_max;
+            }
+        }
+        m_metadata.mean = sum / (double) hprod(shape);
+
+        // 3. Quantize the non-uniform bricks directly into the pool
+        const uint32_t brick_words = BrickVoxels * m_bits / 32;
+        m_pool = empty<DynamicBuffer<UInt32>>((size_t(m_occupied_bricks) + 1) * brick_words);
+        m_pool.managed();
+        if constexpr (is_cuda_array_v<Float>)
+            cuda_sync();
+
+        uint32_t *pool = (uint32_t *) m_pool.data();
+        memset(pool, 0, brick_words * sizeof(uint32_t));
+
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, brick_count),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t b = range.begin(); b != range.end(); ++b) {
+                    if (brick_offset[b] == 0)
+                        continue;
+                    ScalarVector3i origin = brick_origin(b);
+                    uint32_t *words = pool + size_t(brick_offset[b]) * m_bits / 32;
+
+                    if (m_bits == 32) {
+                        for (uint32_t i = 0; i < BrickVoxels; ++i)
+                            words[i] = memcpy_cast<uint32_t>(voxel(origin, i));
+                        continue;
+                    }
+
+                    const uint32_t per_word = 32 / m_bits;
+                    ScalarFloat v_min = brick_range[2 * b],
+                                inv_scale = 1.f / brick_range[2 * b + 1];
+                    for (uint32_t i = 0; i < BrickVoxels; i += per_word) {
+                        uint32_t word = 0;
+                        for (uint32_t j = 0; j < per_word; ++j) {
+                            ScalarFloat q = std::round((voxel(origin, i + j) - v_min) * inv_scale);
+                            word |= uint32_t(std::min(std::max(q, 0.f), quant_max)) << (j * m_bits);
+                        }
+                        words[i / per_word] = word;
+                    }
+                }
+            });
+
+        m_bricks = DynamicBuffer<UInt32>::copy(brick_offset.get(), brick_count);
+        m_brick_ranges = DynamicBuffer<Float>::copy(brick_range.get(), brick_count * 2);
+
+        Log(Debug, "Loaded bricked volume \"%s\": %i of %i bricks occupied, %s (dense: %s)",
+            m_metadata.filename, m_occupied_bricks, brick_count,
+            util::mem_string(memory_size()),
+            util::mem_string(hprod(shape) * sizeof(float)));
+    }
+
+    size_t memory_size() const {
+        return m_pool.size() * sizeof(uint32_t) + m_bricks.size() * sizeof(uint32_t) +
+               m_brick_ranges.size() * sizeof(ScalarFloat);
+    }
+
+    /// Two-level lookup of a voxel value (first the brick, then the voxel)
+    MTS_INLINE Float lookup(const Vector3i &p, Mask active) const {
+        Vector3i brick = sri<3>(p),
+                 local = p & (MTS_BRICK_SIZE - 1);
+
+        Int32 brick_index =
+            fmadd(fmadd(brick.z(), m_brick_count.y(), brick.y()), m_brick_count.x(), brick.x());
+        UInt32 offset = gather<UInt32>(m_bricks, brick_index, active);
+        Vector2f range = gather<Vector2f>(m_brick_ranges, brick_index, active);
+
+        UInt32 index = offset + UInt32(fmadd(fmadd(local.z(), MTS_BRICK_SIZE, local.y()),
+                                             MTS_BRICK_SIZE, local.x()));
+        Float value;
+        if (m_bits == 32) {
+            UInt32 word = gather<UInt32>(m_pool, index, active);
+            value = Float(reinterpret_array<float32_array_t<Float>>(word));
+        } else {
+            uint32_t shift = m_bits == 16 ? 1 : 2;
+            UInt32 word = gather<UInt32>(m_pool, index >> shift, active);
+            value = Float((word >> ((index & ((1u << shift) - 1)) * m_bits)) &
+                          ((1u << m_bits) - 1));
+        }
+
+        return fmadd(range.y(), value, range.x());
+    }
+
+    Float interpolate(Point3f p, Mask active) const {
+        if (m_filter_type == FilterType::Trilinear) {
+            // Scale to volume resolution and apply shift
+            p = fmadd(p, m_metadata.shape, -.5f);
+
+            Vector3i p_i = floor2int<Vector3i>(p);
+            Point3f w1 = p - Point3f(p_i),
+                    w0 = 1.f - w1;
+
+            Float result = 0.f;
+            for (int i = 0; i < 8; ++i) {
+                Vector3i offset(i & 1, (i >> 1) & 1, i >> 2);
+                Float weight = ((i & 1) ? w1.x() : w0.x()) *
+                               ((i & 2) ? w1.y() : w0.y()) *
+                               ((i & 4) ? w1.z() : w0.z());
+                result = fmadd(weight, lookup(wrap(p_i + offset), active), result);
+            }
+            return result;
+        } else {
+            // Scale to volume resolution, no shift
+            p *= m_metadata.shape;
+            return lookup(wrap(floor2int<Vector3i>(p)), active);
+        }
+    }
+
+    template <typename T> T wrap(const T &value) const {
+        if (m_wrap_mode == WrapMode::Clamp) {
+            return clamp(value, 0, m_metadata.shape - 1);
+        } else {
+            T div = T(m_inv_resolution_x(value.x()),
+                      m_inv_resolution_y(value.y()),
+                      m_inv_resolution_z(value.z())),
+              mod = value - div * m_metadata.shape;
+
+            masked(mod, mod < 0) += T(m_metadata.shape);
+
+            if (m_wrap_mode == WrapMode::Mirror)
+                mod = select(eq(div & 1, 0) ^ (value < 0), mod, m_metadata.shape - 1 - mod);
+
+            return mod;
+        }
+    }
+
+protected:
+    VolumeMetadata m_metadata;
+    FilterType m_filter_type;
+    WrapMode m_wrap_mode;
+    enoki::divisor<int32_t> m_inv_resolution_x, m_inv_resolution_y, m_inv_resolution_z;
+
+    /// Number of bits per stored voxel value (32, 16 or 8)
+    uint32_t m_bits;
+
+    /// Number of bricks along each axis
+    ScalarVector3i m_brick_count;
+    /// Number of bricks that have storage in the pool
+    uint32_t m_occupied_bricks;
+
+    /// Brick table: offset of every brick in the pool (in voxels)
+    DynamicBuffer<UInt32> m_bricks;
+    /// Brick table: offset and scale used to decode the brick's voxels
+    DynamicBuffer<Float> m_brick_ranges;
+    /// Packed voxel values of all occupied bricks
+    DynamicBuffer<UInt32> m_pool;
+    /// Maximum value of every brick (used to build majorant grids)
+    std::vector<ScalarFloat> m_brick_max;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(BrickVolume, Volume)
+MTS_EXPORT_PLUGIN(BrickVolume, "Sparse bricked volume")
+NAMESPACE_END(mitsuba)
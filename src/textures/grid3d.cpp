@@ -7,6 +7,8 @@
 #include <mitsuba/render/srgb.h>
 #include <mitsuba/render/texture.h>
 #include <mitsuba/render/volume_texture.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
 
 #include "volume_data.h"
 
@@ -25,7 +27,11 @@ class GridVolumeImpl;
  *
  * This plugin loads RGB data from a binary file. When appropriate,
  * spectral upsampling is applied at loading time to convert RGB values
- * to spectra that can be used in the renderer.
+ * to spectra that can be used in the renderer. Setting the boolean
+ * 'interpolate_coefficients' parameter interpolates the coefficients of the
+ * spectral upsampling model instead of the spectra of the 8 neighboring
+ * voxels, which requires a single evaluation of the model per lookup but
+ * only approximates the interpolated spectrum.
  *
  * Data layout:
  * The data must be ordered so that the following C-style (row-major) indexing
@@ -65,25 +71,36 @@ public:
         m_metadata                = metadata;
         m_raw                     = props.bool_("raw", false);
         ScalarUInt32 size         = hprod(m_metadata.shape);
+        bool finite               = props.bool_("interpolate_coefficients", false);
         // Apply spectral conversion if necessary
         if (is_spectral_v<Spectrum> && m_metadata.channel_count == 3 && !m_raw) {
-            ScalarFloat *ptr = raw_data.get();
+            const ScalarFloat *ptr = raw_data.get();
             auto scaled_data = std::unique_ptr<ScalarFloat[]>(new ScalarFloat[size * 4]);
             ScalarFloat *scaled_data_ptr = scaled_data.get();
-            double mean = 0.0;
-            ScalarFloat max = 0.0;
-            for (ScalarUInt32 i = 0; i < size; ++i) {
-                ScalarColor3f rgb = load_unaligned<ScalarColor3f>(ptr);
-                // TODO: Make this scaling optional if the RGB values are between 0 and 1
-                ScalarFloat scale = hmax(rgb) * 2.f;
-                ScalarColor3f rgb_norm = rgb / std::max((ScalarFloat) 1e-8, scale);
-                ScalarVector3f coeff = srgb_model_fetch(rgb_norm);
-                mean += (double) (srgb_model_mean(coeff) * scale);
-                max = std::max(max, scale);
-                store_unaligned(scaled_data_ptr, concat(coeff, scale));
-                ptr += 3;
-                scaled_data_ptr += 4;
-            }
+
+            // Fit the spectral upsampling model to all voxels in parallel
+            auto [mean, max] = tbb::parallel_reduce(
+                tbb::blocked_range<ScalarUInt32>(0, size, 4096),
+                std::make_pair(0.0, (ScalarFloat) 0.f),
+                [&](const tbb::blocked_range<ScalarUInt32> &range,
+                    std::pair<double, ScalarFloat> result) {
+                    for (ScalarUInt32 i = range.begin(); i != range.end(); ++i) {
+                        ScalarColor3f rgb = load_unaligned<ScalarColor3f>(ptr + 3 * i);
+                        // TODO: Make this scaling optional if the RGB values are between 0 and 1
+                        ScalarFloat scale = hmax(rgb) * 2.f;
+                        ScalarColor3f rgb_norm = rgb / std::max((ScalarFloat) 1e-8, scale);
+                        ScalarVector3f coeff = finite ? srgb_model_fetch_finite(rgb_norm)
+                                                      : srgb_model_fetch(rgb_norm);
+                        result.first += (double) (srgb_model_mean(coeff) * scale);
+                        result.second = std::max(result.second, scale);
+                        store_unaligned(scaled_data_ptr + 4 * i, concat(coeff, scale));
+                    }
+                    return result;
+                },
+                [](std::pair<double, ScalarFloat> a, const std::pair<double, ScalarFloat> &b) {
+                    return std::make_pair(a.first + b.first, std::max(a.second, b.second));
+                }
+            );
             m_metadata.mean = mean;
             m_metadata.max = max;
             m_data = DynamicBuffer<Float>::copy(scaled_data.get(), size * 4);
@@ -145,6 +162,7 @@ public:
             m_inv_resolution_y((int) m_metadata.shape.y()),
             m_inv_resolution_z((int) m_metadata.shape.z()),
             m_filter_type(filter_type), m_wrap_mode(wrap_mode){
+        m_interpolate_coefficients = props.bool_("interpolate_coefficients", false);
 
 
 
@@ -300,6 +318,22 @@ public:
                  d011 = gather<StorageType>(m_data, index[6], active),
                  d111 = gather<StorageType>(m_data, index[7], active);
 
+            if constexpr (uses_srgb_model) {
+                if (m_interpolate_coefficients) {
+                    // Interpolate coefficients and scale, then evaluate the model only once
+                    StorageType d00 = fmadd(w0.x(), d000, w1.x() * d100),
+                                d01 = fmadd(w0.x(), d001, w1.x() * d101),
+                                d10 = fmadd(w0.x(), d010, w1.x() * d110),
+                                d11 = fmadd(w0.x(), d011, w1.x() * d111);
+                    StorageType d0  = fmadd(w0.y(), d00, w1.y() * d10),
+                                d1  = fmadd(w0.y(), d01, w1.y() * d11);
+                    StorageType d   = fmadd(w0.z(), d0, w1.z() * d1);
+
+                    return ResultType(
+                        d.w() * srgb_model_eval<UnpolarizedSpectrum>(head<3>(d), wavelengths));
+                }
+            }
+
             ResultType v000, v001, v010, v011, v100, v101, v110, v111;
             Float scale = 1.f;
             if constexpr (uses_srgb_model) {
@@ -361,6 +395,94 @@ public:
 
     ScalarFloat max() const override { return m_metadata.max; }
     ScalarVector3i resolution() const override { return m_metadata.shape; };
+
+    std::vector<ScalarFloat> max_per_cell(const ScalarBoundingBox3f &bbox,
+                                          const ScalarVector3u &resolution) const override {
+        auto data = detach(m_data);
+        if constexpr (is_cuda_array_v<Float>) {
+            data.managed();
+            cuda_eval();
+            cuda_sync();
+        }
+        const ScalarFloat *ptr = (const ScalarFloat *) data.data();
+
+        constexpr bool uses_srgb_model = is_spectral_v<Spectrum> && !Raw && Channels == 3;
+        constexpr uint32_t stride = uses_srgb_model ? 4 : Channels;
+        const ScalarVector3i shape = m_metadata.shape;
+        const ScalarVector3f shape_f(shape);
+
+        // Upper bound of the value that a single voxel can contribute
+        auto voxel_max = [&](const ScalarVector3i &p) {
+            ScalarVector3i pw = wrap(p);
+            const ScalarFloat *v =
+                ptr + ((size_t(pw.z()) * shape.y() + pw.y()) * shape.x() + pw.x()) * stride;
+            ScalarFloat result = v[0];
+            if constexpr (uses_srgb_model) {
+                // Spectra of the sRGB model are bounded by their scale factor
+                result = v[3];
+            } else {
+                for (uint32_t i = 1; i < Channels; ++i)
+                    result = std::max(result, v[i]);
+            }
+            return result;
+        };
+
+        ScalarVector3f cell_size = bbox.extents() / ScalarVector3f(resolution);
+        std::vector<ScalarFloat> result(hprod(resolution));
+
+        tbb::parallel_for(
+            tbb::blocked_range<uint32_t>(0, resolution.z()),
+            [&](const tbb::blocked_range<uint32_t> &range) {
+                for (uint32_t z = range.begin(); z != range.end(); ++z) {
+                    for (uint32_t y = 0; y < resolution.y(); ++y) {
+                        for (uint32_t x = 0; x < resolution.x(); ++x) {
+                            // Bounding box of the cell in the volume's local coordinates
+                            ScalarPoint3f p_min = bbox.min + ScalarVector3f(x, y, z) * cell_size;
+                            ScalarBoundingBox3f local;
+                            for (int i = 0; i < 8; ++i) {
+                                ScalarVector3f offset((i & 1) ? cell_size.x() : 0.f,
+                                                      (i & 2) ? cell_size.y() : 0.f,
+                                                      (i & 4) ? cell_size.z() : 0.f);
+                                local.expand(m_world_to_local * (p_min + offset));
+                            }
+
+                            // Range of voxels that can influence lookups within the cell
+                            ScalarVector3i lo, hi;
+                            if (m_filter_type == FilterType::Trilinear) {
+                                lo = floor2int<ScalarVector3i>(fmadd(local.min, shape_f, -.5f));
+                                hi = floor2int<ScalarVector3i>(fmadd(local.max, shape_f, -.5f)) + 1;
+                            } else {
+                                lo = floor2int<ScalarVector3i>(local.min * shape_f);
+                                hi = floor2int<ScalarVector3i>(local.max * shape_f);
+                            }
+
+                            // Wrapped lookups may touch every voxel along an axis
+                            if (m_wrap_mode != WrapMode::Clamp) {
+                                for (int i = 0; i < 3; ++i) {
+                                    if (hi[i] - lo[i] + 1 >= shape[i]) {
+                                        lo[i] = 0;
+                                        hi[i] = shape[i] - 1;
+                                    }
+                                }
+                            } else {
+                                lo = clamp(lo, 0, shape - 1);
+                                hi = clamp(hi, 0, shape - 1);
+                            }
+
+                            ScalarFloat value = 0.f;
+                            for (int32_t k = lo.z(); k <= hi.z(); ++k)
+                                for (int32_t j = lo.y(); j <= hi.y(); ++j)
+                                    for (int32_t i = lo.x(); i <= hi.x(); ++i)
+                                        value = std::max(value, voxel_max(ScalarVector3i(i, j, k)));
+
+                            result[(size_t(z) * resolution.y() + y) * resolution.x() + x] = value;
+                        }
+                    }
+                }
+            });
+
+        return result;
+    }
     auto data_size() const { return m_data.size(); }
 
     void traverse(TraversalCallback *callback) override {
@@ -412,6 +534,7 @@ protected:
     ScalarUInt32 m_size;
     FilterType m_filter_type;
     WrapMode m_wrap_mode;
+    bool m_interpolate_coefficients;
 };
 
 MTS_IMPLEMENT_CLASS_VARIANT(GridVolume, Volume)
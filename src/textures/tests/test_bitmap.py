@@ -1,7 +1,7 @@
 import mitsuba
 import pytest
 
-from mitsuba.python.test.util import fresolver_append_path
+from mitsuba.python.test.util import fresolver_append_path, tmpfile
 
 
 @fresolver_append_path
@@ -59,4 +59,148 @@ def test02_eval_grad(variant_scalar_rgb):
             fv = bitmap.eval_1(si)
             gradient_finite_difference = Vector2f((fu - f)/delta, (fv - f)/delta)
             gradient_analytic = bitmap.eval_1_grad(si)
-            assert ek.allclose(0, ek.abs(gradient_finite_difference/gradient_analytic - 1.0), atol = 1e04)
\ No newline at end of file
+            assert ek.allclose(0, ek.abs(gradient_finite_difference/gradient_analytic - 1.0), atol = 1e04)
+
+def write_bitmap(filename, values):
+    """Write a single-channel linear OpenEXR image"""
+    from mitsuba.core import Bitmap
+    import numpy as np
+    Bitmap(np.array(values, dtype=np.float32)).write(filename)
+
+
+@pytest.mark.parametrize('filter_type', ['trilinear', 'ewa'])
+def test03_eval_mipmap(variant_scalar_rgb, tmpfile, filter_type):
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import SurfaceInteraction3f
+    import numpy as np
+    import enoki as ek
+
+    filename = tmpfile + '.exr'
+    np.random.seed(0)
+    values = np.random.uniform(size=(64, 32, 1))
+    write_bitmap(filename, values)
+
+    def load(filter_type):
+        return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="%s"/>
+            <string name="filter_type" value="%s"/>
+            <boolean name="raw" value="true"/>
+        </texture>""" % (filename, filter_type)).expand()[0]
+
+    bilinear, bitmap = load('bilinear'), load(filter_type)
+    assert bitmap.needs_differentials()
+    assert not bilinear.needs_differentials()
+
+    # Without differentials, the lookup reduces to bilinear interpolation
+    si = SurfaceInteraction3f()
+    for uv in np.random.rand(20, 2):
+        si.uv = uv
+        assert ek.allclose(bitmap.eval_1(si), bilinear.eval_1(si), atol=1e-5)
+
+    # A footprint covering the whole texture returns its mean value
+    si.duv_dx = [2, 0]
+    si.duv_dy = [0, 2]
+    for uv in np.random.rand(5, 2):
+        si.uv = uv
+        assert ek.allclose(bitmap.eval_1(si), np.mean(values), atol=1e-2)
+
+    # Filtering a footprint of a few texels stays within the texel range
+    si.duv_dx = [4 / 32, 0]
+    si.duv_dy = [0, 0.5 / 64]
+    for uv in np.random.rand(20, 2):
+        si.uv = uv
+        v = bitmap.eval_1(si)
+        assert v >= values.min() - 1e-5 and v <= values.max() + 1e-5
+
+
+def test04_bsdf_needs_differentials(variant_scalar_rgb, tmpfile):
+    from mitsuba.core.xml import load_string
+    import numpy as np
+
+    filename = tmpfile + '.exr'
+    write_bitmap(filename, np.ones((4, 4, 1)))
+
+    def load(filter_type):
+        return load_string("""
+        <shape type="rectangle" version="2.0.0">
+            <bsdf type="diffuse">
+                <texture type="bitmap" name="reflectance">
+                    <string name="filename" value="%s"/>
+                    <string name="filter_type" value="%s"/>
+                </texture>
+            </bsdf>
+        </shape>""" % (filename, filter_type))
+
+    assert load('ewa').bsdf().needs_differentials()
+    assert not load('bilinear').bsdf().needs_differentials()
+
+
+@pytest.mark.parametrize('filter_type', ['nearest', 'bilinear', 'trilinear'])
+@pytest.mark.parametrize('dtype, ext', [('uint8', '.png'), ('float16', '.exr')])
+@pytest.mark.parametrize('channels', [1, 3])
+def test05_compact_storage(variant_scalar_rgb, tmpfile, filter_type, dtype, ext, channels):
+    from mitsuba.core import Bitmap
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import SurfaceInteraction3f
+    import numpy as np
+    import enoki as ek
+
+    filename = tmpfile + ext
+    np.random.seed(0)
+    values = np.random.uniform(size=(23, 17, channels))
+    if dtype == 'uint8':
+        values = np.uint8(values * 255)
+    Bitmap(np.array(values, dtype=dtype)).write(filename)
+
+    def load(compact):
+        return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="%s"/>
+            <string name="filter_type" value="%s"/>
+            <boolean name="compact" value="%s"/>
+        </texture>""" % (filename, filter_type, compact)).expand()[0]
+
+    texture, reference = load('true'), load('false')
+    assert 'texel_format = %s' % dtype in str(texture)
+    assert 'texel_format = float32' in str(reference)
+    assert ek.allclose(texture.mean(), reference.mean())
+
+    si = SurfaceInteraction3f()
+    for uv in np.random.uniform(-0.5, 1.5, size=(100, 2)):
+        si.uv = uv
+        si.duv_dx = [0.1, 0]
+        si.duv_dy = [0, 0.05]
+        assert ek.allclose(texture.eval(si), reference.eval(si), atol=1e-5)
+        if channels == 1:
+            assert ek.allclose(texture.eval_1_grad(si), reference.eval_1_grad(si),
+                               rtol=1e-3, atol=1e-3)
+
+    # Importance sampling uses the decoded texels
+    for sample in np.random.uniform(size=(10, 2)):
+        p0, pdf0 = texture.sample_position(sample)
+        p1, pdf1 = reference.sample_position(sample)
+        assert ek.allclose(p0, p1) and ek.allclose(pdf0, pdf1, rtol=1e-4)
+
+
+def test06_compact_storage_vec(variant_packet_rgb, tmpfile):
+    from mitsuba.core import Bitmap
+    from mitsuba.core.xml import load_string
+    from mitsuba.render import SurfaceInteraction3f
+    import numpy as np
+    import enoki as ek
+
+    filename = tmpfile + '.png'
+    np.random.seed(0)
+    Bitmap(np.uint8(np.random.uniform(size=(31, 9, 3)) * 255)).write(filename)
+
+    def load(compact):
+        return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="%s"/>
+            <boolean name="compact" value="%s"/>
+        </texture>""" % (filename, compact)).expand()[0]
+
+    si = SurfaceInteraction3f.zero(100)
+    si.uv = np.random.uniform(0, 1, size=(100, 2))
+    assert ek.allclose(load('true').eval(si), load('false').eval(si), atol=1e-5)
@@ -0,0 +1,113 @@
+import numpy as np
+import pytest
+
+import enoki as ek
+import mitsuba
+
+from mitsuba.python.test.util import tmpfile
+
+
+def write_volume(filename, values):
+    """Write a single-channel grid with bounds [0, 1]^3 ('values' is indexed as [z, y, x])"""
+    values = np.array(values, dtype=np.float32)
+    with open(filename, 'wb') as f:
+        f.write(b'VOL')
+        f.write(np.uint8(3).tobytes())   # Version
+        f.write(np.int32(1).tobytes())   # Float32 data
+        f.write(np.array(values.shape[::-1], dtype=np.int32).tobytes())
+        f.write(np.int32(1).tobytes())   # Channel count
+        f.write(np.array([0, 0, 0, 1, 1, 1], dtype=np.float32).tobytes())
+        f.write(values.tobytes())
+
+
+def load_volume(plugin, filename, **kwargs):
+    from mitsuba.core.xml import load_string
+    params = ''.join('<string name="%s" value="%s"/>' % (k, v) for k, v in kwargs.items())
+    volume = load_string("""
+        <volume type="{}" version="2.0.0">
+            <string name="filename" value="{}"/>
+            {}
+        </volume>
+    """.format(plugin, filename, params))
+    return volume.expand()[0] if plugin == 'gridvolume' else volume
+
+
+@pytest.fixture
+def sparse_volume(tmpfile):
+    # Mostly empty 20x13x9 grid (partial bricks along every axis) with a smooth blob
+    np.random.seed(0)
+    z, y, x = np.meshgrid(np.arange(9), np.arange(13), np.arange(20), indexing='ij')
+    values = np.exp(-((x - 14) ** 2 + (y - 4) ** 2 + (z - 3) ** 2) / 4.0)
+    values[values < 1e-3] = 0
+    values[1, 2, 3] = 5
+    write_volume(tmpfile, values)
+    return tmpfile, values
+
+
+@pytest.mark.parametrize('filter_type', ['nearest', 'trilinear'])
+@pytest.mark.parametrize('wrap_mode', ['repeat', 'clamp', 'mirror'])
+def test01_eval_matches_grid(variant_scalar_rgb, sparse_volume, filter_type, wrap_mode):
+    from mitsuba.render import Interaction3f
+
+    filename, values = sparse_volume
+    kwargs = {'filter_type': filter_type, 'wrap_mode': wrap_mode}
+    grid = load_volume('gridvolume', filename, **kwargs)
+    brick = load_volume('brickvolume', filename, **kwargs)
+
+    assert brick.resolution() == grid.resolution()
+    assert ek.allclose(brick.max(), 5)
+
+    it = Interaction3f()
+    for p in np.random.uniform(-0.5, 1.5, size=(200, 3)):
+        it.p = p
+        assert ek.allclose(brick.eval_1(it), grid.eval_1(it), atol=1e-6)
+        assert ek.allclose(brick.eval(it), grid.eval(it), atol=1e-6)
+
+
+@pytest.mark.parametrize('storage, atol', [('uint16', 1e-4), ('uint8', 3e-2)])
+def test02_quantized_storage(variant_scalar_rgb, sparse_volume, storage, atol):
+    from mitsuba.render import Interaction3f
+
+    filename, _ = sparse_volume
+    grid = load_volume('gridvolume', filename)
+    brick = load_volume('brickvolume', filename, storage=storage)
+
+    it = Interaction3f()
+    for p in np.random.uniform(0, 1, size=(200, 3)):
+        it.p = p
+        assert ek.allclose(brick.eval_1(it), grid.eval_1(it), atol=atol)
+
+
+def test03_max_per_cell(variant_scalar_rgb, sparse_volume):
+    from mitsuba.core import ScalarBoundingBox3f
+    from mitsuba.render import Interaction3f
+
+    filename, _ = sparse_volume
+    brick = load_volume('brickvolume', filename)
+
+    bbox = ScalarBoundingBox3f([0, 0, 0], [1, 1, 1])
+    res = [4, 4, 4]
+    bounds = np.array(brick.max_per_cell(bbox, res)).reshape(4, 4, 4)
+
+    # The empty corner away from the blob and the bright voxel has a zero majorant
+    assert bounds[3, 3, 0] == 0
+    assert bounds.max() == 5
+
+    # The bounds are conservative
+    it = Interaction3f()
+    for p in np.random.uniform(0, 1, size=(500, 3)):
+        it.p = p
+        cell = np.minimum((p * 4).astype(int), 3)
+        assert brick.eval_1(it) <= bounds[cell[2], cell[1], cell[0]] + 1e-6
+
+
+def test04_eval_vec(variant_packet_rgb, sparse_volume):
+    from mitsuba.render import Interaction3f
+
+    filename, _ = sparse_volume
+    grid = load_volume('gridvolume', filename)
+    brick = load_volume('brickvolume', filename)
+
+    it = Interaction3f.zero(100)
+    it.p = np.random.uniform(0, 1, size=(100, 3))
+    assert ek.allclose(brick.eval_1(it), grid.eval_1(it), atol=1e-6)
@@ -0,0 +1,126 @@
+import time
+
+import numpy as np
+import pytest
+
+import enoki as ek
+import mitsuba
+
+from mitsuba.python.test.util import tmpfile
+
+
+def write_rgb_volume(filename, values):
+    """Write a RGB grid with bounds [0, 1]^3 ('values' is indexed as [z, y, x, channel])"""
+    values = np.array(values, dtype=np.float32)
+    with open(filename, 'wb') as f:
+        f.write(b'VOL')
+        f.write(np.uint8(3).tobytes())   # Version
+        f.write(np.int32(1).tobytes())   # Float32 data
+        f.write(np.array(values.shape[2::-1], dtype=np.int32).tobytes())
+        f.write(np.int32(3).tobytes())   # Channel count
+        f.write(np.array([0, 0, 0, 1, 1, 1], dtype=np.float32).tobytes())
+        f.write(values.tobytes())
+
+
+def load_bitmap(filename, interpolate_coefficients):
+    from mitsuba.core.xml import load_string
+    return load_string("""
+        <texture type="bitmap" version="2.0.0">
+            <string name="filename" value="%s"/>
+            <boolean name="interpolate_coefficients" value="%s"/>
+        </texture>""" % (filename, interpolate_coefficients)).expand()[0]
+
+
+def load_grid(filename, interpolate_coefficients):
+    from mitsuba.core.xml import load_string
+    return load_string("""
+        <volume type="gridvolume" version="2.0.0">
+            <string name="filename" value="%s"/>
+            <boolean name="interpolate_coefficients" value="%s"/>
+        </volume>""" % (filename, interpolate_coefficients)).expand()[0]
+
+
+@pytest.fixture
+def rgb_bitmap(tmpfile):
+    from mitsuba.core import Bitmap
+
+    # Smooth color gradients, and a few black and white texels
+    y, x = np.meshgrid(np.linspace(0, 1, 32), np.linspace(0, 1, 48), indexing='ij')
+    values = np.stack([x, y, 0.5 * (1 - x * y)], axis=-1)
+    values[3, 4] = 0
+    values[20, 30] = 1
+
+    filename = tmpfile + '.exr'
+    Bitmap(np.float32(values)).write(filename)
+    return filename
+
+
+def test01_bitmap(variant_scalar_spectral, rgb_bitmap):
+    from mitsuba.render import SurfaceInteraction3f
+
+    reference = load_bitmap(rgb_bitmap, 'false')
+    texture = load_bitmap(rgb_bitmap, 'true')
+    assert ek.allclose(texture.mean(), reference.mean(), rtol=1e-4)
+
+    si = SurfaceInteraction3f()
+    si.wavelengths = [400, 500, 600, 700]
+
+    # Texel centers are reproduced exactly (up to the finite black/white representation)
+    for y in range(32):
+        for x in range(48):
+            si.uv = [(x + .5) / 48, (y + .5) / 32]
+            assert ek.allclose(texture.eval(si), reference.eval(si), atol=1e-4)
+
+    # Interpolation within smooth regions is a close approximation
+    for uv in np.random.uniform(0.25, 0.5, size=(100, 2)):
+        si.uv = uv
+        assert ek.allclose(texture.eval(si), reference.eval(si), atol=1e-2)
+        assert ek.all(ek.isfinite(texture.eval(si)))
+
+
+def test02_grid(variant_scalar_spectral, tmpfile):
+    from mitsuba.render import Interaction3f
+
+    np.random.seed(0)
+    values = np.random.uniform(0, 2, size=(5, 6, 7, 3))
+    values[1, 2, 3] = 0
+    write_rgb_volume(tmpfile, values)
+
+    reference = load_grid(tmpfile, 'false')
+    grid = load_grid(tmpfile, 'true')
+    assert ek.allclose(grid.max(), reference.max())
+
+    it = Interaction3f()
+    it.wavelengths = [400, 500, 600, 700]
+    for z in range(5):
+        for y in range(6):
+            for x in range(7):
+                it.p = [(x + .5) / 7, (y + .5) / 6, (z + .5) / 5]
+                assert ek.allclose(grid.eval(it), reference.eval(it), atol=1e-3)
+
+    for p in np.random.uniform(0, 1, size=(100, 3)):
+        it.p = p
+        assert ek.all(ek.isfinite(grid.eval(it)))
+
+
+@pytest.mark.slow
+def test03_benchmark(variant_packet_spectral, rgb_bitmap):
+    from mitsuba.render import SurfaceInteraction3f
+
+    n = 1000000
+    si = SurfaceInteraction3f.zero(n)
+    si.uv = np.random.uniform(size=(n, 2))
+    si.wavelengths = np.random.uniform(360, 830, size=(n, 4))
+
+    timings = []
+    for interpolate_coefficients in ['false', 'true']:
+        texture = load_bitmap(rgb_bitmap, interpolate_coefficients)
+        texture.eval(si)
+        start = time.time()
+        for i in range(10):
+            texture.eval(si)
+        timings.append((time.time() - start) / 10)
+
+    print('\nbitmap.eval() with %i lookups: %.2f ms (spectra), %.2f ms (coefficients), '
+          'speedup: %.2fx' % (n, timings[0] * 1000, timings[1] * 1000,
+                              timings[0] / timings[1]))
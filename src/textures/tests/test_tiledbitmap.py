@@ -0,0 +1,82 @@
+import numpy as np
+import pytest
+
+import enoki as ek
+import mitsuba
+
+from mitsuba.python.test.util import tmpfile
+
+
+def load_texture(plugin, filename, filter_type):
+    from mitsuba.core.xml import load_string
+    return load_string("""
+        <texture type="%s" version="2.0.0">
+            <string name="filename" value="%s"/>
+            <string name="filter_type" value="%s"/>
+            <boolean name="raw" value="true"/>
+        </texture>""" % (plugin, filename, filter_type)).expand()[0]
+
+
+@pytest.fixture
+def textures(tmpfile):
+    from mitsuba.core import Bitmap, TiledImage
+
+    np.random.seed(0)
+    values = np.random.uniform(size=(45, 30, 1)).astype(np.float32)
+    exr_file, mtx_file = tmpfile + '.exr', tmpfile + '.mtx'
+    Bitmap(values).write(exr_file)
+    TiledImage.write(Bitmap(values), mtx_file, tile_size=16)
+    return exr_file, mtx_file, values
+
+
+@pytest.mark.parametrize('filter_type', ['nearest', 'bilinear'])
+def test01_eval_matches_bitmap(variant_scalar_rgb, textures, filter_type):
+    from mitsuba.render import SurfaceInteraction3f
+
+    exr_file, mtx_file, values = textures
+    bitmap = load_texture('bitmap', exr_file, filter_type)
+    tiled = load_texture('tiledbitmap', mtx_file, filter_type)
+
+    assert tiled.resolution() == bitmap.resolution()
+    assert ek.allclose(tiled.mean(), np.mean(values), atol=2e-2)
+
+    si = SurfaceInteraction3f()
+    for uv in np.random.uniform(-0.5, 1.5, size=(200, 2)):
+        si.uv = uv
+        assert ek.allclose(tiled.eval_1(si), bitmap.eval_1(si), atol=1e-5)
+
+
+def test02_eval_trilinear(variant_scalar_rgb, textures):
+    from mitsuba.render import SurfaceInteraction3f
+
+    exr_file, mtx_file, values = textures
+    bitmap = load_texture('bitmap', exr_file, 'bilinear')
+    tiled = load_texture('tiledbitmap', mtx_file, 'trilinear')
+    assert tiled.needs_differentials()
+    assert not load_texture('tiledbitmap', mtx_file, 'bilinear').needs_differentials()
+
+    # Without differentials, the lookup reduces to bilinear interpolation
+    si = SurfaceInteraction3f()
+    for uv in np.random.rand(20, 2):
+        si.uv = uv
+        assert ek.allclose(tiled.eval_1(si), bitmap.eval_1(si), atol=1e-5)
+
+    # A footprint covering the whole texture returns its mean value
+    si.duv_dx = [2, 0]
+    si.duv_dy = [0, 2]
+    for uv in np.random.rand(5, 2):
+        si.uv = uv
+        assert ek.allclose(tiled.eval_1(si), np.mean(values), atol=2e-2)
+
+
+def test03_eval_vec(variant_packet_rgb, textures):
+    from mitsuba.render import SurfaceInteraction3f
+
+    exr_file, mtx_file, _ = textures
+    bitmap = load_texture('bitmap', exr_file, 'bilinear')
+    tiled = load_texture('tiledbitmap', mtx_file, 'bilinear')
+
+    si = SurfaceInteraction3f.zero(100)
+    si.uv = np.random.uniform(0, 1, size=(100, 2))
+    assert ek.allclose(tiled.eval_1(si), bitmap.eval_1(si), atol=1e-5)
+    assert ek.allclose(tiled.eval(si), bitmap.eval(si), atol=1e-5)
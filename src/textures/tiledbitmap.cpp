@@ -0,0 +1,417 @@
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/texcache.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/srgb.h>
+#include <mitsuba/render/texture.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _texture-tiledbitmap:
+
+Tiled bitmap texture (:monosp:`tiledbitmap`)
+--------------------------------------------
+
+.. pluginparameters::
+
+ * - filename
+   - |string|
+   - Filename of an image in Mitsuba's native tiled format (see below)
+
+ * - filter_type
+   - |string|
+   - Specifies how pixel values are interpolated and filtered when queried over larger
+     UV regions. The following options are currently available:
+
+     - ``bilinear`` (default): perform bilinear interpolation, but no filtering.
+
+     - ``nearest``: disable filtering and interpolation. In this mode, the plugin
+       performs nearest neighbor lookups of texture values.
+
+     - ``trilinear``: perform bilinear interpolation on the two levels of the MIP map
+       that best match the pixel footprint, and interpolate linearly between them.
+
+ * - wrap_mode
+   - |string|
+   - Controls the behavior of texture evaluations that fall outside of the
+     :math:`[0, 1]` range. The following options are currently available:
+
+     - ``repeat`` (default): tile the texture infinitely.
+
+     - ``mirror``: mirror the texture along its boundaries.
+
+     - ``clamp``: clamp coordinates to the edge of the texture.
+
+ * - raw
+   - |bool|
+   - Should the spectral upsampling of the stored color data be disabled?
+     (Default: false)
+
+ * - to_uv
+   - |transform|
+   - Specifies an optional 3x3 transformation matrix that will be applied to UV
+     values. A 4x4 matrix can also be provided, in which case the extra row and
+     column are ignored.
+
+This plugin provides a bitmap texture for scenes whose textures don't fit into
+memory. Instead of decoding the entire image when the scene is loaded, the
+texture is stored on disk in a tiled and MIP-mapped format, and tiles are loaded
+on demand through a texture cache that is shared by all instances of this
+plugin. The cache evicts the least recently used tiles once its memory budget
+(1 GiB by default, see the ``--texture-cache`` option of the :monosp:`mitsuba`
+executable) is exceeded, and its hit rates are reported along with the profiler
+output.
+
+Tiled images are created from any image format supported by Mitsuba using the
+Python API:
+
+.. code-block:: python
+
+    from mitsuba.core import Bitmap, TiledImage
+    TiledImage.write(Bitmap('texture.png'), 'texture.mtx', tile_size=64)
+
+The conversion stores linear color values, i.e. sRGB-encoded images are
+linearized. Call ``Bitmap.set_srgb_gamma(False)`` before the conversion to
+store the encoded values instead (e.g. for normal maps).
+
+This plugin is only available in the CPU (scalar and packet) variants.
+
+*/
+
+enum class TiledFilterType { Nearest, Bilinear, Trilinear };
+enum class TiledWrapMode { Repeat, Mirror, Clamp };
+
+template <typename Float, typename Spectrum>
+class TiledBitmapTexture final : public Texture<Float, Spectrum> {
+public:
+    MTS_IMPORT_TYPES(Texture)
+
+    // Representation of texel values after evaluating the spectral upsampling model
+    using ResultType = std::conditional_t<is_spectral_v<Spectrum>, UnpolarizedSpectrum, Color3f>;
+
+    TiledBitmapTexture(const Properties &props) : Texture(props) {
+        if constexpr (is_cuda_array_v<Float>)
+            Throw("The tiledbitmap texture is only supported in CPU variants!");
+
+        m_transform = props.transform("to_uv", ScalarTransform4f()).extract();
+
+        FileResolver* fs = Thread::thread()->file_resolver();
+        fs::path file_path = fs->resolve(props.string("filename"));
+        m_name = file_path.filename().string();
+
+        std::string filter_type = props.string("filter_type", "bilinear");
+        if (filter_type == "nearest")
+            m_filter_type = TiledFilterType::Nearest;
+        else if (filter_type == "bilinear")
+            m_filter_type = TiledFilterType::Bilinear;
+        else if (filter_type == "trilinear")
+            m_filter_type = TiledFilterType::Trilinear;
+        else
+            Throw("Invalid filter type \"%s\", must be one of: \"nearest\", "
+                  "\"bilinear\", or \"trilinear\"!", filter_type);
+
+        std::string wrap_mode = props.string("wrap_mode", "repeat");
+        if (wrap_mode == "repeat")
+            m_wrap_mode = TiledWrapMode::Repeat;
+        else if (wrap_mode == "mirror")
+            m_wrap_mode = TiledWrapMode::Mirror;
+        else if (wrap_mode == "clamp")
+            m_wrap_mode = TiledWrapMode::Clamp;
+        else
+            Throw("Invalid wrap mode \"%s\", must be one of: \"repeat\", "
+                  "\"mirror\", or \"clamp\"!", wrap_mode);
+
+        m_raw = props.bool_("raw", false);
+
+        /* Peek at the channel count to decide whether tiles must be converted
+           into coefficients of the spectral upsampling model upon loading */
+        m_image = new TiledImage(file_path);
+        m_spectral_coeffs = is_spectral_v<Spectrum> && !m_raw &&
+                            m_image->channel_count() == 3;
+
+        if (m_spectral_coeffs) {
+            m_image = new TiledImage(file_path, [](float *data, size_t texel_count) {
+                for (size_t i = 0; i < texel_count; ++i) {
+                    Color<float, 3> value = load_unaligned<Color<float, 3>>(data);
+                    store_unaligned(data, srgb_model_fetch(value));
+                    data += 3;
+                }
+            });
+        }
+
+        Log(Debug, "Opened tiled texture \"%s\" (%ix%i, %i levels)", m_name,
+            m_image->size().x(), m_image->size().y(), m_image->level_count());
+
+        // The coarsest level of the MIP map stores the mean texel value
+        ScalarColor3f mean = texel(m_image->level_count() - 1, ScalarPoint2i(0));
+        if (m_spectral_coeffs)
+            m_mean = srgb_model_mean(mean);
+        else
+            m_mean = luminance(mean);
+    }
+
+    UnpolarizedSpectrum eval(const SurfaceInteraction3f &si, Mask active) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (is_spectral_v<Spectrum> && m_raw && m_image->channel_count() == 3)
+            Throw("The tiled bitmap texture %s was queried for a spectrum, but texture "
+                  "conversion into spectra was explicitly disabled! (raw=true)",
+                  to_string());
+
+        ResultType result = interpolate(si, active);
+
+        if constexpr (is_monochromatic_v<Spectrum>)
+            return luminance(result);
+        else
+            return result;
+    }
+
+    Float eval_1(const SurfaceInteraction3f &si, Mask active = true) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_spectral_coeffs)
+            Throw("eval_1(): The tiled bitmap texture %s was queried for a "
+                  "monochromatic value, but texture conversion to color "
+                  "spectra had previously been requested! (raw=false)",
+                  to_string());
+
+        return luminance(interpolate_color(si, active));
+    }
+
+    Color3f eval_3(const SurfaceInteraction3f &si, Mask active = true) const override {
+        MTS_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_image->channel_count() != 3)
+            Throw("eval_3(): The tiled bitmap texture %s was queried for a RGB "
+                  "value, but it is monochromatic!", to_string());
+        else if (m_spectral_coeffs)
+            Throw("eval_3(): The tiled bitmap texture %s was queried for a RGB "
+                  "value, but texture conversion to color spectra had "
+                  "previously been requested! (raw=false)",
+                  to_string());
+
+        return interpolate_color(si, active);
+    }
+
+    ScalarVector2i resolution() const override {
+        return ScalarVector2i(m_image->size());
+    }
+
+    ScalarFloat mean() const override { return m_mean; }
+
+    bool is_spatially_varying() const override { return true; }
+
+    bool needs_differentials() const override {
+        return m_filter_type == TiledFilterType::Trilinear;
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "TiledBitmapTexture[" << std::endl
+            << "  name = \"" << m_name << "\"," << std::endl
+            << "  image = " << string::indent(m_image) << "," << std::endl
+            << "  raw = " << (int) m_raw << "," << std::endl
+            << "  mean = " << m_mean << "," << std::endl
+            << "  transform = " << string::indent(m_transform) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+
+protected:
+    /// Evaluate the texture, including the spectral upsampling model (if enabled)
+    ResultType interpolate(const SurfaceInteraction3f &si, Mask active) const {
+        if constexpr (is_spectral_v<Spectrum>) {
+            if (m_spectral_coeffs) {
+                return lookup(si, active, [&](const Color3f &coeff) {
+                    return srgb_model_eval<UnpolarizedSpectrum>(coeff, si.wavelengths);
+                });
+            } else {
+                return ResultType(luminance(interpolate_color(si, active)));
+            }
+        } else {
+            return interpolate_color(si, active);
+        }
+    }
+
+    /// Evaluate the texture, returning the stored color values
+    Color3f interpolate_color(const SurfaceInteraction3f &si, Mask active) const {
+        return lookup(si, active, [](const Color3f &value) { return value; });
+    }
+
+    /**
+     * \brief Filtered texture lookup
+     *
+     * Texels are fetched from the texture cache one lane at a time, while the
+     * function \c convert (e.g. the spectral upsampling model) and the
+     * interpolation run vectorized.
+     */
+    template <typename Func>
+    auto lookup(const SurfaceInteraction3f &si, Mask active, const Func &convert) const {
+        using Result = decltype(convert(std::declval<Color3f>()));
+
+        if constexpr (!is_array_v<Mask>)
+            active = true;
+
+        Point2f uv = m_transform.transform_affine(si.uv);
+
+        if (m_filter_type == TiledFilterType::Nearest) {
+            Color3f v[4];
+            Vector2f w;
+            fetch(UInt32(0), uv, false, active, v, w);
+            return convert(v[0]);
+        }
+
+        auto bilinear = [&](const UInt32 &level) {
+            Color3f v[4];
+            Vector2f w1;
+            fetch(level, uv, true, active, v, w1);
+            Vector2f w0 = 1.f - w1;
+
+            Result v0 = fmadd(w0.x(), convert(v[0]), w1.x() * convert(v[1])),
+                   v1 = fmadd(w0.x(), convert(v[2]), w1.x() * convert(v[3]));
+
+            return Result(fmadd(w0.y(), v0, w1.y() * v1));
+        };
+
+        if (m_filter_type == TiledFilterType::Bilinear)
+            return bilinear(UInt32(0));
+
+        // Trilinear filtering: choose the levels based on the pixel footprint
+        ScalarVector2f res(m_image->size());
+        ScalarFloat last = ScalarFloat(m_image->level_count() - 1);
+        Vector2f dst0 = m_transform * si.duv_dx,
+                 dst1 = m_transform * si.duv_dy;
+        Float width = max(norm(dst0 * res), norm(dst1 * res)),
+              lod   = min(log2(max(width, 1.f)), last);
+
+        UInt32 level0 = floor2int<UInt32>(lod),
+               level1 = min(level0 + 1, m_image->level_count() - 1);
+        Float t = lod - Float(level0);
+
+        Result v0 = bilinear(level0);
+        if (none(active && t > 0.f))
+            return v0;
+
+        Result v1 = bilinear(level1);
+        return Result(fmadd(t, v1 - v0, v0));
+    }
+
+    /**
+     * \brief Fetch the texels used by a lookup from the texture cache
+     *
+     * For bilinear lookups, <tt>v[0..3]</tt> receive the texels at the
+     * offsets (0, 0), (1, 0), (0, 1) and (1, 1), and \c w receives the
+     * interpolation weights. Otherwise, only <tt>v[0]</tt> is set.
+     */
+    void fetch(const UInt32 &level, const Point2f &uv, bool bilinear, const Mask &active,
+               Color3f *v, Vector2f &w) const {
+        if constexpr (!is_cuda_array_v<Float>) {
+            constexpr size_t Lanes = is_array_v<Float> ? array_size_v<Float> : 1;
+
+            // Transpose the lookup into per-lane arrays
+            ScalarFloat u_in[Lanes], v_in[Lanes];
+            uint32_t level_in[Lanes], active_in[Lanes];
+            store_lanes(u_in, uv.x());
+            store_lanes(v_in, uv.y());
+            store_lanes(level_in, level);
+            store_lanes(active_in, select(active, UInt32(1), UInt32(0)));
+
+            ScalarFloat v_out[4][3][Lanes] = { }, w_out[2][Lanes] = { };
+
+            for (size_t i = 0; i < Lanes; ++i) {
+                if (!active_in[i])
+                    continue;
+
+                uint32_t level_i = level_in[i];
+                ScalarVector2i res(m_image->level_size(level_i));
+                ScalarPoint2f p = ScalarPoint2f(u_in[i], v_in[i]) * ScalarVector2f(res);
+
+                auto put = [&](int k, const ScalarPoint2i &p_i) {
+                    ScalarColor3f value = texel(level_i, wrap(p_i, res));
+                    for (int ch = 0; ch < 3; ++ch)
+                        v_out[k][ch][i] = value[ch];
+                };
+
+                if (!bilinear) {
+                    put(0, floor2int<ScalarPoint2i>(p));
+                    continue;
+                }
+
+                p -= .5f;
+                ScalarPoint2i p_i = floor2int<ScalarPoint2i>(p);
+                w_out[0][i] = p.x() - p_i.x();
+                w_out[1][i] = p.y() - p_i.y();
+
+                for (int k = 0; k < 4; ++k)
+                    put(k, p_i + ScalarVector2i(k & 1, k >> 1));
+            }
+
+            for (int k = 0; k < (bilinear ? 4 : 1); ++k)
+                v[k] = Color3f(load_lanes<Float>(v_out[k][0]),
+                               load_lanes<Float>(v_out[k][1]),
+                               load_lanes<Float>(v_out[k][2]));
+            w = Vector2f(load_lanes<Float>(w_out[0]), load_lanes<Float>(w_out[1]));
+        } else {
+            ENOKI_MARK_USED(level); ENOKI_MARK_USED(uv); ENOKI_MARK_USED(bilinear);
+            ENOKI_MARK_USED(active); ENOKI_MARK_USED(v); ENOKI_MARK_USED(w);
+        }
+    }
+
+    template <typename Value, typename T> static void store_lanes(T *ptr, const Value &value) {
+        if constexpr (is_array_v<Value>)
+            store_unaligned(ptr, value);
+        else
+            *ptr = value;
+    }
+
+    template <typename Value, typename T> static Value load_lanes(const T *ptr) {
+        if constexpr (is_array_v<Value>)
+            return load_unaligned<Value>(ptr);
+        else
+            return *ptr;
+    }
+
+    /// Fetch a texel through the texture cache (monochromatic images are replicated)
+    ScalarColor3f texel(uint32_t level, const ScalarPoint2i &p) const {
+        const float *value = m_image->texel(level, (uint32_t) p.x(), (uint32_t) p.y());
+        if (m_image->channel_count() == 1)
+            return ScalarColor3f(value[0]);
+        else
+            return ScalarColor3f(value[0], value[1], value[2]);
+    }
+
+    /// Apply the wrap mode to an integer texel position on a level of resolution \c res
+    ScalarPoint2i wrap(const ScalarPoint2i &p, const ScalarVector2i &res) const {
+        if (m_wrap_mode == TiledWrapMode::Clamp)
+            return clamp(p, 0, res - 1);
+
+        ScalarPoint2i div(p.x() >= 0 ? p.x() / res.x() : (p.x() + 1) / res.x() - 1,
+                          p.y() >= 0 ? p.y() / res.y() : (p.y() + 1) / res.y() - 1),
+                      mod = p - div * res;
+
+        if (m_wrap_mode == TiledWrapMode::Mirror)
+            mod = select(eq(div & 1, 0), mod, res - 1 - mod);
+
+        return mod;
+    }
+
+protected:
+    ref<TiledImage> m_image;
+    std::string m_name;
+    ScalarTransform3f m_transform;
+    TiledFilterType m_filter_type;
+    TiledWrapMode m_wrap_mode;
+    bool m_raw;
+    bool m_spectral_coeffs;
+    ScalarFloat m_mean;
+};
+
+MTS_IMPLEMENT_CLASS_VARIANT(TiledBitmapTexture, Texture)
+MTS_EXPORT_PLUGIN(TiledBitmapTexture, "Tiled bitmap texture")
+
+NAMESPACE_END(mitsuba)
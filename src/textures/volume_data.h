@@ -6,6 +6,7 @@
 /// @file Helper functions for volume data handling.
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/math.h>
+#include <mitsuba/core/mmap.h>
 #include <mitsuba/core/thread.h>
 #include <mitsuba/core/transform.h>
 #include <mitsuba/render/volume_texture.h>
@@ -101,4 +102,58 @@ read_binary_volume_data(const std::string &filename) {
     return { meta, std::move(raw_data) };
 }
 
+/**
+ * Memory-maps a Mitsuba binary volume file without copying its contents.
+ *
+ * Only the header is parsed: the mean and maximum values of the returned
+ * metadata are left uninitialized. The voxel data (\c float32 values in
+ * x-major order, with interleaved channels) starts at the returned pointer
+ * and remains valid for the lifetime of the mapping.
+ */
+template <typename Float>
+std::tuple<VolumeMetadata, ref<MemoryMappedFile>, const float *>
+map_binary_volume_data(const std::string &filename) {
+    MTS_IMPORT_CORE_TYPES()
+
+    VolumeMetadata meta;
+    auto fs       = Thread::thread()->file_resolver();
+    meta.filename = fs->resolve(filename).string();
+    ref<MemoryMappedFile> mmap = new MemoryMappedFile(meta.filename);
+
+    // Magic, version, type, shape, channel count and bounding box
+    const size_t header_size = 3 + 1 + 4 + 3 * 4 + 4 + 6 * 4;
+    const uint8_t *ptr = (const uint8_t *) mmap->data();
+    if (mmap->size() < header_size || ptr[0] != 'V' || ptr[1] != 'O' || ptr[2] != 'L')
+        Throw("Invalid volume file %s", filename);
+    meta.version = ptr[3];
+    if (meta.version != 3)
+        Throw("Invalid version, currently only version 3 is supported (found %d)", meta.version);
+
+    int32_t ints[5];
+    float dims[6];
+    memcpy(ints, ptr + 4, sizeof(int32_t) * 5);
+    memcpy(dims, ptr + 24, sizeof(float) * 6);
+
+    meta.data_type = ints[0];
+    if (meta.data_type != 1)
+        Throw("Wrong type, currently only type == 1 (Float32) data is supported (found type = %d)",
+              meta.data_type);
+
+    meta.shape         = ScalarVector3i(ints[1], ints[2], ints[3]);
+    meta.channel_count = ints[4];
+    size_t size        = hprod(meta.shape);
+    if (size < 8)
+        Throw("Invalid grid dimensions: %d x %d x %d < 8 (must have at "
+              "least one value at each corner)",
+              meta.shape.x(), meta.shape.y(), meta.shape.z());
+    if (mmap->size() < header_size + size * meta.channel_count * sizeof(float))
+        Throw("Volume file %s is truncated", filename);
+
+    meta.bbox      = ScalarBoundingBox3f(ScalarPoint3f(dims[0], dims[1], dims[2]),
+                                         ScalarPoint3f(dims[3], dims[4], dims[5]));
+    meta.transform = detail::bbox_transform(meta.bbox);
+
+    return { meta, mmap, (const float *) (ptr + header_size) };
+}
+
 NAMESPACE_END(mitsuba)